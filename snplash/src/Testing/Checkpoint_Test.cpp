@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "../engine/output/checkpoint.hh"
+
+using namespace std;
+
+static string contents(const string &fileName){
+	ifstream in(fileName.c_str());
+	stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+TEST(Checkpoint, SaveAndLoad) {
+	const string file = "checkpoint_test.ckpt";
+	Checkpoint a;
+	a.init(file, "engine 9\ncov age sex\n", 60);
+	ASSERT_TRUE(a.save(12345, 678901));
+
+	Checkpoint b;
+	b.init(file, "engine 9\ncov age sex\n", 60);
+	long lines;
+	unsigned long long offset;
+	ASSERT_TRUE(b.load(lines, offset));
+	ASSERT_EQ(12345, lines);
+	ASSERT_EQ(678901ULL, offset);
+
+	// Another run must not pick it up.
+	Checkpoint c;
+	c.init(file, "engine 9\ncov age\n", 60);
+	ASSERT_FALSE(c.load(lines, offset));
+
+	b.finish();
+	ASSERT_FALSE(b.load(lines, offset));
+}
+
+// Lines written after the checkpoint are dropped and the file appended to.
+TEST(Checkpoint, ResumeCutsBackOutput) {
+	const string file = "checkpoint_test.out";
+	Output first;
+	ASSERT_TRUE(first.init(file));
+	first.write_header("header\n");
+	first.write_line("line 0\n");
+	unsigned long long offset = first.sync();
+	ASSERT_EQ(14ULL, offset);
+	first.write_line("line 1, lost\n");
+	first.close();
+
+	Output second;
+	ASSERT_TRUE(second.resume(file, false, offset));
+	second.write_line("line 1\n");
+	second.close();
+	ASSERT_EQ("header\nline 0\nline 1\n", contents(file));
+
+	Output third;
+	ASSERT_FALSE(third.resume(file, false, 1000));
+	remove(file.c_str());
+}
+
+#if SNPLASH_HAVE_ZLIB
+// A compressed file is resumed as a second gzip member.
+TEST(Checkpoint, ResumeCompressed) {
+	const string file = "checkpoint_test.out";
+	Output first;
+	ASSERT_TRUE(first.init(file, true));
+	first.write_line("line 0\n");
+	unsigned long long offset = first.sync();
+	first.write_line("line 1, lost\n");
+	first.close();
+
+	Output second;
+	ASSERT_TRUE(second.resume(file, true, offset));
+	second.write_line("line 1\n");
+	second.close();
+
+	gzFile gz = gzopen((file + ".gz").c_str(), "rb");
+	ASSERT_TRUE(gz != NULL);
+	char buf[256];
+	int n = gzread(gz, buf, sizeof(buf));
+	gzclose(gz);
+	ASSERT_EQ("line 0\nline 1\n", string(buf, n > 0 ? n : 0));
+	remove((file + ".gz").c_str());
+}
+#endif
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <limits>
+#include "../engine/output/column_output.hh"
+
+// Rows i = 0..n-1: index i, p-value (i+1)/n (NaN every 100th), name "rs<i>".
+static void writeFile(const char *name, int n){
+	ColumnOutput out;
+	out.add_column("index", COLUMN_INT);
+	out.add_column("pVal", COLUMN_DOUBLE);
+	out.add_column("name", COLUMN_STRING);
+	ASSERT_TRUE(out.init(name));
+	for(int i=0;i < n;i++){
+		out.put(i);
+		if(i % 100 == 99){
+			out.put(numeric_limits<double>::quiet_NaN());
+		}else{
+			out.put((i + 1.0) / n);
+		}
+		char buf[32];
+		sprintf(buf, "rs%d", i);
+		out.put(string(buf));
+		out.end_row();
+	}
+	out.close();
+}
+
+TEST(ColumnOutput, RoundTrip) {
+	const char *name = "column_output_test.tmp";
+	const int n = 2 * COLUMN_BLOCK_ROWS + 5;
+	writeFile(name, n);
+
+	ColumnInput in;
+	ASSERT_TRUE(in.open(name));
+	ASSERT_EQ(3, in.num_columns());
+	ASSERT_EQ(1, in.find_column("pVal"));
+	ASSERT_EQ(-1, in.find_column("beta"));
+	ASSERT_EQ(COLUMN_STRING, in.column_type(2));
+	ASSERT_EQ(static_cast<unsigned long long>(n), in.num_rows());
+	ASSERT_EQ(3, in.num_blocks());
+	ASSERT_EQ(5u, in.block_rows(2));
+
+	int row = 0;
+	for(int b=0;b < in.num_blocks();b++){
+		vector<int> index;
+		vector<double> p;
+		vector<string> names;
+		ASSERT_TRUE(in.read(b, 0, index));
+		ASSERT_TRUE(in.read(b, 1, p));
+		ASSERT_TRUE(in.read(b, 2, names));
+		ASSERT_FALSE(in.read(b, 1, index)) << "Type mismatch must fail";
+		ASSERT_EQ(in.block_rows(b), index.size());
+		ASSERT_EQ(in.block_rows(b), names.size());
+		for(unsigned int i=0;i < index.size();i++, row++){
+			ASSERT_EQ(row, index[i]);
+			if(row % 100 == 99){
+				ASSERT_TRUE(p[i] != p[i]);
+			}else{
+				ASSERT_EQ((row + 1.0) / n, p[i]);
+			}
+			char buf[32];
+			sprintf(buf, "rs%d", row);
+			ASSERT_EQ(string(buf), names[i]);
+		}
+	}
+	ASSERT_EQ(n, row);
+
+	// Block ranges skip the NaNs.
+	ASSERT_EQ(1.0 / n, in.block_min(0, 1));
+	ASSERT_EQ(COLUMN_BLOCK_ROWS / static_cast<double>(n), in.block_max(0, 1));
+	ASSERT_EQ(COLUMN_BLOCK_ROWS, in.block_min(1, 0));
+	ASSERT_EQ(n - 1, in.block_max(2, 0));
+
+	// Only the first block can hold p-values below 0.1.
+	int wanted = 0;
+	for(int b=0;b < in.num_blocks();b++){
+		if(in.block_min(b, 1) < 0.1) wanted++;
+	}
+	ASSERT_EQ(1, wanted);
+
+	remove(name);
+}
+
+TEST(ColumnOutput, EmptyFile) {
+	const char *name = "column_output_empty.tmp";
+	writeFile(name, 0);
+
+	ColumnInput in;
+	ASSERT_TRUE(in.open(name));
+	ASSERT_EQ(3, in.num_columns());
+	ASSERT_EQ(0u, in.num_rows());
+	ASSERT_EQ(0, in.num_blocks());
+	remove(name);
+}
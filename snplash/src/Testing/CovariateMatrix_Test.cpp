@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include "../engine/covariate_matrix.hh"
+
+// Three individuals, two covariates, one of them missing for individual 1.
+static void fillMatrix(CovariateMatrix &m){
+	vector<double> rows;
+	rows.push_back(1); rows.push_back(10);
+	rows.push_back(2); rows.push_back(numeric_limits<double>::max());
+	rows.push_back(3); rows.push_back(30);
+	m.assign_rows(rows, 3, 2);
+}
+
+TEST(CovariateMatrix, StoresColumns) {
+	CovariateMatrix m;
+	fillMatrix(m);
+	ASSERT_EQ(3u, m.num_people());
+	ASSERT_EQ(2u, m.num_covariates());
+	ASSERT_EQ(2, m.column(0)[1]);
+	ASSERT_EQ(30, m.column(1)[2]);
+	ASSERT_EQ(10, m.at(0, 1));
+	ASSERT_TRUE(m.complete(0));
+	ASSERT_FALSE(m.complete(1));
+}
+
+TEST(CovariateMatrix, GatherAndKeep) {
+	CovariateMatrix m;
+	fillMatrix(m);
+	vector<unsigned int> rows;
+	rows.push_back(2); rows.push_back(0);
+	vector<vector<double> > cov;
+	m.gather(rows, cov);
+	ASSERT_EQ(2u, cov.size());
+	ASSERT_EQ(3, cov[0][0]);
+	ASSERT_EQ(10, cov[1][1]);
+
+	vector<bool> keep(3, true);
+	keep[1] = false;
+	m.keep_people(keep);
+	ASSERT_EQ(2u, m.num_people());
+	ASSERT_EQ(30, m.at(1, 1));
+	ASSERT_TRUE(m.complete(1));
+}
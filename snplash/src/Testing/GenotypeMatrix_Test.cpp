@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include "../engine/genotype_matrix.hh"
+
+// Fill a matrix with every code, including the phased heterozygote.
+static void fillMatrix(GenotypeMatrix &m, unsigned long snps, unsigned int people){
+	m.resize(snps, people);
+	for(unsigned long s=0; s < snps; s++){
+		for(unsigned int p=0; p < people; p++){
+			m.set(s, p, (s + p) % 5);
+		}
+	}
+}
+
+TEST(GenotypeMatrix, StoresAllCodes) {
+	GenotypeMatrix m;
+	fillMatrix(m, 3, 11);
+	for(unsigned long s=0; s < 3; s++){
+		for(unsigned int p=0; p < 11; p++){
+			ASSERT_EQ(static_cast<short>((s + p) % 5), m.get(s, p)) << "SNP " << s << " individual " << p;
+		}
+	}
+}
+
+TEST(GenotypeMatrix, ExpandMatchesAt) {
+	GenotypeMatrix m;
+	for(unsigned int people=1; people < 20; people++){
+		fillMatrix(m, 2, people);
+		vector<short> codes(people);
+		GenotypeMatrix::expand(m.row(1), m.phase_row(1), people, &codes[0]);
+		for(unsigned int p=0; p < people; p++){
+			ASSERT_EQ(m.get(1, p), codes[p]) << people << " individuals, individual " << p;
+		}
+	}
+}
+
+TEST(GenotypeMatrix, FlipSwapsAlleles) {
+	GenotypeMatrix m;
+	fillMatrix(m, 1, 10);
+	m.flip(0);
+	const short flipped[5] = {0, 4, 3, 2, 1};
+	for(unsigned int p=0; p < 10; p++){
+		ASSERT_EQ(flipped[p % 5], m.get(0, p)) << "Individual " << p;
+	}
+}
+
+TEST(GenotypeMatrix, AllMissing) {
+	GenotypeMatrix m;
+	m.resize(2, 7);
+	ASSERT_TRUE(m.all_missing(0));
+	m.set(1, 6, 4);
+	ASSERT_FALSE(m.all_missing(1)) << "Genotype in the last, padded byte";
+}
+
+TEST(GenotypeMatrix, KeepPeople) {
+	GenotypeMatrix m;
+	fillMatrix(m, 2, 9);
+	vector<bool> keep(9, true);
+	keep[0] = keep[4] = keep[5] = false;
+	m.keep_people(keep);
+	ASSERT_EQ(6u, m.num_people());
+	const unsigned int kept[6] = {1, 2, 3, 6, 7, 8};
+	for(unsigned int p=0; p < 6; p++){
+		ASSERT_EQ(static_cast<short>((1 + kept[p]) % 5), m.get(1, p)) << "Individual " << p;
+	}
+}
+
+TEST(GenotypeMatrix, KeepSnpsThenPeople) {
+	GenotypeMatrix m;
+	fillMatrix(m, 5, 9);
+	vector<bool> keepSnps(5, true);
+	keepSnps[0] = keepSnps[2] = false;
+	ASSERT_TRUE(m.keep_snps(keepSnps));
+	ASSERT_EQ(3u, m.num_snps());
+
+	vector<bool> keep(9, true);
+	keep[1] = keep[7] = false;
+	m.keep_people(keep);
+	ASSERT_EQ(7u, m.num_people());
+	const unsigned long keptSnps[3] = {1, 3, 4};
+	const unsigned int kept[7] = {0, 2, 3, 4, 5, 6, 8};
+	for(unsigned long s=0; s < 3; s++){
+		for(unsigned int p=0; p < 7; p++){
+			ASSERT_EQ(static_cast<short>((keptSnps[s] + kept[p]) % 5), m.get(s, p)) << "SNP " << s << " individual " << p;
+		}
+	}
+}
+
+TEST(GenotypeMatrix, StreamedKeepsSnps) {
+	GenotypeMatrix m;
+	m.stream(4, 6);
+	m.load_block(2, 2);
+	ASSERT_FALSE(m.keep_snps(vector<bool>(4, false)));
+	ASSERT_EQ(4u, m.num_snps());
+}
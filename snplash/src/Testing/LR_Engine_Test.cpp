@@ -90,6 +90,34 @@ TEST_F(LR_Engine_Test, test_newton_raphson) {
         ASSERT_NEAR(relErr,0.0,NEAR_THRESH);
 }
 
+// One object refit after a fit of another size gives the same answer, and the
+// inverse information at the fitted betas is the one returned by the fit.
+TEST_F(LR_Engine_Test, test_reused_workspace) {
+
+        vector<vector<double> > invInfMatrix = vecops::getDblVec(inMat.size(), inMat.size());
+        vector<double> betas = lr.newtonRaphson(inMat, phenotype, invInfMatrix);
+
+        vector<vector<double> > small(inMat.begin(), inMat.begin() + 2);
+        vector<vector<double> > smallInv = vecops::getDblVec(2, 2);
+        lr.newtonRaphson(small, phenotype, smallInv);
+
+        vector<vector<double> > again = vecops::getDblVec(inMat.size(), inMat.size());
+        vector<double> betasAgain = lr.newtonRaphson(inMat, phenotype, again);
+        for(unsigned int i=0; i < betas.size(); i++){
+            ASSERT_DOUBLE_EQ(betas[i], betasAgain[i]);
+            for(unsigned int j=0; j < betas.size(); j++)
+                ASSERT_DOUBLE_EQ(invInfMatrix[i][j], again[i][j]);
+        }
+
+        vector<vector<double> > fisher;
+        ASSERT_TRUE(lr.invFisherInformation(inMat, betas, fisher));
+        ASSERT_EQ(inMat.size(), fisher.size());
+        for(unsigned int i=0; i < betas.size(); i++){
+            for(unsigned int j=0; j < betas.size(); j++)
+                ASSERT_NEAR(invInfMatrix[i][j], fisher[i][j], NEAR_THRESH * fabs(invInfMatrix[i][j]) + 1e-12);
+        }
+}
+
 TEST_F(LR_Separable_Test, test_separable) {
 
         LogisticRegression lr;
@@ -97,3 +125,35 @@ TEST_F(LR_Separable_Test, test_separable) {
         ASSERT_EQ( separableColumn, 0);
 
 }
+
+// Penalized estimates checked by maximizing l(b) + 1/2 log|I(b)| directly.
+TEST_F(LR_Engine_Test, test_firth) {
+
+        vector<vector<double> > invInfMatrix = vecops::getDblVec(inMat.size(), inMat.size());
+        vector<double> betas = lr.firth(inMat, phenotype, invInfMatrix);
+        ASSERT_NEAR(betas[0], 0.0595162755, 1e-5);
+        ASSERT_NEAR(betas[1], 0.8320934117, 1e-5);
+        ASSERT_NEAR(betas[2], -0.8247038669, 1e-5);
+        ASSERT_NEAR(lr.getFirthLikelihood(), -3.396647541081105, 1e-8);
+        ASSERT_GT(invInfMatrix[1][1], 0);
+}
+
+// The maximum likelihood estimate does not exist; the penalized one does.
+TEST_F(LR_Separable_Test, test_firth_separated) {
+
+        vector<vector<double> > in;
+        in.push_back(vector<double>(response.size(), 1.0));
+        in.push_back(cov[1]);
+        vector<vector<double> > invInfMatrix = vecops::getDblVec(2, 2);
+
+        LogisticRegression lr;
+        ASSERT_ANY_THROW(lr.newtonRaphson(in, response, invInfMatrix));
+
+        vector<double> betas = lr.firth(in, response, invInfMatrix);
+        ASSERT_NEAR(betas[0], 3.6146053423, 1e-5);
+        ASSERT_NEAR(betas[1], -1.0327443771, 1e-5);
+        ASSERT_NEAR(lr.getFirthLikelihood(), -1.1550752093646566, 1e-8);
+        LRStats l = lr.getSingleStats(betas, invInfMatrix, 1);
+        ASSERT_GT(l.pVal, 0);
+        ASSERT_LT(l.pVal, 1);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "../engine/utils/linear_regression.hh"
+
+#define LINREG_NEAR 1e-9
+
+// Residual-like responses for 200 individuals in three genotype classes.
+class LinearRegression_Test : public ::testing::Test {
+
+	protected:
+
+		vector<int> genotype;
+		vector<double> response;
+		ClassSums sums;
+		double mean;
+
+		virtual void SetUp(){
+			unsigned int seed = 29;
+			mean = 0;
+			for(int k=0; k < 3; k++) sums.n[k] = sums.sum[k] = sums.sumSq[k] = 0;
+			for(int i=0; i < 200; i++){
+				seed = seed * 1103515245 + 12345;
+				int g = (seed >> 8) % 3;
+				seed = seed * 1103515245 + 12345;
+				double r = ((seed >> 8) % 1000) / 250.0 - 2 + 0.3 * g;
+				genotype.push_back(g);
+				response.push_back(r);
+				sums.n[g]++;
+				sums.sum[g] += r;
+				sums.sumSq[g] += r * r;
+				mean += r;
+			}
+			mean /= response.size();
+		}
+
+		// The closed form against leastSquares on the expanded column.
+		void expectMatches(const double code[3]){
+			vector<vector<double> > in(2);
+			for(unsigned int i=0; i < genotype.size(); i++){
+				in[0].push_back(1.0);
+				in[1].push_back(code[genotype[i]]);
+			}
+			LinearRegression lr;
+			vector<double> betas = lr.leastSquares(in, response);
+			double sse, ssr;
+			lr.sumSquaredStats(in, betas, response, mean, sse, ssr);
+
+			double csse, cssr, sxx;
+			double beta = lr.classLeastSquares(sums, code, mean, csse, cssr, sxx);
+			ASSERT_NEAR(betas[1], beta, LINREG_NEAR);
+			ASSERT_NEAR(sse, csse, LINREG_NEAR * sse);
+			ASSERT_NEAR(ssr, cssr, LINREG_NEAR * sse);
+
+			double sx = 0, sxsq = 0;
+			for(unsigned int i=0; i < in[1].size(); i++){
+				sx += in[1][i];
+				sxsq += in[1][i] * in[1][i];
+			}
+			double n = in[1].size();
+			ASSERT_NEAR((sxsq - sx * sx / n) / n, sxx, LINREG_NEAR);
+		}
+};
+
+TEST_F(LinearRegression_Test, ClassLeastSquares) {
+	double add[3] = {-1, 0, 1};
+	double dom[3] = {0, 1, 1};
+	double rec[3] = {0, 0, 1};
+	double lof[3] = {1, -2, 1};
+	expectMatches(add);
+	expectMatches(dom);
+	expectMatches(rec);
+	expectMatches(lof);
+}
+
+// With no aa individuals the recessive column is constant.
+TEST_F(LinearRegression_Test, ClassLeastSquaresSingular) {
+	sums.n[2] = sums.sum[2] = sums.sumSq[2] = 0;
+	double rec[3] = {0, 0, 1};
+	double sse, ssr, sxx;
+	LinearRegression lr;
+	ASSERT_THROW(lr.classLeastSquares(sums, rec, mean, sse, ssr, sxx), LinearRegressionException);
+}
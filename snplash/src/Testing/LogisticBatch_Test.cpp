@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include "../engine/utils/logistic_batch.hh"
+#include "../engine/utils/lr.hh"
+#include "../engine/utils/vecops.hh"
+
+#define BATCH_NEAR 1e-6
+
+// Two covariates, a genotype coded -1/0/1 and a response that depends on all three.
+class LogisticBatch_Test : public ::testing::Test {
+
+	protected:
+
+		vector<vector<double> > cov;
+		vector<double> add, dom, response, ones;
+
+		virtual void SetUp(){
+			cov.assign(2, vector<double>());
+			unsigned int seed = 17;
+			for(int i=0; i < 300; i++){
+				seed = seed * 1103515245 + 12345;
+				double u = ((seed >> 8) % 1000) / 1000.0;
+				seed = seed * 1103515245 + 12345;
+				int g = (seed >> 8) % 3 - 1;
+				double age = (i % 37) / 10.0;
+				double sex = i % 2;
+				cov[0].push_back(age);
+				cov[1].push_back(sex);
+				add.push_back(g);
+				dom.push_back(g >= 0 ? 1 : 0);
+				ones.push_back(1.0);
+				double eta = -0.8 + 0.3 * age - 0.4 * sex + 0.5 * g;
+				response.push_back(u < 1 / (1 + exp(-eta)) ? 1 : 0);
+			}
+		}
+
+		// Fit cov, ones, then the given columns with LogisticRegression.
+		vector<double> fitAlone(const vector<double> &a, const vector<double> *b, vector<vector<double> > &invInf){
+			vector<vector<double> > in(cov);
+			if(b != NULL){
+				in.push_back(a);
+				in.push_back(ones);
+				in.push_back(*b);
+			}else{
+				in.push_back(ones);
+				in.push_back(a);
+			}
+			invInf = vecops::getDblVec(in.size(), in.size());
+			LogisticRegression lr;
+			return lr.newtonRaphson(in, response, invInf);
+		}
+};
+
+TEST_F(LogisticBatch_Test, MatchesNewtonRaphson) {
+
+	LogisticNullModel null;
+	ASSERT_TRUE(null.fit(cov, response));
+	ASSERT_EQ(3u, null.get_betas().size());
+
+	LogisticBatch batch;
+	batch.set_base(cov, response, null.get_betas());
+	int a = batch.add_model(add);
+	int d = batch.add_model(dom);
+	int lof = batch.add_model(add, dom);
+	batch.fit();
+	ASSERT_TRUE(batch.converged(a));
+	ASSERT_TRUE(batch.converged(d));
+	ASSERT_TRUE(batch.converged(lof));
+
+	vector<vector<double> > invInf;
+	vector<double> betas = fitAlone(add, NULL, invInf);
+	ASSERT_NEAR(betas[3], batch.snp_betas(a)[0], BATCH_NEAR);
+	ASSERT_NEAR(invInf[3][3], batch.snp_inv_inf(a)[0][0], BATCH_NEAR);
+	vector<double> all = batch.betas(a);
+	for(int i=0; i < 3; i++){
+		ASSERT_NEAR(betas[i], all[i], BATCH_NEAR);
+	}
+
+	betas = fitAlone(dom, NULL, invInf);
+	ASSERT_NEAR(betas[3], batch.snp_betas(d)[0], BATCH_NEAR);
+	ASSERT_NEAR(invInf[3][3], batch.snp_inv_inf(d)[0][0], BATCH_NEAR);
+
+	// cov, add, ones, dom: the SNP block is rows and columns 2 and 4.
+	betas = fitAlone(add, &dom, invInf);
+	ASSERT_NEAR(betas[2], batch.snp_betas(lof)[0], BATCH_NEAR);
+	ASSERT_NEAR(betas[4], batch.snp_betas(lof)[1], BATCH_NEAR);
+	ASSERT_NEAR(invInf[2][2], batch.snp_inv_inf(lof)[0][0], BATCH_NEAR);
+	ASSERT_NEAR(invInf[2][4], batch.snp_inv_inf(lof)[0][1], BATCH_NEAR);
+	ASSERT_NEAR(invInf[4][4], batch.snp_inv_inf(lof)[1][1], BATCH_NEAR);
+}
+
+// A SNP column that copies a covariate leaves the information matrix singular.
+TEST_F(LogisticBatch_Test, FlagsSingularModel) {
+	LogisticBatch batch;
+	batch.set_base(cov, response, vector<double>());
+	int bad = batch.add_model(cov[1]);
+	int good = batch.add_model(add);
+	batch.fit();
+	ASSERT_FALSE(batch.converged(bad));
+	ASSERT_TRUE(batch.converged(good));
+}
+
+// A column already in the null model has no score and no variance left; the
+// additive score is close to the Wald test.
+TEST_F(LogisticBatch_Test, ScoreAgainstNull) {
+	LogisticNullModel null;
+	ASSERT_TRUE(null.fit(cov, response));
+
+	vector<unsigned int> rows;
+	for(unsigned int i=0; i < response.size(); i++) rows.push_back(i);
+	const vector<double> *cols[2];
+	double u[2], v[4];
+
+	cols[0] = &cov[1];
+	null.score(rows, cols, 1, u, v);
+	ASSERT_NEAR(0, u[0], BATCH_NEAR);
+	ASSERT_NEAR(0, v[0], BATCH_NEAR);
+
+	cols[0] = &add;
+	null.score(rows, cols, 1, u, v);
+	vector<vector<double> > invInf;
+	vector<double> betas = fitAlone(add, NULL, invInf);
+	double wald = betas[3] * betas[3] / invInf[3][3];
+	ASSERT_NEAR(wald, u[0] * u[0] / v[0], 0.1 * wald);
+	ASSERT_NEAR(betas[3], u[0] / v[0], 0.1);
+
+	// Two columns: v is symmetric and its diagonal matches the single column runs.
+	cols[1] = &dom;
+	double u2[2], v2[4];
+	null.score(rows, cols, 2, u2, v2);
+	ASSERT_NEAR(u[0], u2[0], BATCH_NEAR);
+	ASSERT_NEAR(v[0], v2[0], BATCH_NEAR);
+	ASSERT_NEAR(v2[1], v2[2], BATCH_NEAR);
+}
+
+// Individuals missing at the SNP, mostly the older ones: the score must be
+// adjusted for the covariates over the rest.  It should then agree with the
+// score against a null model refit on those individuals, and be close to
+// the Wald test of the full fit.
+TEST_F(LogisticBatch_Test, ScoreWithMissingGenotypes) {
+	LogisticNullModel null;
+	ASSERT_TRUE(null.fit(cov, response));
+
+	vector<unsigned int> rows;
+	vector<vector<double> > subCov(2);
+	vector<double> subAdd, subDom, subResponse;
+	for(unsigned int i=0; i < response.size(); i++){
+		if(cov[0][i] > 2.0 && i % 3 != 0) continue;
+		rows.push_back(i);
+		subCov[0].push_back(cov[0][i]);
+		subCov[1].push_back(cov[1][i]);
+		subAdd.push_back(add[i]);
+		subDom.push_back(dom[i]);
+		subResponse.push_back(response[i]);
+	}
+	ASSERT_LT(rows.size(), response.size());
+
+	LogisticNullModel subNull;
+	ASSERT_TRUE(subNull.fit(subCov, subResponse));
+	vector<unsigned int> subRows;
+	for(unsigned int i=0; i < rows.size(); i++) subRows.push_back(i);
+
+	const vector<double> *cols[2] = {&subAdd, &subDom};
+	double u[2], v[4], refU[2], refV[4];
+	ASSERT_TRUE(null.score(rows, cols, 2, u, v));
+	ASSERT_TRUE(subNull.score(subRows, cols, 2, refU, refV));
+	for(int c=0; c < 2; c++){
+		ASSERT_NEAR(refU[c], u[c], 0.05 * sqrt(refV[c * 3]));
+	}
+	for(int c=0; c < 4; c++){
+		ASSERT_NEAR(refV[c], v[c], 0.05 * refV[0]);
+	}
+
+	vector<vector<double> > in(subCov);
+	vector<double> ones(rows.size(), 1.0);
+	in.push_back(ones);
+	in.push_back(subAdd);
+	vector<vector<double> > invInf = vecops::getDblVec(in.size(), in.size());
+	LogisticRegression lr;
+	vector<double> betas = lr.newtonRaphson(in, subResponse, invInf);
+	ASSERT_TRUE(null.score(rows, cols, 1, u, v));
+	double wald = betas[3] * betas[3] / invInf[3][3];
+	ASSERT_NEAR(wald, u[0] * u[0] / v[0], 0.1 * wald);
+	ASSERT_NEAR(betas[3], u[0] / v[0], 0.1);
+}
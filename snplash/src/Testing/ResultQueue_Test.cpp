@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <cstdio>
+#include "../engine/output/output.h"
+#include "../engine/output/result_queue.hh"
+
+// Formats each number as a line of the file.
+class NumberSink : public ResultSink<long> {
+	public:
+		Output out;
+		void consume(const long &n, long){
+			stringstream ss;
+			ss << n << endl;
+			out.write_line(ss.str());
+		}
+};
+
+// Several rings' worth of records, each thread taking every fourth one, must
+// come out in order.  Threads that get ahead wait for the writer.
+TEST(ResultQueue, OrdersRecordsFromThreads) {
+	const char *name = "result_queue_test.tmp";
+	const long lines = 3 * RESULT_QUEUE_SIZE + 7;
+	{
+		NumberSink sink;
+		ASSERT_TRUE(sink.out.init(name));
+		sink.out.write_header("header\n");
+		ResultQueue<long> queue;
+		ASSERT_TRUE(queue.start(&sink));
+		#pragma omp parallel for schedule(static, 1) num_threads(4)
+		for(long i=0; i < lines; i++){
+			queue.push(i, i);
+		}
+		queue.stop();
+		sink.out.close();
+	}
+
+	ifstream in(name);
+	string line;
+	getline(in, line);
+	ASSERT_EQ("header", line);
+	long n = 0;
+	while(getline(in, line)){
+		stringstream ss;
+		ss << n;
+		ASSERT_EQ(ss.str(), line);
+		n++;
+	}
+	ASSERT_EQ(lines, n);
+	remove(name);
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include "../engine/snp_scheduler.hh"
+
+// Every SNP in the window is handed out exactly once, including when the
+// queues are drained by fewer threads than they were filled for, which
+// forces the others' work to be stolen.
+TEST(SnpScheduler, HandsOutEachSnpOnce) {
+	SnpScheduler sched(4);
+	vector<int> cost(100, 1);
+	cost[3] = 50;
+	cost[60] = 50;
+	sched.fill(10, 110, cost);
+
+	vector<int> seen(110, 0);
+	int i;
+	while(sched.next(1, i)){
+		ASSERT_GE(i, 10);
+		ASSERT_LT(i, 110);
+		seen[i]++;
+	}
+	for(int s=10; s < 110; s++){
+		ASSERT_EQ(1, seen[s]);
+	}
+	ASSERT_FALSE(sched.next(0, i));
+}
+
+TEST(SnpScheduler, ParallelDrain) {
+	int threads = 4;
+	SnpScheduler sched(threads);
+	vector<int> cost(1000, 1);
+	sched.fill(0, 1000, cost);
+
+	vector<int> seen(1000, 0);
+	#pragma omp parallel num_threads(threads)
+	{
+		int i;
+		while(sched.next(SnpScheduler::thread_id(), i)){
+			#pragma omp atomic
+			seen[i]++;
+		}
+	}
+	for(int s=0; s < 1000; s++){
+		ASSERT_EQ(1, seen[s]);
+	}
+}
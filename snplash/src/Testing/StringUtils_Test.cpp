@@ -14,6 +14,42 @@ TEST(StringPadding, HandlesFrontAndBackPadding) {
 	ASSERT_STREQ("  test",s.c_str()) << "Test of format string with left padding"; 
 }
 
+// The layouts below are what the output files have always contained, including
+// the odd ones, so they must not change.
+TEST(SpacedNumber, KeepsExistingLayout) {
+	ASSERT_STREQ(" 0.0500000000", strnutils::spaced_number(0.05, 12, 10, 1).c_str());
+	ASSERT_STREQ("2.34e-13", strnutils::spaced_number(.000000000000234, 8, 4, 0).c_str());
+	ASSERT_STREQ(" 1.500000e-20", strnutils::spaced_number(1.5e-20, 12, 10, 1).c_str());
+	ASSERT_STREQ("   -3.25000", strnutils::spaced_number(-3.25, 10, 5, 1).c_str());
+	ASSERT_STREQ(" 123456", strnutils::spaced_number(123456.0, 7, 4, 1).c_str());
+	ASSERT_STREQ(" -123456.000000", strnutils::spaced_number(-123456.0, 7, 4, 1).c_str());
+	ASSERT_STREQ("     0.00", strnutils::spaced_number(0.0, 8, 2, 1).c_str());
+	ASSERT_STREQ("   2", strnutils::spaced_number(2.0, 4, 0, 1).c_str());
+	ASSERT_STREQ("100.00", strnutils::spaced_number(99.999, 5, 2, 0).c_str());
+
+	ASSERT_STREQ("       42", strnutils::spaced_number(42, 8, 1).c_str());
+	ASSERT_STREQ("      -42", strnutils::spaced_number(-42, 8, 1).c_str());
+	ASSERT_STREQ("99999", strnutils::spaced_number(1234567, 5, 0).c_str());
+	ASSERT_STREQ("     0", strnutils::spaced_number(0, 6, 0).c_str());
+}
+
+TEST(SpacedNumber, AppendMatchesSpaced) {
+	std::string line = "x";
+	strnutils::append_spaced_string(line, "rs1", 8, 2);
+	strnutils::append_spaced_number(line, -17, 6, 1);
+	strnutils::append_spaced_number(line, 3.5e-9, 12, 10, 1);
+	strnutils::append_spaced_number(line, 0.123456, 7, 4, 1);
+	strnutils::append_number(line, -2147483647 - 1);
+
+	std::string expected = "x";
+	expected += strnutils::spaced_string("rs1", 8, 2);
+	expected += strnutils::spaced_number(-17, 6, 1);
+	expected += strnutils::spaced_number(3.5e-9, 12, 10, 1);
+	expected += strnutils::spaced_number(0.123456, 7, 4, 1);
+	expected += "-2147483648";
+	ASSERT_EQ(expected, line);
+}
+
 TEST(IntegerLog, IntLogCorrect) {
 	ASSERT_EQ(0,strnutils::int_log(0)) << "Test of log(0)";
 	ASSERT_EQ(0,strnutils::int_log(1)) << "Test of log(1)";	
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "../engine/tile_grid.hh"
+
+using namespace std;
+
+// Walk the grid the way InterTwoLog does and record each pair's number.
+static long walk(TileGrid &grid, int snps, vector<long> &number){
+	number.assign(snps * snps, -1);
+	long seen = 0;
+	int t;
+	long order;
+	while(grid.next(t, order)){
+		int i0, i1, j0, j1;
+		grid.bounds(t, i0, i1, j0, j1);
+		for(int i=i0; i < i1; i++){
+			for(int j=max(j0, i+1); j < j1; j++, order++){
+				EXPECT_EQ(-1, number[i * snps + j]) << "pair " << i << " " << j << " seen twice";
+				number[i * snps + j] = order;
+				seen++;
+			}
+		}
+	}
+	return seen;
+}
+
+TEST(TileGrid, CoversEachPairOnce) {
+	const int snps = 23;
+	TileGrid grid(snps, 5);
+	ASSERT_EQ(15, grid.num_tiles());
+	long pairs = grid.plan();
+	ASSERT_EQ(snps * (snps - 1) / 2, pairs);
+
+	vector<long> number;
+	ASSERT_EQ(pairs, walk(grid, snps, number));
+
+	// Every pair numbered, the numbers 0 .. pairs-1 each used once.
+	vector<int> used(pairs, 0);
+	for(int i=0; i < snps; i++){
+		for(int j=i+1; j < snps; j++){
+			long n = number[i * snps + j];
+			ASSERT_TRUE(n >= 0 && n < pairs);
+			used[n]++;
+		}
+	}
+	for(long n=0; n < pairs; n++) ASSERT_EQ(1, used[n]);
+}
+
+TEST(TileGrid, OneTileIsFileOrder) {
+	const int snps = 10;
+	TileGrid grid(snps, 64);
+	ASSERT_EQ(1, grid.num_tiles());
+	grid.plan();
+
+	vector<long> number;
+	walk(grid, snps, number);
+	long expected = 0;
+	for(int i=0; i < snps; i++){
+		for(int j=i+1; j < snps; j++){
+			ASSERT_EQ(expected++, number[i * snps + j]);
+		}
+	}
+}
+
+TEST(TileGrid, ResumeStartsAtPair) {
+	const int snps = 12;
+	TileGrid full(snps, 4);
+	full.plan();
+	vector<long> before;
+	walk(full, snps, before);
+
+	// Tiles 0 and 1 hold pairs 0 .. 21; resume after pair 25, in tile 2.
+	TileGrid grid(snps, 4);
+	ASSERT_EQ(6, grid.num_tiles());
+	ASSERT_EQ(6 + 16, grid.num_pairs(0) + grid.num_pairs(1));
+	ASSERT_EQ(snps * (snps - 1) / 2, grid.plan(25));
+
+	int t;
+	long first;
+	ASSERT_TRUE(grid.next(t, first));
+	ASSERT_EQ(2, t);
+	ASSERT_EQ(22, first);
+
+	// The numbers are those of the full run.
+	grid.plan(25);
+	vector<long> after;
+	walk(grid, snps, after);
+	for(int i=0; i < snps; i++){
+		for(int j=i+1; j < snps; j++){
+			long n = before[i * snps + j];
+			if(n < 22){
+				ASSERT_EQ(-1, after[i * snps + j]);
+			}else{
+				ASSERT_EQ(n, after[i * snps + j]);
+			}
+		}
+	}
+
+	// Nothing left once every pair is done.
+	grid.plan(snps * (snps - 1) / 2);
+	ASSERT_FALSE(grid.next(t, first));
+}
+
+TEST(TileGrid, RowStripsAreFileOrder) {
+	const int snps = 23;
+	TileGrid grid(snps, 1, 5);
+	long pairs = grid.plan();
+	ASSERT_EQ(snps * (snps - 1) / 2, pairs);
+
+	vector<long> number;
+	ASSERT_EQ(pairs, walk(grid, snps, number));
+	long expected = 0;
+	for(int i=0; i < snps; i++){
+		for(int j=i+1; j < snps; j++){
+			ASSERT_EQ(expected++, number[i * snps + j]) << "pair " << i << " " << j;
+		}
+	}
+	for(int t=0; t < grid.num_tiles(); t++) ASSERT_LT(0, grid.num_pairs(t));
+}
+
+TEST(TileGrid, BandsAreFileOrder) {
+	const int snps = 23;
+	TileGrid grid(snps, 5);
+	long pairs = grid.plan(30);
+	ASSERT_EQ(snps * (snps - 1) / 2, pairs);
+
+	// Square tiles, numbered by band: pair (i, j) is the (i, j)th in file order.
+	vector<long> number(snps * snps, -1);
+	int first, last;
+	long start, expectedStart = 0;
+	while(grid.next_band(first, last, start)){
+		ASSERT_EQ(expectedStart, start);
+		for(int t=first; t < last; t++){
+			int i0, i1, j0, j1;
+			grid.bounds(t, i0, i1, j0, j1);
+			for(int i=i0; i < i1; i++){
+				for(int j=max(j0, i+1); j < j1; j++){
+					EXPECT_EQ(-1, number[i * snps + j]);
+					number[i * snps + j] = start + grid.band_pair(i, j);
+				}
+			}
+			expectedStart += grid.num_pairs(t);
+		}
+	}
+	ASSERT_EQ(pairs, expectedStart);
+
+	long expected = 0;
+	for(int i=0; i < snps; i++){
+		for(int j=i+1; j < snps; j++){
+			ASSERT_EQ(expected++, number[i * snps + j]) << "pair " << i << " " << j;
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "../engine/top_pairs.hh"
+
+struct TestPair {
+	int index1, index2;
+	double p;
+};
+
+struct SmallerP {
+	bool operator()(const TestPair &a, const TestPair &b) const {
+		if(a.p != b.p) return a.p < b.p;
+		return ByPair<TestPair>()(a, b);
+	}
+};
+
+// Pairs (i, j) for i < j < 40 with p values in a scrambled order, some tied.
+static void pairs(vector<TestPair> &all){
+	for(int i=0;i < 40;i++){
+		for(int j=i+1;j < 40;j++){
+			TestPair t;
+			t.index1 = i;
+			t.index2 = j;
+			t.p = ((i * 37 + j * 11) % 101) / 101.0;
+			all.push_back(t);
+		}
+	}
+}
+
+TEST(TopPairs, KeepsBestAcrossThreads) {
+	vector<TestPair> all;
+	pairs(all);
+
+	TopPairs<TestPair, SmallerP> top(3, 25);
+	for(unsigned int i=0;i < all.size();i++) top.offer(i % 3, all[i]);
+	vector<TestPair> got;
+	top.merge(got);
+
+	sort(all.begin(), all.end(), SmallerP());
+	ASSERT_EQ(25u, got.size());
+	for(unsigned int i=0;i < got.size();i++){
+		ASSERT_EQ(all[i].index1, got[i].index1);
+		ASSERT_EQ(all[i].index2, got[i].index2);
+	}
+}
+
+TEST(TopPairs, NoLimitKeepsAll) {
+	vector<TestPair> all;
+	pairs(all);
+
+	TopPairs<TestPair, SmallerP> top(2, 0);
+	for(unsigned int i=0;i < all.size();i++) top.offer(i % 2, all[i]);
+	vector<TestPair> got;
+	top.merge(got);
+	ASSERT_EQ(all.size(), got.size());
+
+	sort(got.begin(), got.end(), ByPair<TestPair>());
+	for(unsigned int i=0;i < got.size();i++){
+		ASSERT_EQ(all[i].index1, got[i].index1);
+		ASSERT_EQ(all[i].index2, got[i].index2);
+	}
+}
@@ -20,7 +20,7 @@ public:
 
 	virtual void classify(int a[4]) = 0; // Run test on the actual data.
     virtual void classify(int a[4], SnpData *) = 0; // Run test on passed data.
-    virtual int classify(vector<short> &) = 0; // Run test on single instance.
+    virtual int classify(const GenotypeRow &) = 0; // Run test on single instance.
 	
 };
 
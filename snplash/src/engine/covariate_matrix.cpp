@@ -0,0 +1,128 @@
+/*
+ *      covariate_matrix.cpp
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+#include "covariate_matrix.hh"
+#include <limits>
+
+/**
+ * Store the covariates, transposing them into columns.
+ *
+ * @param rows people*columns values, all covariates for the first individual first.
+ * @param people Number of individuals.
+ * @param columns Number of covariates.
+ */
+void CovariateMatrix::assign_rows(const vector<double> &rows, unsigned int people, unsigned int columns){
+	this->people = people;
+	this->columns = columns;
+	values.assign(static_cast<size_t>(people) * columns, 0);
+	for(unsigned int p=0; p < people; p++){
+		for(unsigned int c=0; c < columns; c++){
+			values[static_cast<size_t>(c) * people + p] = rows[static_cast<size_t>(p) * columns + c];
+		}
+	}
+	find_present();
+}
+
+/**
+ * Store the covariates as they are laid out here, one column after another.
+ *
+ * @param cols people*columns values.
+ * @param people Number of individuals.
+ * @param columns Number of covariates.
+ */
+void CovariateMatrix::assign_columns(const double *cols, unsigned int people, unsigned int columns){
+	this->people = people;
+	this->columns = columns;
+	values.assign(cols, cols + static_cast<size_t>(people) * columns);
+	find_present();
+}
+
+void CovariateMatrix::clear(){
+	people = columns = 0;
+	values.clear();
+	present.clear();
+}
+
+/**
+ * Flag the individuals with every covariate present.
+ */
+void CovariateMatrix::find_present(){
+	present.assign(people, true);
+	for(unsigned int c=0; c < columns; c++){
+		const double *col = column(c);
+		for(unsigned int p=0; p < people; p++){
+			if(col[p] == numeric_limits<double>::max()){
+				present[p] = false;
+			}
+		}
+	}
+}
+
+/**
+ * Remove individuals.  Each column is compacted in place.
+ *
+ * @param keep One flag per individual.
+ */
+void CovariateMatrix::keep_people(const vector<bool> &keep){
+	unsigned int kept = 0;
+	for(unsigned int p=0; p < people; p++){
+		if(keep[p]) kept++;
+	}
+	if(kept == people){
+		return;
+	}
+
+	vector<double> new_values(static_cast<size_t>(kept) * columns);
+	for(unsigned int c=0; c < columns; c++){
+		const double *from = column(c);
+		size_t to = static_cast<size_t>(c) * kept;
+		for(unsigned int p=0; p < people; p++){
+			if(keep[p]) new_values[to++] = from[p];
+		}
+	}
+	values.swap(new_values);
+
+	vector<bool> new_present;
+	new_present.reserve(kept);
+	for(unsigned int p=0; p < people; p++){
+		if(keep[p]) new_present.push_back(present[p]);
+	}
+	present.swap(new_present);
+	people = kept;
+}
+
+/**
+ * Build the covariate part of a design matrix.  Existing storage in out is
+ * reused, so calling this once per SNP with the same vector does not allocate.
+ *
+ * @param rows Individuals to take, in order.
+ * @param out Resized to one vector per covariate.
+ */
+void CovariateMatrix::gather(const vector<unsigned int> &rows, vector<vector<double> > &out) const {
+	out.resize(columns);
+	for(unsigned int c=0; c < columns; c++){
+		const double *col = column(c);
+		vector<double> &o = out[c];
+		o.resize(rows.size());
+		for(unsigned int i=0; i < rows.size(); i++){
+			o[i] = col[rows[i]];
+		}
+	}
+}
@@ -0,0 +1,78 @@
+/*
+ *      covariate_matrix.hh
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef COVARIATE_MATRIX_H
+#define COVARIATE_MATRIX_H
+
+/**
+ * Contiguous, column-major storage for the covariates.
+ *
+ * All values live in one block, one column per covariate, so column c for
+ * every individual is column(c)[0 .. num_people()-1].  The tests build their
+ * design matrices one covariate at a time from the individuals that are not
+ * missing at a SNP, which is a gather from each column (see gather()).
+ *
+ * Missing values are numeric_limits<double>::max(), as in the readers.
+ * Whether an individual has every covariate is worked out once when the
+ * data is stored (see complete()).
+ */
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+class CovariateMatrix {
+
+	public:
+		CovariateMatrix() : people(0), columns(0) {}
+
+		/* Store people x columns values given one individual at a time (row-major). */
+		void assign_rows(const vector<double> &rows, unsigned int people, unsigned int columns);
+		/* Store people x columns values already in columns. */
+		void assign_columns(const double *cols, unsigned int people, unsigned int columns);
+		void clear();
+
+		unsigned int num_people() const {return people;}
+		unsigned int num_covariates() const {return columns;}
+
+		double at(unsigned int person, unsigned int c) const {return values[c * people + person];}
+		/* All individuals for one covariate. */
+		const double *column(unsigned int c) const {return values.empty() ? NULL : &values[static_cast<size_t>(c) * people];}
+		/* True if the individual has no missing covariate. */
+		bool complete(unsigned int person) const {return present[person];}
+
+		/* Compact the matrix, keeping only individuals flagged true. */
+		void keep_people(const vector<bool> &keep);
+
+		/* Fill out with one vector per covariate holding the values for the listed individuals. */
+		void gather(const vector<unsigned int> &rows, vector<vector<double> > &out) const;
+
+	protected:
+		unsigned int people;
+		unsigned int columns;
+		vector<double> values;
+		vector<bool> present;
+
+		void find_present();
+};
+
+#endif
@@ -60,6 +60,13 @@ void Dandelion::init(){
 		//exit(0);
 	}
 
+	SnpDataCache cache(param_reader);
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		delete reader;
+		numFinalPhen = data->pheno_size();
+		return;
+	}
+
 	reader->process(data->getDataObject(), param_reader);
 
 	numInitSNPs = data->geno_size();
@@ -89,6 +96,7 @@ void Dandelion::init(){
 	}
 
 	numFinalPhen = data->pheno_size();
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 }
 
 /*
@@ -203,29 +211,23 @@ void Dandelion::runSet(int begin, int end){
 	vector<double> phen_nonmissing;
 	vector<vector<double> > cov;
 
-	/* Prep covariate matrix */
-	vector<double> *tmp = data->get_covariates(0);
-	if(tmp != NULL){
-		for(unsigned int i=0;i<tmp->size();i++){
-			vector<double> a;
-			cov.push_back(a);
-		}
-	}
+	vector<unsigned int> used; // Every individual.
 
 	vector<short> vCn, vCb, vCs; // temp vectors for each type.
 
 	for(int s1 = begin; s1 <= end; s1++){
 
 		if(data->getDataObject()->isUsable(s1)){
+			GenotypeColumn col = data->get_snp(s1);
 			for(int i=0; i<data->pheno_size(); i++ ){
 				// push onto stacks depending on the case/cntrl status.
 
 				if ( equal(data->get_phenotype(i) , 1)){
-					vCn.push_back( data->get_data(i)->at(s1) );
-					vCb.push_back( data->get_data(i)->at(s1) );
+					vCn.push_back( col.at(i) );
+					vCb.push_back( col.at(i) );
 				}else if( equal(data->get_phenotype(i) , 2)){
-					vCs.push_back( data->get_data(i)->at(s1) );
-					vCb.push_back( data->get_data(i)->at(s1) );
+					vCs.push_back( col.at(i) );
+					vCb.push_back( col.at(i) );
 				}
 			}
 
@@ -240,14 +242,9 @@ void Dandelion::runSet(int begin, int end){
 
 	for(int i=0;i < data->pheno_size();++i){
 		phen_nonmissing.push_back(data->get_phenotype(i)-1);
-
-		vector<double> *t = data->get_covariates(i);
-		if(t != NULL){
-			for(unsigned int j=0;j<t->size();j++){
-				cov.at(j).push_back(t->at(j));
-			}
-		}
+		used.push_back(i);
 	}
+	data->get_covariates(used, cov);
 
 	// Data was set up.  Run and get each hap freq.
 	EM *emCs, *emCn, *emCb;
@@ -50,22 +50,163 @@ void DataAccess::setRedirectBootstrap(){
 	for(unsigned int i=0;i < data->phenotypes.size();i++){
 		redirect.push_back(static_cast<int>(data->random.get() * static_cast<double>(data->phenotypes.size())));
 	}
-	
+	summarize_view();
 }
 
 /**
- * Return all SNPs for a single individual in form of a pointer.
+ * View an arbitrary subset of the individuals.
+ *
+ * @param people Individuals of the full data set, in the order to present them.
+ */
+void DataAccess::setRedirect(const vector<unsigned int> &people){
+	uses_redirect = true;
+	redirect = people;
+	summarize_view();
+}
+
+/**
+ * View a cross-validation fold, or everything but the fold.
+ *
+ * @param fold_of Fold of each individual (see make_folds).
+ * @param fold The fold.
+ * @param in_fold true for the individuals in the fold (testing), false for the rest (training).
+ */
+void DataAccess::setRedirectFold(const vector<int> &fold_of, int fold, bool in_fold){
+	uses_redirect = true;
+	redirect.clear();
+	for(unsigned int i=0; i < fold_of.size(); i++){
+		if((fold_of[i] == fold) == in_fold){
+			redirect.push_back(i);
+		}
+	}
+	summarize_view();
+}
+
+/**
+ * View one phenotype class, such as the cases.
+ *
+ * @param value The phenotype.
+ */
+void DataAccess::setRedirectPhenotype(double value){
+	uses_redirect = true;
+	redirect.clear();
+	for(unsigned int i=0; i < data->phenotypes.size(); i++){
+		if(equal(data->phenotypes[i], value)){
+			redirect.push_back(i);
+		}
+	}
+	summarize_view();
+}
+
+void DataAccess::clearRedirect(){
+	uses_redirect = false;
+	redirect.clear();
+	multiplicity.clear();
+	phenotype_counts.clear();
+}
+
+/**
+ * Assign each individual to a fold.  Fold sizes differ by at most one.
+ *
+ * @param folds Number of folds.
+ * @param fold_of Filled with the fold of each individual.
+ */
+void DataAccess::make_folds(int folds, vector<int> &fold_of){
+	unsigned int n = data->phenotypes.size();
+	fold_of.resize(n);
+	for(unsigned int i=0; i < n; i++){
+		fold_of[i] = i % folds;
+	}
+	// Shuffle.
+	for(unsigned int i=n; i > 1; i--){
+		unsigned int j = static_cast<unsigned int>(data->random.get() * i);
+		if(j >= i) j = i - 1;
+		swap(fold_of[i-1], fold_of[j]);
+	}
+}
+
+/**
+ * Count how often each individual appears and how many of each phenotype
+ * there are, so engines do not have to scan the view for them.
+ */
+void DataAccess::summarize_view(){
+	multiplicity.assign(data->phenotypes.size(), 0);
+	vector<double> phen(redirect.size());
+	for(unsigned int i=0; i < redirect.size(); i++){
+		multiplicity.at(redirect[i])++;
+		phen[i] = data->phenotypes[redirect[i]];
+	}
+
+	sort(phen.begin(), phen.end());
+	phenotype_counts.clear();
+	for(unsigned int i=0; i < phen.size(); i++){
+		if(phenotype_counts.empty() || !equal(phenotype_counts.back().first, phen[i])){
+			phenotype_counts.push_back(make_pair(phen[i], 0));
+		}
+		phenotype_counts.back().second++;
+	}
+}
+
+/**
+ * @param person Individual of the full data set.
+ * @return Number of times the individual is in the view (0 if it is left out).
+ */
+unsigned int DataAccess::times_in_view(int person){
+	if(uses_redirect){
+		return multiplicity.at(person);
+	}
+	return 1;
+}
+
+/**
+ * @param value The phenotype.
+ * @return Number of individuals in the view with that phenotype.
+ */
+int DataAccess::count_phenotype(double value){
+	int count = 0;
+	if(uses_redirect){
+		for(unsigned int k=0; k < phenotype_counts.size(); k++){
+			if(equal(phenotype_counts[k].first, value)){
+				count += phenotype_counts[k].second;
+			}
+		}
+	}else{
+		for(unsigned int i=0; i < data->phenotypes.size(); i++){
+			if(equal(data->phenotypes[i], value)) count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * Return all SNPs for a single individual.
  * If this DataAccess object uses redirection, then the method figures out
  * which individual to actually return.
  *
  * @param i  The individual whose data is returned
- * @return vector<short> *  A pointer to the vector of data for the individual queried. 
+ * @return GenotypeRow  A view of the data for the individual queried. 
+ */
+GenotypeRow DataAccess::get_data(int i){
+	if(uses_redirect){
+		return data->get_row(redirect.at(i));
+	}else{
+		return data->get_row(i);
+	}
+}
+
+/**
+ * Return a single SNP for all individuals.  The genotypes are stored by
+ * SNP, so walking the result is contiguous.  Redirection is applied by the
+ * returned view.
+ *
+ * @param snp  The SNP to return
+ * @return GenotypeColumn  A view of the SNP, indexed by individual.
  */
-vector<short> * DataAccess::get_data(int i){
+GenotypeColumn DataAccess::get_snp(int snp){
 	if(uses_redirect){
-		return data->get_column(redirect.at(i));
+		return data->get_column(snp, &redirect);
 	}else{
-		return data->get_column(i);
+		return data->get_column(snp);
 	}
 }
 
@@ -92,7 +233,7 @@ int DataAccess::pheno_size(){
  * @return int Number of SNPs.
  */
 int DataAccess::geno_size(){
-	return data->snp_size(0);
+	return data->snp_size();
 }
 
 /**
@@ -103,12 +244,26 @@ string DataAccess::get_person_ID(int i){
 	return data->individualName[i];
 }
 
-/* Return covariates for an individual. */
-vector<double> * DataAccess::get_covariates(int i){
+/* Return the number of covariates. */
+int DataAccess::num_covariates(){
+	return data->covariates.num_covariates();
+}
+
+/**
+ * Build the covariate columns of a design matrix.
+ *
+ * @param people Individuals to use, in order.
+ * @param cov Filled with one vector per covariate.  Its storage is reused.
+ */
+void DataAccess::get_covariates(const vector<unsigned int> &people, vector<vector<double> > &cov){
 	if(uses_redirect){
-		return data->covariate_column(redirect.at(i));
+		vector<unsigned int> rows(people.size());
+		for(unsigned int i=0; i < people.size(); i++){
+			rows[i] = redirect.at(people[i]);
+		}
+		data->covariates.gather(rows, cov);
 	}else{
-		return data->covariate_column(i);
+		data->covariates.gather(people, cov);
 	}
 }
 
@@ -24,6 +24,11 @@
  * accessors (generally, engines.) 
  * 
  * Utilize an optional permutation vector for redirection. 
+ *
+ * A redirected DataAccess is a view: a bootstrap sample, a cross-validation
+ * fold or one phenotype class of the shared SnpData.  It holds only the
+ * index vector and a few counts, so many engines can each have their own
+ * view of a single copy of the data.
  */
 
 #ifndef DATA_PLUGIN_H
@@ -44,17 +49,36 @@ class DataAccess {
 		
 		/* Set up the process. */
 		void setRedirectBootstrap();
+		/* View the given individuals, in order.  Repeats are allowed. */
+		void setRedirect(const vector<unsigned int> &people);
+		/* View the individuals in one fold (in_fold) or in every other fold. */
+		void setRedirectFold(const vector<int> &fold_of, int fold, bool in_fold);
+		/* View the individuals with the given phenotype. */
+		void setRedirectPhenotype(double value);
+		/* Go back to viewing every individual once. */
+		void clearRedirect();
+		/* Randomly split the individuals into folds of (nearly) equal size. */
+		void make_folds(int folds, vector<int> &fold_of);
+
+		/* Number of times an individual of the full data set appears in the view. */
+		unsigned int times_in_view(int person);
+		/* Number of individuals in the view with the given phenotype. */
+		int count_phenotype(double value);
 		
-		/* Return pointer to all SNPs for an individual. */
-		vector<short> *get_data(int);
+		/* Return all SNPs for an individual. */
+		GenotypeRow get_data(int);
+		/* Return a single SNP for all individuals.  Prefer this in loops over individuals. */
+		GenotypeColumn get_snp(int);
 		/* Return phenotype value for individual. */
 		double get_phenotype(int);
 		/* Return number of phenotypes (so number of people) */
 		int pheno_size();
 		/* Return number of SNPs */
 		int geno_size();
-		/* Return covariates for an individual. */
-		vector<double> *get_covariates(int);
+		/* Return the number of covariates. */
+		int num_covariates();
+		/* Fill cov with one vector per covariate holding the values for the listed individuals. */
+		void get_covariates(const vector<unsigned int> &people, vector<vector<double> > &cov);
 		/* Return the chromosome for a given SNP */
 		string get_chrom(int);
 		/* Return several pieces of information about a SNP */
@@ -68,7 +92,7 @@ class DataAccess {
 		/* Return the name of a single SNP */
 		string snp_name(long l){ return data->snp_name(l); };
 		/* Return number of snps in a sample */
-		long snp_size(unsigned int o){return data->snp_size(o);}
+		long snp_size(unsigned int){return data->snp_size();}
 
 		
 		int max_person_ID_size(){return data->maxPersonIDLength;}
@@ -81,6 +105,11 @@ class DataAccess {
 		SnpData *data;
 		vector<unsigned int> redirect;
 		bool uses_redirect;
+
+		// Worked out once per view.
+		vector<unsigned int> multiplicity; // Times each individual is in the view.
+		vector<pair<double, int> > phenotype_counts;
+		void summarize_view();
 		bool owns_data; // if it was created here, then kill it here.
 	
 };
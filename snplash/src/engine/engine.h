@@ -12,6 +12,8 @@
 #include "../reader/linkage_reader.h"
 #include "../reader/binary_bed_reader.h"
 #include "data_plugin.h"
+#include "snp_summary.hh"
+#include "snp_data_cache.hh"
 #include <math.h>
 
 class Engine {
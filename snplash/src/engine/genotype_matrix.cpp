@@ -0,0 +1,457 @@
+/*
+ *      genotype_matrix.cpp
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+#include "genotype_matrix.hh"
+#include <sys/mman.h>
+
+using namespace std;
+
+const short GenotypeMatrix::decode[4] = {1, 0, 2, 4};
+const unsigned char GenotypeMatrix::encode[5] = {1, 0, 2, 2, 3};
+short GenotypeMatrix::byte_decode[256][4];
+
+namespace {
+	// Fill GenotypeMatrix::byte_decode before main() runs.
+	struct ByteDecodeInit {
+		ByteDecodeInit(){
+			for(int b=0; b < 256; b++){
+				for(int f=0; f < 4; f++){
+					GenotypeMatrix::byte_decode[b][f] = GenotypeMatrix::decode[(b >> (f << 1)) & 3];
+				}
+			}
+		}
+	} byte_decode_init;
+}
+
+GenotypeMatrix::GenotypeMatrix(){
+	snps = 0;
+	people = 0;
+	row_bytes = 0;
+	phase_bytes = 0;
+	first = 0;
+	resident = 0;
+	streamed = false;
+	external = NULL;
+	mapping = NULL;
+	mapping_length = 0;
+}
+
+GenotypeMatrix::~GenotypeMatrix(){
+	release_mapping();
+}
+
+/**
+ * Allocate space for the given number of SNPs and individuals.  Every
+ * genotype starts as missing.  Any previous contents are discarded.
+ *
+ * @param s Number of SNPs
+ * @param p Number of individuals
+ */
+void GenotypeMatrix::resize(unsigned long s, unsigned int p){
+	snps = s;
+	people = p;
+	row_bytes = (p + 3) / 4;
+	phase_bytes = (p + 7) / 8;
+	first = 0;
+	resident = s;
+	streamed = false;
+	source.clear();
+
+	release_mapping();
+	packed.assign(snps * row_bytes, 0x55);
+	phase.clear();
+	for(unsigned long i=0; i < snps; i++){
+		clear_padding(mutable_row(i));
+	}
+}
+
+void GenotypeMatrix::clear(){
+	resize(0, 0);
+}
+
+/**
+ * Read rows in place from a memory mapping, typically a Plink .bed file.
+ * The rows must use the layout described in genotype_matrix.hh, which is
+ * the .bed layout, and start at the first SNP wanted.  Windowing is done
+ * by the caller by offsetting rows.
+ *
+ * @param map Start of the mapping, released with munmap when no longer used.
+ * @param map_length Length of the mapping.
+ * @param rows First packed row.
+ * @param s Number of SNPs
+ * @param p Number of individuals
+ */
+void GenotypeMatrix::attach(void *map, size_t map_length, const unsigned char *rows, unsigned long s, unsigned int p){
+	release_mapping();
+	vector<unsigned char>().swap(packed);
+	phase.clear();
+
+	snps = s;
+	people = p;
+	row_bytes = (p + 3) / 4;
+	phase_bytes = (p + 7) / 8;
+	first = 0;
+	resident = s;
+	streamed = false;
+	source.clear();
+
+	mapping = map;
+	mapping_length = map_length;
+	external = rows;
+}
+
+/**
+ * Set up a matrix of the given shape with no resident rows.  The reader
+ * loads one block of SNPs at a time with load_block().  Individuals may be
+ * dropped before or between blocks; source_columns() tells the reader which
+ * columns of the file are still wanted.
+ *
+ * @param s Number of SNPs
+ * @param p Number of individuals
+ */
+void GenotypeMatrix::stream(unsigned long s, unsigned int p){
+	release_mapping();
+	vector<unsigned char>().swap(packed);
+	phase.clear();
+
+	snps = s;
+	people = p;
+	row_bytes = (p + 3) / 4;
+	phase_bytes = (p + 7) / 8;
+	first = 0;
+	resident = 0;
+	streamed = true;
+
+	source.resize(p);
+	for(unsigned int i=0; i < p; i++){
+		source[i] = i;
+	}
+}
+
+/**
+ * Replace the resident rows of a streamed matrix with SNPs
+ * first..first+count-1.  The rows are zeroed and must be filled by the
+ * caller.  The buffer is reused between blocks.
+ *
+ * @param f First SNP in the block
+ * @param count Number of SNPs in the block
+ * @return The first row of the block.
+ */
+unsigned char *GenotypeMatrix::load_block(unsigned long f, unsigned long count){
+	first = f;
+	resident = count;
+	packed.assign(resident * row_bytes, 0);
+	return packed.empty() ? NULL : &packed[0];
+}
+
+/**
+ * Copy mapped rows into owned memory so they can be modified.
+ */
+void GenotypeMatrix::materialize(){
+	if(external == NULL){
+		return;
+	}
+	packed.assign(external, external + resident * row_bytes);
+	release_mapping();
+}
+
+void GenotypeMatrix::release_mapping(){
+	if(mapping != NULL){
+		munmap(mapping, mapping_length);
+	}
+	mapping = NULL;
+	mapping_length = 0;
+	external = NULL;
+}
+
+/**
+ * Store a genotype using the coding in snp_data.hh.
+ *
+ * @param snp SNP index
+ * @param person Individual index
+ * @param code Genotype code (0-4)
+ */
+void GenotypeMatrix::set(unsigned long snp, unsigned int person, short code){
+	unsigned char *r = mutable_row(snp);
+	int shift = (person & 3) << 1;
+	r[person >> 2] = (r[person >> 2] & ~(3 << shift)) | (encode[code] << shift);
+
+	if(code == 3 && phase.empty()){
+		allocate_phase();
+	}
+	if(!phase.empty()){
+		unsigned char *ph = &phase[snp * phase_bytes];
+		if(code == 3){
+			ph[person >> 3] |= (1 << (person & 7));
+		}else{
+			ph[person >> 3] &= ~(1 << (person & 7));
+		}
+	}
+}
+
+/**
+ * Writers that fill rows directly (see LinkageReader) use this to add the
+ * phase of the heterozygotes.
+ *
+ * @param snp SNP index
+ * @param bits One bit per individual, packed from the low bit.
+ */
+void GenotypeMatrix::set_phase_row(unsigned long snp, const unsigned char *bits){
+	if(phase.empty()){
+		allocate_phase();
+	}
+	copy(bits, bits + phase_bytes, phase.begin() + snp * phase_bytes);
+}
+
+/**
+ * Decode a packed row into genotype codes, four individuals per table
+ * lookup.  Heterozygotes with their phase bit set come out as 3.
+ *
+ * @param packed Packed row
+ * @param phase Phase row, or NULL
+ * @param n Number of individuals
+ * @param out Receives n codes
+ */
+void GenotypeMatrix::expand(const unsigned char *packed, const unsigned char *phase, unsigned int n, short *out){
+	unsigned int whole = n >> 2;
+	for(unsigned int b=0; b < whole; b++){
+		const short *c = byte_decode[packed[b]];
+		out[4*b] = c[0];
+		out[4*b+1] = c[1];
+		out[4*b+2] = c[2];
+		out[4*b+3] = c[3];
+	}
+	for(unsigned int p=whole << 2; p < n; p++){
+		out[p] = byte_decode[packed[whole]][p & 3];
+	}
+
+	if(phase == NULL){
+		return;
+	}
+	for(unsigned int b=0; b < (n + 7) / 8; b++){
+		if(phase[b] == 0){
+			continue;
+		}
+		for(unsigned int p=b << 3; p < n && p < (b+1) << 3; p++){
+			if(out[p] == 2 && ((phase[b] >> (p & 7)) & 1)){
+				out[p] = 3;
+			}
+		}
+	}
+}
+
+/**
+ * A SNP is all missing when every field is 01, so whole bytes are 0x55
+ * apart from the zero padding in the last one.
+ *
+ * @param snp SNP index
+ */
+bool GenotypeMatrix::all_missing(unsigned long snp) const {
+	const unsigned char *r = row(snp);
+	unsigned long whole = people >> 2;
+	for(unsigned long b=0; b < whole; b++){
+		if(r[b] != 0x55){
+			return false;
+		}
+	}
+	if((people & 3) != 0){
+		unsigned char mask = static_cast<unsigned char>((1 << ((people & 3) << 1)) - 1);
+		if(r[whole] != (0x55 & mask)){
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Swap the alleles for a SNP.  Homozygotes swap (1<->4) and heterozygotes
+ * swap their order (2<->3).  Missing is unchanged.
+ *
+ * @param snp SNP index
+ */
+void GenotypeMatrix::flip(unsigned long snp){
+	unsigned char *r = mutable_row(snp);
+	bool has_het = false;
+	for(unsigned long b=0; b < row_bytes; b++){
+		// A field is homozygous when both of its bits match.  Invert those.
+		unsigned char same = ~(r[b] ^ (r[b] >> 1)) & 0x55;
+		r[b] ^= same | (same << 1);
+		// Heterozygous fields are 10.
+		has_het = has_het || ((r[b] & ~(r[b] << 1) & 0xAA) != 0);
+	}
+	clear_padding(r);
+
+	if(!has_het){
+		return;
+	}
+	if(phase.empty()){
+		allocate_phase();
+	}
+	unsigned char *ph = &phase[snp * phase_bytes];
+	for(unsigned int p=0; p < people; p++){
+		if(((r[p >> 2] >> ((p & 3) << 1)) & 3) == 2){
+			ph[p >> 3] ^= (1 << (p & 7));
+		}
+	}
+}
+
+/**
+ * Recode all 3s as 2s by discarding the phase plane.
+ */
+void GenotypeMatrix::drop_phase(){
+	vector<unsigned char>().swap(phase);
+}
+
+/**
+ * Remove all SNPs whose flag is false.  Rows are moved down in place.
+ * A streamed matrix holds only one block of rows, so it is left alone.
+ *
+ * @param keep One flag per SNP.
+ * @return false if the matrix is streamed.
+ */
+bool GenotypeMatrix::keep_snps(const vector<bool> &keep){
+	if(streamed){
+		return false;
+	}
+
+	unsigned long kept = 0;
+	if(external != NULL){
+		// Copy only the rows that are kept out of the mapping.
+		vector<unsigned char> new_packed;
+		for(unsigned long i=0; i < snps; i++){
+			if(keep.at(i)){
+				new_packed.insert(new_packed.end(), row(i), row(i) + row_bytes);
+			}
+		}
+		release_mapping();
+		packed.swap(new_packed);
+	}else{
+		for(unsigned long i=0; i < snps; i++){
+			if(!keep.at(i)){
+				continue;
+			}
+			if(kept != i){
+				copy(packed.begin() + i * row_bytes, packed.begin() + (i+1) * row_bytes, packed.begin() + kept * row_bytes);
+			}
+			kept++;
+		}
+	}
+
+	kept = 0;
+	for(unsigned long i=0; i < snps; i++){
+		if(!keep.at(i)){
+			continue;
+		}
+		if(kept != i && !phase.empty()){
+			copy(phase.begin() + i * phase_bytes, phase.begin() + (i+1) * phase_bytes, phase.begin() + kept * phase_bytes);
+		}
+		kept++;
+	}
+
+	snps = kept;
+	first = 0;
+	resident = snps;
+	packed.resize(snps * row_bytes);
+	if(!phase.empty()){
+		phase.resize(snps * phase_bytes);
+	}
+	return true;
+}
+
+/**
+ * Remove all individuals whose flag is false.  Each SNP row is rebuilt in
+ * a single pass, so the cost does not depend on how many are removed.
+ * Rows are independent, so they are rebuilt in parallel.
+ *
+ * @param keep One flag per individual.
+ */
+void GenotypeMatrix::keep_people(const vector<bool> &keep){
+	vector<unsigned int> kept; // Old column of each remaining individual.
+	for(unsigned int p=0; p < people; p++){
+		if(keep.at(p)) kept.push_back(p);
+	}
+	unsigned int new_people = kept.size();
+	if(new_people == people){
+		return;
+	}
+
+	unsigned long new_row_bytes = (new_people + 3) / 4;
+	unsigned long new_phase_bytes = (new_people + 7) / 8;
+	vector<unsigned char> new_packed(resident * new_row_bytes, 0);
+	vector<unsigned char> new_phase;
+	if(!phase.empty()){
+		new_phase.assign(snps * new_phase_bytes, 0);
+	}
+
+	long rows = resident;
+	#if RUN_IN_PARALLEL_GENOTYPES
+	#pragma omp parallel for
+	#endif
+	for(long i=0; i < rows; i++){
+		const unsigned char *src = row(first + i);
+		unsigned char *dst = new_row_bytes == 0 ? NULL : &new_packed[i * new_row_bytes];
+		for(unsigned int q=0; q < new_people; q++){
+			unsigned int p = kept[q];
+			dst[q >> 2] |= ((src[p >> 2] >> ((p & 3) << 1)) & 3) << ((q & 3) << 1);
+		}
+	}
+
+	// The phase plane covers every SNP, not just the resident ones.
+	long phase_rows = new_phase.empty() ? 0 : snps;
+	#if RUN_IN_PARALLEL_GENOTYPES
+	#pragma omp parallel for
+	#endif
+	for(long i=0; i < phase_rows; i++){
+		const unsigned char *src_ph = phase_row(i);
+		unsigned char *dst_ph = &new_phase[i * new_phase_bytes];
+		for(unsigned int q=0; q < new_people; q++){
+			unsigned int p = kept[q];
+			dst_ph[q >> 3] |= ((src_ph[p >> 3] >> (p & 7)) & 1) << (q & 7);
+		}
+	}
+
+	if(streamed){
+		for(unsigned int q=0; q < new_people; q++){
+			source[q] = source[kept[q]];
+		}
+		source.resize(new_people);
+	}
+
+	release_mapping();
+	people = new_people;
+	row_bytes = new_row_bytes;
+	phase_bytes = new_phase_bytes;
+	packed.swap(new_packed);
+	phase.swap(new_phase);
+}
+
+/**
+ * Zero the unused fields at the end of a row, as Plink does.
+ */
+void GenotypeMatrix::clear_padding(unsigned char *r){
+	if(row_bytes == 0 || (people & 3) == 0){
+		return;
+	}
+	r[row_bytes - 1] &= static_cast<unsigned char>((1 << ((people & 3) << 1)) - 1);
+}
+
+void GenotypeMatrix::allocate_phase(){
+	phase.assign(snps * phase_bytes, 0);
+}
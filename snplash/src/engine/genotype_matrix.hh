@@ -0,0 +1,217 @@
+/*
+ *      genotype_matrix.hh
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef GENOTYPE_MATRIX_H
+#define GENOTYPE_MATRIX_H
+
+/**
+ * Packed, SNP-major storage for the genotype data.
+ *
+ * Each SNP is stored as one row of 2-bit fields, one field per individual,
+ * using the same layout as a Plink .bed row:
+ *
+ * 00: 1 1 (code 1)
+ * 01: missing (code 0)
+ * 10: 1 2 (code 2)
+ * 11: 2 2 (code 4)
+ *
+ * Fields are packed from the low bits of each byte, and each row is padded
+ * with zero bits to a whole byte.  Codes are the ones described in snp_data.hh.
+ *
+ * Linkage input can carry the order of the alleles for heterozygotes (code 3
+ * is 2 1).  That bit is held in a separate plane which is only allocated once
+ * a code 3 is stored, so binary input never pays for it.
+ *
+ * The rows may also live in a memory mapped .bed file (see attach()).  They
+ * are then read in place, and copied into owned memory only when something
+ * modifies the matrix.
+ *
+ * For data too large to hold at once the matrix can be streamed (see
+ * stream()).  It then keeps its full shape, but only one block of SNP rows
+ * is resident at a time and the reader replaces that block as the engine
+ * moves through the SNPs.  SNP indices stay global.
+ */
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+using namespace std;
+
+#define RUN_IN_PARALLEL_GENOTYPES 1
+
+class GenotypeMatrix {
+
+	public:
+		GenotypeMatrix();
+		~GenotypeMatrix();
+
+		/* Allocate snps x people genotypes, all missing. */
+		void resize(unsigned long snps, unsigned int people);
+		void clear();
+		/* Use rows that live in a memory mapping.  The matrix takes ownership of the mapping. */
+		void attach(void *mapping, size_t mapping_length, const unsigned char *rows, unsigned long snps, unsigned int people);
+		bool is_mapped() const {return external != NULL;}
+		/* Keep the shape but no rows.  Rows are brought in with load_block(). */
+		void stream(unsigned long snps, unsigned int people);
+		bool is_streamed() const {return streamed;}
+		/* Make SNPs first..first+count-1 resident.  Returns their rows for the caller to fill. */
+		unsigned char *load_block(unsigned long first, unsigned long count);
+		/* For a streamed matrix, the column in the source file of each individual. */
+		const vector<unsigned int> &source_columns() const {return source;}
+
+		unsigned long num_snps() const {return snps;}
+		unsigned int num_people() const {return people;}
+		/* Number of bytes in one packed SNP row. */
+		unsigned long stride() const {return row_bytes;}
+
+		inline short get(unsigned long snp, unsigned int person) const;
+		void set(unsigned long snp, unsigned int person, short code);
+
+		/* Direct access to a packed SNP row. */
+		const unsigned char *row(unsigned long snp) const {return base() + (snp - first) * row_bytes;}
+		unsigned char *mutable_row(unsigned long snp) {materialize(); return &packed[(snp - first) * row_bytes];}
+		/* Phase row for a SNP, or NULL if no code 3 was ever stored. */
+		const unsigned char *phase_row(unsigned long snp) const {return phase.empty() ? NULL : &phase[snp * phase_bytes];}
+		/* Store a whole phase row, one bit per individual (set for code 3). */
+		void set_phase_row(unsigned long snp, const unsigned char *bits);
+
+		void flip(unsigned long snp); // 1<->4 ; 2<->3
+		void drop_phase(); // 3 -> 2 everywhere.
+
+		/* Compact the matrix, keeping only SNPs / individuals flagged true.
+		 * A streamed matrix can only drop individuals: keep_snps returns
+		 * false and changes nothing. */
+		bool keep_snps(const vector<bool> &keep);
+		void keep_people(const vector<bool> &keep);
+
+		/* Packed field -> genotype code. */
+		static const short decode[4];
+		/* Genotype code -> packed field. */
+		static const unsigned char encode[5];
+		/* Packed byte -> the four genotype codes it holds. */
+		static short byte_decode[256][4];
+
+		/* Decode a packed row (and optional phase row) of n individuals into out. */
+		static void expand(const unsigned char *packed, const unsigned char *phase, unsigned int n, short *out);
+		/* True if every individual is missing for the SNP. */
+		bool all_missing(unsigned long snp) const;
+
+	protected:
+		unsigned long snps;
+		unsigned int people;
+		unsigned long row_bytes;
+		unsigned long phase_bytes;
+
+		// Resident rows.  Everything is resident unless the matrix is streamed.
+		unsigned long first;
+		unsigned long resident;
+		bool streamed;
+		vector<unsigned int> source;
+
+		vector<unsigned char> packed;
+		vector<unsigned char> phase;
+
+		// Mapped rows, if attached.  Owned by this object.
+		const unsigned char *external;
+		void *mapping;
+		size_t mapping_length;
+
+		const unsigned char *base() const {return (external != NULL) ? external : (packed.empty() ? NULL : &packed[0]);}
+		void materialize(); // Copy mapped rows into owned memory.
+		void release_mapping();
+
+		void clear_padding(unsigned char *r);
+		void allocate_phase();
+
+	private:
+		// The mapping can not be shared.
+		GenotypeMatrix(const GenotypeMatrix &);
+		GenotypeMatrix &operator=(const GenotypeMatrix &);
+};
+
+/**
+ * A single SNP over all individuals.  Optionally redirects individuals
+ * through an index vector (see DataAccess::setRedirectBootstrap).
+ *
+ * This is a view: it is only valid while the matrix is unchanged.
+ */
+class GenotypeColumn {
+
+	public:
+		GenotypeColumn(const unsigned char *packed, const unsigned char *phase, unsigned int people, const vector<unsigned int> *redirect)
+			: packed(packed), phase(phase), people(people), redirect(redirect) {}
+
+		inline short at(unsigned int i) const {
+			unsigned int p = (redirect == NULL) ? i : (*redirect)[i];
+			short c = GenotypeMatrix::decode[(packed[p >> 2] >> ((p & 3) << 1)) & 3];
+			if(c == 2 && phase != NULL && ((phase[p >> 3] >> (p & 7)) & 1)){
+				return 3;
+			}
+			return c;
+		}
+
+		unsigned int size() const {return (redirect == NULL) ? people : redirect->size();}
+
+		/* Decode the whole column at once.  Much faster than calling at() in a loop. */
+		void decode(vector<short> &out) const {
+			out.resize(size());
+			if(out.empty()){
+				return;
+			}
+			if(redirect == NULL){
+				GenotypeMatrix::expand(packed, phase, people, &out[0]);
+			}else{
+				for(unsigned int i=0; i < out.size(); i++){
+					out[i] = at(i);
+				}
+			}
+		}
+
+	protected:
+		const unsigned char *packed;
+		const unsigned char *phase;
+		unsigned int people;
+		const vector<unsigned int> *redirect;
+};
+
+/**
+ * All SNPs for a single individual.  Used by the machine learning engines,
+ * which evaluate rules one person at a time.
+ */
+class GenotypeRow {
+
+	public:
+		GenotypeRow(const GenotypeMatrix *m, unsigned int person) : m(m), person(person) {}
+
+		short at(unsigned long snp) const {return m->get(snp, person);}
+		unsigned long size() const {return m->num_snps();}
+
+	protected:
+		const GenotypeMatrix *m;
+		unsigned int person;
+};
+
+inline short GenotypeMatrix::get(unsigned long snp, unsigned int person) const {
+	return GenotypeColumn(row(snp), phase_row(snp), people, NULL).at(person);
+}
+
+#endif
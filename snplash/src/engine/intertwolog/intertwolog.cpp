@@ -19,7 +19,8 @@
 
 #include "intertwolog.hh"
 
-#include "../utils/lr.hh"
+#include "../snp_scheduler.hh"
+#include "../tile_grid.hh"
 #include "../../logger/log.hh"
 
 
@@ -57,13 +58,20 @@ void InterTwoLog::init(){
 		//exit(0);
 	}
 
+	Logger::Instance()->init(param_reader->get_out_file() + ".log");
+
+	SnpDataCache cache(param_reader);
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		delete reader;
+		numFinalPhen = data->pheno_size();
+		return;
+	}
+
 	reader->process(data->getDataObject(), param_reader);
 	
 	numInitSNPs = data->geno_size();
 	numInitPhen = data->pheno_size();
 	
-	Logger::Instance()->init(param_reader->get_out_file() + ".log");
-	
 	data->getDataObject()->remove_phenotype(numeric_limits<double>::max());
 	data->getDataObject()->remove_covariate(numeric_limits<double>::max());
 	data->getDataObject()->remove_phenotype(0);
@@ -84,7 +92,7 @@ void InterTwoLog::init(){
 	}
 	
 	numFinalPhen = data->pheno_size();
-	
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 }
 
 /*
@@ -100,6 +108,12 @@ void InterTwoLog::preProcess(){
 	ss << "INDIVIDUALS READ FROM THE INPUT FILE:            " << numInitPhen << endl;
 	ss << "INDIVIDUALS DELETED                              " << numInitPhen - numFinalPhen << endl;
 	ss << "INDIVIDUALS LEFT FROM THE INPUT FILE:            " << numFinalPhen << "  (" << numCase << " cases and " << numFinalPhen - numCase << " controls)" << endl;
+	if(itl_param->get_report_pairs()){
+		ss << "PAIRS WRITTEN:                                   ";
+		if(itl_param->get_report_p() >= 0) ss << "p-value below " << itl_param->get_report_p() << "  ";
+		if(itl_param->get_report_top() > 0) ss << "the " << itl_param->get_report_top() << " smallest p-values, smallest first";
+		ss << endl;
+	}
 
 	cout << ss.str();
 
@@ -112,62 +126,129 @@ void InterTwoLog::preProcess(){
 }
 
 /*
- * Process the entire data set using a series of parallel OMP for loops.
+ * Process the entire data set in one parallel region.  The pairs are
+ * cut into square tiles (see TileGrid) and each thread takes a row band of
+ * tiles at a time.  It decodes the band's SNPs once, and each column block
+ * once, and runs every pair of a tile out of those buffers.  The band's
+ * lines are kept until the band is done and then queued in the usual file
+ * order, i then j; the output queue puts the bands back in order.  A
+ * resumed run skips the pairs its output already holds.
+ *
+ * If only some pairs are to be reported, each thread keeps its own and
+ * they are written once at the end.
  */
 void InterTwoLog::process(){
 	
 	int sz = data->geno_size();
+
+	bool report = itl_param->get_report_pairs();
+	double maxP = itl_param->get_report_p();
+	TopPairs<InterTwoLogMeasures, SmallerPValue> top(SnpScheduler::max_threads(), itl_param->get_report_top());
+
+	// Smaller tiles for small runs, so that every thread gets some bands.
+	int tile = min(INTERTWOLOG_TILE, max(1, sz / (4 * SnpScheduler::max_threads())));
+	long done = out.first_line();
+	TileGrid grid(sz, tile);
+	grid.plan(done);
 	
-	int idx = 0;
-	
-	for(int i=0;i < sz; i++){
-		
-		#if RUN_IN_PARALLEL
-		#pragma omp parallel shared(sz, idx) 
-		{
-			#pragma omp for schedule(static)
-		#endif
-		for(int j=i+1;j < sz; j++){
-			
-			#if INTERTWOLOG_TESTLOOP
-			cout << "Running " << i << " " << j << endl;
-			#endif
-			
-			InterTwoLogMeasures itlm;
-			processPair(i,j,itlm);
-			itlm.index1 = i+1;
-			itlm.index2 = j+1;
-			
-			string tempS;
-			int tempP;
-			data->get_map_info(i, tempS, itlm.name1, tempP);
-			data->get_map_info(j, tempS, itlm.name2, tempP);
-			
-			#if INTERTWOLOG_TESTLOOP
-				cout << "Running " << i << " " << j << " printing." << endl;
-			#endif
-			out.printLine(itlm, idx+j-i-1);
-			#if INTERTWOLOG_TESTLOOP
-				cout << "Running " << i << " " << j << " done." << endl;
-			#endif
-		}
-		#if RUN_IN_PARALLEL
+	#if RUN_IN_PARALLEL_INTERTWOLOG
+	#pragma omp parallel
+	#endif
+	{
+		vector<vector<short> > rows, cols;
+		vector<InterTwoLogMeasures> band; // Lines of the current band.
+		InterTwoLogMeasures itlm;
+		LogisticRegression lr(itl_param->getRegressionConditionNumberThreshold());
+		int first, last;
+		long start;
+		while(grid.next_band(first, last, start)){
+			int i0, i1, j0, j1;
+			grid.bounds(first, i0, i1, j0, j1);
+			decodeBlock(i0, i1, rows);
+			long pairs = 0;
+			for(int t=first;t < last; t++) pairs += grid.num_pairs(t);
+			if(!report) band.resize(pairs);
+
+			for(int t=first;t < last; t++){
+				grid.bounds(t, i0, i1, j0, j1);
+				decodeBlock(j0, j1, cols);
+
+				for(int i=i0;i < i1; i++){
+					for(int j=max(j0, i+1);j < j1; j++){
+						long order = start + grid.band_pair(i, j);
+						if(order < done) continue;
+						
+						#if INTERTWOLOG_TESTLOOP
+						cout << "Running " << i << " " << j << endl;
+						#endif
+						
+						InterTwoLogMeasures &m = report ? itlm : band[order - start];
+						processPair(i, j, rows[i-i0], cols[j-j0], lr, m);
+						m.index1 = i+1;
+						m.index2 = j+1;
+						if(!report) continue;
+
+						// A NaN p-value is a failed fit and is never reported.
+						if(m.pVal != m.pVal || (maxP >= 0 && m.pVal >= maxP)) continue;
+						
+						string tempS;
+						int tempP;
+						data->get_map_info(i, tempS, m.name1, tempP);
+						data->get_map_info(j, tempS, m.name2, tempP);
+						top.offer(SnpScheduler::thread_id(), m);
+					}
+				}
+			}
+
+			if(report) continue;
+			for(long k=max(done - start, 0L);k < pairs; k++){
+				InterTwoLogMeasures &m = band[k];
+				string tempS;
+				int tempP;
+				data->get_map_info(m.index1 - 1, tempS, m.name1, tempP);
+				data->get_map_info(m.index2 - 1, tempS, m.name2, tempP);
+				
+				#if INTERTWOLOG_TESTLOOP
+					cout << "Running " << m.index1 - 1 << " " << m.index2 - 1 << " printing." << endl;
+				#endif
+				out.printLine(m, start + k);
+			}
 		}
-		#endif
-		idx += sz-i-1;
+	}
+
+	if(report){
+		vector<InterTwoLogMeasures> pairs;
+		top.merge(pairs);
+		// Without --top the pairs keep the usual file order.
+		if(itl_param->get_report_top() == 0) sort(pairs.begin(), pairs.end(), ByPair<InterTwoLogMeasures>());
+		out.printReport(pairs);
 	}
 	out.close();
 	
 }
 
+/*
+ * Decode SNPs [first, last) into block, one vector of codes per SNP.
+ * The vectors are reused from tile to tile.
+ */
+void InterTwoLog::decodeBlock(int first, int last, vector<vector<short> > &block){
+	if(block.size() < static_cast<unsigned int>(last - first)) block.resize(last - first);
+	for(int i=first;i < last; i++){
+		data->get_snp(i).decode(block[i-first]);
+	}
+}
+
 /**
  * Create data and run test for a single pair of SNPs given by i and j.
  * 
  * @param i First SNP
  * @param j Second SNP
+ * @param col1 Decoded genotypes of SNP i.
+ * @param col2 Decoded genotypes of SNP j.
+ * @param lr This thread's regression, reused from pair to pair.
  * @return itlm Structure filled with p, beta, se.
  */
-void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
+void InterTwoLog::processPair(int i, int j, const vector<short> &col1, const vector<short> &col2, LogisticRegression &lr, InterTwoLogMeasures &itlm){
 	
 	vector<double> snp1, snp2, snpInt, ones;
 	vector<double> phen_vec;
@@ -177,14 +258,7 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 		cout << "Running " << i << " " << j << " start." << endl;
 	#endif
 	
-	/* Prep covariate matrix */
-	vector<double> *tmp = data->get_covariates(0);
-	if(tmp != NULL){
-		for(unsigned int ii=0;ii<tmp->size();ii++){
-			vector<double> a;
-			cov.push_back(a);
-		}
-	}
+	vector<unsigned int> used; // Individuals with both genotypes present.
 	
 	#if INTERTWOLOG_TESTLOOP
 		cout << "Running " << i << " " << j << " cov filled." << endl;
@@ -198,10 +272,11 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 		
 		double ph = data->get_phenotype(people)-1;
 		short s1, s2;
-		s1 = data->get_data(people)->at(i);
-		s2 = data->get_data(people)->at(j);
+		s1 = col1[people];
+		s2 = col2[people];
 		if(s1 * s2 > 0){  // if neither is 0.
 			ones.push_back(1.0);
+			used.push_back(people);
 			phen_vec.push_back(ph);
 			if(s1 == 1){
 				snp1.push_back(-1);
@@ -237,8 +312,8 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 	for(int people = 0;people < data->pheno_size();++people){
 		
 		short s1, s2;
-		s1 = data->get_data(people)->at(i);
-		s2 = data->get_data(people)->at(j);
+		s1 = col1[people];
+		s2 = col2[people];
 		if(s1 * s2 > 0){
 			double interaction;
 			if(s1 == 1){
@@ -260,13 +335,9 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 				interaction *= (1 - mean2);
 			}
 			snpInt.push_back(interaction);
-			
-			vector<double> *t = data->get_covariates(people);
-			for(unsigned int jj=0;jj<t->size();jj++){
-				cov.at(jj).push_back(t->at(jj));
-			}
 		}
 	}
+	data->get_covariates(used, cov);
 		
 	#if INTERTWOLOG_TESTLOOP
 		cout << "Running " << i << " " << j << " data filled." << endl;
@@ -280,7 +351,6 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 	vector<vector<double> > inv_infmatrix = vecops::getDblVec(cov.size(), cov.size());
 	vector<double> betas;
 	LRStats l;
-	LogisticRegression lr(itl_param->getRegressionConditionNumberThreshold());
 
 	int retry = 0;
 	double startVal = 0;  // value to start betas with.
@@ -302,6 +372,7 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 		}catch (ConditionNumberEx ex){
 			// The condition number of the information matrix is large. Check for separation.
 			int separableVariable = lr.dataIsSeparable(cov, phen_vec);
+			bool penalized = itl_param->get_firth() && firthPair(lr, cov, phen_vec, itlm);
 			
 			string tempS;
 			int tempP;
@@ -313,7 +384,9 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 			if (separableVariable < 0){
 				// Error: poor conditioning.
 				stringstream ss;
-				ss << "Intertwolog SNPs " << name1 << " and " << name2 << ": Poor conditioning in information matrix." << endl;
+				ss << "Intertwolog SNPs " << name1 << " and " << name2 << ": Poor conditioning in information matrix.";
+				if(penalized) ss << " Reported the Firth-penalized fit.";
+				ss << endl;
 				Logger::Instance()->writeLine(ss.str());
 			}else{
 				// Error: the poor conditioning is due to separable variable.
@@ -328,6 +401,7 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 				}else{
 					ss << "Separable by a covariate.";
 				}
+				if(penalized) ss << " Reported the Firth-penalized fit.";
 				ss << endl;
 				Logger::Instance()->writeLine(ss.str());
 			}
@@ -338,6 +412,11 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 				cout << "Running " << i << " " << j << " try " << retry << " failed." << endl;
 			#endif
 
+			// The penalized fit converges where other starting values would not.
+			if(itl_param->get_firth()){
+				if(firthPair(lr, cov, phen_vec, itlm)) return;
+				retry = 2;
+			}
 			retry++;
 			if(retry == 1) {startVal = 0.5;}
 			else if(retry == 2){ startVal = -0.5;}
@@ -355,6 +434,26 @@ void InterTwoLog::processPair(int i, int j, InterTwoLogMeasures &itlm){
 }
 
 
+/**
+ * Fit a pair with the Firth penalty (--firth) after the plain fit failed.
+ * 
+ * @return true if the fit worked; itlm then holds its beta, p and se.
+ */
+bool InterTwoLog::firthPair(LogisticRegression &lr, const vector<vector<double> > &cov, const vector<double> &phen, InterTwoLogMeasures &itlm){
+	
+	vector<vector<double> > inv_infmatrix = vecops::getDblVec(cov.size(), cov.size());
+	try{
+		vector<double> betas = lr.firth(cov, phen, inv_infmatrix);
+		LRStats l = lr.getSingleStats(betas, inv_infmatrix, betas.size()-1);
+		itlm.beta = betas.at(betas.size() - 1);
+		itlm.pVal = l.pVal;
+		itlm.SE = l.invInf;
+		return true;
+	}catch(...){
+		return false;
+	}
+}
+
 void InterTwoLog::enslave(EngineParamReader *){
 	cerr << "Enslave not supported for INTERTWOLOG." << endl;
 }
@@ -42,6 +42,10 @@
 // Turn on to get a peak at the raw data before it enters the LR engine.
 #define INTERTWOLOG_DATAPEAK 0
 
+#define RUN_IN_PARALLEL_INTERTWOLOG 1
+// Most SNPs on a side of a tile of the pair grid; see TileGrid.
+#define INTERTWOLOG_TILE 64
+
 
 #include <stdlib.h>
 #include <iostream>
@@ -50,9 +54,19 @@
 #include "../../param/engine_param_reader.h"
 #include "../engine.h"
 #include "../output/intertwolog_out.hh"
+#include "../top_pairs.hh"
+#include "../utils/lr.hh"
 
 using namespace std;
 
+/* Reported pairs come smallest p-value first, ties in file order. */
+struct SmallerPValue {
+	bool operator()(const InterTwoLogMeasures &a, const InterTwoLogMeasures &b) const {
+		if(a.pVal != b.pVal) return a.pVal < b.pVal;
+		return ByPair<InterTwoLogMeasures>()(a, b);
+	}
+};
+
 class InterTwoLog : public Engine{
 
 	public :
@@ -80,7 +94,9 @@ class InterTwoLog : public Engine{
 		int numCase;
 
 		void delete_my_innards();
-		void processPair(int i, int j, InterTwoLogMeasures &itlm);
+		void decodeBlock(int first, int last, vector<vector<short> > &block);
+		void processPair(int i, int j, const vector<short> &col1, const vector<short> &col2, LogisticRegression &lr, InterTwoLogMeasures &itlm);
+		bool firthPair(LogisticRegression &lr, const vector<vector<double> > &cov, const vector<double> &phen, InterTwoLogMeasures &itlm);
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "ld.h"
+#include "../snp_scheduler.hh"
 
 LinkageDisequilibrium::LinkageDisequilibrium(){
 	this->param_reader = ParamReader::Instance();
@@ -53,6 +54,13 @@ void LinkageDisequilibrium::init(){
 
 	initializeReader(); // defined in engine.h
 
+	SnpDataCache cache(param_reader);
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		delete reader;
+		numFinalPhen = data->pheno_size();
+		return;
+	}
+
 	reader->process(data->getDataObject(), param_reader);
 
 	numInitSNPs = data->geno_size();
@@ -73,6 +81,7 @@ void LinkageDisequilibrium::init(){
 	delete reader; // No longer needed.
 	
 	numFinalPhen = data->pheno_size();
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 	
 	
 }
@@ -93,6 +102,12 @@ void LinkageDisequilibrium::preProcess(){
 		ss << "INDIVIDUALS READ FROM THE INPUT FILE:            " << numInitPhen << endl;
 		ss << "INDIVIDUALS DELETED                              " << numInitPhen - numFinalPhen << endl;
 		ss << "INDIVIDUALS LEFT FROM THE INPUT FILE:            " << numFinalPhen << "  (" << numCase << " cases and " << numFinalPhen - numCase << " controls)" << endl;
+		if(ld_param->get_report_pairs()){
+			ss << "PAIRS WRITTEN:                                   ";
+			if(ld_param->get_report_r2() >= 0) ss << "r^2 above " << ld_param->get_report_r2() << "  ";
+			if(ld_param->get_report_top() > 0) ss << "the " << ld_param->get_report_top() << " largest r^2, largest first";
+			ss << endl;
+		}
 		
 		cout << ss.str();
 	}else{
@@ -105,7 +120,7 @@ void LinkageDisequilibrium::preProcess(){
 			exit(0);
 		}
 	}else{
-		if(! output.init(ld_param->get_dprime_fmt(),param_reader,data->max_map_size())){
+		if(! output.init(ld_param->get_dprime_fmt(),param_reader,ld_param,data->max_map_size(), !ld_param->get_report_pairs())){
 			cerr << "Bad setup.  Aborting." << endl;
 			exit(0);
 		}	
@@ -117,14 +132,20 @@ void LinkageDisequilibrium::preProcess(){
  * Compute DPrime for all pairs of SNPs.
  * 
  * If the dp-smartpairs option was chosen, then only compute if the map chr matches.
+ * If only some pairs are to be reported, each thread keeps its own and they
+ * are written once at the end.  A resumed run skips the pairs its output
+ * already holds.
  */
 void LinkageDisequilibrium::process(){
 
 	int run_size = data->geno_size();	
+	bool report = !haveOwner && ld_param->get_report_pairs();
+	TopPairs<LinkageMeasures, LargerRSquare> top(SnpScheduler::max_threads(), ld_param->get_report_top());
 	// Set up window with window size.
 	window = ld_param->get_dprime_window();
 	if(window < 0) window = run_size + 1;
-	int order = 0;
+	long order = 0;
+	long done = output.first_line();
 	int ceil;
 	if(ld_param->get_dprime_smartpairs()){
 		
@@ -137,6 +158,10 @@ void LinkageDisequilibrium::process(){
 				if(data->get_chrom(i) == data->get_chrom(j))	
 					run_pairs.push_back(j);
 			}
+			if(order + static_cast<long>(run_pairs.size()) <= done){
+				order += run_pairs.size();
+				continue;
+			}
 
 			#if RUN_IN_PARALLEL_LD
 			#pragma omp parallel 
@@ -147,6 +172,7 @@ void LinkageDisequilibrium::process(){
 				#pragma omp for schedule(static,1)
 				#endif
 				for(int ju=0;ju<rp_sz;ju++){
+					if(order+ju < done) continue;
 					LinkageMeasures l;
 					if(data->getDataObject()->isUsable(i) && data->getDataObject()->isUsable(ju)){
 						dprimeOnPair(i,ju, l);
@@ -161,8 +187,9 @@ void LinkageDisequilibrium::process(){
 					
 					data->get_map_info(l.index1-1, l.chr1, l.name1, l.position1);
 					data->get_map_info(l.index2-1, l.chr2, l.name2, l.position2);
-					#pragma omp critical
-					{
+					if(report){
+						if(wanted(l)) top.offer(SnpScheduler::thread_id(), l);
+					}else{
 						output.printLine(l, order+ju);
 					}
 				}
@@ -176,12 +203,17 @@ void LinkageDisequilibrium::process(){
 		
 		for(int i=0;i<run_size;i++){
 			ceil = run_size < i+window ? run_size : i+window;
+			if(order + ceil-i-1 <= done){
+				order += ceil-i-1;
+				continue;
+			}
 			#if RUN_IN_PARALLEL_LD
 			#pragma omp parallel shared(ceil, order) 
 			{
 				#pragma omp for schedule(static)
 			#endif
 				for(int j=1+i;j<ceil;j++){
+					if(order+j-i-1 < done) continue;
 					LinkageMeasures l;
 					if(data->getDataObject()->isUsable(i) && data->getDataObject()->isUsable(j)){
 						dprimeOnPair(i,j, l);
@@ -195,18 +227,36 @@ void LinkageDisequilibrium::process(){
 					l.index2 = j+param_reader->get_begin();
 					data->get_map_info(i, l.chr1, l.name1, l.position1);
 					data->get_map_info(j, l.chr2, l.name2, l.position2);
-					output.printLine(l, order+j-i-1);
+					if(report){
+						if(wanted(l)) top.offer(SnpScheduler::thread_id(), l);
+					}else{
+						output.printLine(l, order+j-i-1);
+					}
 				}
 			#if RUN_IN_PARALLEL_LD
 			}
 			#endif
 			order += ceil-i-1;
 		}
-		output.close();
 	}
+
+	if(report){
+		vector<LinkageMeasures> pairs;
+		top.merge(pairs);
+		// Without --top the pairs keep the usual file order.
+		if(ld_param->get_report_top() == 0) sort(pairs.begin(), pairs.end(), ByPair<LinkageMeasures>());
+		output.printReport(pairs);
+	}
+	output.close();
 	
 }
 
+bool LinkageDisequilibrium::wanted(const LinkageMeasures &l) const{
+	double minR2 = ld_param->get_report_r2();
+	// NaN never compares, so it is never reported.
+	return l.rsquare == l.rsquare && (minR2 < 0 || l.rsquare > minR2);
+}
+
 /**
  * Enslave this LD engine. For now, nothing changes.
  */
@@ -245,18 +295,62 @@ bool LinkageDisequilibrium::dprimeOnPair(int s1, int s2, LinkageMeasures &lr){
 		return false;
 	}
 	
-	vector<int> numAlleles;
-	vector<double> unknownProb;
-	EM emAlgorithm;
-	
 	vector<short> v1, v2;
+	GenotypeColumn col1 = data->get_snp(s1);
+	GenotypeColumn col2 = data->get_snp(s2);
 	for(int i=0; i<data->pheno_size(); i++ ){
-		if(data->get_data(i)->at(s1) != 0 && data->get_data(i)->at(s2) != 0 && data->get_phenotype(i) != 0){
+		if(col1.at(i) != 0 && col2.at(i) != 0 && data->get_phenotype(i) != 0){
 			// Data to be used only if not missing in both and not in phenotype
-			v1.push_back( data->get_data(i)->at(s1) );
-			v2.push_back( data->get_data(i)->at(s2) );
+			v1.push_back( col1.at(i) );
+			v2.push_back( col2.at(i) );
 		}
 	}
+	return dprimeOnData(s1, s2, v1, v2, lr);
+}
+
+/**
+ * Perform all linkage disequilibrium measures on two SNPs, walking only
+ * the individuals that have a genotype at the first.
+ * 
+ * @param first Summary of SNP 1
+ * @param s2 SNP 2
+ * @return lr A filled linkage measures struct.
+ */
+bool LinkageDisequilibrium::dprimeOnPair(const SnpSummary &first, int s2, LinkageMeasures &lr){
+	
+	int s1 = first.get_snp();
+	if(s1 == s2) return false;
+	
+	if(s1 >= data->geno_size() || s2 >= data->geno_size()){
+		lr.dPrime = -1;
+		lr.dee = -1;
+		lr.rsquare = -1;
+		lr.delta = -1;
+		return false;
+	}
+	
+	vector<short> v1, v2;
+	const vector<short> &col1 = first.codes();
+	const vector<unsigned int> &present = first.present();
+	GenotypeColumn col2 = data->get_snp(s2);
+	for(unsigned int k=0; k<present.size(); k++ ){
+		int i = present[k];
+		if(col2.at(i) != 0 && data->get_phenotype(i) != 0){
+			v1.push_back( col1[i] );
+			v2.push_back( col2.at(i) );
+		}
+	}
+	return dprimeOnData(s1, s2, v1, v2, lr);
+}
+
+/**
+ * The measures themselves, given the genotypes of the individuals used.
+ */
+bool LinkageDisequilibrium::dprimeOnData(int s1, int s2, const vector<short> &v1, const vector<short> &v2, LinkageMeasures &lr){
+	
+	vector<int> numAlleles;
+	vector<double> unknownProb;
+	EM emAlgorithm;
 	
 	if(v1.empty()){
 		lr.dPrime = lr.dee = lr.rsquare = lr.delta = -1;
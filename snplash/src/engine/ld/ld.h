@@ -45,9 +45,18 @@
 #include "../randwh.h"
 #include "../em/em.h"
 #include "../output/dprime_out.h"
+#include "../top_pairs.hh"
 
 using namespace std;
 
+/* Reported pairs come largest r^2 first, ties in file order. */
+struct LargerRSquare {
+	bool operator()(const LinkageMeasures &a, const LinkageMeasures &b) const {
+		if(a.rsquare != b.rsquare) return a.rsquare > b.rsquare;
+		return ByPair<LinkageMeasures>()(a, b);
+	}
+};
+
 class LinkageDisequilibrium : public Engine{
 	
 	public : 
@@ -63,6 +72,8 @@ class LinkageDisequilibrium : public Engine{
         virtual void test();
 	
 		bool dprimeOnPair(int s1, int s2, LinkageMeasures &results);
+		/* Same, using a summary already built for s1. */
+		bool dprimeOnPair(const SnpSummary &s1, int s2, LinkageMeasures &results);
 	
 		// Computation engine pieces.  These are static so you could run
 		// them without instantiating an LD engine if you already have
@@ -74,6 +85,7 @@ class LinkageDisequilibrium : public Engine{
 		static double compDelta(double dee, EM &e);
 	
 	protected :
+		bool dprimeOnData(int s1, int s2, const vector<short> &v1, const vector<short> &v2, LinkageMeasures &lr);
 		
 		bool haveOwner;
 		int order_in_bag;
@@ -83,6 +95,8 @@ class LinkageDisequilibrium : public Engine{
 		bool diagonal;
 		
 		void delete_my_innards();
+		/* True if l is to be written when only some pairs are reported. */
+		bool wanted(const LinkageMeasures &l) const;
 	
 		LinkageOutput output;
 		
@@ -37,7 +37,7 @@ AD_Rule::AD_Rule(Precondition p, Condition c, double a1, double a2){
 /**
  * Perform a test of this rule on the input data passed in.
  */
-double AD_Rule::evaluate(vector<short> *vec){
+double AD_Rule::evaluate(const GenotypeRow &vec){
 	if(precon.evaluate_truth(vec)){
 		if(con.evaluate(vec)){
 			return score_true;
@@ -49,10 +49,10 @@ double AD_Rule::evaluate(vector<short> *vec){
  * Evaluate truth value of this rule on the instance vector.
  * 
  * name: evaluate_truth
- * @param vector<short> address representing instance.  No checks on correctness of length.
+ * @param GenotypeRow representing instance.  No checks on correctness of length.
  * @return boolean truth value.
  */
-bool AD_Rule::evaluate_truth(vector<short> * vec){
+bool AD_Rule::evaluate_truth(const GenotypeRow &vec){
 	return con.evaluate(vec) && precon.evaluate_truth(vec);
 }
 
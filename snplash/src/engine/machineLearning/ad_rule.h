@@ -52,8 +52,8 @@ class AD_Rule {
 		AD_Rule();
 		AD_Rule(Precondition, Condition , double a1, double a2);
 
-		double evaluate(vector<short> *);
-		bool evaluate_truth(vector<short> * vec);
+		double evaluate(const GenotypeRow &);
+		bool evaluate_truth(const GenotypeRow &vec);
 		long attribute_value(){return con.attribute_index;}
 
 		string to_string(DataAccess *data);
@@ -27,11 +27,11 @@ AD_Data::~AD_Data(){
 /**
  * Return score for a given node start on vector v.
  * 
- * @param vector<short> pointer to instance
+ * @param GenotypeRow instance
  * @param int denoting position of the node to be evaluated.
  * @return double value of node i on instance v 
  */
-double AD_Data::evaluate(vector<short> *v, int start){
+double AD_Data::evaluate(const GenotypeRow &v, int start){
 
 	return nodes.at(start).evaluate(v);
 
@@ -40,11 +40,11 @@ double AD_Data::evaluate(vector<short> *v, int start){
 /**
  * Evaluate the truth value (boolean) of an instance on a single rule.
  * 
- * @param vector<short> pointer to instance
+ * @param GenotypeRow instance
  * @param int denoting position of the node to be evaluated.
  * @return boolean value of rule i evaluated on instance v.
  */
-bool AD_Data::evaluate_truth(vector<short> *v, int i){
+bool AD_Data::evaluate_truth(const GenotypeRow &v, int i){
 	return nodes.at(i).evaluate_truth(v);
 }
 
@@ -100,7 +100,7 @@ string AD_Data::print(DataAccess *data){
  * @param vector pointer to instance data
  * @return double score for this individual.
  */
-double AD_Data::evaluate_instance(vector<short> *vec){
+double AD_Data::evaluate_instance(const GenotypeRow &vec){
 	double return_value = 0;
 	for(unsigned int i=0;i < nodes.size(); ++i){
 		return_value += nodes.at(i).evaluate(vec);
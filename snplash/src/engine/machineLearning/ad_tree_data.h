@@ -41,10 +41,10 @@ class AD_Data {
 
 		/* Functions */
 		// Evaluation methods.
-		double evaluate_instance(vector<short> *); // Perform evaluation of this instance.
-		double evaluate(vector<short> *, int ); // holds start index and vector to evaluate.
-		double evaluate_on_last(vector<short> * v){ return evaluate(v,nodes.size()-1); }
-		bool evaluate_truth(vector<short> *, int) ; // return only truth value.
+		double evaluate_instance(const GenotypeRow &); // Perform evaluation of this instance.
+		double evaluate(const GenotypeRow &, int ); // holds start index and vector to evaluate.
+		double evaluate_on_last(const GenotypeRow &v){ return evaluate(v,nodes.size()-1); }
+		bool evaluate_truth(const GenotypeRow &, int) ; // return only truth value.
 		
 		void push_node(AD_Rule , unsigned int);
 		void push_precondition(Precondition);
@@ -68,7 +68,16 @@ void ADTree::init(){
 
 	initializeReader(); // defined in engine.h
 
+	SnpDataCache cache(param_reader);
+	int numInitSNPs = 0, numInitPhen = 0;
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		delete reader;
+		return;
+	}
+
 	reader->process(data->getDataObject(), param_reader);
+	numInitSNPs = data->geno_size();
+	numInitPhen = data->pheno_size();
 	
 	data->getDataObject()->prep_data(param_reader);
 	
@@ -83,6 +92,7 @@ void ADTree::init(){
 	data->getDataObject()->remove_haplotype();
 	//data->getDataObject()->pass_through_bootstrap();
 	delete reader; // No longer needed.
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 
 }
 
@@ -272,22 +282,22 @@ void ADTree::weights( double *ret_weights , int pre_cond, long attribute, Condit
 			val_at_p = true;
 			switch (test){
 				case Condition::GE :
-					val_at_c = ((data->get_data(i))->at(attribute) >= val);	
+					val_at_c = (data->get_data(i).at(attribute) >= val);	
 				break;
 				case Condition::GT :
-					val_at_c = ((data->get_data(i))->at(attribute) > val);
+					val_at_c = (data->get_data(i).at(attribute) > val);
 				break;
 				case Condition::LT :
-					val_at_c = ((data->get_data(i))->at(attribute) < val);
+					val_at_c = (data->get_data(i).at(attribute) < val);
 				break;
 				case Condition::LE :
-					val_at_c = ((data->get_data(i))->at(attribute) <= val);
+					val_at_c = (data->get_data(i).at(attribute) <= val);
 				break;
 				case Condition::EQ :
-					val_at_c = ((data->get_data(i))->at(attribute) == val);
+					val_at_c = (data->get_data(i).at(attribute) == val);
 				break;
 				case Condition::NE :
-					val_at_c = ((data->get_data(i))->at(attribute) != val);
+					val_at_c = (data->get_data(i).at(attribute) != val);
 				break;
 			}
 			
@@ -330,7 +340,6 @@ void ADTree::weights2(double *ret_weights, int pre_cond, long attribute){
 	bool val_at_p = false;
 	bool val_at_c1 = false;
 	bool val_at_c2 = false;
-	vector<short>* vec;
 
 	// Initialize ret_weights to 0.
 	for(int i=0;i < 9;i++){ret_weights[i] = 0;}
@@ -339,9 +348,9 @@ void ADTree::weights2(double *ret_weights, int pre_cond, long attribute){
 	for(int i=0; i < this->data->pheno_size() ; i++){
 		if(pre->evaluate_truth(data->get_data(i))){
 			val_at_p = true;
-			vec = data->get_data(i);
-			val_at_c1 = (vec->at(attribute) >= 2);	
-			val_at_c2 = (vec->at(attribute) >= 4); // so really just 4	
+			GenotypeRow vec = data->get_data(i);
+			val_at_c1 = (vec.at(attribute) >= 2);	
+			val_at_c2 = (vec.at(attribute) >= 4); // so really just 4	
 			
 		}else{
 			val_at_p = false;
@@ -388,14 +397,9 @@ void ADTree::weights2(double *ret_weights, int pre_cond, long attribute){
  * Returns [phen==2,phen==1] for W_+, W_-
  */
 void ADTree::weights(double *ret_weight){
-	ret_weight[0] = 0; ret_weight[1] = 0;
-	for(int i=0;i < data->pheno_size();i++){
-		if(equal(data->get_phenotype(i) , -1)){
-			ret_weight[1]++;
-		}else if(equal(data->get_phenotype(i) , 1)){
-			ret_weight[0]++;
-		}
-	}
+	// Counted once when the view was made.
+	ret_weight[0] = data->count_phenotype(1);
+	ret_weight[1] = data->count_phenotype(-1);
 }
 
 /**
@@ -564,7 +568,7 @@ double ADTree::score_ordinal(int pre_cond, long snp, short &s, vector<double> &t
 		if(pre->evaluate_truth(data->get_data(ii))){
 			double phen = data->get_phenotype(ii);
 
-			switch (data->get_data(ii)->at(snp)){
+			switch (data->get_data(ii).at(snp)){
 				case 1:
 					if(equal(phen,-1)){
 						w1m += weight_vec.at(ii);
@@ -701,8 +705,8 @@ void ADTree::classify(int a[4], SnpData * data){
  * Return the classification for this individual.
  * @return int 1 or -1 based on sign.
  */
-int ADTree::classify(vector<short> &data){
-	double score = tree.evaluate_instance(&data);
+int ADTree::classify(const GenotypeRow &data){
+	double score = tree.evaluate_instance(data);
 	return score > 0 ? 1 : -1;
 }
 
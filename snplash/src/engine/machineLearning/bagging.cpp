@@ -79,10 +79,19 @@ void Bagging::init(){
 		exit(1);
 	}
 
+	SnpDataCache cache(param_reader);
+	int numInitSNPs = 0, numInitPhen = 0;
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		return;
+	}
+
 	reader->process(data->getDataObject(), param_reader);
+	numInitSNPs = data->geno_size();
+	numInitPhen = data->pheno_size();
 	data->getDataObject()->prep_data(param_reader);
 	data->make_categorical(-1,1);
 	data->getDataObject()->remove_haplotype();
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 }
 
 /**
@@ -329,4 +338,4 @@ void Bagging::print_and_process(int bags, AD_Rule &a){
 /////////////////////////////////////////////////////////////////////
 void Bagging::classify(int a[4]){} // Run test on the actual data.
 void Bagging::classify(int a[4], SnpData *){} // Run test on passed data.
-int Bagging::classify(vector<short> &){return 0;}// Run test on single individual.
+int Bagging::classify(const GenotypeRow &){return 0;}// Run test on single individual.
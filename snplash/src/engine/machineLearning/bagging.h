@@ -53,7 +53,7 @@ class Bagging : public Classifies {
         /// Classification
         virtual void classify(int a[4]); // Run test on the actual data.
         virtual void classify(int a[4], SnpData *); // Run test on passed data.
-		virtual int classify(vector<short> &); // Run test on single individual.
+		virtual int classify(const GenotypeRow &); // Run test on single individual.
 	
 	private : 
 	
@@ -31,11 +31,11 @@ Condition::Condition(){
  *
  * Returns: the boolean value for this Condition on this data.
  */
-bool Condition::evaluate(vector<short> *vec){
+bool Condition::evaluate(const GenotypeRow &vec){
 
 	if(attribute_index == -1){return true;} // A fake value.
 
-	short a = vec->at(this->attribute_index);
+	short a = vec.at(this->attribute_index);
 	
 	// Missing is always false.
 	if(a == 0){return false;}
@@ -58,7 +58,7 @@ class Condition {
 		//	 5 : ==
 		//	 6 : !=
 		
-		bool evaluate(vector<short> *);
+		bool evaluate(const GenotypeRow &);
 		
 		void inverse();
 		string print(DataAccess *data);
@@ -23,6 +23,7 @@
 CrossValidation::CrossValidation(){
 	param_reader = ParamReader::Instance();
 	data = new DataAccess;
+	data->init(NULL);
 	cross_param = new EngineParamReader;
 	haveOwner = false;
 	order_in_bag = 0;
@@ -37,44 +38,75 @@ void CrossValidation::init(){
 
 	initializeReader(); // defined in engine.h
 
+	SnpDataCache cache(param_reader);
+	int numInitSNPs = 0, numInitPhen = 0;
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		delete reader;
+		return;
+	}
+
 	reader->process(data->getDataObject(), param_reader);
+	numInitSNPs = data->geno_size();
+	numInitPhen = data->pheno_size();
 
 	data->getDataObject()->prep_data(param_reader);
 	data->make_categorical(-1,1);
 	data->getDataObject()->remove_haplotype();
 	delete reader; // No longer needed.	
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 	
 }
+CrossValidation::~CrossValidation(){
+	for(unsigned int i=0; i < engines.size(); i++){
+		delete engines.at(i);
+	}
+	for(unsigned int i=0; i < views.size(); i++){
+		delete views.at(i);
+	}
+	if(!haveOwner){
+		delete cross_param;
+		delete data;
+	}
+}
+
 /**
  * Create all of the engines and set up the master-slave system.
  * Create data first.
+ *
+ * No data is copied: each engine gets a view of the shared data holding
+ * every fold but its own, and out_of_bag records which engine has not
+ * seen each individual.
  */
 void CrossValidation::preProcess(){
 	
 	// Create data.
-	int start_pos = 0;//data->create_cv_data(cross_param->get_number_of_bags(), this->order_in_bag, this->out_of_bag);
+	int folds = cross_param->get_cross_validation();
+	data->make_folds(folds, this->out_of_bag);
+	for(int i=0; i < 4; i++){
+		results[i] = 0;
+	}
+	for(int i=0; i < folds; i++){
+		DataAccess *d = new DataAccess();
+		d->init(data->getDataObject());
+		views.push_back(d);
+	}
 	
 	if(cross_param->get_engine_type() == ParamReader::ADTREE){
-		ADTree *e ;//= new ADTree(param_reader, data);
-		for(int i=0; i < cross_param->get_number_of_bags(); i++){
-			e = new ADTree(data);
-			engines.push_back(e);
-		}
-		for(int i=0; i < cross_param->get_number_of_bags(); i++){
-//			engines.at(i)->enslave(cross_param, i+start_pos);
+		for(int i=0; i < folds; i++){
+			engines.push_back(new ADTree(views.at(i)));
 		}
 	}else if(cross_param->get_engine_type() == ParamReader::BAGGING){
-		Bagging *e ;//= new ADTree(data);
-		for(int i=0; i < cross_param->get_number_of_bags(); i++){
-			e = new Bagging(data);
-			engines.push_back(e);
-		}
-		for(int i=0; i < cross_param->get_number_of_bags(); i++){
-	//		engines.at(i)->enslave(cross_param, i+start_pos);
+		for(int i=0; i < folds; i++){
+			engines.push_back(new Bagging(views.at(i)));
 		}
 	}else{
 		cerr << "Warning: no engines assigned." << endl;
 	}
+
+	for(unsigned int i=0; i < engines.size(); i++){
+		engines.at(i)->enslave(cross_param);
+		views.at(i)->setRedirectFold(this->out_of_bag, i, false);
+	}
 }
 /**
  * Make this engine controllable by another.
@@ -92,7 +124,7 @@ void CrossValidation::enslave(EngineParamReader *b){
  */
 void CrossValidation::process(){
 	
-	int num_bags = cross_param->get_number_of_bags();
+	int num_bags = engines.size();
 	
 	#pragma omp parallel
 	{
@@ -107,7 +139,7 @@ void CrossValidation::process(){
 	for(unsigned int i=0;i < data->pheno_size();++i){
 		
 		int oob = out_of_bag.at(i); // Get correct OOB tree.
-		int score = engines.at(oob)->classify(*(data->get_data(i)));
+		int score = engines.at(oob)->classify(data->get_data(i));
 		if(equal(data->get_phenotype(i) , -1)){
 			if(score < 0){
 				results[3]++;
@@ -131,4 +163,4 @@ void CrossValidation::classify(int a[4]){
 		a[i] = results[i];
 }
 void CrossValidation::classify(int a[4], SnpData *){} // Run test on passed data.
-int CrossValidation::classify(vector<short> &){return 0;} // Run test on single individual.
+int CrossValidation::classify(const GenotypeRow &){return 0;} // Run test on single individual.
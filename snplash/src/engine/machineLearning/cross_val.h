@@ -42,7 +42,7 @@ class CrossValidation : public Classifies {
     
 	explicit CrossValidation();
 
-	~CrossValidation(){};
+	~CrossValidation();
 	
 	/// From engine
 	virtual void init();
@@ -54,7 +54,7 @@ class CrossValidation : public Classifies {
 	/// Classification
 	virtual void classify(int a[4]); // Run test on the actual data.
 	virtual void classify(int a[4], SnpData *); // Run test on passed data.
-	virtual int classify(vector<short> &); // Run test on single individual.
+	virtual int classify(const GenotypeRow &); // Run test on single individual.
     
     private : 
 	bool haveOwner;
@@ -63,6 +63,7 @@ class CrossValidation : public Classifies {
 	vector<bool> classification;
 	vector<int> out_of_bag;
 	vector<Classifies *> engines; // Holds the cast of engines.
+	vector<DataAccess *> views; // The training data of each engine.
 	ofstream outstream;
 	
 	/// Result vector
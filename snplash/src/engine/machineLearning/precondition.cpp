@@ -26,7 +26,7 @@
  * @param *v address to instance.  No checking of sizes because this should be fast.
  * @return boolean truth value
  */
-bool Precondition::evaluate_truth(vector<short> *v){
+bool Precondition::evaluate_truth(const GenotypeRow &v){
 	for(unsigned int i=0; i < conditions.size(); ++i){
 		if(! conditions.at(i).evaluate(v) ){return false;}
 	}
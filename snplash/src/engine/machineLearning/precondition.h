@@ -32,7 +32,7 @@ class Precondition {
 		vector<Condition> conditions;
 		
 		Condition last_condition();
-		bool evaluate_truth(vector<short> *);	
+		bool evaluate_truth(const GenotypeRow &);	
 		string to_string(DataAccess *data);
 		string hash();
 		void used(vector<long> &);
@@ -0,0 +1,145 @@
+/*
+ *      checkpoint.cpp
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#include "checkpoint.hh"
+#include "../snp_data_cache.hh"
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+	const char *checkpoint_head = "SNPLASH CHECKPOINT 1";
+}
+
+Checkpoint::Checkpoint(){
+	seconds = 0;
+	last = 0;
+	unchecked = 0;
+}
+
+/**
+ * The key is the data cache's key (inputs and data options) followed by
+ * the output options and the engine options, except the ones that only
+ * say how to checkpoint.
+ */
+void Checkpoint::init(ParamReader *param, EngineParamReader *eparams){
+	SnpDataCache cache(param);
+	stringstream ss;
+	ss << cache.get_key();
+	ss << "out " << param->get_out_file() << " " << param->get_compress_output() << " " << param->get_column_output() << endl;
+	ss << "options";
+	vector<string> *options = param->get_engine_specific_params();
+	for(unsigned int i=0; i < options->size(); i++){
+		if(options->at(i).compare("--resume") == 0) continue;
+		if(options->at(i).compare("--checkpoint") == 0){
+			i++;
+			continue;
+		}
+		ss << " " << options->at(i);
+	}
+	ss << endl;
+	init(param->get_out_file() + ".ckpt", ss.str(), 60 * eparams->get_checkpoint_minutes());
+}
+
+void Checkpoint::init(const string &fileName, const string &key, int seconds){
+	file = fileName;
+	this->key = key;
+	this->seconds = seconds;
+	last = time(NULL);
+	unchecked = 0;
+}
+
+bool Checkpoint::open(Output &out, const string &outFile, bool compress, bool resume, long &lines){
+	lines = 0;
+	if(!resume) return out.init(outFile, compress);
+
+	unsigned long long offset;
+	if(!load(lines, offset)) return false;
+	cout << "Resuming after " << lines << " lines." << endl;
+	return out.resume(outFile, compress, offset);
+}
+
+/*
+ * Save if it is time to.  The file must be on disk before the checkpoint
+ * that points into it.
+ */
+void Checkpoint::check(long lines, Output &out){
+	unchecked = 0;
+	time_t now = time(NULL);
+	if(now - last < seconds) return;
+	save(lines, out.sync());
+	last = time(NULL);
+}
+
+bool Checkpoint::save(long lines, unsigned long long offset){
+	string tmp = file + ".tmp";
+	FILE *f = fopen(tmp.c_str(), "w");
+	if(f == NULL){
+		cerr << "Could not write checkpoint " << tmp << endl;
+		return false;
+	}
+	stringstream ss;
+	ss << checkpoint_head << endl;
+	ss << "lines " << lines << endl;
+	ss << "offset " << offset << endl;
+	ss << key;
+	string s = ss.str();
+	bool ok = fwrite(s.data(), 1, s.size(), f) == s.size();
+	ok = fflush(f) == 0 && ok;
+	ok = fsync(fileno(f)) == 0 && ok;
+	ok = fclose(f) == 0 && ok;
+	if(!ok || rename(tmp.c_str(), file.c_str()) != 0){
+		cerr << "Could not write checkpoint " << file << endl;
+		remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool Checkpoint::load(long &lines, unsigned long long &offset){
+	ifstream in(file.c_str());
+	if(!in.is_open()){
+		cerr << "There is no checkpoint " << file << " to resume from." << endl;
+		return false;
+	}
+	string head, word;
+	getline(in, head);
+	in >> word >> lines;
+	in >> word >> offset;
+	getline(in, word);
+	if(!in.good() || head.compare(checkpoint_head) != 0){
+		cerr << file << " is not a checkpoint." << endl;
+		return false;
+	}
+	stringstream rest;
+	rest << in.rdbuf();
+	if(rest.str() != key){
+		cerr << file << " is from a run with other inputs or options.  Run with the same ones to resume." << endl;
+		return false;
+	}
+	return true;
+}
+
+void Checkpoint::finish(){
+	if(!file.empty()) remove(file.c_str());
+}
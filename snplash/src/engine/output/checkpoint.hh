@@ -0,0 +1,106 @@
+/*
+ *      checkpoint.hh
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/**
+ * Progress of a long all-pairs run (INTERTWOLOG, DPRIME), so that a run
+ * that is killed can be picked up again with --resume.
+ *
+ * Every so often the writer thread gets the result file onto disk and then
+ * records, in <out>.ckpt, how many lines it has written, the size of the
+ * file at that point and the key of the run: the input files and options,
+ * as for the data cache, plus the engine options.  A resumed run checks the
+ * key, cuts the result file back to the recorded size, appends to it and
+ * skips the pairs already written.  The file is removed when a run ends.
+ *
+ * The checkpoint is written to a temporary file and renamed, so a run
+ * killed while saving leaves the previous one.
+ *
+ * Layout, text:
+ *
+ *   SNPLASH CHECKPOINT 1
+ *   lines <lines written>
+ *   offset <bytes of result file>
+ *   key lines
+ */
+
+#include <string>
+#include <ctime>
+#include "output.h"
+#include "../../param/param_reader.h"
+#include "../../param/engine_param_reader.h"
+
+using namespace std;
+
+// Lines written between looks at the clock.
+#define CHECKPOINT_CHECK_LINES 4096
+
+class Checkpoint {
+
+	public:
+
+		Checkpoint();
+
+		/* Use <out>.ckpt and the key of this run.  Saves every eparams->get_checkpoint_minutes(). */
+		void init(ParamReader *param, EngineParamReader *eparams);
+		/* Same, with the key and interval given. */
+		void init(const string &fileName, const string &key, int seconds);
+
+		/*
+		 * Open out for this run.  Resuming, the file is cut back to the last
+		 * checkpoint and lines is the number already written; otherwise it
+		 * is a new file and lines is 0.
+		 */
+		bool open(Output &out, const string &outFile, bool compress, bool resume, long &lines);
+
+		/* Writer thread: called with the number of lines written after each one. */
+		void wrote(long lines, Output &out){
+			if(seconds > 0 && ++unchecked >= CHECKPOINT_CHECK_LINES) check(lines, out);
+		}
+
+		/* Record progress now. */
+		bool save(long lines, unsigned long long offset);
+		/* Read the last progress recorded.  False if there is none for this run. */
+		bool load(long &lines, unsigned long long &offset);
+
+		/* The run is complete; drop the checkpoint. */
+		void finish();
+
+		const string &get_file() const {return file;}
+
+	protected:
+		string file;
+		string key;
+		int seconds;       // 0 for no checkpoints.
+		time_t last;       // Time of the last save.
+		int unchecked;     // Lines since the clock was read.
+
+		void check(long lines, Output &out);
+
+	private:
+		Checkpoint(const Checkpoint &);
+		Checkpoint &operator=(const Checkpoint &);
+};
+
+#endif
@@ -0,0 +1,339 @@
+#include "column_output.hh"
+
+#include <limits>
+#include <string.h>
+
+namespace {
+
+void append_raw(string &s, const void *v, size_t n){
+	s.append(static_cast<const char *>(v), n);
+}
+
+template<class T>
+void append_value(string &s, T v){
+	append_raw(s, &v, sizeof(T));
+}
+
+template<class T>
+bool read_value(istream &in, T &v){
+	in.read(reinterpret_cast<char *>(&v), sizeof(T));
+	return in.good();
+}
+
+const unsigned int byte_order_mark = 0x01020304;
+const size_t magic_size = 8;
+
+}
+
+/*************************************************************************
+ *
+ * Writer
+ *
+ *************************************************************************/
+ColumnOutput::ColumnOutput(){
+	current = 0;
+	block_rows = 0;
+	total_rows = 0;
+}
+
+ColumnOutput::~ColumnOutput(){
+	close();
+}
+
+void ColumnOutput::add_column(const string &name, ColumnType type){
+	Column c;
+	c.name = name;
+	c.type = type;
+	c.min = numeric_limits<double>::infinity();
+	c.max = -numeric_limits<double>::infinity();
+	columns.push_back(c);
+}
+
+/**
+ * Open the file and write the column descriptions.
+ */
+bool ColumnOutput::init(string fileName){
+	out.open(fileName.c_str(), ios::out | ios::binary);
+	if(!out.is_open()) return false;
+
+	string head(COLUMN_MAGIC);
+	append_value(head, byte_order_mark);
+	append_value(head, static_cast<unsigned int>(columns.size()));
+	for(unsigned int i=0;i < columns.size();i++){
+		append_value(head, static_cast<unsigned char>(columns[i].type));
+		append_value(head, static_cast<unsigned int>(columns[i].name.size()));
+		head += columns[i].name;
+		if(columns[i].type != COLUMN_STRING){
+			columns[i].data.reserve(COLUMN_BLOCK_ROWS * sizeof(double));
+		}
+	}
+	out.write(head.data(), head.size());
+	return out.good();
+}
+
+/* Write the last block and the footer. */
+void ColumnOutput::close(){
+	if(!out.is_open()) return;
+	write_block();
+
+	unsigned long long footer = out.tellp();
+	string tail;
+	append_value(tail, static_cast<unsigned long long>(block_offsets.size()));
+	for(unsigned int i=0;i < block_offsets.size();i++){
+		append_value(tail, block_offsets[i]);
+	}
+	append_value(tail, total_rows);
+	append_value(tail, footer);
+	tail += COLUMN_MAGIC;
+	out.write(tail.data(), tail.size());
+	out.close();
+}
+
+void ColumnOutput::put(int value){
+	if(current >= columns.size()){
+		cerr << "Column output: more values than columns in a row." << endl;
+		return;
+	}
+	Column &c = columns[current++];
+	if(c.type == COLUMN_DOUBLE){
+		append_value(c.data, static_cast<double>(value));
+	}else{
+		append_value(c.data, value);
+	}
+	note(c, value);
+}
+
+void ColumnOutput::put(double value){
+	if(current >= columns.size()){
+		cerr << "Column output: more values than columns in a row." << endl;
+		return;
+	}
+	Column &c = columns[current++];
+	append_value(c.data, value);
+	note(c, value);
+}
+
+void ColumnOutput::put(const string &value){
+	if(current >= columns.size()){
+		cerr << "Column output: more values than columns in a row." << endl;
+		return;
+	}
+	Column &c = columns[current++];
+	c.data += value;
+	c.data += '\0';
+}
+
+void ColumnOutput::end_row(){
+	if(current != columns.size()){
+		cerr << "Column output: row has " << current << " values for " << columns.size() << " columns." << endl;
+	}
+	current = 0;
+	block_rows++;
+	if(block_rows >= COLUMN_BLOCK_ROWS){
+		write_block();
+	}
+}
+
+/* Track the block's range.  NaN never compares, so it is left out. */
+void ColumnOutput::note(Column &c, double value){
+	if(value < c.min) c.min = value;
+	if(value > c.max) c.max = value;
+}
+
+/**
+ * Write the collected rows as one block: the chunk descriptions first so a
+ * reader can skip the block, then each column's chunk.
+ */
+void ColumnOutput::write_block(){
+	if(block_rows == 0) return;
+
+	block_offsets.push_back(out.tellp());
+
+	string head;
+	append_value(head, block_rows);
+	packed.clear();
+	for(unsigned int i=0;i < columns.size();i++){
+		Column &c = columns[i];
+		unsigned long long raw = c.data.size();
+		unsigned long long stored = raw;
+		unsigned char codec = COLUMN_RAW;
+		size_t at = packed.size();
+
+		#if SNPLASH_HAVE_ZLIB
+		uLongf len = compressBound(raw);
+		packed.resize(at + len);
+		if(compress2(reinterpret_cast<Bytef *>(&packed[at]), &len,
+				reinterpret_cast<const Bytef *>(c.data.data()), raw, Z_BEST_SPEED) == Z_OK
+				&& len < raw){
+			packed.resize(at + len);
+			stored = len;
+			codec = COLUMN_DEFLATE;
+		}else{
+			packed.resize(at);
+		}
+		#endif
+		if(codec == COLUMN_RAW) packed += c.data;
+
+		double lo = c.min, hi = c.max;
+		if(c.type == COLUMN_STRING){
+			lo = hi = numeric_limits<double>::quiet_NaN();
+		}
+		append_value(head, codec);
+		append_value(head, raw);
+		append_value(head, stored);
+		append_value(head, lo);
+		append_value(head, hi);
+
+		c.data.clear();
+		c.min = numeric_limits<double>::infinity();
+		c.max = -numeric_limits<double>::infinity();
+	}
+	out.write(head.data(), head.size());
+	out.write(packed.data(), packed.size());
+
+	total_rows += block_rows;
+	block_rows = 0;
+}
+
+/*************************************************************************
+ *
+ * Reader
+ *
+ *************************************************************************/
+ColumnInput::ColumnInput(){
+	total_rows = 0;
+}
+
+/**
+ * Open fileName and read its columns and block headers.
+ *
+ * @return false if the file is missing, truncated or not a column file.
+ */
+bool ColumnInput::open(string fileName){
+	in.open(fileName.c_str(), ios::in | ios::binary);
+	if(!in.is_open()) return false;
+
+	char magic[magic_size];
+	unsigned int mark, ncols;
+	in.read(magic, magic_size);
+	if(!in.good() || memcmp(magic, COLUMN_MAGIC, magic_size) != 0){
+		cerr << fileName << " is not a column result file." << endl;
+		return false;
+	}
+	if(!read_value(in, mark) || mark != byte_order_mark){
+		cerr << fileName << " was written on a machine with a different byte order." << endl;
+		return false;
+	}
+	if(!read_value(in, ncols)) return false;
+	for(unsigned int i=0;i < ncols;i++){
+		unsigned char type;
+		unsigned int len;
+		if(!read_value(in, type) || !read_value(in, len)) return false;
+		string name(len, ' ');
+		if(len > 0) in.read(&name[0], len);
+		names.push_back(name);
+		types.push_back(static_cast<ColumnType>(type));
+	}
+
+	unsigned long long footer, nblocks;
+	in.seekg(-static_cast<long>(sizeof(footer) + magic_size), ios::end);
+	if(!read_value(in, footer)) return false;
+	in.read(magic, magic_size);
+	if(!in.good() || memcmp(magic, COLUMN_MAGIC, magic_size) != 0){
+		cerr << fileName << " is truncated." << endl;
+		return false;
+	}
+	in.seekg(footer);
+	if(!read_value(in, nblocks)) return false;
+	vector<unsigned long long> offsets(nblocks);
+	for(unsigned long long b=0;b < nblocks;b++){
+		if(!read_value(in, offsets[b])) return false;
+	}
+	if(!read_value(in, total_rows)) return false;
+
+	blocks.resize(nblocks);
+	for(unsigned long long b=0;b < nblocks;b++){
+		Block &block = blocks[b];
+		in.seekg(offsets[b]);
+		if(!read_value(in, block.rows)) return false;
+		block.chunks.resize(ncols);
+		for(unsigned int i=0;i < ncols;i++){
+			Chunk &c = block.chunks[i];
+			unsigned char codec;
+			if(!read_value(in, codec) || !read_value(in, c.raw) || !read_value(in, c.stored)
+					|| !read_value(in, c.min) || !read_value(in, c.max)) return false;
+			c.codec = codec;
+		}
+		unsigned long long at = in.tellg();
+		for(unsigned int i=0;i < ncols;i++){
+			block.chunks[i].offset = at;
+			at += block.chunks[i].stored;
+		}
+	}
+	return true;
+}
+
+int ColumnInput::find_column(const string &name) const{
+	for(unsigned int i=0;i < names.size();i++){
+		if(names[i] == name) return i;
+	}
+	return -1;
+}
+
+/* Read and inflate one chunk. */
+bool ColumnInput::load(int block, int col, ColumnType type, string &data){
+	if(types.at(col) != type) return false;
+	const Chunk &c = blocks.at(block).chunks.at(col);
+
+	string stored(c.stored, '\0');
+	in.clear();
+	in.seekg(c.offset);
+	if(c.stored > 0) in.read(&stored[0], c.stored);
+	if(!in.good()) return false;
+
+	if(c.codec == COLUMN_RAW){
+		data.swap(stored);
+		return true;
+	}
+	#if SNPLASH_HAVE_ZLIB
+	data.resize(c.raw);
+	uLongf len = c.raw;
+	return c.codec == COLUMN_DEFLATE
+		&& uncompress(reinterpret_cast<Bytef *>(&data[0]), &len,
+			reinterpret_cast<const Bytef *>(stored.data()), c.stored) == Z_OK
+		&& len == c.raw;
+	#else
+	cerr << "This build has no zlib and cannot read compressed columns." << endl;
+	return false;
+	#endif
+}
+
+bool ColumnInput::read(int block, int col, vector<int> &values){
+	string data;
+	if(!load(block, col, COLUMN_INT, data)) return false;
+	values.resize(data.size() / sizeof(int));
+	if(!values.empty()) memcpy(&values[0], data.data(), values.size() * sizeof(int));
+	return true;
+}
+
+bool ColumnInput::read(int block, int col, vector<double> &values){
+	string data;
+	if(!load(block, col, COLUMN_DOUBLE, data)) return false;
+	values.resize(data.size() / sizeof(double));
+	if(!values.empty()) memcpy(&values[0], data.data(), values.size() * sizeof(double));
+	return true;
+}
+
+bool ColumnInput::read(int block, int col, vector<string> &values){
+	string data;
+	if(!load(block, col, COLUMN_STRING, data)) return false;
+	values.clear();
+	size_t start = 0;
+	for(size_t i=0;i < data.size();i++){
+		if(data[i] == '\0'){
+			values.push_back(data.substr(start, i - start));
+			start = i + 1;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,167 @@
+/*
+ *      column_output.hh
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef COLUMN_OUTPUT_H
+#define COLUMN_OUTPUT_H
+
+/**
+ * A typed, column oriented result file, the binary alternative to the text
+ * tables (-col).
+ *
+ * Rows are collected COLUMN_BLOCK_ROWS at a time.  Each full block is
+ * written column by column, every column chunk deflated when zlib is
+ * available.  The block header carries the row count and, for every numeric
+ * column, the smallest and largest value in the block (NaN ignored).  A
+ * reader looking for p-values below a threshold can skip any block whose
+ * minimum is above it without inflating anything.
+ *
+ * Layout, all numbers in host byte order:
+ *
+ *   header   "SNPLCOL1" u32 0x01020304 u32 ncols
+ *            ncols x { u8 type, u32 name length, name }
+ *   block    u32 nrows
+ *            ncols x { u8 codec, u64 raw bytes, u64 stored bytes, f64 min, f64 max }
+ *            ncols x stored bytes of data
+ *   footer   u64 nblocks, nblocks x u64 block offset, u64 nrows
+ *   trailer  u64 footer offset, "SNPLCOL1"
+ *
+ * Ints are stored as i32, doubles as f64 and strings as bytes ending in '\0'.
+ *
+ * Like Output, a ColumnOutput is not thread safe; engines fill it from their
+ * writer thread.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#if SNPLASH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+// Rows collected before a block is written.
+#define COLUMN_BLOCK_ROWS 8192
+
+#define COLUMN_MAGIC "SNPLCOL1"
+
+enum ColumnType { COLUMN_INT = 1, COLUMN_DOUBLE = 2, COLUMN_STRING = 3 };
+enum ColumnCodec { COLUMN_RAW = 0, COLUMN_DEFLATE = 1 };
+
+class ColumnOutput {
+
+	public:
+
+		ColumnOutput();
+		~ColumnOutput();
+
+		/* Describe the columns, in order, before init. */
+		void add_column(const string &name, ColumnType type);
+		bool init(string fileName);
+		void close();
+
+		/* Values of the current row, one per column in order. */
+		void put(int value);
+		void put(double value);
+		void put(const string &value);
+		void end_row();
+
+		int num_columns() const {return columns.size();}
+
+	private:
+
+		struct Column {
+			string name;
+			ColumnType type;
+			string data;
+			double min, max;
+		};
+
+		vector<Column> columns;
+		unsigned int current; // column the next put() fills.
+		unsigned int block_rows;
+		unsigned long long total_rows;
+		vector<unsigned long long> block_offsets;
+		ofstream out;
+		string packed;
+
+		void write_block();
+		void note(Column &c, double value);
+
+		ColumnOutput(const ColumnOutput &);
+		ColumnOutput &operator=(const ColumnOutput &);
+};
+
+/**
+ * Reads files written by ColumnOutput.  The block headers are read when the
+ * file is opened; column data only when asked for.
+ */
+class ColumnInput {
+
+	public:
+
+		ColumnInput();
+
+		bool open(string fileName);
+
+		int num_columns() const {return names.size();}
+		const string &column_name(int col) const {return names.at(col);}
+		ColumnType column_type(int col) const {return types.at(col);}
+		/* -1 if there is no such column. */
+		int find_column(const string &name) const;
+
+		unsigned long long num_rows() const {return total_rows;}
+		int num_blocks() const {return blocks.size();}
+		unsigned int block_rows(int block) const {return blocks.at(block).rows;}
+
+		/* Range of a numeric column over one block. */
+		double block_min(int block, int col) const {return blocks.at(block).chunks.at(col).min;}
+		double block_max(int block, int col) const {return blocks.at(block).chunks.at(col).max;}
+
+		/* Read one column of one block.  False on a type mismatch or a bad file. */
+		bool read(int block, int col, vector<int> &values);
+		bool read(int block, int col, vector<double> &values);
+		bool read(int block, int col, vector<string> &values);
+
+	private:
+
+		struct Chunk {
+			int codec;
+			unsigned long long raw, stored, offset;
+			double min, max;
+		};
+		struct Block {
+			unsigned int rows;
+			vector<Chunk> chunks;
+		};
+
+		ifstream in;
+		vector<string> names;
+		vector<ColumnType> types;
+		vector<Block> blocks;
+		unsigned long long total_rows;
+
+		bool load(int block, int col, ColumnType type, string &data);
+};
+
+#endif
@@ -43,13 +43,13 @@ void DandelionOutput::setMaxPersonId(int maxPersonSize){
  */
 bool DandelionOutput::init(ParamReader *param, EngineParamReader *engine_param, int numSnps, string message){
 
-	bool ret = outMain.init(param->get_out_file());
+	bool ret = outMain.init(param->get_out_file(), param->get_compress_output());
 	outMain.write_header(message);
 	if(ret) writeHeader(numSnps);
 
 
 	if(engine_param->get_dandelion_pprob()){
-		ret = ret && outPProb.init(param->get_out_file() + ".pprob");
+		ret = ret && outPProb.init(param->get_out_file() + ".pprob", param->get_compress_output());
 	}
 
 	return ret;
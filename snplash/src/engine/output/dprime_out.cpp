@@ -4,14 +4,25 @@
 LinkageOutput::LinkageOutput(){
 	outputType = 0;
 	beginSNP = 0;
+	checkpointed = false;
+	resuming = false;
+	firstLine = 0;
 }
 LinkageOutput::~LinkageOutput(){
 	
 }
-bool LinkageOutput::init(int outputType, ParamReader *param, int maxMapSize){
-	return init(outputType, param->get_out_file(), param, maxMapSize);
+bool LinkageOutput::init(int outputType, ParamReader *param, EngineParamReader *eparams, int maxMapSize, bool ordered){
+	// Only the pair list, written line by line in order, can be picked up again.
+	checkpointed = ordered && outputType == 3;
+	resuming = eparams->get_resume();
+	if(resuming && !checkpointed){
+		cerr << "--resume only works when every pair is listed (--dprime_fmt 3, no --report_r2 or --top)." << endl;
+		return false;
+	}
+	if(checkpointed) checkpoint.init(param, eparams);
+	return init(outputType, param->get_out_file(), param, maxMapSize, ordered);
 }
-bool LinkageOutput::init(int outputType, string fileName, ParamReader *param, int maxMapSize){
+bool LinkageOutput::init(int outputType, string fileName, ParamReader *param, int maxMapSize, bool ordered){
 	
 	if(maxMapSize < 8)
 		maxMapSize = 8;
@@ -20,8 +31,9 @@ bool LinkageOutput::init(int outputType, string fileName, ParamReader *param, in
 	beginSNP = param->get_begin();
 	
 	this->outputType = outputType;
-	bool ret = out.init(param->get_out_file());
-	if(ret){
+	bool ret = checkpoint.open(out, param->get_out_file(), param->get_compress_output(), resuming, firstLine);
+	// A resumed file has its headers already.
+	if(ret && !resuming){
 		
 		out.write_header("**************************************************************************************\n");
 		out.write_header("Drime, a part of SNPLASH Version ");
@@ -86,20 +98,43 @@ bool LinkageOutput::init(int outputType, string fileName, ParamReader *param, in
         
        
 	}
-	return ret;
+	return ret && (!ordered || queue.start(this, firstLine));
+}
+
+/*
+ * Queue the measures for the writer thread.
+ */
+void LinkageOutput::printLine(const LinkageMeasures &m, long order){
+	queue.push(m, order);
+}
+
+/*
+ * Write pairs chosen by the engine.  They are already in the order wanted
+ * and there are few of them, so they bypass the queue.
+ */
+void LinkageOutput::printReport(const vector<LinkageMeasures> &pairs){
+	for(unsigned int i=0;i < pairs.size();i++){
+		consume(pairs[i], i);
+	}
 }
 
 /*
- * Build the line requested and call output.
+ * Build the line requested and call output.  Runs on the writer thread.
  */
-void LinkageOutput::printLine(LinkageMeasures m, int order){
+void LinkageOutput::consume(const LinkageMeasures &m, long order){
 	if(outputType == 3){
 		
-		stringstream ss;
-		ss << strnutils::spaced_string(m.name1,8) <<  strnutils::spaced_string(m.name2,8,2);
-		ss << strnutils::spaced_number(m.dee,10,7,2) << strnutils::spaced_number(m.dPrime,10,8,2);
-		ss << strnutils::spaced_number(m.rsquare,10,8,2) << strnutils::spaced_number(m.delta,10,7,2) << endl;
-		out.write_line(ss.str(), order);
+		string &ss = lineBuf;
+		ss.clear();
+		strnutils::append_spaced_string(ss, m.name1,8);
+		strnutils::append_spaced_string(ss, m.name2,8,2);
+		strnutils::append_spaced_number(ss, m.dee,10,7,2);
+		strnutils::append_spaced_number(ss, m.dPrime,10,8,2);
+		strnutils::append_spaced_number(ss, m.rsquare,10,8,2);
+		strnutils::append_spaced_number(ss, m.delta,10,7,2);
+		ss += '\n';
+		out.write_line(ss);
+		if(checkpointed) checkpoint.wrote(order + 1, out);
 	
 	}else if(outputType == 2){
 		fmt2_storage[m.index1][m.index2] = m;
@@ -221,9 +256,11 @@ void LinkageOutput::create_fmt2_output(){
  */
 void LinkageOutput::close(){
 	
+	queue.stop();
 	if(outputType == 2){
 		create_fmt2_output();
 	}
 	
 	out.close();
+	if(checkpointed) checkpoint.finish();
 }
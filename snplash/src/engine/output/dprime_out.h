@@ -26,8 +26,11 @@
  * Output class for dprime.  Uses an output class.  
  */
 #include "output.h"
+#include "result_queue.hh"
+#include "checkpoint.hh"
 #include "../../param/param_reader.h"
 #include <sstream> // Used to create and manage the string.
+#include <vector>
 #include <map>
 #include "../utils/stringutils.h"
 
@@ -47,7 +50,7 @@ struct LinkageMeasures{
 	double	rsquare;
 };
 
-class LinkageOutput {
+class LinkageOutput : public ResultSink<LinkageMeasures> {
 	
 	friend class LinkageDisequilibrium;
 	
@@ -57,17 +60,35 @@ class LinkageOutput {
 		LinkageOutput();
 		~LinkageOutput();
 		
-		bool init(int, ParamReader *, int maxMapSize); // use default file name.
-		bool init(int, string filename, ParamReader *, int maxMapSize); // use passed in file name.
+		/* With ordered false, nothing goes through the queue; see printReport. */
+		bool init(int, ParamReader *, EngineParamReader *, int maxMapSize, bool ordered = true); // use default file name.
+		bool init(int, string filename, ParamReader *, int maxMapSize, bool ordered = true); // use passed in file name.
 		
 		void close();
+
+		/* Writer thread: write or store one pair. */
+		void consume(const LinkageMeasures &m, long order);
+
+		/* Pairs a resumed run had already written; 0 for a new run. */
+		long first_line() const {return firstLine;}
 	
 	protected:
 		Output out;
+		ResultQueue<LinkageMeasures> queue;
+		/* Line buffer, reused by the writer thread for every pair. */
+		string lineBuf;
+		/* Progress of a run writing the pair list (see Checkpoint). */
+		Checkpoint checkpoint;
+		bool checkpointed;
+		bool resuming;
+		long firstLine;
 		/* Output types: 3 [default] -> row is a SNP 
 		 * 				 2 -> matrix of values. */
 		int outputType;
-		void printLine(LinkageMeasures m, int order);
+		/* Queue a pair's results; any thread. */
+		void printLine(const LinkageMeasures &m, long order);
+		/* Write the selected pairs as they are, from the calling thread. */
+		void printReport(const vector<LinkageMeasures> &pairs);
 		
 		/* Used in output format 2 */
 		map<int, map<int, LinkageMeasures> > fmt2_storage;
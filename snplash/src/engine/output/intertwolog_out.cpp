@@ -23,6 +23,9 @@
 #include "../../snplashConfig.h"
 
 InterTwoLogOutput::InterTwoLogOutput(){
+	writeColumns = false;
+	checkpointed = false;
+	firstLine = 0;
 }
 
 InterTwoLogOutput::~InterTwoLogOutput(){
@@ -42,12 +45,35 @@ InterTwoLogOutput::~InterTwoLogOutput(){
  */
 bool InterTwoLogOutput::init(ParamReader *param, EngineParamReader *eparams, int maxMapSize, string message){
 
-	bool ret = out.init(param->get_out_file());
+	writeColumns = param->get_column_output();
+	// Only a text file of every pair, in order, can be picked up again.
+	checkpointed = !writeColumns && !eparams->get_report_pairs();
+	bool resume = eparams->get_resume();
+	if(resume && !checkpointed){
+		cerr << "--resume only works when every pair is written as text (no -col, --report_p or --top)." << endl;
+		return false;
+	}
+
+	bool ret;
+	if(writeColumns){
+		outColumns.add_column("index1", COLUMN_INT);
+		outColumns.add_column("name1", COLUMN_STRING);
+		outColumns.add_column("index2", COLUMN_INT);
+		outColumns.add_column("name2", COLUMN_STRING);
+		outColumns.add_column("beta", COLUMN_DOUBLE);
+		outColumns.add_column("pVal", COLUMN_DOUBLE);
+		outColumns.add_column("SE", COLUMN_DOUBLE);
+		ret = outColumns.init(param->get_out_file() + ".col");
+	}else{
+		if(checkpointed) checkpoint.init(param, eparams);
+		ret = checkpoint.open(out, param->get_out_file(), param->get_compress_output(), resume, firstLine);
+	}
 
 	mapSize = maxMapSize;
 	if(mapSize < 4) mapSize = 4;
 
-	if(ret){
+	// A resumed file has its headers already.
+	if(ret && !writeColumns && !resume){
 		writeMainHeader(param);
 		out.write_header(message);
 		writeMainLegend();
@@ -55,11 +81,16 @@ bool InterTwoLogOutput::init(ParamReader *param, EngineParamReader *eparams, int
 
 	writeLogHead(param);
 
-	return ret;
+	// Selected pairs are written at the end without the queue.
+	if(eparams->get_report_pairs()) return ret;
+	return ret && queue.start(this, firstLine);
 }
 
 void InterTwoLogOutput::close(){
+	queue.stop();
 	out.close();
+	outColumns.close();
+	if(checkpointed) checkpoint.finish();
 }
 
 /*************************************************************************
@@ -67,19 +98,50 @@ void InterTwoLogOutput::close(){
  * Main writing method.
  *
  *************************************************************************/
-void InterTwoLogOutput::printLine(const InterTwoLogMeasures &itlo, int order){
+void InterTwoLogOutput::printLine(const InterTwoLogMeasures &itlo, long order){
+	queue.push(itlo, order);
+}
+
+/*
+ * Write pairs chosen by the engine.  They are already in the order wanted
+ * and there are few of them, so they bypass the queue.
+ */
+void InterTwoLogOutput::printReport(const vector<InterTwoLogMeasures> &pairs){
+	for(unsigned int i=0;i < pairs.size();i++){
+		consume(pairs[i], i);
+	}
+}
+
+/*
+ * Format one line, or add a row to the column file, on the writer thread.
+ */
+void InterTwoLogOutput::consume(const InterTwoLogMeasures &itlo, long order){
 	
-	stringstream ss;
-	ss << strnutils::spaced_number(itlo.index1, 8,0);
-	ss << strnutils::spaced_string(itlo.name1, mapSize,2);
-	ss << strnutils::spaced_number(itlo.index2, 8,2);
-	ss << strnutils::spaced_string(itlo.name2, mapSize,2);
-	ss << strnutils::spaced_number(itlo.beta, 10, 7,2);
-	ss << strnutils::spaced_number(itlo.pVal, 10, 7,2);
-	ss << strnutils::spaced_number(itlo.SE, 8, 6,2);
-	ss << endl;
-	
-	out.write_line(ss.str(), order);
+	if(writeColumns){
+		outColumns.put(itlo.index1);
+		outColumns.put(itlo.name1);
+		outColumns.put(itlo.index2);
+		outColumns.put(itlo.name2);
+		outColumns.put(itlo.beta);
+		outColumns.put(itlo.pVal);
+		outColumns.put(itlo.SE);
+		outColumns.end_row();
+		return;
+	}
+
+	string &ss = lineBuf;
+	ss.clear();
+	strnutils::append_spaced_number(ss, itlo.index1, 8,0);
+	strnutils::append_spaced_string(ss, itlo.name1, mapSize,2);
+	strnutils::append_spaced_number(ss, itlo.index2, 8,2);
+	strnutils::append_spaced_string(ss, itlo.name2, mapSize,2);
+	strnutils::append_spaced_number(ss, itlo.beta, 10, 7,2);
+	strnutils::append_spaced_number(ss, itlo.pVal, 10, 7,2);
+	strnutils::append_spaced_number(ss, itlo.SE, 8, 6,2);
+	ss += '\n';
+	
+	out.write_line(ss);
+	if(checkpointed) checkpoint.wrote(order + 1, out);
 }
 
 
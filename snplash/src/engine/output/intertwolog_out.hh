@@ -25,9 +25,13 @@
  * Output class for dprime.  Uses an output class.  
  */
 #include "output.h"
+#include "result_queue.hh"
+#include "column_output.hh"
+#include "checkpoint.hh"
 #include "../../param/param_reader.h"
 #include "../../param/engine_param_reader.h"
 #include <sstream> // Used to create and manage the string.
+#include <vector>
 #include "../utils/stringutils.h"
 
 #include "../../logger/log.hh"
@@ -42,7 +46,7 @@ struct InterTwoLogMeasures{
 	double 	beta;
 	double 	SE;
 };
-class InterTwoLogOutput {
+class InterTwoLogOutput : public ResultSink<InterTwoLogMeasures> {
 	
 	friend class InterTwoLog;
 	
@@ -52,11 +56,30 @@ class InterTwoLogOutput {
 		
 		bool init(ParamReader *, EngineParamReader *, int maxMapSize, string message);
 		void close();
+
+		/* Writer thread: format and write one pair. */
+		void consume(const InterTwoLogMeasures &itlo, long order);
+
+		/* Pairs a resumed run had already written; 0 for a new run. */
+		long first_line() const {return firstLine;}
 	
 	protected:
 		Output out;
+		/* Results when writeColumns is set. */
+		ColumnOutput outColumns;
+		bool writeColumns;
+		ResultQueue<InterTwoLogMeasures> queue;
+		/* Line buffer, reused by the writer thread for every pair. */
+		string lineBuf;
+		/* Progress of a run writing every pair as text (see Checkpoint). */
+		Checkpoint checkpoint;
+		bool checkpointed;
+		long firstLine;
 
-		void printLine(const InterTwoLogMeasures &itlo, int order);
+		/* Queue a pair's results; any thread. */
+		void printLine(const InterTwoLogMeasures &itlo, long order);
+		/* Write the selected pairs as they are, from the calling thread. */
+		void printReport(const vector<InterTwoLogMeasures> &pairs);
 		
 		
 		void writeMainHeader(ParamReader *param);
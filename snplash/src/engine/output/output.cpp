@@ -1,51 +1,126 @@
 #include "output.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 Output::Output(){
-	n_line = p_line = 0;
 	outfile = "";
-	
+	compressed = false;
+	#if SNPLASH_HAVE_ZLIB
+	gz = NULL;
+	#endif
 }
 
-bool Output::init(string fileName){
+Output::~Output(){
+	close();
+}
+
+bool Output::init(string fileName, bool compress){
+	compressed = compress;
+	buffer.reserve(OUTPUT_WRITE_BYTES + 4096);
+	if(compress){
+		#if SNPLASH_HAVE_ZLIB
+		outfile = fileName + ".gz";
+		gz = gzopen(outfile.c_str(), "wb");
+		return gz != NULL;
+		#else
+		cerr << "This build has no zlib; writing " << fileName << " uncompressed." << endl;
+		compressed = false;
+		#endif
+	}
+	outfile = fileName;
 	outstream.open(fileName.c_str());
 	return outstream.is_open();
 }
 
-/* Check that no lines remain in buffer and then print. */	
+/**
+ * Reopen a file left by an earlier run.  Whatever follows offset (lines
+ * written after the last checkpoint) is thrown away.
+ *
+ * @return false if the file is missing or shorter than offset.
+ */
+bool Output::resume(string fileName, bool compress, unsigned long long offset){
+	compressed = compress;
+	buffer.reserve(OUTPUT_WRITE_BYTES + 4096);
+	#if SNPLASH_HAVE_ZLIB
+	if(compress) fileName += ".gz";
+	#else
+	compressed = false;
+	#endif
+	outfile = fileName;
+
+	struct stat st;
+	if(stat(fileName.c_str(), &st) != 0 || static_cast<unsigned long long>(st.st_size) < offset){
+		cerr << fileName << " is missing or shorter than its checkpoint." << endl;
+		return false;
+	}
+	if(truncate(fileName.c_str(), offset) != 0){
+		cerr << "Could not cut " << fileName << " back to its checkpoint." << endl;
+		return false;
+	}
+	#if SNPLASH_HAVE_ZLIB
+	if(compressed){
+		gz = gzopen(fileName.c_str(), "ab");
+		return gz != NULL;
+	}
+	#endif
+	outstream.open(fileName.c_str(), ios::out | ios::app);
+	return outstream.is_open();
+}
+
+/* Write out what is buffered and close the file. */
 void Output::close(){
-	if(lines.size() > 0){
-		cerr << "Caution: calling close on an asynchronous output buffer"
-			<< " with " << lines.size() << " unwritten lines."  << endl;
-		cerr << "Line " << p_line << " was never received." << endl;
+	flush();
+	if(outstream.is_open()){
+		outstream.close();
 	}
-	outstream.close();
-	lines.clear();
+	#if SNPLASH_HAVE_ZLIB
+	if(gz != NULL){
+		gzclose(gz);
+		gz = NULL;
+	}
+	#endif
 }
 
-void Output::write_header(string head){
-	outstream << head;
+void Output::flush(){
+	if(buffer.empty()) return;
+	if(compressed){
+		#if SNPLASH_HAVE_ZLIB
+		if(gz != NULL) gzwrite(gz, buffer.data(), buffer.size());
+		#endif
+	}else if(outstream.is_open()){
+		outstream.write(buffer.data(), buffer.size());
+		outstream.flush();
+	}
+	buffer.clear();
 }
-/*
- * This is called to print a line.
- * 1) Include the line in the map 'lines' at specified order.
- * 2) If the order matches p_line then print it and all others while
- * they exist.
- */
-void Output::write_line(string line, int order){
-	#pragma omp critical
-	{
-		lines[order] = line;
-		if(order == p_line){
-			outstream << lines[p_line];
-			lines.erase(p_line);
-			p_line++;
-			while(lines.count(p_line) > 0){
-				outstream << lines[p_line];
-				lines.erase(p_line);
-				p_line++;
-			}
-		}else if(p_line > order){
-			cerr << "Problem in output class: requested print of a line out of order.  Got " << p_line << " but expected >= " << order << endl;
-		}
+
+void Output::write_header(const string &head){
+	write_line(head);
+}
+
+void Output::write_line(const string &line){
+	buffer += line;
+	if(buffer.size() >= OUTPUT_WRITE_BYTES){
+		flush();
+	}
+}
+
+unsigned long long Output::sync(){
+	flush();
+	if(compressed){
+		#if SNPLASH_HAVE_ZLIB
+		if(gz != NULL) gzflush(gz, Z_FINISH);
+		#endif
+	}
+
+	unsigned long long size = 0;
+	int fd = open(outfile.c_str(), O_RDONLY);
+	if(fd >= 0){
+		fsync(fd);
+		struct stat st;
+		if(fstat(fd, &st) == 0) size = st.st_size;
+		::close(fd);
 	}
+	return size;
 }
@@ -20,8 +20,11 @@
  */
 
 /**
- * An output engine used for storing results from asychronous computation
- * in an ordered way.  Lines are assumed to be ordered, which gives 
+ * One result file.  Everything written is collected in a buffer and written
+ * to the file in blocks of OUTPUT_WRITE_BYTES, optionally through gzip.
+ *
+ * Not thread safe.  Engines running in parallel write their lines from a
+ * single thread by way of a ResultQueue (see result_queue.hh).
  */
 
 #ifndef OUTPUT_H
@@ -29,33 +32,50 @@
 
 #include <iostream>
 #include <string>
-#include <map>		// to maintain the lines we have to print
 #include <fstream> // for file output.
+#if SNPLASH_HAVE_ZLIB
+#include <zlib.h>
+#endif
 using namespace std;
 
+// Bytes collected before they are written out.
+#define OUTPUT_WRITE_BYTES (1 << 20)
+
 class Output {
 	
 	public:
 	
 		Output();
+		~Output();
 	 
-		bool init(string fileName);
+		/* Open fileName, or fileName.gz if compress is set. */
+		bool init(string fileName, bool compress = false);
+		/* Open an existing file, cut back to offset bytes, to append to it. */
+		bool resume(string fileName, bool compress, unsigned long long offset);
 		void close();
 		void flush();
-		void write_header(string head);
-		void write_line(string line, int order);	
+		/*
+		 * Get everything written so far onto disk and return the size of
+		 * the file.  A compressed file ends its gzip member here, so it can
+		 * be cut back to this size and resumed.
+		 */
+		unsigned long long sync();
+		void write_header(const string &head);
+		/* Lines must arrive in the order they belong in the file. */
+		void write_line(const string &line);
 		
 	private:
 	
 		ofstream outstream;
+		#if SNPLASH_HAVE_ZLIB
+		gzFile gz;
+		#endif
+		bool compressed;
 		string outfile;
+		string buffer;
 		
-		/* Next int contains the next line missing */
-		int n_line;
-		/* Next int contains the next line to print */
-		int p_line;
-		
-		map<int, string> lines;
+		Output(const Output &);
+		Output &operator=(const Output &);
 };
 
 #endif
@@ -27,9 +27,11 @@ QSnpgwaOutput::QSnpgwaOutput(){
 }
 
 QSnpgwaOutput::~QSnpgwaOutput(){
+    close();
 }
 
 void QSnpgwaOutput::close(){
+    queue.stop();
     outMain.close();
     outGeno1.close();
     outGeno2.close();
@@ -55,23 +57,24 @@ bool QSnpgwaOutput::init(ParamReader *param, EngineParamReader *eparams, int max
     writeGenoFiles = eparams->get_output_geno();
     writeValFile = eparams->get_output_val();
 
-    bool ret = outMain.init(param->get_out_file());
+    bool gz = param->get_compress_output();
+    bool ret = outMain.init(param->get_out_file(), gz);
 
     string t = param->get_out_file();
 
     if(writeGenoFiles){
-        ret = ret && outGeno1.init(t + ".geno1");
-        ret = ret && outGeno2.init(t + ".geno2");
-        ret = ret && outGeno3.init(t + ".geno3");
+        ret = ret && outGeno1.init(t + ".geno1", gz);
+        ret = ret && outGeno2.init(t + ".geno2", gz);
+        ret = ret && outGeno3.init(t + ".geno3", gz);
     }
 
     if(writeHWEFiles){
-        ret = ret && outHWE.init(t + ".hwe");
+        ret = ret && outHWE.init(t + ".hwe", gz);
     }
 
-    if(writeRefFile) ret = ret && outRefAllele.init(t + ".ref");
+    if(writeRefFile) ret = ret && outRefAllele.init(t + ".ref", gz);
     
-    if(writeValFile) ret = ret && outVal.init(t + ".statvals");
+    if(writeValFile) ret = ret && outVal.init(t + ".statvals", gz);
 
     if(ret){
         writeMainHeader(outMain, param);
@@ -100,7 +103,7 @@ bool QSnpgwaOutput::init(ParamReader *param, EngineParamReader *eparams, int max
         }
     }
 
-    return ret;
+    return ret && queue.start(this);
 }
 
 /**
@@ -205,160 +208,186 @@ out.write_header("---------- ------ ------ ------ ------------ -- -- ------ ----
 }
 
 /**
- * Write a line.
+ * Write a line.  The results are only queued here; consume() writes them.
  */
 void QSnpgwaOutput::writeLine(int idx, SnpInfo &q, const ContPopStatsResults &cp
     , const ContGenoStatsResults &cg){
+
+    QSnpgwaRecord r;
+    r.s = q;
+    r.p = cp;
+    r.g = cg;
+    queue.push(r, idx);
+}
+
+/**
+ * Format the lines for one SNP, on the writer thread.
+ */
+void QSnpgwaOutput::consume(const QSnpgwaRecord &r, long){
+
+    const SnpInfo &q = r.s;
+    const ContPopStatsResults &cp = r.p;
+    const ContGenoStatsResults &cg = r.g;
         
-    stringstream ss;
+    string &ss = lineBuf;
+    ss.clear();
     // print starting information.
     q.print(ss, mapSize);
     
-    ss << strnutils::spaced_number(cp.totalIndiv, 6,3);
-    ss << strnutils::spaced_number(cp.maf,6,4,2);
+    strnutils::append_spaced_number(ss, cp.totalIndiv, 6,3);
+    strnutils::append_spaced_number(ss, cp.maf,6,4,2);
     
-    ss << strnutils::spaced_number(cp.perMissing,6,2,2);
-    ss << strnutils::spaced_number(cp.perMissingPVal,12,10,1);
+    strnutils::append_spaced_number(ss, cp.perMissing,6,2,2);
+    strnutils::append_spaced_number(ss, cp.perMissingPVal,12,10,1);
     
-    ss << "  " << q.majAllele << "  " << q.minAllele << "   " << q.refAllele;
+    ss += "  ";
+    ss += q.majAllele;
+    ss += "  ";
+    ss += q.minAllele;
+    ss += "   ";
+    ss += q.refAllele;
     
     // HWE
     
-    ss << strnutils::spaced_number(cp.numPP,7,6);
-    ss << strnutils::spaced_number(cp.expPP,7,1,1);
-    ss << strnutils::spaced_number(cp.numPQ,7,1);
-    ss << strnutils::spaced_number(cp.expPQ,7,1,1);
-    ss << strnutils::spaced_number(cp.numQQ,7,1);
-    ss << strnutils::spaced_number(cp.expQQ,7,1,1);
-    ss << strnutils::spaced_number(cp.chiSqPval,12,10,1);
-    ss << strnutils::spaced_number(cp.pHWE,12,10,1);
+    strnutils::append_spaced_number(ss, cp.numPP,7,6);
+    strnutils::append_spaced_number(ss, cp.expPP,7,1,1);
+    strnutils::append_spaced_number(ss, cp.numPQ,7,1);
+    strnutils::append_spaced_number(ss, cp.expPQ,7,1,1);
+    strnutils::append_spaced_number(ss, cp.numQQ,7,1);
+    strnutils::append_spaced_number(ss, cp.expQQ,7,1,1);
+    strnutils::append_spaced_number(ss, cp.chiSqPval,12,10,1);
+    strnutils::append_spaced_number(ss, cp.pHWE,12,10,1);
     
     // Regression
     
-    ss << strnutils::spaced_number(cg.twodegfree_pval,12,10,4);
+    strnutils::append_spaced_number(ss, cg.twodegfree_pval,12,10,4);
     
-    ss << strnutils::spaced_number(cg.dom_pval,12,10,1);
-    ss << strnutils::spaced_number(cg.dom_beta,10,5,1);
-    ss << strnutils::spaced_number(cg.dom_se,10,5,1);
+    strnutils::append_spaced_number(ss, cg.dom_pval,12,10,1);
+    strnutils::append_spaced_number(ss, cg.dom_beta,10,5,1);
+    strnutils::append_spaced_number(ss, cg.dom_se,10,5,1);
     
-    ss << strnutils::spaced_number(cg.add_pval,12,10,1);
-    ss << strnutils::spaced_number(cg.add_beta,10,5,1);
-    ss << strnutils::spaced_number(cg.add_se,10,5,1);
+    strnutils::append_spaced_number(ss, cg.add_pval,12,10,1);
+    strnutils::append_spaced_number(ss, cg.add_beta,10,5,1);
+    strnutils::append_spaced_number(ss, cg.add_se,10,5,1);
     
-    ss << strnutils::spaced_number(cg.rec_pval,12,10,1);
-    ss << strnutils::spaced_number(cg.rec_beta,10,5,1);
-    ss << strnutils::spaced_number(cg.rec_se,10,5,1);
+    strnutils::append_spaced_number(ss, cg.rec_pval,12,10,1);
+    strnutils::append_spaced_number(ss, cg.rec_beta,10,5,1);
+    strnutils::append_spaced_number(ss, cg.rec_se,10,5,1);
     
-    ss << strnutils::spaced_number(cg.lof_pval, 12, 10, 1);
+    strnutils::append_spaced_number(ss, cg.lof_pval, 12, 10, 1);
 
     // Moments
     
-    ss << strnutils::spaced_number(cg.meanAA,10,4,1);
-    ss << strnutils::spaced_number(cg.sdAA,10,4,1);
-    ss << strnutils::spaced_number(cg.meanAa,10,4,1);
-    ss << strnutils::spaced_number(cg.sdAa,10,4,1);
-    ss << strnutils::spaced_number(cg.meanaa,10,4,1);
-    ss << strnutils::spaced_number(cg.sdaa,10,4,1);
-    ss << strnutils::spaced_number(cg.meanAA_Aa,10,4,1);
-    ss << strnutils::spaced_number(cg.sdAA_Aa,10,4,1);
-    ss << strnutils::spaced_number(cg.meanAa_aa,10,4,1);
-    ss << strnutils::spaced_number(cg.sdAa_aa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.meanAA,10,4,1);
+    strnutils::append_spaced_number(ss, cg.sdAA,10,4,1);
+    strnutils::append_spaced_number(ss, cg.meanAa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.sdAa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.meanaa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.sdaa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.meanAA_Aa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.sdAA_Aa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.meanAa_aa,10,4,1);
+    strnutils::append_spaced_number(ss, cg.sdAa_aa,10,4,1);
     
     // LD
-    ss << strnutils::spaced_number(cg.dprime, 7, 5, 4);
-    ss << strnutils::spaced_number(cg.rsquare, 7, 5, 1);
+    strnutils::append_spaced_number(ss, cg.dprime, 7, 5, 4);
+    strnutils::append_spaced_number(ss, cg.rsquare, 7, 5, 1);
     
-    ss << endl;
-    outMain.write_line(ss.str(), idx);
+    ss += '\n';
+    outMain.write_line(ss);
     
-    if(writeHWEFiles) writeHWELine(idx, q, cp);
-    if(writeValFile) writeValLine(idx, q, cp, cg);
+    if(writeHWEFiles) writeHWELine(q, cp);
+    if(writeValFile) writeValLine(q, cp, cg);
 }
 
-void QSnpgwaOutput::writeHWELine(int idx, const SnpInfo &s, const ContPopStatsResults &p){
+void QSnpgwaOutput::writeHWELine(const SnpInfo &s, const ContPopStatsResults &p){
     
-    stringstream ss;
+    string &ss = lineBuf;
+    ss.clear();
     
     if(s.name.size() > 0){
-        ss << strnutils::spaced_string(s.name, 10);
+        strnutils::append_spaced_string(ss, s.name, 10);
     }else{
-        ss << strnutils::spaced_number(s.index, 10);
+        strnutils::append_spaced_number(ss, s.index, 10);
     }
     
-    ss << strnutils::spaced_number(p.totalIndiv, 9,1);
-    ss << strnutils::spaced_number(p.maf, 11, 6, 4);
+    strnutils::append_spaced_number(ss, p.totalIndiv, 9,1);
+    strnutils::append_spaced_number(ss, p.maf, 11, 6, 4);
     
-    ss << strnutils::spaced_number(100*p.perMissing, 9, 2, 4);
-    ss << strnutils::spaced_number(p.perMissingPVal, 12, 10, 4);
+    strnutils::append_spaced_number(ss, 100*p.perMissing, 9, 2, 4);
+    strnutils::append_spaced_number(ss, p.perMissingPVal, 12, 10, 4);
     
-    ss << " " << s.majAllele;
-    ss << " " << s.minAllele;
+    ss += " ";
+    ss += s.majAllele;
+    ss += " ";
+    ss += s.minAllele;
     
-    ss << "     " << s.refAllele;
+    ss += "     ";
+    ss += s.refAllele;
     
-    ss << strnutils::spaced_number(p.numPP, 5,2);
-    ss << strnutils::spaced_number(p.expPP, 5,2);
+    strnutils::append_spaced_number(ss, p.numPP, 5,2);
+    strnutils::append_spaced_number(ss, p.expPP, 5,2);
     
-    ss << strnutils::spaced_number(p.numPQ, 5,2);
-    ss << strnutils::spaced_number(p.expPQ, 5,2);
+    strnutils::append_spaced_number(ss, p.numPQ, 5,2);
+    strnutils::append_spaced_number(ss, p.expPQ, 5,2);
     
-    ss << strnutils::spaced_number(p.numQQ, 5,2);
-    ss << strnutils::spaced_number(p.expQQ, 5,2);
+    strnutils::append_spaced_number(ss, p.numQQ, 5,2);
+    strnutils::append_spaced_number(ss, p.expQQ, 5,2);
     
-    ss << strnutils::spaced_number(p.chiSqPval, 8,6);
-    ss << strnutils::spaced_number(p.pHWE, 8,6);
+    strnutils::append_spaced_number(ss, p.chiSqPval, 8,6);
+    strnutils::append_spaced_number(ss, p.pHWE, 8,6);
 }
 
 /**
  * Write output line for the value file.  This is a separate file that contains
  * test statistics rather than their corresponding p-values.
  * 
- * @param ids Index in final file (for asynchronous update)
  * @param s Contains SNP info to write.
  * @param p Contains population stats results to write.
  * @param h Contains haplotype stats results to write.
  * @param g Contains genotypic stats results to write.
  */
-void QSnpgwaOutput::writeValLine(int ids, SnpInfo &q, const ContPopStatsResults &cp,
+void QSnpgwaOutput::writeValLine(const SnpInfo &q, const ContPopStatsResults &cp,
     const ContGenoStatsResults &cg){
 
-	stringstream ss;
+	string &ss = lineBuf;
+	ss.clear();
 
 	if(q.name.size() > 0){
-		ss << strnutils::spaced_string(q.name, 10);
+		strnutils::append_spaced_string(ss, q.name, 10);
 	}else{
-		ss << strnutils::spaced_number(q.index, 10);
+		strnutils::append_spaced_number(ss, q.index, 10);
 	}
 	
-	ss << strnutils::spaced_number(cg.twodegfree_fStat, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.twodegfree_sse, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.twodegfree_ssr, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.twodegfree_n1, 4, 0, 1);
-	ss << strnutils::spaced_number(cg.twodegfree_n2, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.twodegfree_fStat, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.twodegfree_sse, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.twodegfree_ssr, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.twodegfree_n1, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.twodegfree_n2, 4, 0, 1);
 	
-	ss << strnutils::spaced_number(cg.dom_fStat, 14, 12, 3);
-	ss << strnutils::spaced_number(cg.dom_sse, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.dom_ssr, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.dom_n1, 4, 0, 1);
-	ss << strnutils::spaced_number(cg.dom_n2, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.dom_fStat, 14, 12, 3);
+	strnutils::append_spaced_number(ss, cg.dom_sse, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.dom_ssr, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.dom_n1, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.dom_n2, 4, 0, 1);
 	
-	ss << strnutils::spaced_number(cg.add_fStat, 14, 12, 3);
-	ss << strnutils::spaced_number(cg.add_sse, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.add_ssr, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.add_n1, 4, 0, 1);
-	ss << strnutils::spaced_number(cg.add_n2, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.add_fStat, 14, 12, 3);
+	strnutils::append_spaced_number(ss, cg.add_sse, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.add_ssr, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.add_n1, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.add_n2, 4, 0, 1);
 	
-	ss << strnutils::spaced_number(cg.rec_fStat, 14, 12, 3);
-	ss << strnutils::spaced_number(cg.rec_sse, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.rec_ssr, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.rec_n1, 4, 0, 1);
-	ss << strnutils::spaced_number(cg.rec_n2, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.rec_fStat, 14, 12, 3);
+	strnutils::append_spaced_number(ss, cg.rec_sse, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.rec_ssr, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.rec_n1, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.rec_n2, 4, 0, 1);
 	
-	ss << strnutils::spaced_number(cg.lof_fStat, 14, 12, 3);
-	ss << strnutils::spaced_number(cg.lof_sse, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.lof_ssr, 14, 12, 1);
-	ss << strnutils::spaced_number(cg.lof_n1, 4, 0, 1);
-	ss << strnutils::spaced_number(cg.lof_n2, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.lof_fStat, 14, 12, 3);
+	strnutils::append_spaced_number(ss, cg.lof_sse, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.lof_ssr, 14, 12, 1);
+	strnutils::append_spaced_number(ss, cg.lof_n1, 4, 0, 1);
+	strnutils::append_spaced_number(ss, cg.lof_n2, 4, 0, 1);
 	
 	
 /*
@@ -380,8 +409,8 @@ void QSnpgwaOutput::writeValLine(int ids, SnpInfo &q, const ContPopStatsResults
 	ss << strnutils::spaced_number(h.threeMarkerChiS, 14,12,4);
 	ss << strnutils::spaced_number(h.threeMarkerDF, 4,0,1);
 */
-	ss << endl;
+	ss += '\n';
 
-	outVal.write_line(ss.str(), ids);
+	outVal.write_line(ss);
 
 }
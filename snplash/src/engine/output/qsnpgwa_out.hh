@@ -35,6 +35,7 @@
  * All but the log file are handled in this class.
  */
 #include "output.h"
+#include "result_queue.hh"
 #include "snpinfo_out.hh"
 #include "../../param/param_reader.h"
 #include "../../param/engine_param_reader.h"
@@ -125,7 +126,14 @@ struct ContGenoStatsResults{
 	double dprime;
 };
 
-class QSnpgwaOutput {
+/* Everything written for one SNP, as queued for the writer thread. */
+struct QSnpgwaRecord{
+	SnpInfo s;
+	ContPopStatsResults p;
+	ContGenoStatsResults g;
+};
+
+class QSnpgwaOutput : public ResultSink<QSnpgwaRecord> {
 	
 	friend class QSnpgwa;
 	
@@ -136,14 +144,21 @@ class QSnpgwaOutput {
 		
 		bool init(ParamReader *param, EngineParamReader *eparams, int maxMapSize, string message);
 		void close();
+
+		/* Writer thread: format and write one SNP. */
+		void consume(const QSnpgwaRecord &r, long order);
 	
 	protected :
 
 		Output outMain, outGeno1, outGeno2, outGeno3, outHWE, outRefAllele, outVal;
+		ResultQueue<QSnpgwaRecord> queue;
+		/* Line buffer, reused by the writer thread for every SNP. */
+		string lineBuf;
 
+		/* Queue a SNP's results; any thread. */
 		void writeLine(int idx, SnpInfo &q, const ContPopStatsResults &cp,
 			const ContGenoStatsResults &cg);
-		void writeValLine(int ids, SnpInfo &q, const ContPopStatsResults &cp,
+		void writeValLine(const SnpInfo &q, const ContPopStatsResults &cp,
 			const ContGenoStatsResults &cg);
 
 		/* HWE writers */
@@ -161,7 +176,7 @@ class QSnpgwaOutput {
 		void writeMainLegend(Output &);
 		void writeHWELegend(Output &);
 		
-		void writeHWELine(int idx, const SnpInfo &s, const ContPopStatsResults &p);
+		void writeHWELine(const SnpInfo &s, const ContPopStatsResults &p);
 		
 		int mapSize;
 };
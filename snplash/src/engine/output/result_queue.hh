@@ -0,0 +1,218 @@
+/*
+ *      result_queue.hh
+ *
+ *      
+ *      Copyright 2010 Richard T. Guy <guyrt@guyrt-lappy>
+ *      
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *      
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *      
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef RESULT_QUEUE_H
+#define RESULT_QUEUE_H
+
+/**
+ * Hands results from the compute threads to a single writer thread, in
+ * order.
+ *
+ * Compute threads push() a record tagged with its position in the output.
+ * It goes into a fixed ring of RESULT_QUEUE_SIZE slots at
+ * order % RESULT_QUEUE_SIZE without taking a lock: the record is copied in
+ * and then the slot is published by storing its order.  A thread more than
+ * a ring ahead of the writer waits until its slot comes free, so memory use
+ * does not grow with the run.
+ *
+ * The writer thread hands each record, in order, to a ResultSink.  That is
+ * where formatting and file writes happen, so none of it is on the compute
+ * threads and the sink needs no locking of its own.
+ *
+ * Whoever produces the next record to be written must never be waiting on
+ * a later one; loops that hand each thread increasing orders are fine.
+ */
+
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+using namespace std;
+
+// Records held in the ring.
+#define RESULT_QUEUE_SIZE 16384
+
+template <class T>
+class ResultSink {
+	public:
+		virtual ~ResultSink() {}
+		/* Called on the writer thread for every record, in order. */
+		virtual void consume(const T &record, long order) = 0;
+		/* Called on the writer thread when it has nothing to do for a while. */
+		virtual void idle() {}
+};
+
+template <class T>
+class ResultQueue {
+
+	public:
+		ResultQueue() : ring(NULL), next(0), stopping(false), running(false), sink(NULL) {}
+		~ResultQueue() {stop();}
+
+		/* Start the writer thread.  Records, from order first on, then go to sink. */
+		bool start(ResultSink<T> *sink, long first = 0);
+		/* Queue a record.  Safe to call from any number of threads. */
+		void push(const T &record, long order);
+		/* Hand over everything queued and stop the writer thread. */
+		void stop();
+
+		bool is_running() const {return running;}
+
+	protected:
+		struct Slot {
+			volatile long order; // Order of the record held, -1 if none.
+			T record;
+		};
+		Slot *ring;
+
+		/* Next record for the sink.  Only the writer thread changes it. */
+		volatile long next;
+		volatile bool stopping;
+		bool running;
+		ResultSink<T> *sink;
+		pthread_t writer;
+
+		static void *drain(void *self);
+		void drain();
+		static void nap(int idle);
+
+	private:
+		ResultQueue(const ResultQueue &);
+		ResultQueue &operator=(const ResultQueue &);
+};
+
+template <class T>
+bool ResultQueue<T>::start(ResultSink<T> *sink, long first){
+	if(running) return true;
+
+	this->sink = sink;
+	ring = new Slot[RESULT_QUEUE_SIZE];
+	for(int i=0; i < RESULT_QUEUE_SIZE; i++){
+		ring[i].order = -1;
+	}
+	next = first;
+	stopping = false;
+	running = pthread_create(&writer, NULL, &ResultQueue<T>::drain, this) == 0;
+	if(!running){
+		cerr << "Could not start the output writer thread." << endl;
+	}
+	return running;
+}
+
+template <class T>
+void ResultQueue<T>::push(const T &record, long order){
+	if(!running){
+		cerr << "Problem in output class: record " << order << " queued with no writer running." << endl;
+		return;
+	}
+	if(order < next){
+		cerr << "Problem in output class: requested print of a line out of order.  Got " << next << " but expected >= " << order << endl;
+		return;
+	}
+	for(int idle=0; order >= next + RESULT_QUEUE_SIZE; idle++){
+		nap(idle);
+	}
+	__sync_synchronize(); // The writer is done with the slot's last record.
+
+	Slot &s = ring[order % RESULT_QUEUE_SIZE];
+	s.record = record;
+	__sync_synchronize(); // Record stored before it is published.
+	s.order = order;
+}
+
+template <class T>
+void ResultQueue<T>::stop(){
+	if(!running) return;
+
+	stopping = true;
+	pthread_join(writer, NULL);
+	running = false;
+
+	long waiting = 0;
+	for(int i=0; i < RESULT_QUEUE_SIZE; i++){
+		if(ring[i].order >= next) waiting++;
+	}
+	if(waiting > 0){
+		cerr << "Caution: calling close on an asynchronous output buffer"
+			<< " with " << waiting << " unwritten lines."  << endl;
+		cerr << "Line " << next << " was never received." << endl;
+	}
+	delete [] ring;
+	ring = NULL;
+}
+
+template <class T>
+void *ResultQueue<T>::drain(void *self){
+	static_cast<ResultQueue<T> *>(self)->drain();
+	return NULL;
+}
+
+/*
+ * Writer thread: pass records to the sink in order.  Exits once stop() is
+ * called and every record before the first gap has been passed on.
+ */
+template <class T>
+void ResultQueue<T>::drain(){
+	int idle = 0;
+	while(true){
+		bool last = stopping;
+		__sync_synchronize(); // Records pushed before stop() are visible.
+
+		bool moved = false;
+		while(true){
+			Slot &s = ring[next % RESULT_QUEUE_SIZE];
+			if(s.order != next) break;
+			__sync_synchronize();
+			sink->consume(s.record, next);
+			__sync_synchronize();
+			next = next + 1;
+			moved = true;
+		}
+
+		if(moved){
+			idle = 0;
+		}else if(idle == 16){
+			sink->idle();
+		}
+		if(last){
+			break;
+		}
+		nap(idle++);
+	}
+	sink->idle();
+}
+
+/* Wait a little, longer the longer we have been idle. */
+template <class T>
+void ResultQueue<T>::nap(int idle){
+	if(idle < 16){
+		sched_yield();
+	}else{
+		struct timespec t;
+		t.tv_sec = 0;
+		t.tv_nsec = idle < 64 ? 20000 : 500000;
+		nanosleep(&t, NULL);
+	}
+}
+
+#endif
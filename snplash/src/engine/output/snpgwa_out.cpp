@@ -26,6 +26,7 @@ SnpgwaOutput::SnpgwaOutput(){
 	writeMainFileMap = false;
 	writeMainFileHap = writeRefFile = true;
 	writeValFile = false;
+	writeColumns = false;
 
 	maxMapSize = 0;
 }
@@ -69,36 +70,46 @@ bool SnpgwaOutput::init(ParamReader *param, EngineParamReader *eparams, int maxM
 
 	writeValFile = eparams->get_output_val();
 
-	bool ret = outMain.init(param->get_out_file());
-
+	bool gz = param->get_compress_output();
 	string t = param->get_out_file();
 
+	writeColumns = param->get_column_output();
+	bool ret;
+	if(writeColumns){
+		addColumns();
+		ret = outColumns.init(t + ".col");
+	}else{
+		ret = outMain.init(t, gz);
+	}
+
 	if(writeGenoFiles){
-		ret = ret && outGeno1.init(t + ".geno1");
-		ret = ret && outGeno2.init(t + ".geno2");
-		ret = ret && outGeno3.init(t + ".geno3");
+		ret = ret && outGeno1.init(t + ".geno1", gz);
+		ret = ret && outGeno2.init(t + ".geno2", gz);
+		ret = ret && outGeno3.init(t + ".geno3", gz);
 	}
 
 	if(writeHWEFiles){
-		ret = ret && outHWEcase.init(t + ".hwecase");
-		ret = ret && outHWEcntrl.init(t + ".hwecntrl");
-		ret = ret && outHWEcomb.init(t + ".hwe");
+		ret = ret && outHWEcase.init(t + ".hwecase", gz);
+		ret = ret && outHWEcntrl.init(t + ".hwecntrl", gz);
+		ret = ret && outHWEcomb.init(t + ".hwe", gz);
 	}
 
 	if(writeHaploFiles){
-		ret = ret && outGeno1.init(t + ".haplo1");
-		ret = ret && outGeno2.init(t + ".haplo2");
-		ret = ret && outGeno3.init(t + ".haplo3");
+		ret = ret && outGeno1.init(t + ".haplo1", gz);
+		ret = ret && outGeno2.init(t + ".haplo2", gz);
+		ret = ret && outGeno3.init(t + ".haplo3", gz);
 	}
 
-	if(writeRefFile) ret = ret && outRefAllele.init(t + ".ref");
+	if(writeRefFile) ret = ret && outRefAllele.init(t + ".ref", gz);
 
-	if(writeValFile) ret = ret && outVal.init(t + ".statvals");
+	if(writeValFile) ret = ret && outVal.init(t + ".statvals", gz);
 
 	if(ret){
-		writeMainHeader(outMain, param);
-		outMain.write_header(message);
-		writeMainLegend(outMain);
+		if(!writeColumns){
+			writeMainHeader(outMain, param);
+			outMain.write_header(message);
+			writeMainLegend(outMain);
+		}
 
 		if(writeGenoFiles){
 			writeMainHeader(outGeno1, param);
@@ -126,11 +137,13 @@ bool SnpgwaOutput::init(ParamReader *param, EngineParamReader *eparams, int maxM
 
 	writeLogHead(param);
 
-	return ret;
+	return ret && queue.start(this);
 }
 
 void SnpgwaOutput::close(){
+	queue.stop();
 	outMain.close();
+	outColumns.close();
 	outGeno1.close();
 	outGeno2.close();
 	outGeno3.close();
@@ -156,232 +169,498 @@ void SnpgwaOutput::close(){
  * The index is for parallel creation of an in-order output file.
  * It must be 0 based.
  *
- * The main file is written here.  Others are written via calls from here.
+ * The results are only queued here; consume() writes them.
  */
 void SnpgwaOutput::writeLine(int idx, SnpInfo &s, const PopStatsResults &p,
 	const HaploStatsResults &h, const GenoStatsResults &g)
 {
-	stringstream ss;
+	SnpgwaRecord r;
+	r.s = s;
+	r.p = p;
+	r.h = h;
+	r.g = g;
+	queue.push(r, idx);
+}
+
+/**
+ * Write the results for one SNP, on the writer thread.
+ *
+ * The main file, or the column file, is written here.  Others are written
+ * via calls from here.
+ */
+void SnpgwaOutput::consume(const SnpgwaRecord &r, long)
+{
+	const SnpInfo &s = r.s;
+	const PopStatsResults &p = r.p;
+	const HaploStatsResults &h = r.h;
+	const GenoStatsResults &g = r.g;
+
+	if(writeColumns){
+		writeColumnRow(s, p, h, g);
+	}else{
+		writeMainLine(s, p, h, g);
+	}
+
+	if(writeValFile) writeValLine(s, p, h, g);
+	if(writeHWEFiles) writeHWELine(s, p);
+	if(writeGenoFiles) writeGenoLine(s, p, g, h);
+	if(writeRefFile){
+		string &ssr = lineBuf[0];
+		ssr.clear();
+		ssr += s.chr;
+		ssr += " ";
+		if(s.name.size() > 0){
+			strnutils::append_spaced_string(ssr, s.name, 10);
+		}else{
+			strnutils::append_spaced_number(ssr, s.index, 6);
+		}
+		ssr += " 0   ";
+		strnutils::append_number(ssr, s.position);
+		ssr += "  ";
+		ssr += s.refAllele;
+		ssr += '\n';
+		outRefAllele.write_line(ssr);
+	}
+
+}
+
+/**
+ * Format and write the main file line for one SNP.
+ */
+void SnpgwaOutput::writeMainLine(const SnpInfo &s, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g){
+
+	string &ss = lineBuf[0];
+	ss.clear();
 
 	s.print(ss, maxMapSize);
 
-	ss << strnutils::spaced_number(p.caseCount, 8,1);
-	ss << strnutils::spaced_number(p.cntrlCount, 8, 1);
+	strnutils::append_spaced_number(ss, p.caseCount, 8,1);
+	strnutils::append_spaced_number(ss, p.cntrlCount, 8, 1);
 
-	ss << strnutils::spaced_number(p.caseRefFreq, 8, 4, 4);
-	ss << strnutils::spaced_number(p.cntrlRefFreq, 8, 4, 1);
+	strnutils::append_spaced_number(ss, p.caseRefFreq, 8, 4, 4);
+	strnutils::append_spaced_number(ss, p.cntrlRefFreq, 8, 4, 1);
 
-	ss << strnutils::spaced_number(100*p.pMissingCombined, 8, 2, 4);
-	ss << strnutils::spaced_number(100*p.pMissingCase, 8, 2, 1);
-	ss << strnutils::spaced_number(100*p.pMissingCntrl, 8, 2, 1);
-	ss << strnutils::spaced_number(p.missingPVal, 13, 10, 3);
-	ss << strnutils::spaced_number(p.missingOR, 13, 10, 3);
+	strnutils::append_spaced_number(ss, 100*p.pMissingCombined, 8, 2, 4);
+	strnutils::append_spaced_number(ss, 100*p.pMissingCase, 8, 2, 1);
+	strnutils::append_spaced_number(ss, 100*p.pMissingCntrl, 8, 2, 1);
+	strnutils::append_spaced_number(ss, p.missingPVal, 13, 10, 3);
+	strnutils::append_spaced_number(ss, p.missingOR, 13, 10, 3);
 
-	ss << "  " << s.majAllele << "  " << s.minAllele << "   " << s.refAllele;
+	ss += "  ";
+	ss += s.majAllele;
+	ss += "  ";
+	ss += s.minAllele;
+	ss += "   ";
+	ss += s.refAllele;
 
-	ss << strnutils::spaced_number(p.cntrlPP, 5, 2);
-	ss << strnutils::spaced_number(p.casePP, 5, 1);
+	strnutils::append_spaced_number(ss, p.cntrlPP, 5, 2);
+	strnutils::append_spaced_number(ss, p.casePP, 5, 1);
 	if(p.expcmbdPP < 0.01){
-		ss << strnutils::spaced_number(0, 8, 2, 1);
+		strnutils::append_spaced_number(ss, 0, 8, 2, 1);
 	}else{
-		ss << strnutils::spaced_number(p.expcmbdPP, 8, 2, 1);	
+		strnutils::append_spaced_number(ss, p.expcmbdPP, 8, 2, 1);
 	}
-	ss << strnutils::spaced_number(p.cntrlPQ, 5, 1);
-	ss << strnutils::spaced_number(p.casePQ, 5, 1);
+	strnutils::append_spaced_number(ss, p.cntrlPQ, 5, 1);
+	strnutils::append_spaced_number(ss, p.casePQ, 5, 1);
 	if(p.expcmbdPQ < 0.01){
-		ss << strnutils::spaced_number(0, 8, 2, 1);
+		strnutils::append_spaced_number(ss, 0, 8, 2, 1);
 	}else{
-		ss << strnutils::spaced_number(p.expcmbdPQ, 8, 2, 1);	
+		strnutils::append_spaced_number(ss, p.expcmbdPQ, 8, 2, 1);
 	}
-	ss << strnutils::spaced_number(p.cntrlQQ, 5, 1);
-	ss << strnutils::spaced_number(p.caseQQ, 5, 1);
+	strnutils::append_spaced_number(ss, p.cntrlQQ, 5, 1);
+	strnutils::append_spaced_number(ss, p.caseQQ, 5, 1);
 	if(p.expcmbdQQ < 0.01){
-		ss << strnutils::spaced_number(0.0, 8, 2, 1);
+		strnutils::append_spaced_number(ss, 0.0, 8, 2, 1);
 	}else{
-		ss << strnutils::spaced_number(p.expcmbdQQ, 8, 2, 1);	
+		strnutils::append_spaced_number(ss, p.expcmbdQQ, 8, 2, 1);
 	}
-	ss << strnutils::spaced_number(p.cmbdPVal, 12,10,1);
-	ss << strnutils::spaced_number(p.cmbdExactPVal, 12,10,1);
-	ss << strnutils::spaced_number(p.caseExactPVal, 12,10,1);
-	ss << strnutils::spaced_number(p.cntrlExactPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, p.cmbdPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, p.cmbdExactPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, p.caseExactPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, p.cntrlExactPVal, 12,10,1);
 
 	// insert geno information.
-	ss << strnutils::spaced_number(g.twodegPVal, 12,10,4);
-	ss << strnutils::spaced_number(g.domPVal, 12,10,1);
-	ss << strnutils::spaced_number(g.domOR, 7,4,1);
-	ss << strnutils::spaced_number(g.domLCI, 7,4,1);
-	ss << strnutils::spaced_number(g.domUCI, 7,4,1);
-	ss << strnutils::spaced_number(g.domSens, 6,4,1);
-	ss << strnutils::spaced_number(g.domSpec, 6,4,1);
-	ss << strnutils::spaced_number(g.domCStat, 6,4,1);
-
-	ss << strnutils::spaced_number(g.addPVal, 12,10,1);
-	ss << strnutils::spaced_number(g.addOR, 7,4,1);
-	ss << strnutils::spaced_number(g.addLCI, 7,4,1);
-	ss << strnutils::spaced_number(g.addUCI, 7,4,1);
-
-	ss << strnutils::spaced_number(g.addSensNNRN, 6,4,1);
-	ss << strnutils::spaced_number(g.addSpecNNRN, 6,4,1);
-	ss << strnutils::spaced_number(g.addSensNNRR, 6,4,1);
-	ss << strnutils::spaced_number(g.addSpecNNRR, 6,4,1);
-	ss << strnutils::spaced_number(g.addSensNRRR, 6,4,1);
-	ss << strnutils::spaced_number(g.addSpecNRRR, 6,4,1);
-	ss << strnutils::spaced_number(g.addCStat, 6,4,1);
-
-	ss << strnutils::spaced_number(g.recPVal, 12,10,1);
-	ss << strnutils::spaced_number(g.recOR, 7,4,1);
-	ss << strnutils::spaced_number(g.recLCI, 7,4,1);
-	ss << strnutils::spaced_number(g.recUCI, 7,4,1);
-	ss << strnutils::spaced_number(g.recSens, 6,4,1);
-	ss << strnutils::spaced_number(g.recSpec, 6,4,1);
-	ss << strnutils::spaced_number(g.recCStat, 6,4,1);
-
-	ss << strnutils::spaced_number(g.lofPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, g.twodegPVal, 12,10,4);
+	strnutils::append_spaced_number(ss, g.domPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, g.domOR, 7,4,1);
+	strnutils::append_spaced_number(ss, g.domLCI, 7,4,1);
+	strnutils::append_spaced_number(ss, g.domUCI, 7,4,1);
+	strnutils::append_spaced_number(ss, g.domSens, 6,4,1);
+	strnutils::append_spaced_number(ss, g.domSpec, 6,4,1);
+	strnutils::append_spaced_number(ss, g.domCStat, 6,4,1);
+
+	strnutils::append_spaced_number(ss, g.addPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, g.addOR, 7,4,1);
+	strnutils::append_spaced_number(ss, g.addLCI, 7,4,1);
+	strnutils::append_spaced_number(ss, g.addUCI, 7,4,1);
+
+	strnutils::append_spaced_number(ss, g.addSensNNRN, 6,4,1);
+	strnutils::append_spaced_number(ss, g.addSpecNNRN, 6,4,1);
+	strnutils::append_spaced_number(ss, g.addSensNNRR, 6,4,1);
+	strnutils::append_spaced_number(ss, g.addSpecNNRR, 6,4,1);
+	strnutils::append_spaced_number(ss, g.addSensNRRR, 6,4,1);
+	strnutils::append_spaced_number(ss, g.addSpecNRRR, 6,4,1);
+	strnutils::append_spaced_number(ss, g.addCStat, 6,4,1);
+
+	strnutils::append_spaced_number(ss, g.recPVal, 12,10,1);
+	strnutils::append_spaced_number(ss, g.recOR, 7,4,1);
+	strnutils::append_spaced_number(ss, g.recLCI, 7,4,1);
+	strnutils::append_spaced_number(ss, g.recUCI, 7,4,1);
+	strnutils::append_spaced_number(ss, g.recSens, 6,4,1);
+	strnutils::append_spaced_number(ss, g.recSpec, 6,4,1);
+	strnutils::append_spaced_number(ss, g.recCStat, 6,4,1);
+
+	strnutils::append_spaced_number(ss, g.lofPVal, 12,10,1);
 
 	// LD info.
 
-	ss << strnutils::spaced_number(h.dprime, 12,10,4);
-	ss << strnutils::spaced_number(h.rsquare, 12, 10, 1);
+	strnutils::append_spaced_number(ss, h.dprime, 12,10,4);
+	strnutils::append_spaced_number(ss, h.rsquare, 12, 10, 1);
 
-	ss << strnutils::spaced_number(h.allelicPval, 12, 10, 4);
+	strnutils::append_spaced_number(ss, h.allelicPval, 12, 10, 4);
 
-	ss << strnutils::spaced_number(h.twoMarkerPval, 12, 10, 4);
+	strnutils::append_spaced_number(ss, h.twoMarkerPval, 12, 10, 4);
 	double td;
 	for(int i=0;i<4;i++){
 		td = h.twoMarkerCaseFreq.at(i);
 		if(td < 0.0001){
-			ss << strnutils::spaced_number(0.0,6,4,1);
+			strnutils::append_spaced_number(ss, 0.0,6,4,1);
 		}else{
-			ss << strnutils::spaced_number(h.twoMarkerCaseFreq.at(i),6,4,1);
+			strnutils::append_spaced_number(ss, h.twoMarkerCaseFreq.at(i),6,4,1);
 		}
 	}
 	for(int i=0;i<4;i++){
 		td = h.twoMarkerCntrlFreq.at(i);
 		if(td < 0.0001){
-			ss << strnutils::spaced_number(0.0,6,4,1);
+			strnutils::append_spaced_number(ss, 0.0,6,4,1);
 		}else{
-			ss << strnutils::spaced_number(h.twoMarkerCntrlFreq.at(i),6,4,1);
+			strnutils::append_spaced_number(ss, h.twoMarkerCntrlFreq.at(i),6,4,1);
 		}
 	}
-	ss << strnutils::spaced_number(h.threeMarkerPval, 12, 10, 4);
+	strnutils::append_spaced_number(ss, h.threeMarkerPval, 12, 10, 4);
 	for(int i=0;i<8;i++){
 		td = h.threeMarkerCaseFreq.at(i);
 		if(td < 0.0001){
-			ss  << strnutils::spaced_number(0.0,7,4,1);
+			strnutils::append_spaced_number(ss, 0.0,7,4,1);
 		}else{
-			ss  << strnutils::spaced_number(h.threeMarkerCaseFreq.at(i),7,4,1);
+			strnutils::append_spaced_number(ss, h.threeMarkerCaseFreq.at(i),7,4,1);
 		}
 	}
 	for(int i=0;i<8;i++){
 		td = h.threeMarkerCntrlFreq.at(i);
 		if(td < 0.0001){
-			ss << strnutils::spaced_number(0.0,7,4,1);
+			strnutils::append_spaced_number(ss, 0.0,7,4,1);
 		}else{
-			ss  << strnutils::spaced_number(h.threeMarkerCntrlFreq.at(i),7,4,1);
+			strnutils::append_spaced_number(ss, h.threeMarkerCntrlFreq.at(i),7,4,1);
 		}
 	}
 
-	ss << endl;
+	ss += '\n';
 
-	outMain.write_line(ss.str(), idx);
+	outMain.write_line(ss);
+}
 
-	if(writeValFile) writeValLine(idx, s, p, h, g);
-	if(writeHWEFiles) writeHWELine(idx, s, p);
-	if(writeGenoFiles) writeGenoLine(idx, s, p, g, h);
-	if(writeRefFile){
-		stringstream ssr;
-		ssr << s.chr << " ";
-		if(s.name.size() > 0){
-			ssr << strnutils::spaced_string(s.name, 10);
-		}else{
-			ssr << strnutils::spaced_number(s.index, 6);
-		}
-		ssr << " 0   " << s.position << "  " << s.refAllele << endl;
-		outRefAllele.write_line(ssr.str(), idx);
+/**
+ * Describe the columns of the .col file: the SNP, then every field of the
+ * result structs under its own name.
+ */
+void SnpgwaOutput::addColumns(){
+	outColumns.add_column("index", COLUMN_INT);
+	outColumns.add_column("chr", COLUMN_STRING);
+	outColumns.add_column("name", COLUMN_STRING);
+	outColumns.add_column("position", COLUMN_INT);
+	outColumns.add_column("majAllele", COLUMN_STRING);
+	outColumns.add_column("minAllele", COLUMN_STRING);
+	outColumns.add_column("refAllele", COLUMN_STRING);
+
+	outColumns.add_column("caseCount", COLUMN_INT);
+	outColumns.add_column("cntrlCount", COLUMN_INT);
+	outColumns.add_column("caseRefFreq", COLUMN_DOUBLE);
+	outColumns.add_column("cntrlRefFreq", COLUMN_DOUBLE);
+	outColumns.add_column("pMissingCombined", COLUMN_DOUBLE);
+	outColumns.add_column("pMissingCase", COLUMN_DOUBLE);
+	outColumns.add_column("pMissingCntrl", COLUMN_DOUBLE);
+	outColumns.add_column("missingPVal", COLUMN_DOUBLE);
+	outColumns.add_column("missingOR", COLUMN_DOUBLE);
+	outColumns.add_column("cntrlPP", COLUMN_INT);
+	outColumns.add_column("casePP", COLUMN_INT);
+	outColumns.add_column("expcntrlPP", COLUMN_DOUBLE);
+	outColumns.add_column("expcasePP", COLUMN_DOUBLE);
+	outColumns.add_column("expcmbdPP", COLUMN_DOUBLE);
+	outColumns.add_column("cntrlPQ", COLUMN_INT);
+	outColumns.add_column("casePQ", COLUMN_INT);
+	outColumns.add_column("expcntrlPQ", COLUMN_DOUBLE);
+	outColumns.add_column("expcasePQ", COLUMN_DOUBLE);
+	outColumns.add_column("expcmbdPQ", COLUMN_DOUBLE);
+	outColumns.add_column("cntrlQQ", COLUMN_INT);
+	outColumns.add_column("caseQQ", COLUMN_INT);
+	outColumns.add_column("expcntrlQQ", COLUMN_DOUBLE);
+	outColumns.add_column("expcaseQQ", COLUMN_DOUBLE);
+	outColumns.add_column("expcmbdQQ", COLUMN_DOUBLE);
+	outColumns.add_column("cmbdTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("caseTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("cntrlTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("cmbdPVal", COLUMN_DOUBLE);
+	outColumns.add_column("casePVal", COLUMN_DOUBLE);
+	outColumns.add_column("cntrlPVal", COLUMN_DOUBLE);
+	outColumns.add_column("cmbdExactPVal", COLUMN_DOUBLE);
+	outColumns.add_column("caseExactPVal", COLUMN_DOUBLE);
+	outColumns.add_column("cntrlExactPVal", COLUMN_DOUBLE);
+
+	outColumns.add_column("twodegTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("twodegPVal", COLUMN_DOUBLE);
+	outColumns.add_column("domTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("domPVal", COLUMN_DOUBLE);
+	outColumns.add_column("domOR", COLUMN_DOUBLE);
+	outColumns.add_column("domLCI", COLUMN_DOUBLE);
+	outColumns.add_column("domUCI", COLUMN_DOUBLE);
+	outColumns.add_column("domSens", COLUMN_DOUBLE);
+	outColumns.add_column("domSpec", COLUMN_DOUBLE);
+	outColumns.add_column("domCStat", COLUMN_DOUBLE);
+	outColumns.add_column("addTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("addPVal", COLUMN_DOUBLE);
+	outColumns.add_column("addOR", COLUMN_DOUBLE);
+	outColumns.add_column("addLCI", COLUMN_DOUBLE);
+	outColumns.add_column("addUCI", COLUMN_DOUBLE);
+	outColumns.add_column("addSensNNRN", COLUMN_DOUBLE);
+	outColumns.add_column("addSpecNNRN", COLUMN_DOUBLE);
+	outColumns.add_column("addSensNNRR", COLUMN_DOUBLE);
+	outColumns.add_column("addSpecNNRR", COLUMN_DOUBLE);
+	outColumns.add_column("addSensNRRR", COLUMN_DOUBLE);
+	outColumns.add_column("addSpecNRRR", COLUMN_DOUBLE);
+	outColumns.add_column("addCStat", COLUMN_DOUBLE);
+	outColumns.add_column("recTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("recPVal", COLUMN_DOUBLE);
+	outColumns.add_column("recOR", COLUMN_DOUBLE);
+	outColumns.add_column("recLCI", COLUMN_DOUBLE);
+	outColumns.add_column("recUCI", COLUMN_DOUBLE);
+	outColumns.add_column("recSens", COLUMN_DOUBLE);
+	outColumns.add_column("recSpec", COLUMN_DOUBLE);
+	outColumns.add_column("recCStat", COLUMN_DOUBLE);
+	outColumns.add_column("lofTestStat", COLUMN_DOUBLE);
+	outColumns.add_column("lofPVal", COLUMN_DOUBLE);
+
+	outColumns.add_column("dprime", COLUMN_DOUBLE);
+	outColumns.add_column("rsquare", COLUMN_DOUBLE);
+	outColumns.add_column("allelicChiS", COLUMN_DOUBLE);
+	outColumns.add_column("allelicDF", COLUMN_DOUBLE);
+	outColumns.add_column("allelicPval", COLUMN_DOUBLE);
+	outColumns.add_column("twoMarkerChiS", COLUMN_DOUBLE);
+	outColumns.add_column("twoMarkerDF", COLUMN_DOUBLE);
+	outColumns.add_column("twoMarkerPval", COLUMN_DOUBLE);
+	outColumns.add_column("threeMarkerChiS", COLUMN_DOUBLE);
+	outColumns.add_column("threeMarkerDF", COLUMN_DOUBLE);
+	outColumns.add_column("threeMarkerPval", COLUMN_DOUBLE);
+
+	addFreqColumns("twoMarkerCaseFreq", 4);
+	addFreqColumns("twoMarkerCntrlFreq", 4);
+	addFreqColumns("threeMarkerCaseFreq", 8);
+	addFreqColumns("threeMarkerCntrlFreq", 8);
+}
+
+/* Columns prefix1 to prefixn for a vector of haplotype frequencies. */
+void SnpgwaOutput::addFreqColumns(const string &prefix, unsigned int n){
+	for(unsigned int i=1;i <= n;i++){
+		string name = prefix;
+		strnutils::append_number(name, i);
+		outColumns.add_column(name, COLUMN_DOUBLE);
 	}
+}
 
+/**
+ * Write one SNP to the .col file, in the order of addColumns().
+ */
+void SnpgwaOutput::writeColumnRow(const SnpInfo &s, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g){
+	outColumns.put(s.index);
+	outColumns.put(s.chr);
+	outColumns.put(s.name);
+	outColumns.put(s.position);
+	outColumns.put(string(1, s.majAllele));
+	outColumns.put(string(1, s.minAllele));
+	outColumns.put(string(1, s.refAllele));
+
+	outColumns.put(p.caseCount);
+	outColumns.put(p.cntrlCount);
+	outColumns.put(p.caseRefFreq);
+	outColumns.put(p.cntrlRefFreq);
+	outColumns.put(p.pMissingCombined);
+	outColumns.put(p.pMissingCase);
+	outColumns.put(p.pMissingCntrl);
+	outColumns.put(p.missingPVal);
+	outColumns.put(p.missingOR);
+	outColumns.put(p.cntrlPP);
+	outColumns.put(p.casePP);
+	outColumns.put(p.expcntrlPP);
+	outColumns.put(p.expcasePP);
+	outColumns.put(p.expcmbdPP);
+	outColumns.put(p.cntrlPQ);
+	outColumns.put(p.casePQ);
+	outColumns.put(p.expcntrlPQ);
+	outColumns.put(p.expcasePQ);
+	outColumns.put(p.expcmbdPQ);
+	outColumns.put(p.cntrlQQ);
+	outColumns.put(p.caseQQ);
+	outColumns.put(p.expcntrlQQ);
+	outColumns.put(p.expcaseQQ);
+	outColumns.put(p.expcmbdQQ);
+	outColumns.put(p.cmbdTestStat);
+	outColumns.put(p.caseTestStat);
+	outColumns.put(p.cntrlTestStat);
+	outColumns.put(p.cmbdPVal);
+	outColumns.put(p.casePVal);
+	outColumns.put(p.cntrlPVal);
+	outColumns.put(p.cmbdExactPVal);
+	outColumns.put(p.caseExactPVal);
+	outColumns.put(p.cntrlExactPVal);
+
+	outColumns.put(g.twodegTestStat);
+	outColumns.put(g.twodegPVal);
+	outColumns.put(g.domTestStat);
+	outColumns.put(g.domPVal);
+	outColumns.put(g.domOR);
+	outColumns.put(g.domLCI);
+	outColumns.put(g.domUCI);
+	outColumns.put(g.domSens);
+	outColumns.put(g.domSpec);
+	outColumns.put(g.domCStat);
+	outColumns.put(g.addTestStat);
+	outColumns.put(g.addPVal);
+	outColumns.put(g.addOR);
+	outColumns.put(g.addLCI);
+	outColumns.put(g.addUCI);
+	outColumns.put(g.addSensNNRN);
+	outColumns.put(g.addSpecNNRN);
+	outColumns.put(g.addSensNNRR);
+	outColumns.put(g.addSpecNNRR);
+	outColumns.put(g.addSensNRRR);
+	outColumns.put(g.addSpecNRRR);
+	outColumns.put(g.addCStat);
+	outColumns.put(g.recTestStat);
+	outColumns.put(g.recPVal);
+	outColumns.put(g.recOR);
+	outColumns.put(g.recLCI);
+	outColumns.put(g.recUCI);
+	outColumns.put(g.recSens);
+	outColumns.put(g.recSpec);
+	outColumns.put(g.recCStat);
+	outColumns.put(g.lofTestStat);
+	outColumns.put(g.lofPVal);
+
+	outColumns.put(h.dprime);
+	outColumns.put(h.rsquare);
+	outColumns.put(h.allelicChiS);
+	outColumns.put(h.allelicDF);
+	outColumns.put(h.allelicPval);
+	outColumns.put(h.twoMarkerChiS);
+	outColumns.put(h.twoMarkerDF);
+	outColumns.put(h.twoMarkerPval);
+	outColumns.put(h.threeMarkerChiS);
+	outColumns.put(h.threeMarkerDF);
+	outColumns.put(h.threeMarkerPval);
+
+	putFreqs(h.twoMarkerCaseFreq, 4);
+	putFreqs(h.twoMarkerCntrlFreq, 4);
+	putFreqs(h.threeMarkerCaseFreq, 8);
+	putFreqs(h.threeMarkerCntrlFreq, 8);
+	outColumns.end_row();
+}
+
+/* n haplotype frequencies; NaN for any that were not computed. */
+void SnpgwaOutput::putFreqs(const vector<double> &freqs, unsigned int n){
+	for(unsigned int i=0;i < n;i++){
+		outColumns.put(i < freqs.size() ? freqs[i] : numeric_limits<double>::quiet_NaN());
+	}
 }
 /**
  * Write output line to each of the three HWE files.
  * 
- * @param idx Index in final file (for synchronous update)
  * @param s Contains SNP info to write.
  * @param p Contains population stats results to write.
  */
-void SnpgwaOutput::writeHWELine(int idx, const SnpInfo &s, const PopStatsResults &p){
+void SnpgwaOutput::writeHWELine(const SnpInfo &s, const PopStatsResults &p){
 
-	stringstream sscase, sscnt, ss;
+	string &sscase = lineBuf[0];
+	sscase.clear();
+	string &sscnt = lineBuf[1];
+	sscnt.clear();
+	string &ss = lineBuf[2];
+	ss.clear();
 
 	if(s.name.size() > 0){
-		ss << strnutils::spaced_string(s.name, 10);
-		sscase << strnutils::spaced_string(s.name, 10);
-		sscnt << strnutils::spaced_string(s.name, 10);
+		strnutils::append_spaced_string(ss, s.name, 10);
+		strnutils::append_spaced_string(sscase, s.name, 10);
+		strnutils::append_spaced_string(sscnt, s.name, 10);
 	}else{
-		ss << strnutils::spaced_number(s.index, 10);
-		sscase << strnutils::spaced_number(s.index, 10);
-		sscnt << strnutils::spaced_number(s.index, 10);
+		strnutils::append_spaced_number(ss, s.index, 10);
+		strnutils::append_spaced_number(sscase, s.index, 10);
+		strnutils::append_spaced_number(sscnt, s.index, 10);
 	}
 
-	ss << strnutils::spaced_number(p.caseCount+p.cntrlCount, 9,1);
-	sscase << strnutils::spaced_number(p.caseCount, 9,1);
-	sscnt << strnutils::spaced_number(p.cntrlCount, 9,1);
+	strnutils::append_spaced_number(ss, p.caseCount+p.cntrlCount, 9,1);
+	strnutils::append_spaced_number(sscase, p.caseCount, 9,1);
+	strnutils::append_spaced_number(sscnt, p.cntrlCount, 9,1);
 
 	double freq = (static_cast<double>(p.caseCount) * p.caseRefFreq + static_cast<double>(p.cntrlCount) * p.cntrlRefFreq)/(p.caseCount+p.cntrlCount);
-	ss << strnutils::spaced_number(freq, 11, 6, 4);
-	sscase << strnutils::spaced_number(p.caseRefFreq, 11, 6, 4);
-	sscnt << strnutils::spaced_number(p.cntrlRefFreq, 11, 6, 4);
-
-	ss << strnutils::spaced_number(p.pMissingCombined, 9, 2, 4);
-	sscase << strnutils::spaced_number(p.pMissingCase, 9, 2, 4);
-	sscnt << strnutils::spaced_number(p.pMissingCntrl, 9, 2, 4);
-
-	ss << "  " << s.majAllele << "  " << s.minAllele << "   " << s.refAllele;
-
-	ss << strnutils::spaced_number(p.cntrlPP+p.casePP, 5,2);
-	sscnt << strnutils::spaced_number(p.cntrlPP, 5,2);
-	sscase << strnutils::spaced_number(p.casePP, 5,2);
-
-	ss << strnutils::spaced_number(p.expcmbdPP, 8,2,1);
-	sscnt << strnutils::spaced_number(p.expcntrlPP, 8,2,1);
-	sscase << strnutils::spaced_number(p.expcasePP, 8,2,1);
-
-	ss << strnutils::spaced_number(p.cntrlPQ+p.casePQ, 5,1);
-	sscnt << strnutils::spaced_number(p.cntrlPQ, 5,1);
-	sscase << strnutils::spaced_number(p.casePQ, 5,1);
-
-	ss << strnutils::spaced_number(p.expcmbdPQ, 8,2,1);
-	sscnt << strnutils::spaced_number(p.expcntrlPQ, 8,2,1);
-	sscase << strnutils::spaced_number(p.expcasePQ, 8,2,1);
-
-	ss << strnutils::spaced_number(p.cntrlQQ+p.caseQQ, 5,1);
-	sscnt << strnutils::spaced_number(p.cntrlQQ, 5,1);
-	sscase << strnutils::spaced_number(p.caseQQ, 5,1);
-
-	ss << strnutils::spaced_number(p.expcmbdQQ, 8,2,1);
-	sscnt << strnutils::spaced_number(p.expcntrlQQ, 8,2,1);
-	sscase << strnutils::spaced_number(p.expcaseQQ, 8,2,1);
-
-	ss << strnutils::spaced_number(p.cmbdPVal, 12,10,1);
-	sscase << strnutils::spaced_number(p.casePVal, 12,10,1);
-	sscnt << strnutils::spaced_number(p.cntrlPVal, 12,10,1);
-
-	ss << strnutils::spaced_number(p.cmbdExactPVal, 12, 10, 1);
-	sscase << strnutils::spaced_number(p.caseExactPVal, 12, 10, 1);
-	sscnt << strnutils::spaced_number(p.cntrlExactPVal, 12, 10, 1);
-
-	ss << endl;
-	sscase << endl;
-	sscnt << endl;
-
-	outHWEcase.write_line(sscase.str(), idx);
-	outHWEcntrl.write_line(sscnt.str(), idx);
-	outHWEcomb.write_line(ss.str(), idx);
+	strnutils::append_spaced_number(ss, freq, 11, 6, 4);
+	strnutils::append_spaced_number(sscase, p.caseRefFreq, 11, 6, 4);
+	strnutils::append_spaced_number(sscnt, p.cntrlRefFreq, 11, 6, 4);
+
+	strnutils::append_spaced_number(ss, p.pMissingCombined, 9, 2, 4);
+	strnutils::append_spaced_number(sscase, p.pMissingCase, 9, 2, 4);
+	strnutils::append_spaced_number(sscnt, p.pMissingCntrl, 9, 2, 4);
+
+	ss += "  ";
+	ss += s.majAllele;
+	ss += "  ";
+	ss += s.minAllele;
+	ss += "   ";
+	ss += s.refAllele;
+
+	strnutils::append_spaced_number(ss, p.cntrlPP+p.casePP, 5,2);
+	strnutils::append_spaced_number(sscnt, p.cntrlPP, 5,2);
+	strnutils::append_spaced_number(sscase, p.casePP, 5,2);
+
+	strnutils::append_spaced_number(ss, p.expcmbdPP, 8,2,1);
+	strnutils::append_spaced_number(sscnt, p.expcntrlPP, 8,2,1);
+	strnutils::append_spaced_number(sscase, p.expcasePP, 8,2,1);
+
+	strnutils::append_spaced_number(ss, p.cntrlPQ+p.casePQ, 5,1);
+	strnutils::append_spaced_number(sscnt, p.cntrlPQ, 5,1);
+	strnutils::append_spaced_number(sscase, p.casePQ, 5,1);
+
+	strnutils::append_spaced_number(ss, p.expcmbdPQ, 8,2,1);
+	strnutils::append_spaced_number(sscnt, p.expcntrlPQ, 8,2,1);
+	strnutils::append_spaced_number(sscase, p.expcasePQ, 8,2,1);
+
+	strnutils::append_spaced_number(ss, p.cntrlQQ+p.caseQQ, 5,1);
+	strnutils::append_spaced_number(sscnt, p.cntrlQQ, 5,1);
+	strnutils::append_spaced_number(sscase, p.caseQQ, 5,1);
+
+	strnutils::append_spaced_number(ss, p.expcmbdQQ, 8,2,1);
+	strnutils::append_spaced_number(sscnt, p.expcntrlQQ, 8,2,1);
+	strnutils::append_spaced_number(sscase, p.expcaseQQ, 8,2,1);
+
+	strnutils::append_spaced_number(ss, p.cmbdPVal, 12,10,1);
+	strnutils::append_spaced_number(sscase, p.casePVal, 12,10,1);
+	strnutils::append_spaced_number(sscnt, p.cntrlPVal, 12,10,1);
+
+	strnutils::append_spaced_number(ss, p.cmbdExactPVal, 12, 10, 1);
+	strnutils::append_spaced_number(sscase, p.caseExactPVal, 12, 10, 1);
+	strnutils::append_spaced_number(sscnt, p.cntrlExactPVal, 12, 10, 1);
+
+	ss += '\n';
+	sscase += '\n';
+	sscnt += '\n';
+
+	outHWEcase.write_line(sscase);
+	outHWEcntrl.write_line(sscnt);
+	outHWEcomb.write_line(ss);
 }
 
 /**
  * TODO: finish?
  */
-void SnpgwaOutput::writeHaploLine(int idx, const SnpInfo &s, const HaploStatsResults &p){
+void SnpgwaOutput::writeHaploLine(const SnpInfo &s, const HaploStatsResults &p){
 	
 	stringstream ss1, ss2, ss3;
 	
@@ -393,123 +672,142 @@ void SnpgwaOutput::writeHaploLine(int idx, const SnpInfo &s, const HaploStatsRes
  * Write output line for the value file.  This is a separate file that contains
  * test statistics rather than their corresponding p-values.
  * 
- * @param ids Index in final file (for asynchronous update)
  * @param s Contains SNP info to write.
  * @param p Contains population stats results to write.
  * @param h Contains haplotype stats results to write.
  * @param g Contains genotypic stats results to write.
  */
-void SnpgwaOutput::writeValLine(int ids, const SnpInfo &s, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g){
+void SnpgwaOutput::writeValLine(const SnpInfo &s, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g){
 
-	stringstream ss;
+	string &ss = lineBuf[0];
+	ss.clear();
 
 	if(s.name.size() > 0){
-		ss << strnutils::spaced_string(s.name, 10);
+		strnutils::append_spaced_string(ss, s.name, 10);
 	}else{
-		ss << strnutils::spaced_number(s.index, 10);
+		strnutils::append_spaced_number(ss, s.index, 10);
 	}
 
-	ss << strnutils::spaced_number(p.cmbdTestStat, 14,12,1);
-	ss << strnutils::spaced_number(p.caseTestStat, 14,12,1);
-	ss << strnutils::spaced_number(p.cntrlTestStat, 14,12,1);
+	strnutils::append_spaced_number(ss, p.cmbdTestStat, 14,12,1);
+	strnutils::append_spaced_number(ss, p.caseTestStat, 14,12,1);
+	strnutils::append_spaced_number(ss, p.cntrlTestStat, 14,12,1);
 
-	ss << strnutils::spaced_number(g.twodegTestStat, 14,12,4);
-	ss << strnutils::spaced_number(g.domTestStat, 14,12,1);
-	ss << strnutils::spaced_number(g.addTestStat, 14,12,1);
-	ss << strnutils::spaced_number(g.recTestStat, 14,12,1);
-	ss << strnutils::spaced_number(g.lofTestStat, 14,12,1);
+	strnutils::append_spaced_number(ss, g.twodegTestStat, 14,12,4);
+	strnutils::append_spaced_number(ss, g.domTestStat, 14,12,1);
+	strnutils::append_spaced_number(ss, g.addTestStat, 14,12,1);
+	strnutils::append_spaced_number(ss, g.recTestStat, 14,12,1);
+	strnutils::append_spaced_number(ss, g.lofTestStat, 14,12,1);
 
-	ss << strnutils::spaced_number(h.allelicChiS, 14,12,4);
-	ss << strnutils::spaced_number(h.allelicDF, 4,0,1);
+	strnutils::append_spaced_number(ss, h.allelicChiS, 14,12,4);
+	strnutils::append_spaced_number(ss, h.allelicDF, 4,0,1);
 
-	ss << strnutils::spaced_number(h.twoMarkerChiS, 14,12,4);
-	ss << strnutils::spaced_number(h.twoMarkerDF, 4,0,1);
-	ss << strnutils::spaced_number(h.threeMarkerChiS, 14,12,4);
-	ss << strnutils::spaced_number(h.threeMarkerDF, 4,0,1);
+	strnutils::append_spaced_number(ss, h.twoMarkerChiS, 14,12,4);
+	strnutils::append_spaced_number(ss, h.twoMarkerDF, 4,0,1);
+	strnutils::append_spaced_number(ss, h.threeMarkerChiS, 14,12,4);
+	strnutils::append_spaced_number(ss, h.threeMarkerDF, 4,0,1);
 
-	ss << endl;
+	ss += '\n';
 
-	outVal.write_line(ss.str(), ids);
+	outVal.write_line(ss);
 
 }
 
 /**
  * Write lines for geno files.
  * 
- * @param idx Index in final file (for asynchronous update)
  * @param s Contains SNP info to write.
  * @param p Contains population stats results to write.
  * @param h Contains haplotype stats results to write.
  * @param g Contains genotypic stats results to write.
  */
-void SnpgwaOutput::writeGenoLine(int idx, const SnpInfo &s, const PopStatsResults &p, const GenoStatsResults &g, const HaploStatsResults &h){
+void SnpgwaOutput::writeGenoLine(const SnpInfo &s, const PopStatsResults &p, const GenoStatsResults &g, const HaploStatsResults &h){
 
-	stringstream ss1, ss2, ss3;
+	string &ss1 = lineBuf[0];
+	ss1.clear();
+	string &ss2 = lineBuf[1];
+	ss2.clear();
+	string &ss3 = lineBuf[2];
+	ss3.clear();
 
 	if(s.name.size() > 0){
-		ss1 << strnutils::spaced_string(s.name, 10);
-		ss2 << strnutils::spaced_string(s.name, 10);
-		ss3 << strnutils::spaced_string(s.name, 10);
+		strnutils::append_spaced_string(ss1, s.name, 10);
+		strnutils::append_spaced_string(ss2, s.name, 10);
+		strnutils::append_spaced_string(ss3, s.name, 10);
 	}else{
-		ss1 << strnutils::spaced_number(s.index, 10);
-		ss2 << strnutils::spaced_number(s.index, 10);
-		ss3 << strnutils::spaced_number(s.index, 10);
+		strnutils::append_spaced_number(ss1, s.index, 10);
+		strnutils::append_spaced_number(ss2, s.index, 10);
+		strnutils::append_spaced_number(ss3, s.index, 10);
 	}
 
-	ss1 << strnutils::spaced_number(p.caseRefFreq, 5, 3, 1);
-	ss1 << strnutils::spaced_number(p.cntrlRefFreq, 5, 3, 1);
-	ss1 << strnutils::spaced_number(p.cmbdExactPVal, 8,6,1);
-	ss1 << strnutils::spaced_number(h.dprime, 5,3,1);
-	ss1 << strnutils::spaced_number(h.rsquare, 5,3,1);
-
-	ss1 << "  " << s.majAllele << "  " << s.minAllele << "   " << s.refAllele;
-
-	ss2 << strnutils::spaced_number(p.caseRefFreq, 5, 3, 1);
-	ss2 << strnutils::spaced_number(p.cntrlRefFreq, 5, 3, 1);
-	ss2 << strnutils::spaced_number(p.cmbdExactPVal, 8,6,1);
-	ss2 << strnutils::spaced_number(h.dprime, 5,3,1);
-	ss2 << strnutils::spaced_number(h.rsquare, 5,3,1);
-
-	ss2 << "  " << s.majAllele << "  " << s.minAllele << "   " << s.refAllele;
-
-	ss3 << strnutils::spaced_number(p.caseRefFreq, 5, 3, 1);
-	ss3 << strnutils::spaced_number(p.cntrlRefFreq, 5, 3, 1);
-	ss3 << strnutils::spaced_number(p.cmbdExactPVal, 8,6,1);
-	ss3 << strnutils::spaced_number(h.dprime, 5,3,1);
-	ss3 << strnutils::spaced_number(h.rsquare, 5,3,1);
-
-	ss3 << "  " << s.majAllele << "  " << s.minAllele << "   " << s.refAllele;
+	strnutils::append_spaced_number(ss1, p.caseRefFreq, 5, 3, 1);
+	strnutils::append_spaced_number(ss1, p.cntrlRefFreq, 5, 3, 1);
+	strnutils::append_spaced_number(ss1, p.cmbdExactPVal, 8,6,1);
+	strnutils::append_spaced_number(ss1, h.dprime, 5,3,1);
+	strnutils::append_spaced_number(ss1, h.rsquare, 5,3,1);
+
+	ss1 += "  ";
+	ss1 += s.majAllele;
+	ss1 += "  ";
+	ss1 += s.minAllele;
+	ss1 += "   ";
+	ss1 += s.refAllele;
+
+	strnutils::append_spaced_number(ss2, p.caseRefFreq, 5, 3, 1);
+	strnutils::append_spaced_number(ss2, p.cntrlRefFreq, 5, 3, 1);
+	strnutils::append_spaced_number(ss2, p.cmbdExactPVal, 8,6,1);
+	strnutils::append_spaced_number(ss2, h.dprime, 5,3,1);
+	strnutils::append_spaced_number(ss2, h.rsquare, 5,3,1);
+
+	ss2 += "  ";
+	ss2 += s.majAllele;
+	ss2 += "  ";
+	ss2 += s.minAllele;
+	ss2 += "   ";
+	ss2 += s.refAllele;
+
+	strnutils::append_spaced_number(ss3, p.caseRefFreq, 5, 3, 1);
+	strnutils::append_spaced_number(ss3, p.cntrlRefFreq, 5, 3, 1);
+	strnutils::append_spaced_number(ss3, p.cmbdExactPVal, 8,6,1);
+	strnutils::append_spaced_number(ss3, h.dprime, 5,3,1);
+	strnutils::append_spaced_number(ss3, h.rsquare, 5,3,1);
+
+	ss3 += "  ";
+	ss3 += s.majAllele;
+	ss3 += "  ";
+	ss3 += s.minAllele;
+	ss3 += "   ";
+	ss3 += s.refAllele;
 
 	// diverges here.
-	ss1 << strnutils::spaced_number(g.twodegPVal, 12, 10, 1);
-	ss1 << strnutils::spaced_number(g.domPVal, 12, 10, 1);
-	ss1 << strnutils::spaced_number(g.addPVal, 12, 10, 1);
-	ss1 << strnutils::spaced_number(g.recPVal, 12, 10, 1);
-	ss1 << strnutils::spaced_number(g.lofPVal, 12, 10, 1);
-
-	ss2 << strnutils::spaced_number(g.domOR, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.domLCI, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.domUCI, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.addOR, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.addLCI, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.addUCI, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.recOR, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.recLCI, 7, 2, 1);
-	ss2 << strnutils::spaced_number(g.recUCI, 7, 2, 1);
-
-	ss3 << strnutils::spaced_number(g.domSpec, 4, 2, 1);
-	ss3 << strnutils::spaced_number(g.domSens, 4, 2, 1);
-	ss3 << strnutils::spaced_number(g.domCStat, 4, 2, 1);
-	ss3 << strnutils::spaced_number(g.addSensNNRN, 4,2,1);
-	ss3 << strnutils::spaced_number(g.addSpecNNRN, 4,2,1);
-	ss3 << strnutils::spaced_number(g.addSensNNRR, 4,2,1);
-	ss3 << strnutils::spaced_number(g.addSpecNNRR, 4,2,1);
-	ss3 << strnutils::spaced_number(g.addSensNRRR, 4,2,1);
-	ss3 << strnutils::spaced_number(g.addSpecNRRR, 4,2,1);
-	ss3 << strnutils::spaced_number(g.addCStat, 4,2,1);
-	ss3 << strnutils::spaced_number(g.recSpec, 4, 2, 1);
-	ss3 << strnutils::spaced_number(g.recSens, 4, 2, 1);
-	ss3 << strnutils::spaced_number(g.recCStat, 4, 2, 1);
+	strnutils::append_spaced_number(ss1, g.twodegPVal, 12, 10, 1);
+	strnutils::append_spaced_number(ss1, g.domPVal, 12, 10, 1);
+	strnutils::append_spaced_number(ss1, g.addPVal, 12, 10, 1);
+	strnutils::append_spaced_number(ss1, g.recPVal, 12, 10, 1);
+	strnutils::append_spaced_number(ss1, g.lofPVal, 12, 10, 1);
+
+	strnutils::append_spaced_number(ss2, g.domOR, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.domLCI, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.domUCI, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.addOR, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.addLCI, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.addUCI, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.recOR, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.recLCI, 7, 2, 1);
+	strnutils::append_spaced_number(ss2, g.recUCI, 7, 2, 1);
+
+	strnutils::append_spaced_number(ss3, g.domSpec, 4, 2, 1);
+	strnutils::append_spaced_number(ss3, g.domSens, 4, 2, 1);
+	strnutils::append_spaced_number(ss3, g.domCStat, 4, 2, 1);
+	strnutils::append_spaced_number(ss3, g.addSensNNRN, 4,2,1);
+	strnutils::append_spaced_number(ss3, g.addSpecNNRN, 4,2,1);
+	strnutils::append_spaced_number(ss3, g.addSensNNRR, 4,2,1);
+	strnutils::append_spaced_number(ss3, g.addSpecNNRR, 4,2,1);
+	strnutils::append_spaced_number(ss3, g.addSensNRRR, 4,2,1);
+	strnutils::append_spaced_number(ss3, g.addSpecNRRR, 4,2,1);
+	strnutils::append_spaced_number(ss3, g.addCStat, 4,2,1);
+	strnutils::append_spaced_number(ss3, g.recSpec, 4, 2, 1);
+	strnutils::append_spaced_number(ss3, g.recSens, 4, 2, 1);
+	strnutils::append_spaced_number(ss3, g.recCStat, 4, 2, 1);
 
 }
 
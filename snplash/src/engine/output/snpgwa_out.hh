@@ -33,11 +33,14 @@
  * All but the log file are handled in this class.
  */
 #include "output.h"
+#include "result_queue.hh"
+#include "column_output.hh"
 #include "snpinfo_out.hh"
 #include "../../param/param_reader.h"
 #include "../../param/engine_param_reader.h"
 #include <sstream> // Used to create and manage the string.
 #include <map>
+#include <limits>
 #include "../utils/stringutils.h"
 #include "../../logger/log.hh"
 
@@ -151,7 +154,15 @@ struct HaploStatsResults{
 	vector<double> threeMarkerCntrlFreq;
 };
 
-class SnpgwaOutput {
+/* Everything written for one SNP, as queued for the writer thread. */
+struct SnpgwaRecord{
+	SnpInfo s;
+	PopStatsResults p;
+	HaploStatsResults h;
+	GenoStatsResults g;
+};
+
+class SnpgwaOutput : public ResultSink<SnpgwaRecord> {
 	
 	friend class Snpgwa;
 		
@@ -161,26 +172,43 @@ class SnpgwaOutput {
 		
 		bool init(ParamReader *, EngineParamReader *, int maxMapSize, int numSNPs, string message);
 		void close();
+
+		/* Writer thread: format and write one SNP. */
+		void consume(const SnpgwaRecord &r, long order);
 	
 	protected:
 		Output outMain, outGeno1, outGeno2, outGeno3, outHWEcase, outHWEcntrl, outHWEcomb, outRefAllele;
 		Output outHap1, outHap2, outHap3;
 		Output outVal;
+		/* Main results when writeColumns is set. */
+		ColumnOutput outColumns;
+		ResultQueue<SnpgwaRecord> queue;
+		/* Line buffers, reused by the writer thread for every SNP. */
+		string lineBuf[3];
 		
 		int maxMapSize, totalNumSNPs;
 
+		/* Queue a SNP's results; any thread. */
 		void writeLine(int ids, SnpInfo &, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g);
 
+		/* Main results as text, or as a row of the column file. */
+		void writeMainLine(const SnpInfo &s, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g);
+		void writeColumnRow(const SnpInfo &s, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g);
+		void addColumns();
+		void addFreqColumns(const string &prefix, unsigned int n);
+		void putFreqs(const vector<double> &freqs, unsigned int n);
+
 		/* Extra writers */
-		void writeHWELine(int ids, const SnpInfo &, const PopStatsResults &p);
-		void writeGenoLine(int idx, const SnpInfo &s, const PopStatsResults &p, const GenoStatsResults &g, const HaploStatsResults &h);
-		void writeValLine(int ids, const SnpInfo &, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g);
-		void writeHaploLine(int idx, const SnpInfo &s, const HaploStatsResults &p);
+		void writeHWELine(const SnpInfo &, const PopStatsResults &p);
+		void writeGenoLine(const SnpInfo &s, const PopStatsResults &p, const GenoStatsResults &g, const HaploStatsResults &h);
+		void writeValLine(const SnpInfo &, const PopStatsResults &p, const HaploStatsResults &h, const GenoStatsResults &g);
+		void writeHaploLine(const SnpInfo &s, const HaploStatsResults &p);
 
 		/* Output file type options */
 		bool writeGenoFiles, writeHWEFiles, writeRefFile, writeValFile, writeHaploFiles;
 		/* Output file options */
 		bool writeMainFileMap, writeMainFileHap;
+		bool writeColumns;
 	
 		/*  header writers */
 		void writeMainHeader(Output &,ParamReader *);
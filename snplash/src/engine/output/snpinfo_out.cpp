@@ -11,15 +11,22 @@ SnpInfo::SnpInfo(){
 	refAllele = '0';
 }
 
-void SnpInfo::print(std::ostream& out, int maxMapSize, bool printMap) // output
+void SnpInfo::print(std::ostream& out, int maxMapSize, bool printMap) const // output
+{
+	std::string line;
+	print(line, maxMapSize, printMap);
+	out << line;
+}
+
+void SnpInfo::print(std::string& out, int maxMapSize, bool printMap) const
 {
 	if (printMap){
-		out << strnutils::spaced_string(chr, 3,0);
-		out << strnutils::spaced_string(name, maxMapSize, 1);
-		out << strnutils::spaced_number(position, 10, 1);
-		out << strnutils::spaced_number(diff, 10, 1);
+		strnutils::append_spaced_string(out, chr, 3,0);
+		strnutils::append_spaced_string(out, name, maxMapSize, 1);
+		strnutils::append_spaced_number(out, position, 10, 1);
+		strnutils::append_spaced_number(out, diff, 10, 1);
 	}
     else{
-		out << strnutils::spaced_number(index, 10);
+		strnutils::append_spaced_number(out, index, 10);
 	}
 }
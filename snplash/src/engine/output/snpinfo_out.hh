@@ -36,7 +36,8 @@ class SnpInfo{
 	
 		SnpInfo();
 		
-		void print(std::ostream& ss, int maxMapSize, bool printMap = true); // output
+		void print(std::ostream& ss, int maxMapSize, bool printMap = true) const; // output
+		void print(std::string& out, int maxMapSize, bool printMap = true) const; // append to out
 		
 		int index;
 		std::string name;
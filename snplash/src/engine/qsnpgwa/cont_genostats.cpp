@@ -22,6 +22,13 @@
 
 ContGenoStats::ContGenoStats(DataAccess *d){
 	data = d;
+	cache = NULL;
+	ranMeans = false;
+}
+
+ContGenoStats::ContGenoStats(DataAccess *d, ResidualCache *cache){
+	data = d;
+	this->cache = cache;
 	ranMeans = false;
 }
 
@@ -63,10 +70,12 @@ void ContGenoStats::computeMeanAndSD(int snp, ContGenoStatsResults &results){
 	numAA = numAa = numaa = 0;
 	double t;
 	
+	vector<short> col;
+	data->get_snp(snp).decode(col);
 	for(int i = 0; i < data->pheno_size(); i++){
 		if(data->get_phenotype(i) != 0){
 			t = data->get_phenotype(i);
-			switch(data->get_data(i)->at(snp)){
+			switch(col.at(i)){
 				case 1:
 					
 					phenAA.push_back(t);
@@ -155,75 +164,63 @@ void ContGenoStats::computeMeanAndSD(int snp, ContGenoStatsResults &results){
 	ranMeans = true;
 }
 
+// Codings of the genotype classes AA, Aa, aa for each single test.
+static const double ADDITIVE_CODE[3] = {-1, 0, 1};
+static const double DOMINANT_CODE[3] = {0, 1, 1};
+static const double RECESSIVE_CODE[3] = {0, 0, 1};
+static const double LACK_OF_FIT_CODE[3] = {1, -2, 1};
+
 /**
  * Use the linear regression engine to compute statistics
  * 	  beta
- *    SE
+ * 	  SE
  * 	  p-val 
+ * 
+ * The covariates were regressed out in covariateAdjust, so each test is a
+ * regression of the residuals on an intercept and one coded genotype column.
+ * One pass over the residuals gathers their count, sum and sum of squares by
+ * genotype; every single test is then solved from those in closed form.
  */
 void ContGenoStats::computeLinRegStats(int snp, ContGenoStatsResults &results){
 
 	if(!ranMeans) throw QSnpgwaException();
 	
+	for(int k=0; k < 3; k++){
+		classSums.n[k] = classSums.sum[k] = classSums.sumSq[k] = 0;
+	}
 	if(residuals.size() == 0){
 		blankLinRegStats(results);
 		return;
 	}
-	vector<double> add_betas, dom_betas, rec_betas,  lof_betas; // return vals from lr engine.
-	vector<double> dom, add, rec, ones;
-
-	vector<vector<double> > add_in, dom_in, rec_in, lof_in;
 
-
-	/* Prep genotypes */
+	/* Sum the residuals by genotype. */
+	add.clear();
+	vector<short> col;
+	data->get_snp(snp).decode(col);
+	unsigned int next = 0;
 	for(int i=0; i<data->pheno_size(); i++ ){
-		// push onto stacks depending on the case/cntrl status.
-		if(data->get_data(i)->at(snp) != 0){
-			ones.push_back(1);
-			switch(data->get_data(i)->at(snp)){
-				case 1:
-					add.push_back(-1);
-					dom.push_back(0);
-					rec.push_back(0);
-				break;
-				case 2:
-					add.push_back(0);
-					dom.push_back(1);
-					rec.push_back(0);
-				break;
-				case 3:
-					add.push_back(0);
-					dom.push_back(1);
-					rec.push_back(0);
-				break;
-				case 4:
-					add.push_back(1);
-					dom.push_back(1);
-					rec.push_back(1);
-				break;
-				default:
-				// won't happen.
-				break;
-			}
+		int k;
+		switch(col.at(i)){
+			case 1: k = 0; break;
+			case 2:
+			case 3: k = 1; break;
+			case 4: k = 2; break;
+			default: continue;
 		}
+		double r = residuals.at(next++);
+		classSums.n[k]++;
+		classSums.sum[k] += r;
+		classSums.sumSq[k] += r*r;
+		add.push_back(ADDITIVE_CODE[k]);
 	}
 	
-	add_in.push_back(ones);
-	add_in.push_back(add);
-	
-	dom_in.push_back(ones);	
-	dom_in.push_back(dom);
-	
-	rec_in.push_back(ones);
-	rec_in.push_back(rec);
-	
 	/*
 	 * F = SSR / p / ( SSE / (n - p - 1) ) for n obs and p vars not including intercept. 
 	 */
 	#if CONT_GENOSTATS_STATS
 		cout << "Debug for qsnpgwa: " << snp << endl;
 	#endif
-	statisticsOutput stats = computeSingleStats(add_in, residuals, meanResidual, "Additive test", snp+1);
+	statisticsOutput stats = computeSingleStats(ADDITIVE_CODE, "Additive test", snp+1);
 	results.add_pval = stats.pVal;
 	results.add_beta = stats.beta;
 	results.add_se 	 = stats.se;
@@ -240,7 +237,7 @@ void ContGenoStats::computeLinRegStats(int snp, ContGenoStatsResults &results){
 		cout << "SE:   " << stats.se << endl;
 	#endif
 	
-	stats = computeSingleStats(dom_in, residuals, meanResidual, "Dominant test", snp+1);
+	stats = computeSingleStats(DOMINANT_CODE, "Dominant test", snp+1);
 	results.dom_pval = stats.pVal;
 	results.dom_beta = stats.beta;
 	results.dom_se 	 = stats.se;
@@ -251,7 +248,7 @@ void ContGenoStats::computeLinRegStats(int snp, ContGenoStatsResults &results){
 	results.dom_n2 = stats.n2;
 
 	
-	stats = computeSingleStats(rec_in, residuals, meanResidual, "Recessive test", snp+1);
+	stats = computeSingleStats(RECESSIVE_CODE, "Recessive test", snp+1);
 	results.rec_pval = stats.pVal;
 	results.rec_beta = stats.beta;
 	results.rec_se 	 = stats.se;
@@ -281,48 +278,15 @@ void ContGenoStats::computeLinRegStats(int snp, ContGenoStatsResults &results){
 }
 
 /**
- * Compute the lack of fit test statistic.
+ * Compute the lack of fit test statistic from the genotype sums gathered
+ * by computeLinRegStats, which must run first.
  *
  * @param snp The SNP index.
  * @param results The stats results object that will hold the response.
  */
 void ContGenoStats::computeLackOfFit(int snp, ContGenoStatsResults &results){
 	
-	vector<double> lofScore, ones;
-	vector<double> betasLOF;
-
-	/* Prep genotypes */
-	for(int i=0; i<data->pheno_size(); i++ ){
-		// push onto stacks depending on the case/cntrl status.
-		if(data->get_data(i)->at(snp) != 0){
-			ones.push_back(1.0);
-			switch(data->get_data(i)->at(snp)){
-				case 1:
-					lofScore.push_back(1);
-					
-				break;
-				case 2:
-					lofScore.push_back(-2);
-				break;
-				case 3:
-					lofScore.push_back(-2);
-				break;
-				case 4:
-					lofScore.push_back(1);
-				break;
-				default:
-				// won't happen.
-				break;
-			}
-		}
-	}
-
-	LinearRegression lr;
-	vector<vector<double> > in;
-	in.push_back(ones);
-	in.push_back(lofScore);
-
-	statisticsOutput stats = computeSingleStats(in, residuals, meanResidual, "Lack of fit test", snp+1);
+	statisticsOutput stats = computeSingleStats(LACK_OF_FIT_CODE, "Lack of fit test", snp+1);
 	results.lof_pval = stats.pVal;
 	results.lof_fStat = stats.fStat;
 	results.lof_sse = stats.sse;
@@ -334,40 +298,31 @@ void ContGenoStats::computeLackOfFit(int snp, ContGenoStatsResults &results){
 }
 
 /**
- * Compute a single set of statistics including p_val, beta, se.
- * 
- * NOTE: The pvalues ect will be reported based on the last beta.
- * Order your variables accordingly.
+ * Compute a single set of statistics including p_val, beta, se, for the
+ * residuals regressed on the genotype column coded by code.
  * 
- *	@param in The input to LR engine
- *	@param response The response variables.
- *	@param meanResidual of the response variable
- *	@return Struct with results for last beta.
+ *	@param code Value of the column for AA, Aa and aa.
+ *	@return Struct with results for the genotype beta.
  */
-ContGenoStats::statisticsOutput ContGenoStats::computeSingleStats(const vector<vector<double> > &in, 
-			const vector<double> &response, double meanResidual, string failMessage, int currentSNP)
+ContGenoStats::statisticsOutput ContGenoStats::computeSingleStats(const double code[3], string failMessage, int currentSNP)
 {
 	
 	statisticsOutput ret;
 	LinearRegression lr;
 	try {
 		
-		vector<double> betas = lr.leastSquares(in, response);
+		double sse, ssr, lxx, f;
+		double beta = lr.classLeastSquares(classSums, code, meanResidual, sse, ssr, lxx);
+		int n = static_cast<int>(classSums.n[0] + classSums.n[1] + classSums.n[2]);
 		
 		#if CONT_GENOSTATS_STATS
-		for (unsigned int idb=0; idb < betas.size(); idb++)
-			cout << betas[idb] << " ";
-		cout << endl;
+		cout << beta << endl;
 		#endif
 		
-		double sse, ssr, f;
-		lr.sumSquaredStats(in, betas, response, meanResidual, sse, ssr);
+		f = ssr / (sse / (n - 2));
 		
-		f = ssr / (sse / (response.size() - 2 ));
-		
-		ret.beta = betas.at(betas.size()-1);
-		double lxx = sumSquaresTotal(in.at(in.size()-1)); // Corrected sumsquares for x.
-		ret.se = sqrt(sse / lxx) / (response.size() - 2 );
+		ret.beta = beta;
+		ret.se = sqrt(sse / lxx) / (n - 2); // lxx is the corrected sum of squares for x.
 		
 		#if CONT_GENOSTATS_STATS
 		cout << "Sum squared stats: " << endl;
@@ -375,29 +330,15 @@ ContGenoStats::statisticsOutput ContGenoStats::computeSingleStats(const vector<v
 		cout << "sse:          " << sse << endl;
 		cout << "ssr:          " << ssr << endl;
 		cout << "f:            " << f << endl;
-		cout << "deg freedom:  " << 1 << " " << response.size() - 2 << endl;
+		cout << "deg freedom:  " << 1 << " " << n - 2 << endl;
 		#endif
 		
-		ret.pVal = 1.0 - alglib::fdistribution(1, response.size() - 2, f);
+		ret.pVal = 1.0 - alglib::fdistribution(1, n - 2, f);
 		ret.fStat = f;
 		ret.n1 = 1;
-		ret.n2 = response.size() - 2;
+		ret.n2 = n - 2;
 		ret.sse = sse;
 		ret.ssr = ssr;
-	}catch(ConditionNumberEx){
-		stringstream ss;
-		ss << "Error on snp " << currentSNP << " " << failMessage << " condition number exception in single stats." << endl;
-		Logger::Instance()->writeLine(ss.str());
-
-		ret.pVal = 2.000;
-		ret.se = -1;
-		ret.beta = -1;
-		
-		ret.fStat = -1.0;
-		ret.n1 = -1;
-		ret.n2 = -1;
-		ret.sse = -1.0;
-		ret.ssr = -1.0;
 	}catch(LinearRegressionException){
 		stringstream ss;
 		ss << "Error on snp " << currentSNP << " " << failMessage << " singular matrix exception in single stats." << endl;
@@ -475,25 +416,6 @@ void ContGenoStats::blankLinRegStats(ContGenoStatsResults &results){
 	
 }
 
-/**
- * Return the total sum of squares.
- * Equal to sum of norm of difference to mean.
- * 
- */
-double ContGenoStats::sumSquaresTotal(vector<double> response){
-	
-	
-	double sum, sumsq;
-	sum = sumsq = 0.0;
-	double sst = 0;
-	for(unsigned int i=0;i<response.size();i++){
-		sum += response.at(i);
-		sumsq += pow(response.at(i),2);
-	}
-	sst = (sumsq - pow(sum , 2)/response.size()) / response.size();
-	return sst;
-}
-
 /**
  * Fill the residuals column.
  * 
@@ -503,6 +425,9 @@ double ContGenoStats::sumSquaresTotal(vector<double> response){
  * whom the current SNP's value is not 0.  Therefore, it can be used directly
  * rather than recomputed.
  * 
+ * If there is a ResidualCache and it holds residuals for the same set of
+ * individuals they are reused.
+ * 
  * @param snp The SNP we are operating on.
  */
 void ContGenoStats::covariateAdjust(int snp){
@@ -510,24 +435,22 @@ void ContGenoStats::covariateAdjust(int snp){
 	meanResidual = 0;
 	vector<double> ones, phen_vec;
 	vector<vector<double> > cov;
-	/* Prep covariate matrix */
-	vector<double> *tmp = data->get_covariates(0);
-	for(unsigned int i=0;i<tmp->size();i++){
-		vector<double> a;
-		cov.push_back(a);
-	}
+	vector<unsigned int> used; // Individuals not missing at this SNP.
 	
 	/* Prep genotypes and fill cov matrix */
+	vector<short> col;
+	data->get_snp(snp).decode(col);
 	for(int i=0; i<data->pheno_size(); i++ ){
-		if(data->get_data(i)->at(snp) != 0){
+		if(col.at(i) != 0){
 			phen_vec.push_back(data->get_phenotype(i));
 			ones.push_back(1.0);
-			vector<double> *t = data->get_covariates(i);
-			for(unsigned int j=0;j<t->size();j++){
-				cov.at(j).push_back(t->at(j));
-			}
+			used.push_back(i);
 		}
 	}
+	if(cache != NULL && cache->find(used, residuals, meanResidual)){
+		return;
+	}
+	data->get_covariates(used, cov);
 	
 	cov.push_back(ones);
 	
@@ -554,4 +477,32 @@ void ContGenoStats::covariateAdjust(int snp){
 		meanResidual += residuals.at(i);
 	meanResidual /= residuals.size();
 
+	if(cache != NULL){
+		cache->store(used, residuals, meanResidual);
+	}
+}
+
+bool ResidualCache::find(const vector<unsigned int> &used, vector<double> &residuals, double &mean) const{
+	for(unsigned int e=0; e < entries.size(); e++){
+		if(entries[e].used == used){
+			residuals = entries[e].residuals;
+			mean = entries[e].mean;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ResidualCache::store(const vector<unsigned int> &used, const vector<double> &residuals, double mean){
+	Entry *e;
+	if(entries.size() < RESIDUAL_CACHE_SIZE){
+		entries.push_back(Entry());
+		e = &entries.back();
+	}else{
+		e = &entries[next];
+		next = (next + 1) % RESIDUAL_CACHE_SIZE;
+	}
+	e->used = used;
+	e->residuals = residuals;
+	e->mean = mean;
 }
@@ -36,11 +36,41 @@ using namespace std;
 #include <iomanip> // reformat a few numbers.
 #endif
 
+// Sets of residuals kept by a ResidualCache.
+#define RESIDUAL_CACHE_SIZE 4
+
+/**
+ * The residuals of the phenotype on the covariates depend only on which
+ * individuals are used, i.e. on the SNP's missingness pattern.  This keeps
+ * the residuals for the last few patterns seen so SNPs that share one skip
+ * the regression.  Not thread safe: use one per thread.
+ */
+class ResidualCache{
+
+	public :
+		ResidualCache() : next(0) {}
+
+		/* Copy out the residuals for used, if they are held. */
+		bool find(const vector<unsigned int> &used, vector<double> &residuals, double &mean) const;
+		void store(const vector<unsigned int> &used, const vector<double> &residuals, double mean);
+
+	protected :
+		struct Entry {
+			vector<unsigned int> used;
+			vector<double> residuals;
+			double mean;
+		};
+		vector<Entry> entries;
+		unsigned int next; // Entry replaced next once full.
+};
+
 
 class ContGenoStats{
 
 	public :
 		ContGenoStats(DataAccess *d);
+		/* Share residuals through cache, which must outlive this object. */
+		ContGenoStats(DataAccess *d, ResidualCache *cache);
 		void prepGenoStatsForOutput(int snp, ContGenoStatsResults &results);
 
 	protected :
@@ -59,14 +89,14 @@ class ContGenoStats{
 		};
 
 		DataAccess *data;
+		ResidualCache *cache; // May be NULL.
 		/* Mean of the response variable (phenotype) over all individuals.  Set in computeMeanAndSD.  */
 		double responseMean;
 		bool ranMeans;
 		double meanResidual; // holds mean of last set of residuals.
 		vector<double> residuals; // Holds last set of residuals.
-
-
-		double sumSquaresTotal(vector<double> response);
+		ClassSums classSums; // Residuals by genotype, from computeLinRegStats.
+		vector<double> add; // Additive coding of the individuals in residuals.
 
 		// These are protected rather than public because their order is important.
 		// See prepGenoStatsForOutput() implementation.
@@ -76,9 +106,8 @@ class ContGenoStats{
 		void computeLinRegStats(int snp, ContGenoStatsResults &results);
 		/* Compute lack of fit stats */
 		void computeLackOfFit(int snp, ContGenoStatsResults &results);
-		/* Compute a single set of stats */
-		statisticsOutput computeSingleStats(const vector<vector<double> > &input, const vector<double> &response, double meanResponse,
-					string message, int snp);
+		/* Compute a single set of stats for a genotype coding, from classSums */
+		statisticsOutput computeSingleStats(const double code[3], string message, int snp);
 
 
 		/* Adjust for covariates */
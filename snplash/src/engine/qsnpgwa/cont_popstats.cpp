@@ -53,14 +53,16 @@ void ContPopStats::countIndividuals(int snp){
 		throw QSnpgwaException();
 	}
 	
+	vector<short> col;
+	data->get_snp(snp).decode(col);
 	for(int i = 0;i<data->pheno_size() ;++i){
 		numTotal++;
 		
-		if(data->get_data(i)->at(snp) == 0){
+		if(col.at(i) == 0){
 			missingQuant+=data->get_phenotype(i);
 		}else{
 			nonMissingQuant+=data->get_phenotype(i);
-			switch(data->get_data(i)->at(snp)){
+			switch(col.at(i)){
 				case 1:
 					pp++;
 				break;
@@ -103,9 +105,11 @@ void ContPopStats::performMissingtTest(int snp, ContPopStatsResults &r){
 	double missingSampVar, nonMissingSampVar;
 	missingSampVar = nonMissingSampVar = 0;
 	// Get sample variance.
+	vector<short> col;
+	data->get_snp(snp).decode(col);
 	for(int i = 0;i<data->pheno_size() ;++i){
 		if(data->get_phenotype(i) != 0){
-			int val = data->get_data(i)->at(snp);
+			int val = col.at(i);
 			if(val == 0){
 				missingSampVar += pow( (data->get_phenotype(i) - meanMissing  )   ,2);
 			}else if(val < 5){
@@ -25,6 +25,7 @@ QSnpgwa::QSnpgwa(){
 	this->data = new DataAccess;
 	this->data->init(NULL);
 	this->snp_param = new EngineParamReader;
+	streaming = false;
 }
 
 
@@ -56,16 +57,34 @@ void QSnpgwa::init(){
 
 	Logger::Instance()->init(param_reader->get_out_file() + ".log");
 
-	reader->process(data->getDataObject(), param_reader);
+	SnpDataCache cache(param_reader);
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		delete reader;
+		return;
+	}
+
+	streaming = false;
+	if(snp_param->get_snp_block() > 0){
+		streaming = reader->open_stream(data->getDataObject(), param_reader);
+		if(!streaming){
+			cerr << "--block is only supported for binary input.  Reading all genotypes." << endl;
+		}
+	}
+	if(!streaming){
+		reader->process(data->getDataObject(), param_reader);
+	}
 	
 	numInitSNPs = data->geno_size();
 	numInitPhen = data->pheno_size();
 
-	delete reader; // No longer needed.
+	if(!streaming){
+		delete reader; // No longer needed.
+	}
 	data->getDataObject()->remove_phenotype(numeric_limits<double>::max());
 	data->getDataObject()->remove_covariate(numeric_limits<double>::max());
 	
 	data->getDataObject()->prep_data(param_reader);
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 }
 
 void QSnpgwa::preProcess(){
@@ -86,71 +105,148 @@ void QSnpgwa::preProcess(){
 void QSnpgwa::process(){
 
 	int sz = data->geno_size();
+	int block = streaming ? snp_param->get_snp_block() : sz;
 	
 	// This is the primary loop.
-	for(int i=0;i < sz;i++){
+	for(int start=0; start < sz; start += block){
+		int stop = min(start + block, sz);
 
-		SnpInfo s;
-		ContPopStatsResults p;
-		ContGenoStatsResults g;
-		s.index = i+param_reader->get_begin();
+		if(streaming){
+			// LD is computed with the next SNP.
+			reader->read_block(data->getDataObject(), start, min(stop + 1, sz) - start);
+			if(stop < sz){
+				reader->prefetch_block(stop, min(stop + block + 1, sz) - stop);
+			}
+		}
 
-		data->get_map_info(i, s.chr, s.name, s.position);
-		
-		data->get_allele_codes(i, s.majAllele, s.minAllele, s.refAllele);
-		if(s.majAllele == ' '){
-			s.majAllele = '.';
+		processRange(start, stop);
+	}
+
+	if(streaming){
+		delete reader;
+	}
+	out.close();
+}
+
+/**
+ * Process SNPs [start, stop), which must be resident, on all threads.  Each
+ * thread has its own ResidualCache and statistics objects; lines are put
+ * back in order by the output class.  See Snpgwa::processRange.
+ *
+ * @param start First SNP.
+ * @param stop One past the last SNP.
+ */
+void QSnpgwa::processRange(int start, int stop){
+
+	#if RUN_IN_PARALLEL_QSNPGWA
+	int threads = SnpScheduler::max_threads();
+	#else
+	int threads = 1;
+	#endif
+
+	vector<ResidualCache> caches(threads);
+
+	if(threads == 1){
+		for(int i=start;i < stop;i++){
+			processSnp(i, &caches[0]);
 		}
-		if(s.minAllele == ' '){
-			s.minAllele = '.';
+		return;
+	}
+
+	SnpScheduler sched(threads);
+	int window = threads * QSNPGWA_WINDOW_PER_THREAD;
+	vector<int> cost;
+
+	for(int w=start; w < stop; w += window){
+		int end = min(w + window, stop);
+
+		cost.resize(end - w);
+		for(int i=w; i < end; i++){
+			cost[i - w] = data->getDataObject()->isUsable(i) ? 8 : 1;
 		}
-		if(s.refAllele == ' '){
-			s.refAllele = '.';
+		sched.fill(w, end, cost);
+
+		#pragma omp parallel num_threads(threads)
+		{
+			int t = SnpScheduler::thread_id();
+			int i;
+			while(sched.next(t, i)){
+				processSnp(i, &caches[t]);
+			}
 		}
-		
-		// calc difference in genetic position.
-		if(i < sz-1){
+	}
+}
 
-			string t, chr;
-			int pos = 0;
+/**
+ * Compute and write all statistics for a single SNP.  SNPs i and i+1 must
+ * be resident.
+ *
+ * @param i SNP index
+ * @param cache Residuals from earlier SNPs on this thread.
+ */
+void QSnpgwa::processSnp(int i, ResidualCache *cache){
 
-			data->get_map_info(i+1, chr, t, pos);
-			if(chr.compare(s.chr) == 0){
-				s.diff = pos-s.position;
-			}else{
-				s.diff = -999;
-			}
+	int sz = data->geno_size();
+
+	SnpInfo s;
+	ContPopStatsResults p;
+	ContGenoStatsResults g;
+	s.index = i+param_reader->get_begin();
 
+	data->get_map_info(i, s.chr, s.name, s.position);
+	
+	data->get_allele_codes(i, s.majAllele, s.minAllele, s.refAllele);
+	if(s.majAllele == ' '){
+		s.majAllele = '.';
+	}
+	if(s.minAllele == ' '){
+		s.minAllele = '.';
+	}
+	if(s.refAllele == ' '){
+		s.refAllele = '.';
+	}
+	
+	// calc difference in genetic position.
+	if(i < sz-1){
+
+		string t, chr;
+		int pos = 0;
+
+		data->get_map_info(i+1, chr, t, pos);
+		if(chr.compare(s.chr) == 0){
+			s.diff = pos-s.position;
 		}else{
 			s.diff = -999;
 		}
 
-		if(data->getDataObject()->isUsable(i)){
-			
-			ContPopStats pop_calc(data);
-			ContGenoStats gen_calc(data);
-	
-			LinkageDisequilibrium ld(data);
-			ld.enslave(snp_param); // We have to do this or the ld engine will think
-								   // that it owns the data and might erase it.
-									
-			LinkageMeasures lr;
-			pop_calc.prepPopStatsForOutput(i,p);
-			gen_calc.prepGenoStatsForOutput(i,g);
-			if(i + 1 < data->geno_size()){
-				ld.dprimeOnPair(i, i+1, lr);
-				g.rsquare = lr.rsquare;
-				g.dprime = lr.dPrime;
-			}else{
-				g.rsquare = g.dprime = -1.0;
-			}
-			
+	}else{
+		s.diff = -999;
+	}
+
+	if(data->getDataObject()->isUsable(i)){
+		
+		ContPopStats pop_calc(data);
+		ContGenoStats gen_calc(data, cache);
+
+		LinkageDisequilibrium ld(data);
+		ld.enslave(snp_param); // We have to do this or the ld engine will think
+							   // that it owns the data and might erase it.
+								
+		LinkageMeasures lr;
+		pop_calc.prepPopStatsForOutput(i,p);
+		gen_calc.prepGenoStatsForOutput(i,g);
+		if(i + 1 < data->geno_size()){
+			ld.dprimeOnPair(i, i+1, lr);
+			g.rsquare = lr.rsquare;
+			g.dprime = lr.dPrime;
 		}else{
-			initToZero(p, g);
+			g.rsquare = g.dprime = -1.0;
 		}
-		out.writeLine(i, s,p,g);
+		
+	}else{
+		initToZero(p, g);
 	}
-	out.close();
+	out.writeLine(i, s,p,g);
 }
 
 // zero out.
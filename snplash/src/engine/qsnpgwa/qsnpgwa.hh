@@ -37,6 +37,8 @@
 // A 1 means spit out checkpoints (for infinite loop debugging)
 #define DB_V_QSNP 0
 // A
+#define RUN_IN_PARALLEL_QSNPGWA 1
+#define QSNPGWA_WINDOW_PER_THREAD 256
 
 #include "../../param/engine_param_reader.h"
 #include "../engine.h"
@@ -44,6 +46,7 @@
 #include "cont_popstats.hh"
 #include "cont_genostats.hh"
 #include "../ld/ld.h"
+#include "../snp_scheduler.hh"
 
 using namespace std;
 
@@ -68,8 +71,11 @@ class QSnpgwa : public Engine {
 		void delete_my_innards();
 
 		void initToZero(ContPopStatsResults &p, ContGenoStatsResults &ge);
+		void processSnp(int i, ResidualCache *cache);
+		void processRange(int start, int stop);
 
 		QSnpgwaOutput out;
+		bool streaming; // true if the reader is handing us blocks of SNPs.
 
 		int numInitSNPs;
 		int numInitPhen;
@@ -62,9 +62,10 @@ int SnpData::remove_phenotype(double d){
  */
 int SnpData::remove_covariate(double d){
 	int deleted = 0;
-	for(unsigned int i=0; i < phenotypes.size(); i++){
-		for(unsigned int j=0;j<covariance.at(i).size();j++){
-			if(covariance.at(i).at(j) == d) {
+	for(unsigned int j=0; j < covariates.num_covariates(); j++){
+		const double *col = covariates.column(j);
+		for(unsigned int i=0; i < covariates.num_people(); i++){
+			if(col[i] == d) {
 				if(delete_indiv(i)) deleted++;
 			}
 		}
@@ -78,39 +79,47 @@ int SnpData::remove_covariate(double d){
  */
 int SnpData::remove_missing_geno(){
 
-	int deleted = 0;
-	for(unsigned long i=0;i<snp_data.at(0).size();i++){
-		bool flag = true;
-		for(unsigned long j=0;j<snp_data.size();j++){
-			if(snp_data.at(j).at(i) != 0) {
-				flag = false;
-				break;
-			}
-		}
-		if(flag){
-			// all missing.  erase.
-			all_missing.push_back(true);
-			deleted++;
-		}else{
-			all_missing.push_back(false);
-		}
+	all_missing.assign(genotypes.num_snps(), false);
+	if(genotypes.is_streamed()){
+		// Checked block by block as the rows are read (see check_missing_geno).
+		return 0;
 	}
+	int deleted = check_missing_geno(0, genotypes.num_snps());
 	cout << "Omitting " << deleted << " SNPs that are missing data on all individuals." << endl;
 	return deleted;
 
 }
 
+/**
+ * Flag the SNPs in a range that are missing data for all individuals.
+ * The rows must be resident.
+ *
+ * @param first First SNP to check
+ * @param count Number of SNPs to check
+ * @return Number of SNPs flagged.
+ */
+int SnpData::check_missing_geno(unsigned long first, unsigned long count){
+
+	int deleted = 0;
+	for(unsigned long i=first;i<first+count;i++){
+		bool flag = genotypes.all_missing(i);
+		all_missing.at(i) = flag;
+		if(flag) deleted++;
+	}
+	return deleted;
+}
+
 /*
  * Remove any individual that has the given value anywhere.
  */
 int SnpData::remove_indiv_with_snp_value(int d){
 
 	int deleted = 0;
-	for(unsigned long i=0;i<snp_data.size();i++){
-		for(unsigned long j=0;j<snp_data.at(i).size();j++){
-			if(snp_data.at(i).at(j) == d) {
+	for(unsigned long j=0;j<genotypes.num_snps();j++){
+		GenotypeColumn col = get_column(j);
+		for(unsigned int i=0;i<genotypes.num_people();i++){
+			if(col.at(i) == d) {
 				if(delete_indiv(i)) deleted++;
-				break;
 			}
 		}
 	}
@@ -141,20 +150,21 @@ void SnpData::prep_data(ParamReader * params){
 void SnpData::normalize(){
 
 	vector<long> locus_counts;
-	for(unsigned long l = 0; l < 2*snp_data.at(0).size(); l++)
+	for(unsigned long l = 0; l < 2*genotypes.num_snps(); l++)
 		locus_counts.push_back(0);
 
 
 	//#pragma omp parallel
 	//{
-		long stop_crit = static_cast<long>(snp_data.size());
+		long stop_crit = static_cast<long>(genotypes.num_snps());
 		short s;
 		//#pragma omp for schedule(static)
-		for(long i = 0; i < stop_crit; i++){
-			for(unsigned long j = 0 ; j < snp_data.at(i).size() ; j++){
+		for(long j = 0; j < stop_crit; j++){
+			GenotypeColumn col = get_column(j);
+			for(unsigned int i = 0 ; i < genotypes.num_people() ; i++){
 
 				// Build based on count.
-				s = snp_data.at(i).at(j);
+				s = col.at(i);
 				switch (s){
 					case 1 :
 						locus_counts.at(j*2)+=2;
@@ -183,7 +193,7 @@ void SnpData::normalize(){
 	// are in the correct order and flip if not.
 	// If the ref allele was not assigned, then we want to get
 	// the locus counts.
-	for(unsigned long l = 0; l < snp_data.at(0).size(); l++){
+	for(unsigned long l = 0; l < genotypes.num_snps(); l++){
 
 		if(map.at(l).refAllele != (char) 0){
 
@@ -223,62 +233,31 @@ void SnpData::normalize(){
  * 1<->4 ; 2<->3
  */
 void SnpData::recode_snp(long l){
-	short s;
-	for(unsigned long i = 0; i < snp_data.size(); i++){
-		s = snp_data.at(i).at(l);
-		switch (s) {
-			case 1:
-				snp_data.at(i).at(l) = 4;
-			break;
-			case 2:
-				snp_data.at(i).at(l) = 3;
-			break;
-			case 3:
-				snp_data.at(i).at(l) = 2;
-			break;
-			case 4:
-				snp_data.at(i).at(l) = 1;
-			break;
-		}
-	}
+	genotypes.flip(l);
 }
 
 /**
  *
- * Verify that all of the individuals have the same number of snps.
- *
- * Will call exit(0) if this fails.
+ * Remove individuals that were never filled in by the reader (they were in
+ * the phenotype file but not the genotype file).  The reader is responsible
+ * for checking that every line had the same number of SNPs.
  *
+ * @param loaded One flag per individual, true if genotypes were read.
  */
-void SnpData::verify_snp_lengths(){
+void SnpData::verify_snp_lengths(const vector<bool> &loaded){
 
-	unsigned int i = 0;
-	unsigned long length;
-	// Get base length;
-	length = snp_data.at(i).size();
-	while(length == 0){
-		i++;
-		length = snp_data.at(i).size();
-	}
-	for(i=1; i < snp_data.size(); i++){
-		if(snp_data.at(i).size() == 0){
+	for(unsigned int i=0; i < loaded.size(); i++){
+		if(!loaded.at(i)){
 			// This was unused in phenotype.
 			delete_indiv(i);
-		}else{
-			if(length != snp_data.at(i).size()){
-				cerr << "Line " << i+1 << " did not have same number of snps as line 1.  " << endl;
-				cerr << "Size was: " << snp_data.at(i).size() << endl;
-				cerr << "Aborting" << endl;
-				exit(0);
-			}
 		}
 	}
 	indiv_flush();
-	cout << "Read " << length << " SNPs" << endl;
+	cout << "Read " << genotypes.num_snps() << " SNPs" << endl;
 }
 
 void SnpData::verify_map_length(){
-	if(map.size() != snp_data.at(0).size()){
+	if(static_cast<long>(map.size()) != numSnps()){
 		cerr << "Map has incorrect number of SNPs.  Aborting." << endl;
 		exit(0);
 	}
@@ -295,7 +274,7 @@ void SnpData::verify_data_size_match(){
 
 	unsigned long length;
 	// Get base length;
-	length = snp_data.size();
+	length = genotypes.num_people();
 	if(length != phenotypes.size()){
 		cerr << "There are " << length << " genotypes but " << phenotypes.size() << " phenotypes." << endl;
 	}
@@ -438,22 +417,7 @@ void SnpData::categorical_phenotype(int low, int hi){
  * Recode all threes in the data as twos for algorithms that do not require haplo information. *
  */
 void SnpData::remove_haplotype(){
-
-	long outer = snp_data.size();
-	long inner = snp_data.at(0).size();
-
-	#pragma omp parallel
-	{
-		#pragma omp for
-		for(long i=0;i < outer;i++){
-			for(long j=0;j < inner;j++){
-				if(snp_data.at(i).at(j) == 3){
-					snp_data.at(i).at(j) = 2;
-				}
-			}
-		}
-	} // end pragma parallel
-
+	genotypes.drop_phase();
 }
 
 /**
@@ -479,20 +443,14 @@ string SnpData::snp_name(long l){
 }
 
 /**
- * Retrieve an array pointer from the snp_data set.  The result
- * corresponds to an individual's genome.
+ * Retrieve a view of a single SNP across all individuals.
  *
- * @param i corresponds to an individual.
- * @return vector<short>* pointer to SNPs for single individual.
+ * @param snp SNP index in data set.
+ * @param redirect Optional individual redirection (see DataAccess).
+ * @return GenotypeColumn view of the packed SNP row.
  */
-vector<short>* SnpData::get_column(unsigned int i){
-	return &(snp_data.at(i));
-}
-
-vector<double>* SnpData::covariate_column(int person){
-	if(static_cast<int>(covariance.size()) > person)
-		return &(covariance.at(person));
-	return NULL;
+GenotypeColumn SnpData::get_column(unsigned long snp, const vector<unsigned int> *redirect){
+	return GenotypeColumn(genotypes.row(snp), genotypes.phase_row(snp), genotypes.num_people(), redirect);
 }
 
 /**
@@ -520,141 +478,126 @@ void SnpData::fill_allele_codes(int i, char &maj, char &min, char &ref){
 // SNP Removal
 
 /**
- * Remove a SNP from the sample data completely.
- *
- * Remove from the vector for each individual.
- * Remove from the map vector.
- *
- * Note: this algorithm is linear in number of elements after l.
+ * Mark SNP l for removal at the next snp_flush().
  *
- * @param l vector position
- * @return bool true if completed.
+ * @return false if it was already marked or does not exist.
  */
-void SnpData::perform_delete_of_snp(long l){
-
-	if(l > static_cast<long>(map.size())){
-		return;
+bool SnpData::delete_snp(long l){
+	if(l < 0 || l >= static_cast<long>(genotypes.num_snps())){
+		return false;
 	}
-
-	// Erase from map
-	this->map.erase(map.begin() + l-1);
-
-	// Erase from each individual.
-	// TODO replace this with a copy of all nonerased individuals then a clear and replace.
-	for(unsigned int i=0; i < snp_data.size(); ++i){
-		this->snp_data.at(i).erase(this->snp_data.at(i).begin() + l);
+	if(snp_keep.size() != genotypes.num_snps()){
+		snp_keep.assign(genotypes.num_snps(), true);
 	}
-}
-
-/**
- * Push l onto SNP delete vector if it is not already there.
- * For removal of SNPs
- */
-bool SnpData::delete_snp(long l){
-	for(unsigned int i=0;i < snp_delete_records.size();++i){
-		if(snp_delete_records.at(i) == l){
-			return false;
-		}
+	if(!snp_keep[l]){
+		return false;
 	}
-	snp_delete_records.push_back(l);
+	snp_keep[l] = false;
 	return true;
 }
 
 /**
- * Perform removal and clear the delete vector.
- * For removal of SNPs
+ * Remove every SNP marked by delete_snp().
+ *
+ * All pending SNPs are removed in one pass over the genotypes, the map,
+ * the character list and the all missing flags, so the cost does not
+ * depend on how many are removed.
  */
 void SnpData::snp_flush(){
-	if(snp_delete_records.size() == 0){return;}
-
-	vector<long>::reverse_iterator it;
-	sort(snp_delete_records.begin(), snp_delete_records.end());
-	for(it = snp_delete_records.rbegin(); it != snp_delete_records.rend(); ++it){
-		//perform_delete_of_snp(*it);
-	}
-
-	// Remove elements from the map.
-	vector<MapData> map_temp;
-	vector<long>::iterator lit = snp_delete_records.begin();
-	for(unsigned int j=0; j < map.size(); j++){
-		if(*lit == j){
-			lit++;
-		}else{
-			map_temp.push_back(map.at(j));
-		}
+	if(snp_keep.empty()){return;}
+
+	vector<bool> keep;
+	keep.swap(snp_keep);
+	if(keep.size() != genotypes.num_snps()){
+		return; // The SNPs changed under the pending deletes.
 	}
-	map = map_temp;
-	map_temp.clear();
 
-	// Remove elements from each individual.
-	for(unsigned int i=0; i < snp_data.size() ; i++){
-		vector<short> temp;
-		vector<long>::iterator lit_inner = snp_delete_records.begin();
-		for(unsigned int j=0; j < snp_data.at(i).size(); j++){
-			if(*lit_inner == j){
-				lit_inner++;
-			}else{
-				temp.push_back(snp_data.at(i).at(j));
-			}
+	if(!genotypes.keep_snps(keep)){
+		DataException d;
+		d.message = "SNPs cannot be removed from streamed genotypes.";
+		throw d;
+	}
+
+	// Remove elements from the map, the character list and the flags.
+	unsigned long kept = 0;
+	for(unsigned long j=0; j < keep.size(); j++){
+		if(!keep[j]){
+			continue;
 		}
-		snp_data.at(i) = temp;
-	}
-
-	// Clear up the characterlist.
-	vector<char> new_list;
-	vector<long>::iterator cit;
-	cit = snp_delete_records.begin();
-	for(long i=0;i < static_cast<long>(character_list.size());i ++){
-		if(*cit == i / 2){
-			i++; // skip ahead two.
-			cit++;
-		}else{
-			new_list.push_back(character_list.at(i));
+		if(kept != j){
+			if(j < map.size()){
+				map[kept] = map[j];
+			}
+			if(2*j+1 < character_list.size()){
+				character_list[2*kept] = character_list[2*j];
+				character_list[2*kept+1] = character_list[2*j+1];
+			}
+			if(j < all_missing.size()){
+				all_missing[kept] = all_missing[j];
+			}
 		}
+		kept++;
 	}
-	character_list = new_list;
-
-	snp_delete_records.clear();
+	map.resize(min(map.size(), static_cast<size_t>(kept)));
+	character_list.resize(min(character_list.size(), static_cast<size_t>(2*kept)));
+	all_missing.resize(min(all_missing.size(), static_cast<size_t>(kept)));
 }
 
-// Delete an indiv by inserting into buffer.
+/**
+ * Mark individual l for removal at the next indiv_flush().
+ *
+ * @return false if it was already marked or does not exist.
+ */
 bool SnpData::delete_indiv(int l){
-	for(unsigned int i=0;i < indiv_delete_records.size();++i){
-		if(indiv_delete_records.at(i) == l){
-			return false;
-		}
+	if(l < 0 || l >= static_cast<int>(phenotypes.size())){
+		return false;
+	}
+	if(indiv_keep.size() != phenotypes.size()){
+		indiv_keep.assign(phenotypes.size(), true);
+	}
+	if(!indiv_keep[l]){
+		return false;
 	}
-	indiv_delete_records.push_back(l);
+	indiv_keep[l] = false;
 	return true;
 }
 
-// Actually perform the delete for individuals in the indiv_delete_records function.
-// Works in reverse order. This method is not efficient b/c we don't want to assume
-// that we can store the data in memory more than once.
+// Actually perform the delete for individuals marked by delete_indiv().
+// Genotypes are packed by SNP, so removing a single individual means rewriting
+// every row: everything is compacted once against the keep mask.
 void SnpData::indiv_flush(){
-	if(indiv_delete_records.size() == 0){
+	if(indiv_keep.empty()){
 		return;
 	}
 
-	vector<int>::reverse_iterator it;
-	sort(indiv_delete_records.begin(), indiv_delete_records.end());
-	for(it = indiv_delete_records.rbegin(); it != indiv_delete_records.rend(); ++it){
-		perform_delete_of_indiv(*it);
+	vector<bool> keep;
+	keep.swap(indiv_keep);
+	if(keep.size() != phenotypes.size()){
+		return; // The individuals changed under the pending deletes.
 	}
-	indiv_delete_records.clear();
-}
-
-// perform deletion.
-void SnpData::perform_delete_of_indiv(int l){
 
-	// Erase from phen.
-	this->phenotypes.erase(this->phenotypes.begin() + l);
+	genotypes.keep_people(keep);
+	covariates.keep_people(keep);
 
-	// Erase from data
-	this->snp_data.erase(snp_data.begin() + l);
-
-	// Erase from cov.
-	this->covariance.erase(covariance.begin() + l);
+	unsigned int kept = 0;
+	for(unsigned int i=0; i < keep.size(); i++){
+		if(keep[i]){
+			phenotypes[kept++] = phenotypes[i];
+		}
+	}
+	phenotypes.resize(kept);
+
+	// Names are only in step with the individuals once the reader has
+	// cleaned them (see cleanIndividualNames()).
+	if(individualName.size() == keep.size()){
+		kept = 0;
+		for(unsigned int i=0; i < keep.size(); i++){
+			if(keep[i]){
+				individualName[kept++] = individualName[i];
+			}
+		}
+		individualName.resize(kept);
+	}
 }
 
 /*
@@ -664,14 +607,14 @@ void SnpData::perform_delete_of_indiv(int l){
  */
 void SnpData::dump_data(){
 
-	for(unsigned int i=0;i < snp_data.size(); i++){
+	for(unsigned int i=0;i < genotypes.num_people(); i++){
 
 		cout << phenotypes.at(i) << " " ;
-		for(unsigned int j=0;j < covariance.at(i).size();j++){
-			cout << covariance.at(i).at(j) << " ";
+		for(unsigned int j=0;j < covariates.num_covariates();j++){
+			cout << covariates.at(i, j) << " ";
 		}
-		for(unsigned int j=0;j < snp_data.at(i).size();j++){
-			cout << snp_data.at(i).at(j) << " ";
+		for(unsigned long j=0;j < genotypes.num_snps();j++){
+			cout << genotypes.get(j, i) << " ";
 		}
 		cout << endl;
 	}
@@ -30,8 +30,9 @@
  * related to data cleaning, unless this is something that
  * we would want to do on a method specific type.
  *
- * In the interest of quick access, we are going to implement all
- * data in vectors, which are thread-safe for access.  Shorts for snps.
+ * Genotypes are held SNP-major in a packed GenotypeMatrix, 2 bits per
+ * genotype (see genotype_matrix.hh).  Access by SNP is contiguous.  The
+ * coding exposed to engines is:
  *
  * 0: Missing
  * 1: 1 1
@@ -51,6 +52,8 @@
 #include "utils/exceptions.h"
 #include "utils/float_ops.hh"
 #include "randwh.h"
+#include "genotype_matrix.hh"
+#include "covariate_matrix.hh"
 
 class SnpData {
 
@@ -58,6 +61,7 @@ class SnpData {
 	friend class LinkageReader;
 	friend class BinaryBedReader;
 	friend class DataAccess;
+	friend class SnpDataCache;
 
 	protected:
 	struct MapData {
@@ -94,14 +98,16 @@ class SnpData {
 		int remove_indiv_with_snp_value(int); // remove all individuals with a single SNP that has given value.
 
 		int remove_missing_geno(); // remove if all individuals are missing.
+		int check_missing_geno(unsigned long first, unsigned long count); // same, for a block of SNPs.
 
 		bool isUsable(int i){return !all_missing.at(i);}
 
 		int numIndividuals(){return phenotypes.size();}
+		long numSnps(){return genotypes.num_snps();}
 
 		/// Data manipulation functions
 		bool delete_snp(long l); // Delete a SNP by inserting into buffer.
-		void snp_flush(); // Actually perform delete.  Two part process: delete_snp(); flush(); flush calls perform_delete();
+		void snp_flush(); // Actually perform delete.  Two part process: delete_snp(); flush();  All pending SNPs go in one pass.
 
 		bool delete_indiv(int i); // Delete an indiv by inserting into buffer.
 		void indiv_flush(); // Actually perform the delete.
@@ -113,10 +119,10 @@ class SnpData {
 		/* The following data access routines are allowed for friends only. */
 		
 		/// Access functions
-		// Returns column using bootstrap in second param.
-		vector<short>* get_column(unsigned int); 
-		// Return a pointer to a column of covariates.
-		vector<double>* covariate_column(int person);
+		// Returns a SNP across all individuals, optionally redirected.
+		GenotypeColumn get_column(unsigned long snp, const vector<unsigned int> *redirect = NULL);
+		// Returns all SNPs for one individual.
+		GenotypeRow get_row(unsigned int person){return GenotypeRow(&genotypes, person);}
 		// Return a single phenotype.
 		double phenotype_at(int i){	return phenotypes.at(i);}
 		
@@ -128,14 +134,16 @@ class SnpData {
 		// Returns the major and minor allele for an individual.
 		void fill_allele_codes(int i, char &maj, char &min, char &ref);
 		// Return number of snps in sample.
-		long snp_size(unsigned int o){return snp_data.at(o).size();}
+		long snp_size(){return genotypes.num_snps();}
 		
-		vector<vector< short> > snp_data;  // Each inner vec stores an individual's genotypes.
-		vector<vector< double > > covariance; 
+		GenotypeMatrix genotypes;  // Each row stores one SNP for all individuals.
+		CovariateMatrix covariates; // Each column stores one covariate for all individuals.
 		vector<double> phenotypes;			
 		vector<MapData> map;
-		vector<long> snp_delete_records; // Holds set of records that are to be deleted. (snps)
-		vector<int> indiv_delete_records;
+		// Pending deletions: false for each SNP / individual to be removed at the next flush.
+		// Empty when nothing is pending.
+		vector<bool> snp_keep;
+		vector<bool> indiv_keep;
 		vector<bool> all_missing; // Holds whether missing for all individuals or not.
 		
 		vector<string> individualName; // Hold original individual names.
@@ -145,11 +153,9 @@ class SnpData {
 
 		void normalize();
 		void recode_snp(long);
-		void perform_delete_of_snp(long); // Actually performs a delete operation.
-		void perform_delete_of_indiv(int); // Actually performs a delete operation.
 
 		// Check fxns.
-		void verify_snp_lengths();
+		void verify_snp_lengths(const vector<bool> &loaded);
 		void verify_data_size_match();
 		void verify_map_length();
 
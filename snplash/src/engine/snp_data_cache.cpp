@@ -0,0 +1,350 @@
+/*
+ *      snp_data_cache.cpp
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+#include "snp_data_cache.hh"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+const unsigned int SnpDataCache::version = 2;
+
+namespace {
+
+	const char magic[8] = {'S', 'N', 'P', 'L', 'C', 'A', 'C', 'H'};
+	const unsigned int byte_order = 0x01020304;
+
+	// Writes values in turn, remembering the offset for alignment.
+	class CacheWriter {
+		public:
+			CacheWriter(FILE *out) : out(out), offset(0), ok(true) {}
+
+			void bytes(const void *p, size_t n){
+				if(n > 0 && fwrite(p, 1, n, out) != n) ok = false;
+				offset += n;
+			}
+			void u64(unsigned long long v){bytes(&v, sizeof(v));}
+			void str(const string &s){
+				u64(s.size());
+				bytes(s.data(), s.size());
+			}
+			void align(){
+				char zero[8] = {0};
+				bytes(zero, (8 - offset % 8) % 8);
+			}
+
+			FILE *out;
+			size_t offset;
+			bool ok;
+	};
+
+	// Reads values in turn from the mapping.  Running off the end clears ok.
+	class CacheCursor {
+		public:
+			CacheCursor(const unsigned char *start, size_t length) : start(start), offset(0), length(length), ok(true) {}
+
+			const unsigned char *bytes(size_t n){
+				if(!ok || n > length - offset){
+					ok = false;
+					return NULL;
+				}
+				const unsigned char *p = start + offset;
+				offset += n;
+				return p;
+			}
+			unsigned long long u64(){
+				unsigned long long v = 0;
+				const unsigned char *p = bytes(sizeof(v));
+				if(p != NULL) memcpy(&v, p, sizeof(v));
+				return v;
+			}
+			string str(){
+				unsigned long long n = u64();
+				const unsigned char *p = bytes(n);
+				return (p == NULL) ? string() : string(reinterpret_cast<const char *>(p), n);
+			}
+			void align(){
+				bytes((8 - offset % 8) % 8);
+			}
+
+			const unsigned char *start;
+			size_t offset;
+			size_t length;
+			bool ok;
+	};
+}
+
+/**
+ * Build the key that a snapshot must match from the current parameters.
+ */
+SnpDataCache::SnpDataCache(ParamReader *params){
+	file = params->get_cache_file();
+
+	stringstream ss;
+	ss << "engine " << params->get_engine_types() << endl;
+	ss << "input " << params->get_input_type() << endl;
+	ss << "geno " << describe_file(params->get_linkage_geno_file()) << endl;
+	ss << "bed " << describe_file(params->get_binary_geno_file()) << endl;
+	ss << "phen " << describe_file(params->get_linkage_pheno_file()) << endl;
+	ss << "map " << describe_file(params->get_linkage_map_file()) << endl;
+	ss << "trait " << params->get_trait() << endl;
+	ss << "cov";
+	vector<string> cov = params->get_covariates();
+	for(unsigned int i=0; i < cov.size(); i++){
+		ss << " " << cov.at(i);
+	}
+	ss << endl;
+	ss << "skip";
+	for(unsigned int i=0; i < params->get_skip_cols().size(); i++){
+		ss << " " << params->get_skip_cols().at(i);
+	}
+	ss << endl;
+	ss << "window " << params->get_begin() << " " << params->get_end() << endl;
+	ss << "ign " << params->get_ign() << endl;
+	key = ss.str();
+}
+
+/**
+ * Path, size and modification time of an input file.
+ */
+string SnpDataCache::describe_file(const string &path){
+	stringstream ss;
+	ss << path;
+	struct stat st;
+	if(stat(path.c_str(), &st) == 0){
+		ss << " " << st.st_size << " " << st.st_mtime;
+	}
+	return ss.str();
+}
+
+/**
+ * Load a snapshot written by save().  Nothing is changed unless the whole
+ * snapshot is read.
+ *
+ * @param data Empty data object to fill.
+ * @param numInitSNPs Set to the number of SNPs read before cleaning.
+ * @param numInitPhen Set to the number of individuals read before cleaning.
+ * @return false if there is no snapshot or it does not match this run.
+ */
+bool SnpDataCache::load(SnpData *data, int &numInitSNPs, int &numInitPhen){
+	if(!enabled()){
+		return false;
+	}
+
+	int fd = open(file.c_str(), O_RDONLY);
+	if(fd < 0){
+		return false;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0){
+		close(fd);
+		return false;
+	}
+	size_t length = static_cast<size_t>(st.st_size);
+	void *mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED){
+		return false;
+	}
+
+	CacheCursor in(static_cast<const unsigned char *>(mapping), length);
+	const unsigned char *m = in.bytes(sizeof(magic));
+	unsigned long long v = in.u64();
+	unsigned long long bom = in.u64();
+	if(m == NULL || memcmp(m, magic, sizeof(magic)) != 0 || v != version || bom != byte_order || in.str() != key){
+		cout << "Cache " << file << " does not match this run.  It will be rebuilt." << endl;
+		munmap(mapping, length);
+		return false;
+	}
+
+	unsigned long long initSnps = in.u64();
+	unsigned long long initPhen = in.u64();
+	unsigned long long snps = in.u64();
+	unsigned long long people = in.u64();
+
+	vector<double> phenotypes(people);
+	const unsigned char *p = in.bytes(people * sizeof(double));
+	if(p != NULL && people > 0) memcpy(&phenotypes[0], p, people * sizeof(double));
+
+	unsigned long long ncov = in.u64();
+	vector<double> covariates(people * ncov);
+	p = in.bytes(covariates.size() * sizeof(double));
+	if(p != NULL && !covariates.empty()) memcpy(&covariates[0], p, covariates.size() * sizeof(double));
+
+	vector<string> names(in.u64());
+	for(unsigned long long i=0; i < names.size() && in.ok; i++){
+		names[i] = in.str();
+	}
+
+	vector<SnpData::MapData> map(snps);
+	for(unsigned long long i=0; i < snps && in.ok; i++){
+		map[i].pos = static_cast<long>(in.u64());
+		map[i].chr = in.str();
+		map[i].name = in.str();
+		p = in.bytes(2);
+		if(p != NULL){
+			map[i].refAllele = static_cast<char>(p[0]);
+			map[i].flipped = p[1] != 0;
+		}
+	}
+
+	string characters = in.str();
+	vector<bool> all_missing(snps);
+	p = in.bytes(snps);
+	for(unsigned long long i=0; p != NULL && i < snps; i++){
+		all_missing[i] = p[i] != 0;
+	}
+
+	unsigned long long maxMapLength = in.u64();
+	unsigned long long maxPersonIDLength = in.u64();
+	unsigned long long hasPhase = in.u64();
+
+	in.align();
+	unsigned long long stride = (people + 3) / 4;
+	const unsigned char *rows = in.bytes(snps * stride);
+	const unsigned char *phase = NULL;
+	if(hasPhase){
+		phase = in.bytes(snps * ((people + 7) / 8));
+	}
+
+	if(!in.ok){
+		cout << "Cache " << file << " is incomplete.  It will be rebuilt." << endl;
+		munmap(mapping, length);
+		return false;
+	}
+
+	data->phenotypes.swap(phenotypes);
+	data->covariates.assign_columns(covariates.empty() ? NULL : &covariates[0], people, ncov);
+	data->individualName.swap(names);
+	data->map.swap(map);
+	data->character_list.assign(characters.begin(), characters.end());
+	data->all_missing.swap(all_missing);
+	data->maxMapLength = maxMapLength;
+	data->maxPersonIDLength = maxPersonIDLength;
+
+	// The genotype rows stay in the mapping, which the matrix now owns.
+	data->genotypes.attach(mapping, length, rows, snps, people);
+	if(phase != NULL){
+		unsigned long long phase_bytes = (people + 7) / 8;
+		for(unsigned long long i=0; i < snps; i++){
+			data->genotypes.set_phase_row(i, phase + i * phase_bytes);
+		}
+	}
+
+	numInitSNPs = initSnps;
+	numInitPhen = initPhen;
+	cout << "Loaded cleaned data from cache " << file << ": " << people << " individuals and " << snps << " SNPs." << endl;
+	return true;
+}
+
+/**
+ * Write the snapshot.  It is written to a temporary file and renamed into
+ * place, so a failed write never leaves a partial snapshot behind.
+ *
+ * @param data Cleaned data.
+ * @param numInitSNPs Number of SNPs read before cleaning.
+ * @param numInitPhen Number of individuals read before cleaning.
+ */
+void SnpDataCache::save(SnpData *data, int numInitSNPs, int numInitPhen){
+	if(!enabled()){
+		return;
+	}
+	if(data->genotypes.is_streamed()){
+		cerr << "Warning: the genotypes were streamed, so no cache was written." << endl;
+		return;
+	}
+	if(data->phenotypes.size() != data->genotypes.num_people() || data->map.size() != data->genotypes.num_snps()
+			|| (data->covariates.num_covariates() > 0 && data->covariates.num_people() != data->genotypes.num_people())){
+		cerr << "Warning: the data set is inconsistent, so no cache was written." << endl;
+		return;
+	}
+
+	string tmp = file + ".tmp";
+	FILE *f = fopen(tmp.c_str(), "wb");
+	if(f == NULL){
+		cerr << "Warning: unable to write cache " << file << endl;
+		return;
+	}
+
+	CacheWriter out(f);
+	unsigned long long snps = data->genotypes.num_snps();
+	unsigned long long people = data->genotypes.num_people();
+
+	out.bytes(magic, sizeof(magic));
+	out.u64(version);
+	out.u64(byte_order);
+	out.str(key);
+
+	out.u64(numInitSNPs);
+	out.u64(numInitPhen);
+	out.u64(snps);
+	out.u64(people);
+
+	if(people > 0) out.bytes(&data->phenotypes[0], people * sizeof(double));
+
+	unsigned long long ncov = data->covariates.num_covariates();
+	out.u64(ncov);
+	for(unsigned long long c=0; c < ncov; c++){
+		out.bytes(data->covariates.column(c), people * sizeof(double));
+	}
+
+	out.u64(data->individualName.size());
+	for(unsigned int i=0; i < data->individualName.size(); i++){
+		out.str(data->individualName[i]);
+	}
+
+	for(unsigned long long i=0; i < snps; i++){
+		const SnpData::MapData &m = data->map.at(i);
+		out.u64(m.pos);
+		out.str(m.chr);
+		out.str(m.name);
+		unsigned char flags[2] = {static_cast<unsigned char>(m.refAllele), static_cast<unsigned char>(m.flipped ? 1 : 0)};
+		out.bytes(flags, 2);
+	}
+
+	out.str(string(data->character_list.begin(), data->character_list.end()));
+	vector<unsigned char> missing(snps);
+	for(unsigned long long i=0; i < snps; i++){
+		missing[i] = (i < data->all_missing.size() && data->all_missing[i]) ? 1 : 0;
+	}
+	if(snps > 0) out.bytes(&missing[0], snps);
+
+	out.u64(data->maxMapLength);
+	out.u64(data->maxPersonIDLength);
+	bool hasPhase = snps > 0 && data->genotypes.phase_row(0) != NULL;
+	out.u64(hasPhase ? 1 : 0);
+
+	out.align();
+	if(snps > 0) out.bytes(data->genotypes.row(0), snps * data->genotypes.stride());
+	if(hasPhase) out.bytes(data->genotypes.phase_row(0), snps * ((people + 7) / 8));
+
+	bool ok = out.ok;
+	if(fclose(f) != 0) ok = false;
+	if(!ok || rename(tmp.c_str(), file.c_str()) != 0){
+		cerr << "Warning: unable to write cache " << file << endl;
+		remove(tmp.c_str());
+		return;
+	}
+	cout << "Wrote cleaned data to cache " << file << "." << endl;
+}
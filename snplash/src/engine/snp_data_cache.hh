@@ -0,0 +1,79 @@
+/*
+ *      snp_data_cache.hh
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef SNP_DATA_CACHE_H
+#define SNP_DATA_CACHE_H
+
+/**
+ * Binary snapshot of a cleaned SnpData (the -cache option).
+ *
+ * Reading text input and cleaning it is the same work every time an engine
+ * is run on a cohort.  After an engine has read and cleaned its data it can
+ * save() the result.  Later runs load() it instead: the file is mapped once,
+ * the genotype rows are used in place (see GenotypeMatrix::attach()) and
+ * everything else is copied out of the mapping.
+ *
+ * Cleaning differs between engines, so the snapshot records the engine and
+ * the input files (with their sizes and modification times) and the options
+ * that affect the data.  A snapshot that does not match is ignored and
+ * replaced.
+ *
+ * Layout, in native byte order:
+ *
+ * magic, version, byte order mark
+ * key (the description above)
+ * counts before cleaning, then SNPs and individuals
+ * phenotypes, covariates (column by column), individual names
+ * map, allele characters, all-missing flags
+ * packed genotype rows (8 byte aligned), then phase rows if any
+ */
+
+#include <string>
+#include "snp_data.hh"
+
+using namespace std;
+
+class SnpDataCache {
+
+	public:
+		SnpDataCache(ParamReader *params);
+
+		/* True if -cache was given. */
+		bool enabled() const {return file.compare("none") != 0;}
+
+		/* Load the snapshot if it matches this run.  Returns the counts before cleaning. */
+		bool load(SnpData *data, int &numInitSNPs, int &numInitPhen);
+		/* Write the snapshot of the cleaned data. */
+		void save(SnpData *data, int numInitSNPs, int numInitPhen);
+
+		/* The inputs and options a snapshot must match, one per line. */
+		const string &get_key() const {return key;}
+
+		static const unsigned int version;
+
+	protected:
+		string file;
+		string key;
+
+		static string describe_file(const string &path);
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ *      snp_scheduler.cpp
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+#include "snp_scheduler.hh"
+#include <algorithm>
+
+/*
+ * Chunks per thread in a window.  More chunks balance better up front at
+ * the price of more trips to the deque.
+ */
+#define CHUNKS_PER_THREAD 8
+
+SnpScheduler::SnpScheduler(int threads){
+	if(threads < 1) threads = 1;
+	for(int t=0; t < threads; t++){
+		Queue *q = new Queue;
+		#ifdef _OPENMP
+		omp_init_lock(&q->lock);
+		#endif
+		queues.push_back(q);
+	}
+}
+
+SnpScheduler::~SnpScheduler(){
+	for(unsigned int t=0; t < queues.size(); t++){
+		#ifdef _OPENMP
+		omp_destroy_lock(&queues[t]->lock);
+		#endif
+		delete queues[t];
+	}
+}
+
+int SnpScheduler::max_threads(){
+	#ifdef _OPENMP
+	return omp_get_max_threads();
+	#else
+	return 1;
+	#endif
+}
+
+int SnpScheduler::thread_id(){
+	#ifdef _OPENMP
+	return omp_get_thread_num();
+	#else
+	return 0;
+	#endif
+}
+
+void SnpScheduler::lock(Queue *q){
+	#ifdef _OPENMP
+	omp_set_lock(&q->lock);
+	#endif
+}
+
+void SnpScheduler::unlock(Queue *q){
+	#ifdef _OPENMP
+	omp_unset_lock(&q->lock);
+	#endif
+}
+
+/**
+ * Cut [start, stop) into chunks of about equal total cost and deal them out.
+ * Must be called outside of the parallel region that drains the queues.
+ *
+ * @param start First SNP.
+ * @param stop One past the last SNP.
+ * @param cost Estimated cost of each SNP, at least 1 is assumed.
+ */
+void SnpScheduler::fill(int start, int stop, const vector<int> &cost){
+
+	long total = 0;
+	for(int i=start; i < stop; i++){
+		total += max(cost[i - start], 1);
+	}
+
+	long target = total / (static_cast<long>(queues.size()) * CHUNKS_PER_THREAD);
+	if(target < 1) target = 1;
+
+	unsigned int t = 0;
+	int first = start;
+	long have = 0;
+	for(int i=start; i < stop; i++){
+		have += max(cost[i - start], 1);
+		if(have >= target || i == stop - 1){
+			queues[t]->ranges.push_back(make_pair(first, i + 1));
+			t = (t + 1) % queues.size();
+			first = i + 1;
+			have = 0;
+		}
+	}
+}
+
+/*
+ * Take the first SNP of the first range in q.  The rest of the range stays
+ * on the deque where another thread can steal it.
+ */
+bool SnpScheduler::pop_front(Queue *q, int &snp){
+	bool found = false;
+	lock(q);
+	if(!q->ranges.empty()){
+		pair<int, int> &r = q->ranges.front();
+		snp = r.first;
+		if(++r.first == r.second){
+			q->ranges.pop_front();
+		}
+		found = true;
+	}
+	unlock(q);
+	return found;
+}
+
+/*
+ * Take the back half of the last range in q, or all of it if it is one SNP.
+ */
+bool SnpScheduler::steal_back(Queue *q, int &first, int &last){
+	bool found = false;
+	lock(q);
+	if(!q->ranges.empty()){
+		pair<int, int> &r = q->ranges.back();
+		if(r.second - r.first > 1){
+			int mid = r.first + (r.second - r.first) / 2;
+			first = mid;
+			last = r.second;
+			r.second = mid;
+		}else{
+			first = r.first;
+			last = r.second;
+			q->ranges.pop_back();
+		}
+		found = true;
+	}
+	unlock(q);
+	return found;
+}
+
+/**
+ * Claim the next SNP for a thread: its own work first, then work stolen
+ * from the others, starting with its neighbour.
+ *
+ * @param thread Caller's thread number.
+ * @param snp Set to the SNP to process.
+ * @return false when every deque is empty.
+ */
+bool SnpScheduler::next(int thread, int &snp){
+
+	int n = static_cast<int>(queues.size());
+	thread %= n;
+
+	if(pop_front(queues[thread], snp)){
+		return true;
+	}
+	int first, last;
+	for(int k=1; k < n; k++){
+		if(steal_back(queues[(thread + k) % n], first, last)){
+			// Keep the loot on our own deque so it can be stolen again.
+			Queue *mine = queues[thread];
+			lock(mine);
+			mine->ranges.push_back(make_pair(first, last));
+			unlock(mine);
+			return pop_front(mine, snp) || next(thread, snp);
+		}
+	}
+	return false;
+}
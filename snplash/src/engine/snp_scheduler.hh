@@ -0,0 +1,99 @@
+/*
+ *      snp_scheduler.hh
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef SNP_SCHEDULER_H
+#define SNP_SCHEDULER_H
+
+/**
+ * Hands out ranges of SNPs to the threads of an OpenMP team.
+ *
+ * The SNPs in a window are cut into chunks of roughly equal estimated cost
+ * and dealt round-robin onto one deque per thread.  A thread takes one SNP
+ * at a time from the front of its own deque; when that is empty it steals
+ * from the back of another thread's deque, splitting the range it finds so
+ * the thief takes only the back half.  Everything not yet started can be
+ * stolen, so at the end of a window no thread waits on more than the one
+ * SNP each other thread is working on.
+ *
+ * Callers that write output in SNP order should fill() one window at a time
+ * and let the team finish it before the next; the output reorder buffer then
+ * never holds more than a window of lines.
+ *
+ * Usage:
+ * 	sched.fill(start, stop, cost);
+ * 	#pragma omp parallel
+ * 	{
+ * 		int i;
+ * 		while(sched.next(SnpScheduler::thread_id(), i)) ...
+ * 	}
+ */
+
+#include <deque>
+#include <vector>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+class SnpScheduler {
+
+	public:
+		/* One deque for each of threads threads. */
+		explicit SnpScheduler(int threads);
+		~SnpScheduler();
+
+		/* Deal out [start, stop).  cost[i - start] estimates the work for SNP i. */
+		void fill(int start, int stop, const vector<int> &cost);
+
+		/* Claim a SNP for thread.  False once there is nothing left anywhere. */
+		bool next(int thread, int &snp);
+
+		int num_threads() const {return static_cast<int>(queues.size());}
+
+		/* Threads available to a parallel region, and the caller's place in it. */
+		static int max_threads();
+		static int thread_id();
+
+	protected:
+		struct Queue {
+			deque<pair<int, int> > ranges;
+			#ifdef _OPENMP
+			omp_lock_t lock;
+			#endif
+		};
+
+		vector<Queue *> queues;
+
+		bool pop_front(Queue *q, int &snp);
+		bool steal_back(Queue *q, int &first, int &last);
+		void lock(Queue *q);
+		void unlock(Queue *q);
+
+	private:
+		SnpScheduler(const SnpScheduler &);
+		SnpScheduler &operator=(const SnpScheduler &);
+};
+
+#endif
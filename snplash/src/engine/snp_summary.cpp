@@ -0,0 +1,48 @@
+/*
+ *      snp_summary.cpp
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+#include "snp_summary.hh"
+
+/**
+ * Scan a SNP once.
+ *
+ * @param data Data to read.
+ * @param snp SNP index.
+ */
+void SnpSummary::build(DataAccess *data, int snp){
+	this->snp = snp;
+	for(int c=0; c < 3; c++){
+		for(int g=0; g < 5; g++){
+			counts[c][g] = 0;
+		}
+	}
+
+	data->get_snp(snp).decode(genotypes);
+	nonmissing.clear();
+	nonmissing.reserve(genotypes.size());
+	for(unsigned int i=0; i < genotypes.size(); i++){
+		double p = data->get_phenotype(i);
+		PhenotypeClass c = (p == 1) ? CONTROL : ((p == 2) ? CASE : OTHER);
+		counts[c][genotypes[i]]++;
+		if(genotypes[i] != 0){
+			nonmissing.push_back(i);
+		}
+	}
+}
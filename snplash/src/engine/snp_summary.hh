@@ -0,0 +1,72 @@
+/*
+ *      snp_summary.hh
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef SNP_SUMMARY_H
+#define SNP_SUMMARY_H
+
+/**
+ * One pass over a SNP, shared by the tests that run on it.
+ *
+ * Holds the decoded genotype of every individual, the individuals that are
+ * not missing (in order) and the genotype counts for controls (phenotype 1),
+ * cases (phenotype 2) and everyone else.  Snpgwa builds one per SNP and hands
+ * it to PopStats, GenoStats, HaploStats and LinkageDisequilibrium, so the
+ * individuals are scanned once rather than once per test.
+ */
+
+#include <vector>
+#include "data_plugin.h"
+
+using namespace std;
+
+class SnpSummary {
+
+	public:
+		/* Phenotype classes that are counted separately. */
+		enum PhenotypeClass { OTHER = 0, CONTROL = 1, CASE = 2 };
+
+		SnpSummary() : snp(-1) {}
+		SnpSummary(DataAccess *data, int snp) {build(data, snp);}
+
+		void build(DataAccess *data, int snp);
+
+		int get_snp() const {return snp;}
+
+		/* Genotype code of every individual. */
+		const vector<short> &codes() const {return genotypes;}
+		/* Individuals with a genotype, in order. */
+		const vector<unsigned int> &present() const {return nonmissing;}
+
+		/* Number of individuals in a class with a genotype code (0 is missing). */
+		int count(PhenotypeClass c, short code) const {return counts[c][code];}
+		int missing(PhenotypeClass c) const {return counts[c][0];}
+		int nonmissing_count(PhenotypeClass c) const {return counts[c][1] + counts[c][2] + counts[c][3] + counts[c][4];}
+		/* Missing over every class. */
+		int missing() const {return counts[OTHER][0] + counts[CONTROL][0] + counts[CASE][0];}
+
+	protected:
+		int snp;
+		vector<short> genotypes;
+		vector<unsigned int> nonmissing;
+		int counts[3][5];
+};
+
+#endif
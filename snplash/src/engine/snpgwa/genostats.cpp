@@ -7,9 +7,39 @@
  *
  * Also, prep covariate matrix by zero meaning all covariates and preloading.
  */
-GenoStats::GenoStats(DataAccess *d, EngineParamReader *p){
+GenoStats::GenoStats(DataAccess *d, EngineParamReader *p) : ownLr(p->getRegressionConditionNumberThreshold()){
     data = d;
     params = p;
+    nullModel = NULL;
+    lr = &ownLr;
+}
+
+GenoStats::GenoStats(DataAccess *d, EngineParamReader *p, const LogisticNullModel *nullModel, LogisticRegression *lr)
+    : ownLr(p->getRegressionConditionNumberThreshold()){
+    data = d;
+    params = p;
+    this->nullModel = nullModel;
+    this->lr = (lr != NULL) ? lr : &ownLr;
+}
+
+/*
+ * Fit phenotype on the covariates and an intercept for every individual.
+ * Each SNP's models start from these betas (see LogisticBatch) and, with
+ * --score_p, are screened by score tests against this model.
+ */
+void GenoStats::fitNullModel(DataAccess *d, EngineParamReader *p, LogisticNullModel &nullModel){
+
+    vector<unsigned int> everyone(d->pheno_size());
+    vector<double> phen(d->pheno_size());
+    for(int i=0; i < d->pheno_size(); i++){
+        everyone[i] = i;
+        phen[i] = d->get_phenotype(i) - 1;
+    }
+    vector<vector<double> > cov;
+    if(d->num_covariates() > 0){
+        d->get_covariates(everyone, cov);
+    }
+    nullModel.fit(cov, phen, p->getRegressionConditionNumberThreshold());
 }
 
 /*
@@ -22,31 +52,29 @@ GenoStats::GenoStats(DataAccess *d, EngineParamReader *p){
  * break out any other pieces.  Still, feel free to try.
  */
 void GenoStats::prepGenoStatsForOutput(int snp, GenoStatsResults &results){
+    SnpSummary s(data, snp);
+    prepGenoStatsForOutput(s, results);
+}
 
+/*
+ * Same, using a summary already built for the SNP.
+ */
+void GenoStats::prepGenoStatsForOutput(const SnpSummary &s, GenoStatsResults &results){
+
+    int snp = s.get_snp();
     bool hasCov = false;
     currentSNP = snp;
 
     vector<double> phen_vec;
     vector<double> dom, add, rec, lof, twodegfree1, twodegfree2;
 
-    vector<vector<double> > add_in, dom_in, rec_in, twodegfree_in, lof_in;
     vector<vector<double> > cov;
     vector<double> ones;
-    vector<double> cov_cum_sum;
 
     double geno_bins[6]; // Used to bin the data by genotype.
     geno_bins[0] = geno_bins[1] = geno_bins[2] = geno_bins[3] = geno_bins[4] = geno_bins[5] = 0;
 
-    /* Prep covariate matrix */
-    vector<double> *tmp = data->get_covariates(0);
-    if(tmp != NULL){
-        hasCov = true;
-        for(unsigned int i=0;i<tmp->size();i++){
-            vector<double> a;
-            cov.push_back(a);
-            cov_cum_sum.push_back(0);
-        }
-    }
+    hasCov = data->num_covariates() > 0;
 
     double temp;
     /* Prep genotypes and fill cov matrix
@@ -66,129 +94,128 @@ void GenoStats::prepGenoStatsForOutput(int snp, GenoStatsResults &results){
      *
      * Must: include way to consider multiple SNPs.
      */
-    for(int i=0; i<data->pheno_size(); i++ ){
+    const vector<short> &col = s.codes();
+    const vector<unsigned int> &used = s.present(); // Individuals not missing at this SNP.
+    for(unsigned int k=0; k<used.size(); k++ ){
+        int i = used[k];
         // push onto stacks depending on the case/cntrl status.
-        if(data->get_data(i)->at(snp) != 0){
-            temp = data->get_phenotype(i)-1;
-            phen_vec.push_back(temp);
-            ones.push_back(1.0);
-            switch(data->get_data(i)->at(snp)){
-                case 1:
-                    add.push_back(-1);
-                    dom.push_back(0);
-                    rec.push_back(0);
-
-                    twodegfree1.push_back(0);
-                    twodegfree2.push_back(0);
-
-                    lof.push_back(1.0);
-
-                    geno_bins[static_cast<int>(temp) * 3]++;
-
-                break;
-                case 2:
-                    add.push_back(0);
-                    dom.push_back(1);
-                    rec.push_back(0);
-
-                    twodegfree1.push_back(0);
-                    twodegfree2.push_back(1);
-
-                    lof.push_back(-2.0);
-
-                    geno_bins[static_cast<int>(temp) * 3+1]++;
-                break;
-                case 3:
-                    add.push_back(0);
-                    dom.push_back(1);
-                    rec.push_back(0);
-
-                    twodegfree1.push_back(0);
-                    twodegfree2.push_back(1);
-
-                    lof.push_back(-2.0);
-
-                    geno_bins[static_cast<int>(temp) * 3+1]++;
-                break;
-                case 4:
-                    add.push_back(1);
-                    dom.push_back(1);
-                    rec.push_back(1);
-
-                    twodegfree1.push_back(1);
-                    twodegfree2.push_back(0);
-
-                    lof.push_back(1.0);
-
-                    geno_bins[static_cast<int>(temp) * 3 + 2]++;
-                break;
-                default:
-                // won't happen.
-                break;
-            }
-            
-            if(hasCov){
-                vector<double> *t = data->get_covariates(i);
-                for(unsigned int j=0;j<t->size();j++){
-                    cov.at(j).push_back(t->at(j));
-                    cov_cum_sum.at(j)+=t->at(j);
-                }
-            }
-        }
-    }
+        temp = data->get_phenotype(i)-1;
+        phen_vec.push_back(temp);
+        ones.push_back(1.0);
+        switch(col.at(i)){
+            case 1:
+                add.push_back(-1);
+                dom.push_back(0);
+                rec.push_back(0);
 
-    /* Make all matrices
-     */
-    if(hasCov){
-        add_in = cov;
-        dom_in = cov;
-        rec_in = cov;
-        twodegfree_in = cov;
-        lof_in = cov;
-    }
+                twodegfree1.push_back(0);
+                twodegfree2.push_back(0);
 
-    add_in.push_back(ones);
-    add_in.push_back(add);
+                lof.push_back(1.0);
 
-    dom_in.push_back(ones);
-    dom_in.push_back(dom);
+                geno_bins[static_cast<int>(temp) * 3]++;
 
-    rec_in.push_back(ones);
-    rec_in.push_back(rec);
+            break;
+            case 2:
+                add.push_back(0);
+                dom.push_back(1);
+                rec.push_back(0);
 
-    twodegfree_in.push_back(twodegfree2);
-    twodegfree_in.push_back(twodegfree1);
-    twodegfree_in.push_back(ones);
+                twodegfree1.push_back(0);
+                twodegfree2.push_back(1);
 
-    lof_in.push_back(add);
-    lof_in.push_back(ones);
-    lof_in.push_back(lof);
+                lof.push_back(-2.0);
 
-    vector<double> dom_beta, add_beta, rec_beta, lof_beta;
+                geno_bins[static_cast<int>(temp) * 3+1]++;
+            break;
+            case 3:
+                add.push_back(0);
+                dom.push_back(1);
+                rec.push_back(0);
+
+                twodegfree1.push_back(0);
+                twodegfree2.push_back(1);
+
+                lof.push_back(-2.0);
+
+                geno_bins[static_cast<int>(temp) * 3+1]++;
+            break;
+            case 4:
+                add.push_back(1);
+                dom.push_back(1);
+                rec.push_back(1);
+
+                twodegfree1.push_back(1);
+                twodegfree2.push_back(0);
+
+                lof.push_back(1.0);
+
+                geno_bins[static_cast<int>(temp) * 3 + 2]++;
+            break;
+            default:
+            // won't happen.
+            break;
+        }
+    }
+
+    /* Covariates for the same individuals. */
+    if(hasCov){
+        data->get_covariates(used, cov);
+    }
+
+    /* With --score_p, a SNP whose score tests are all above the threshold
+     * is reported from those and not fit.
+     */
+    bool screen = nullModel != NULL && nullModel->is_fitted() && params->get_score_p() >= 0;
+    if(screen && scoreTests(used, add, dom, rec, twodegfree2, twodegfree1, results)){
+        calculateSensSpec(snp, results, geno_bins);
+        return;
+    }
+
+    /* Fit the five models together from the null model.  Any that the
+     * batch cannot finish are run on their own, which logs the reason.
+     * The SNP columns come last; the lack of fit model has the additive
+     * column as a nuisance term.
+     */
+    LogisticBatch batch(params->getRegressionConditionNumberThreshold());
+    batch.set_base(cov, phen_vec, nullModel != NULL ? nullModel->get_betas() : vector<double>());
+    int add_m = batch.add_model(add);
+    int dom_m = batch.add_model(dom);
+    int rec_m = batch.add_model(rec);
+    int lof_m = batch.add_model(add, lof);
+    int tdf_m = batch.add_model(twodegfree2, twodegfree1);
+    batch.fit();
+
+    vector<vector<double> > in;
+    vector<double> betas;
 
     errorInformation errorData = {snp, cov.size(), "Additive test "};
 
-    LRStats add_l = runSingleLRTest(add_in, phen_vec, add_beta, errorData);
+    LRStats add_l;
+    if(!batchSingleTest(batch, add_m, add_l)){
+        design(cov, ones, add, NULL, in);
+        add_l = runSingleLRTest(in, phen_vec, betas, errorData);
+    }
     results.addTestStat = add_l.testStat;
     results.addOR = add_l.OR;
     results.addUCI = add_l.UCI;
     results.addLCI = add_l.LCI;
     results.addPVal = add_l.pVal;
     #if DEBUG_GENO_SINGLE
-    if(add_beta.size() > 0){
-        cout << "Add size: " << add_in.size() << " " << add_in.at(0).size() << endl;
-        cout << "Additive beta: " ;
-        for(unsigned int i=0; i < add_beta.size(); i++){
-            cout << add_beta.at(i) << " ";
-        }
-        cout << endl;
+    betas = batch.betas(add_m);
+    cout << "Additive beta: " ;
+    for(unsigned int i=0; i < betas.size(); i++){
+        cout << betas.at(i) << " ";
     }
+    cout << endl;
     #endif
 
     errorData.message = "Dominant test ";
     LRStats dom_l;
-
-    dom_l = runSingleLRTest(dom_in, phen_vec, dom_beta, errorData);
+    if(!batchSingleTest(batch, dom_m, dom_l)){
+        design(cov, ones, dom, NULL, in);
+        dom_l = runSingleLRTest(in, phen_vec, betas, errorData);
+    }
     results.domTestStat = dom_l.testStat;
     results.domOR = dom_l.OR;
     results.domUCI = dom_l.UCI;
@@ -198,7 +225,10 @@ void GenoStats::prepGenoStatsForOutput(int snp, GenoStatsResults &results){
 
     errorData.message = "Recessive test ";
     LRStats rec_l;
-    rec_l = runSingleLRTest(rec_in, phen_vec, rec_beta, errorData);
+    if(!batchSingleTest(batch, rec_m, rec_l)){
+        design(cov, ones, rec, NULL, in);
+        rec_l = runSingleLRTest(in, phen_vec, betas, errorData);
+    }
     results.recTestStat = rec_l.testStat;
     results.recOR = rec_l.OR;
     results.recUCI = rec_l.UCI;
@@ -208,14 +238,18 @@ void GenoStats::prepGenoStatsForOutput(int snp, GenoStatsResults &results){
 
     errorData.message = "Lack of fit test ";
     LRStats lof_l;
-
-    lof_l = runSingleLRTest(lof_in, phen_vec, lof_beta, errorData);
+    if(!batchSingleTest(batch, lof_m, lof_l)){
+        design(cov, add, ones, &lof, in);
+        lof_l = runSingleLRTest(in, phen_vec, betas, errorData);
+    }
     results.lofTestStat = lof_l.testStat;
     results.lofPVal = lof_l.pVal;
 
     errorData.message = "Two deg freedom test ";
-
-    results.twodegPVal = runLRTest(twodegfree_in, phen_vec, results.twodegTestStat, errorData);
+    if(!batchTwoDegTest(batch, tdf_m, results.twodegTestStat, results.twodegPVal)){
+        design(cov, twodegfree2, twodegfree1, &ones, in);
+        results.twodegPVal = runLRTest(in, phen_vec, results.twodegTestStat, errorData);
+    }
 
     calculateSensSpec(snp, results, geno_bins);
 }
@@ -284,7 +318,6 @@ LRStats GenoStats::runSingleLRTest(const vector<vector<double> > &in, const vect
 
     LRStats l;
     l.fillDefault();
-    LogisticRegression lr(params->getRegressionConditionNumberThreshold());
 
     inv_infmatrix = vecops::getDblVec(in.size(), in.size());
 
@@ -292,10 +325,18 @@ LRStats GenoStats::runSingleLRTest(const vector<vector<double> > &in, const vect
     double startVal = 0;  // value to start betas with.
 
     while(retry < 3){
+        // The penalized fit converges where other starting values would not.
+        if(retry == 1 && params->get_firth() && firthSingleTest(in, phen, betas, l, errorData)){
+            return l;
+        }
         try{
-            betas = lr.newtonRaphson(in, phen, inv_infmatrix, startVal);
-            l = lr.getSingleStats(betas, inv_infmatrix, betas.size()-1);
+            betas = lr->newtonRaphson(in, phen, inv_infmatrix, startVal);
+            l = lr->getSingleStats(betas, inv_infmatrix, betas.size()-1);
 
+            // An odds ratio this large is a separated fit.
+            if((l.OR != l.OR || l.OR >= 10000.0) && params->get_firth() && firthSingleTest(in, phen, betas, l, errorData)){
+                return l;
+            }
             if(l.OR != l.OR){
                 stringstream ss;
                 ss << "Odds ratio was NaN";
@@ -328,10 +369,13 @@ LRStats GenoStats::runSingleLRTest(const vector<vector<double> > &in, const vect
             ss << "linalg exception: " << err.msg;
             handleException(l, startVal, retry, ss.str(), errorData);
         }catch(ConditionNumberEx err){
+            if(params->get_firth() && firthSingleTest(in, phen, betas, l, errorData)){
+                return l;
+            }
             //Handle special.
             retry = 10;
             // The condition number of the information matrix is large. Check for separation.
-            int separableVariable = lr.dataIsSeparable(in, phen);
+            int separableVariable = lr->dataIsSeparable(in, phen);
 
             string tempS;
             int tempP;
@@ -362,6 +406,133 @@ LRStats GenoStats::runSingleLRTest(const vector<vector<double> > &in, const vect
     return l;
 }
 
+/*
+ * Wald test on the last SNP column of a batch model, checked as
+ * runSingleLRTest checks its own.  Odd odds ratios are left to
+ * runSingleLRTest, which logs them.
+ */
+bool GenoStats::batchSingleTest(const LogisticBatch &batch, int model, LRStats &l){
+
+    if(!batch.converged(model)) return false;
+
+    const vector<double> &betas = batch.snp_betas(model);
+    l = lr->getSingleStats(betas, batch.snp_inv_inf(model), betas.size()-1);
+    return l.OR == l.OR && l.OR < 10000.0;
+}
+
+/*
+ * Wald test on both SNP columns of a batch model.
+ */
+bool GenoStats::batchTwoDegTest(const LogisticBatch &batch, int model, double &chiS, double &pVal){
+
+    if(!batch.converged(model)) return false;
+
+    try{
+        pVal = lr->getStats(batch.snp_betas(model), batch.snp_inv_inf(model), chiS);
+        return true;
+    }catch(const ConditionNumberEx &){
+        return false;
+    }catch(alglib::ap_error){
+        return false;
+    }
+}
+
+/*
+ * Score tests of the additive, dominant, recessive and 2 df models.  The
+ * single column tests are reported as the Wald tests are, from one Newton
+ * step off the null model: beta = u / v with variance 1 / v, so the test
+ * statistic is the score z, u / sqrt(v).  The lack of fit chi square is the
+ * 2 df statistic less the additive one, since the additive and lack of fit
+ * columns span the same space as the two genotype indicators; its test
+ * statistic is the square root.
+ *
+ * @return true if every p-value is at or above --score_p, false if one is
+ * below it or the tests cannot be computed.
+ */
+bool GenoStats::scoreTests(const vector<unsigned int> &used, const vector<double> &add, const vector<double> &dom, const vector<double> &rec,
+    const vector<double> &het, const vector<double> &hom, GenoStatsResults &results){
+
+    double u[2], v[4];
+    const vector<double> *cols[2];
+    LRStats add_l, dom_l, rec_l;
+
+    cols[0] = &add;
+    if(!nullModel->score(used, cols, 1, u, v)) return false;
+    if(!scoreSingleTest(u[0], v[0], add_l)) return false;
+    cols[0] = &dom;
+    if(!nullModel->score(used, cols, 1, u, v)) return false;
+    if(!scoreSingleTest(u[0], v[0], dom_l)) return false;
+    cols[0] = &rec;
+    if(!nullModel->score(used, cols, 1, u, v)) return false;
+    if(!scoreSingleTest(u[0], v[0], rec_l)) return false;
+
+    cols[0] = &het;
+    cols[1] = &hom;
+    if(!nullModel->score(used, cols, 2, u, v)) return false;
+    double det = v[0] * v[3] - v[1] * v[2];
+    if(!(det > 0)) return false;
+
+    vector<vector<double> > invV(2, vector<double>(2));
+    invV[0][0] = v[3] / det;
+    invV[0][1] = -v[1] / det;
+    invV[1][0] = -v[2] / det;
+    invV[1][1] = v[0] / det;
+    vector<double> step(2);
+    step[0] = invV[0][0] * u[0] + invV[0][1] * u[1];
+    step[1] = invV[1][0] * u[0] + invV[1][1] * u[1];
+
+    double tdfChi, tdfP, lofChi, lofP;
+    try{
+        tdfP = lr->getStats(step, invV, tdfChi);
+        if(tdfP > 1.0) return false;
+        lofChi = max(tdfChi - add_l.testStat * add_l.testStat, 0.0);
+        lofP = Statistics::chi2prob(lofChi, 1.0);
+    }catch(const ConditionNumberEx &){
+        return false;
+    }catch(const StatsException &){
+        return false;
+    }catch(alglib::ap_error){
+        return false;
+    }
+
+    results.addTestStat = add_l.testStat;
+    results.addOR = add_l.OR;
+    results.addUCI = add_l.UCI;
+    results.addLCI = add_l.LCI;
+    results.addPVal = add_l.pVal;
+    results.domTestStat = dom_l.testStat;
+    results.domOR = dom_l.OR;
+    results.domUCI = dom_l.UCI;
+    results.domLCI = dom_l.LCI;
+    results.domPVal = dom_l.pVal;
+    results.recTestStat = rec_l.testStat;
+    results.recOR = rec_l.OR;
+    results.recUCI = rec_l.UCI;
+    results.recLCI = rec_l.LCI;
+    results.recPVal = rec_l.pVal;
+    results.lofTestStat = sqrt(lofChi);
+    results.lofPVal = lofP;
+    results.twodegTestStat = tdfChi;
+    results.twodegPVal = tdfP;
+
+    double threshold = params->get_score_p();
+    return add_l.pVal >= threshold && dom_l.pVal >= threshold && rec_l.pVal >= threshold
+        && tdfP >= threshold && lofP >= threshold;
+}
+
+bool GenoStats::scoreSingleTest(double u, double v, LRStats &l){
+    if(!(v > 0)) return false;
+    l = lr->getSingleStats(vector<double>(1, u / v), vector<vector<double> >(1, vector<double>(1, 1 / v)), 0);
+    return l.OR == l.OR && l.OR < 10000.0 && l.pVal <= 1.0;
+}
+
+void GenoStats::design(const vector<vector<double> > &cov, const vector<double> &a, const vector<double> &b, const vector<double> *c, vector<vector<double> > &in){
+    in = cov;
+    in.push_back(a);
+    in.push_back(b);
+    if(c != NULL) in.push_back(*c);
+}
+
 /*
  * Compute Wald statistic for two coefficients and return the p-value.
  */
@@ -376,9 +547,12 @@ double GenoStats::runLRTest(const vector<vector<double> > &in, const vector<doub
     inv_infmatrix = vecops::getDblVec(in.size(), in.size());
 
     while(retry < 3){
+        double pVal;
+        if(retry == 1 && params->get_firth() && firthTwoDegTest(in, phen, chiS, pVal, errorData)){
+            return pVal;
+        }
         try{
-            LogisticRegression lr(params->getRegressionConditionNumberThreshold());
-            betas = lr.newtonRaphson(in, phen, inv_infmatrix, startVal);
+            betas = lr->newtonRaphson(in, phen, inv_infmatrix, startVal);
 
             vector<double> tdfb;
             tdfb.push_back(betas.at(betas.size()-3));
@@ -406,7 +580,7 @@ double GenoStats::runLRTest(const vector<vector<double> > &in, const vector<doub
             }
             #endif
 
-            return lr.getStats(tdfb, td, chiS);
+            return lr->getStats(tdfb, td, chiS);
         }catch(NewtonRaphsonFailureEx){
 
             string tempS;
@@ -454,9 +628,12 @@ double GenoStats::runLRTest(const vector<vector<double> > &in, const vector<doub
             }
         }catch(ConditionNumberEx err){
 
+            double pVal;
+            if(params->get_firth() && firthTwoDegTest(in, phen, chiS, pVal, errorData)){
+                return pVal;
+            }
             // The condition number of the information matrix is large. Check for separation.
-            LogisticRegression lr(params->getRegressionConditionNumberThreshold());
-            int separableVariable = lr.dataIsSeparable(in, phen);
+            int separableVariable = lr->dataIsSeparable(in, phen);
 
             string tempS;
             int tempP;
@@ -505,6 +682,69 @@ double GenoStats::runLRTest(const vector<vector<double> > &in, const vector<doub
     return 2.0;
 }
 
+/*
+ * Refit a single column model with the Firth penalty and log that it was.
+ * Odd odds ratios count as failures, as in batchSingleTest.
+ */
+bool GenoStats::firthSingleTest(const vector<vector<double> > &in, const vector<double> &phen, vector<double> &betas, LRStats &l, errorInformation errorData){
+
+    vector<vector<double> > inv_infmatrix = vecops::getDblVec(in.size(), in.size());
+    LRStats fit;
+    try{
+        vector<double> b = lr->firth(in, phen, inv_infmatrix);
+        fit = lr->getSingleStats(b, inv_infmatrix, b.size()-1);
+        if(fit.OR != fit.OR || fit.OR >= 10000.0) return false;
+        betas = b;
+    }catch(...){
+        return false;
+    }
+    l = fit;
+
+    string tempS;
+    int tempP;
+    string name1;
+    data->get_map_info(errorData.snp, tempS, name1, tempP);
+    stringstream ss;
+    ss << "SNPGWA for SNP " << name1 << " " << errorData.message << "Reported the Firth-penalized fit." << endl;
+    Logger::Instance()->writeLine(ss.str());
+    return true;
+}
+
+/*
+ * Refit the 2 df model with the Firth penalty; Wald test on the SNP columns.
+ */
+bool GenoStats::firthTwoDegTest(const vector<vector<double> > &in, const vector<double> &phen, double &chiS, double &pVal, errorInformation errorData){
+
+    vector<vector<double> > inv_infmatrix = vecops::getDblVec(in.size(), in.size());
+    try{
+        vector<double> betas = lr->firth(in, phen, inv_infmatrix);
+
+        int a = betas.size()-3, b = betas.size()-2;
+        vector<double> tdfb(2);
+        tdfb[0] = betas[a];
+        tdfb[1] = betas[b];
+        vector<vector<double> > td(2, vector<double>(2));
+        td[0][0] = inv_infmatrix[a][a];
+        td[0][1] = inv_infmatrix[a][b];
+        td[1][0] = inv_infmatrix[b][a];
+        td[1][1] = inv_infmatrix[b][b];
+
+        pVal = lr->getStats(tdfb, td, chiS);
+        if(pVal > 1.0) return false;
+    }catch(...){
+        return false;
+    }
+
+    string tempS;
+    int tempP;
+    string name1;
+    data->get_map_info(errorData.snp, tempS, name1, tempP);
+    stringstream ss;
+    ss << "SNPGWA for SNP " << name1 << " " << errorData.message << "Reported the Firth-penalized fit." << endl;
+    Logger::Instance()->writeLine(ss.str());
+    return true;
+}
+
 void GenoStats::handleException(LRStats &l, double &startVal, int &retry, const string &message, errorInformation errorData){
 
     l.fillDefault();
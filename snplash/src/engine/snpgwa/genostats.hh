@@ -31,6 +31,7 @@
 #include "../engine.h"
 #include "../data_plugin.h" // only for error printing.
 #include "../utils/lr.hh"
+#include "../utils/logistic_batch.hh"
 #include "../utils/statistics.h"
 #include "../utils/vecops.hh"
 #include "../output/snpgwa_out.hh" // this gives us access to the writeout format
@@ -45,7 +46,14 @@ class GenoStats {
 
 	public :
 		GenoStats(DataAccess *d, EngineParamReader *p);
+		/* nullModel: the covariates-only model, from fitNullModel().  Fits go
+		 * through lr if given, which must outlive this object; one per thread. */
+		GenoStats(DataAccess *d, EngineParamReader *p, const LogisticNullModel *nullModel, LogisticRegression *lr = NULL);
 		void prepGenoStatsForOutput(int snp, GenoStatsResults &g);
+		void prepGenoStatsForOutput(const SnpSummary &s, GenoStatsResults &g);
+
+		/* Fit the covariates-only model on every individual. */
+		static void fitNullModel(DataAccess *d, EngineParamReader *p, LogisticNullModel &nullModel);
 
 	private :
 	
@@ -57,11 +65,27 @@ class GenoStats {
 	
 		DataAccess *data; // pointer to data.
 		const EngineParamReader *params;
+		const LogisticNullModel *nullModel; // Start of the batch fits and base of the score tests.
+		LogisticRegression ownLr;
+		LogisticRegression *lr; // Shared or ownLr.
 		
 		void calculateSensSpec(int snp, GenoStatsResults &result, double *geno_bins);
 		LRStats runSingleLRTest(const vector<vector<double> > &in, const vector<double> &phen, vector<double> &betas, errorInformation failMessage);
 		double runLRTest(const vector<vector<double> > &in, const vector<double> &phen, double &chiS, errorInformation failMessage);
 
+		/* Results of a model fit in the batch.  False if it must be run on its own. */
+		bool batchSingleTest(const LogisticBatch &batch, int model, LRStats &l);
+		bool batchTwoDegTest(const LogisticBatch &batch, int model, double &chiS, double &pVal);
+		/* Score tests against the null model.  False if any is below --score_p. */
+		bool scoreTests(const vector<unsigned int> &used, const vector<double> &add, const vector<double> &dom, const vector<double> &rec,
+			const vector<double> &het, const vector<double> &hom, GenoStatsResults &results);
+		bool scoreSingleTest(double u, double v, LRStats &l);
+		/* With --firth, the model refit with the Firth penalty after the plain fit failed.  False if that fails too. */
+		bool firthSingleTest(const vector<vector<double> > &in, const vector<double> &phen, vector<double> &betas, LRStats &l, errorInformation errorData);
+		bool firthTwoDegTest(const vector<vector<double> > &in, const vector<double> &phen, double &chiS, double &pVal, errorInformation errorData);
+		/* The covariates followed by the given columns. */
+		void design(const vector<vector<double> > &cov, const vector<double> &a, const vector<double> &b, const vector<double> *c, vector<vector<double> > &in);
+
 		/**
 		 * Handle an exception. This is a convenience method.
 		 * 
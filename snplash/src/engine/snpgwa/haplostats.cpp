@@ -1,8 +1,9 @@
 #include "haplostats.hh"
 
-HaploStats::HaploStats(DataAccess *d, EngineParamReader *p){
+HaploStats::HaploStats(DataAccess *d, EngineParamReader *p, LogisticRegression *lr){
 	
 	params = p;
+	this->lr = lr;
 	data = d;
 	twoMarkerPval = threeMarkerPval = 2.0;
 	twoMarkerChiS = threeMarkerChiS = -1;
@@ -12,6 +13,26 @@ HaploStats::HaploStats(DataAccess *d, EngineParamReader *p){
 	allelicDF = -1;
 	
 	haploThresh = -1;
+	summary = NULL;
+}
+
+/**
+ * Same as below, using a summary already built for the SNP.
+ */
+void HaploStats::prepHaploStatsForOutput(const SnpSummary &s, HaploStatsResults &res){
+	summary = &s;
+	prepHaploStatsForOutput(s.get_snp(), res);
+}
+
+/**
+ * The summary for a SNP: the one handed in if it matches, or a new one.
+ */
+const SnpSummary &HaploStats::summaryFor(int snp){
+	if(summary == NULL || summary->get_snp() != snp){
+		own.build(data, snp);
+		summary = &own;
+	}
+	return *summary;
 }
 
 void HaploStats::prepHaploStatsForOutput(int snp, HaploStatsResults &res){
@@ -75,55 +96,44 @@ void HaploStats::calculateAllelic(int snp){
 	
 	vector<double> phen_nonmissing;
 	vector<vector<double> > cov;
-	/* Prep covariate matrix */
-	vector<double> *tmp = data->get_covariates(0);
-	if(tmp != NULL){
-		for(unsigned int i=0;i<tmp->size();i++){
-			vector<double> a;
-			cov.push_back(a);
-		}
-	}
 	
 	int cnt = 0;
-	for(int i=0; i<data->pheno_size(); i++ ){
-		if(data->get_data(i)->at(snp) != 0){
-			EMPersonalProbsResults e;
-			e.personId = cnt++;
-			e.prob = 1.0;
-			
-			switch (data->get_data(i)->at(snp)){
-				case 1:
-					e.leftHap = 0;
-					e.rightHap = 0;
-				break;
-				case 2:
-					e.leftHap = 0;
-					e.rightHap = 1;
-				break;
-				case 3:
-					e.leftHap = 1;
-					e.rightHap = 0;
-				break;
-				case 4:
-					e.leftHap = 1;
-					e.rightHap = 1;
-				break;
-				default:
-				break;	
-			}
-			haps.push_back(e);
-			
-			phen_nonmissing.push_back(data->get_phenotype(i)-1);
-			vector<double> *t = data->get_covariates(i);
-			if(t != NULL){
-				for(unsigned int j=0;j<t->size();j++){
-					cov.at(j).push_back(t->at(j));
-				}
-			}
+	const SnpSummary &s = summaryFor(snp);
+	const vector<short> &col = s.codes();
+	const vector<unsigned int> &used = s.present(); // Individuals with a genotype.
+	for(unsigned int k=0; k<used.size(); k++ ){
+		int i = used[k];
+		EMPersonalProbsResults e;
+		e.personId = cnt++;
+		e.prob = 1.0;
+		
+		switch (col.at(i)){
+			case 1:
+				e.leftHap = 0;
+				e.rightHap = 0;
+			break;
+			case 2:
+				e.leftHap = 0;
+				e.rightHap = 1;
+			break;
+			case 3:
+				e.leftHap = 1;
+				e.rightHap = 0;
+			break;
+			case 4:
+				e.leftHap = 1;
+				e.rightHap = 1;
+			break;
+			default:
+			break;	
 		}
+		haps.push_back(e);
+		
+		phen_nonmissing.push_back(data->get_phenotype(i)-1);
 	}
+	data->get_covariates(used, cov);
 
-	Zaykin zay(params);
+	Zaykin zay(params, lr);
 	if(haploThresh >= 0)
 		zay.setKeepThresh(haploThresh);
 	zay.setPhenotype(phen_nonmissing, cov);
@@ -167,39 +177,31 @@ void HaploStats::calculateTwoMarker(int s1, int s2){
 	vector<double> phen_nonmissing;
 	
 	phen_nonmissing.clear();
-	/* Prep covariate matrix */
-	vector<double> *tmp = data->get_covariates(0);
-	if(tmp != NULL){
-		for(unsigned int i=0;i<tmp->size();i++){
-			vector<double> a;
-			cov.push_back(a);
-		}
-	}
-	for(int i=0; i<data->pheno_size(); i++ ){
+	vector<unsigned int> used; // Individuals with every genotype present.
+	const SnpSummary &s = summaryFor(s1);
+	const vector<short> &col1 = s.codes();
+	GenotypeColumn col2 = data->get_snp(s2);
+	for(unsigned int k=0; k<s.present().size(); k++ ){
+		int i = s.present()[k];
 		// push onto stacks depending on the case/cntrl status.
-		if(data->get_data(i)->at(s1) != 0 && data->get_data(i)->at(s2) != 0){
+		if(col2.at(i) != 0){
 			// Data to be used only if not missing in both.
 			if (data->get_phenotype(i) == 1){
-				v1Cn.push_back( data->get_data(i)->at(s1) );
-				v2Cn.push_back( data->get_data(i)->at(s2) );
-				v1Cb.push_back( data->get_data(i)->at(s1) );
-				v2Cb.push_back( data->get_data(i)->at(s2) );
+				v1Cn.push_back( col1.at(i) );
+				v2Cn.push_back( col2.at(i) );
+				v1Cb.push_back( col1.at(i) );
+				v2Cb.push_back( col2.at(i) );
 			}else if(data->get_phenotype(i) == 2){
-				v1Cs.push_back( data->get_data(i)->at(s1) );
-				v2Cs.push_back( data->get_data(i)->at(s2) );
-				v1Cb.push_back( data->get_data(i)->at(s1) );
-				v2Cb.push_back( data->get_data(i)->at(s2) );
+				v1Cs.push_back( col1.at(i) );
+				v2Cs.push_back( col2.at(i) );
+				v1Cb.push_back( col1.at(i) );
+				v2Cb.push_back( col2.at(i) );
 			}
 			phen_nonmissing.push_back(data->get_phenotype(i)-1);
-			
-			vector<double> *t = data->get_covariates(i);
-			if(t != NULL){
-				for(unsigned int j=0;j<t->size();j++){
-					cov.at(j).push_back(t->at(j));
-				}
-			}
+			used.push_back(i);
 		}
 	}
+	data->get_covariates(used, cov);
 	
 	vector<vector<short> > vCs;
 	vCs.push_back(v1Cs);
@@ -273,42 +275,36 @@ void HaploStats::calculateThreeMarker(int s1, int s2, int s3){
 	vector<double> phen_nonmissing;
 	
 	phen_nonmissing.clear();
-	/* Prep covariate matrix */
-	vector<double> *tmp = data->get_covariates(0);
-	if(tmp != NULL){
-		for(unsigned int i=0;i<tmp->size();i++){
-			vector<double> a;
-			cov.push_back(a);
-		}
-	}
-	for(int i=0; i<data->pheno_size(); i++ ){
+	vector<unsigned int> used; // Individuals with every genotype present.
+	const SnpSummary &s = summaryFor(s1);
+	const vector<short> &col1 = s.codes();
+	GenotypeColumn col2 = data->get_snp(s2);
+	GenotypeColumn col3 = data->get_snp(s3);
+	for(unsigned int k=0; k<s.present().size(); k++ ){
+		int i = s.present()[k];
 		// push onto stacks depending on the case/cntrl status.
-		if(data->get_data(i)->at(s1) != 0 && data->get_data(i)->at(s2) != 0 && data->get_data(i)->at(s3) != 0){
+		if(col2.at(i) != 0 && col3.at(i) != 0){
 			// Data to be used only if not missing in both.
 			if (data->get_phenotype(i) == 1){
-				v1Cn.push_back( data->get_data(i)->at(s1) );
-				v2Cn.push_back( data->get_data(i)->at(s2) );
-				v3Cn.push_back( data->get_data(i)->at(s3) );
-				v1Cb.push_back( data->get_data(i)->at(s1) );
-				v2Cb.push_back( data->get_data(i)->at(s2) );
-				v3Cb.push_back( data->get_data(i)->at(s3) );
+				v1Cn.push_back( col1.at(i) );
+				v2Cn.push_back( col2.at(i) );
+				v3Cn.push_back( col3.at(i) );
+				v1Cb.push_back( col1.at(i) );
+				v2Cb.push_back( col2.at(i) );
+				v3Cb.push_back( col3.at(i) );
 			}else if(data->get_phenotype(i) == 2){
-				v1Cs.push_back( data->get_data(i)->at(s1) );
-				v2Cs.push_back( data->get_data(i)->at(s2) );
-				v3Cs.push_back( data->get_data(i)->at(s3) );
-				v1Cb.push_back( data->get_data(i)->at(s1) );
-				v2Cb.push_back( data->get_data(i)->at(s2) );
-				v3Cb.push_back( data->get_data(i)->at(s3) );
+				v1Cs.push_back( col1.at(i) );
+				v2Cs.push_back( col2.at(i) );
+				v3Cs.push_back( col3.at(i) );
+				v1Cb.push_back( col1.at(i) );
+				v2Cb.push_back( col2.at(i) );
+				v3Cb.push_back( col3.at(i) );
 			}
 			phen_nonmissing.push_back(data->get_phenotype(i)-1);
-			vector<double> *t = data->get_covariates(i);
-			if(t != NULL){
-				for(unsigned int j=0;j<t->size();j++){
-					cov.at(j).push_back(t->at(j));
-				}
-			}
+			used.push_back(i);
 		}
 	}
+	data->get_covariates(used, cov);
 
 	#if DEBUG_HAPL_PROGRESS
 	cout << "Three marker run all start " << s1 << endl;
@@ -405,7 +401,7 @@ double HaploStats::computeGlobalZaykinStatisic(EM &em, int size, double &testSta
 	}
 	
 	
-	Zaykin zay(params);
+	Zaykin zay(params, lr);
 	if(haploThresh >= 0)
 		zay.setKeepThresh(haploThresh);
 	zay.setErrorInformation(snp, cov.size(), data);
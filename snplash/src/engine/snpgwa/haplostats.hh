@@ -35,14 +35,21 @@ using namespace std;
 class HaploStats {
 	
 	public :
-		HaploStats(DataAccess *, EngineParamReader *p);
+		/* Haplotype regressions go through lr if given; see Zaykin. */
+		HaploStats(DataAccess *, EngineParamReader *p, LogisticRegression *lr = NULL);
 		void prepHaploStatsForOutput(int, HaploStatsResults &);
+		void prepHaploStatsForOutput(const SnpSummary &, HaploStatsResults &);
 		void setHaploThresh(int k){haploThresh = k;}
 		
 	protected :
 	
 		DataAccess *data;
 		EngineParamReader *params;
+		LogisticRegression *lr;
+
+		const SnpSummary *summary; // Scan of the first SNP, if any.
+		SnpSummary own;
+		const SnpSummary &summaryFor(int snp);
 	
 		void calculateAllelic(int);
 		void calculateTwoMarker(int, int);
@@ -3,6 +3,7 @@
 PopStats::PopStats(DataAccess *d){
 	data = d;
 	lastBuild = -1;
+	summary = NULL;
 	reinit();
 }
 
@@ -22,11 +23,19 @@ void PopStats::reinit(){
 	cmbdExpTotal[0] = cmbdExpTotal[1] = cmbdExpTotal[2] = 0;
 	cmbdChiSquare = -1;
 	cmbdChiSquarePValue = cmbdExactTestPVal = 2.0;
-	snp_data.clear();
-	phen_data.clear();
 	percentMissingTotal = 0.0;
 }
 
+/*
+ * Perform all computations in the populationStatistics framework and send
+ * their results to the output mechanism o
+ */
+bool PopStats::prepPopStatsForOutput(const SnpSummary &s, PopStatsResults &results){
+	summary = &s;
+	lastBuild = -1;
+	return prepPopStatsForOutput(s.get_snp(), results);
+}
+
 /*
  * Perform all computations in the populationStatistics framework and send
  * their results to the output mechanism o
@@ -78,105 +87,55 @@ bool PopStats::prepPopStatsForOutput(int snp, PopStatsResults &results){
 }
 
 /**
- * Repopulate the vector with the new SNP if necessary.
- * If we run all our statistics on a single SNP at one time,
- * we save serious time.
+ * Load the counts for a new SNP if necessary.  Everything the tests need
+ * is read off the SnpSummary here, once per SNP; the tests themselves only
+ * do arithmetic on members.
+ * 
+ * A PopStats object belongs to one thread (Snpgwa makes one per SNP), so
+ * there is nothing to lock.
  * 
  * Return true if it was recomputed.
  */
 bool PopStats::pullData(int snp){
-	bool retVal;
-	#pragma omp critical
-	{
 
-		if(lastBuild != snp){
-			
-			#if DEBUG_POPSTATS_PULL
-			cout << "Rebuilding with SNP " << snp << endl;
-			#endif
-			
-			retVal = true;
-			lastBuild = snp;
-			reinit();
-			for(int i=0; i<data->pheno_size(); i++ ){
-				if(data->get_data(i)->at(snp) > 0){
-					snp_data.push_back(data->get_data(i)->at(snp));
-					phen_data.push_back(data->get_phenotype(i));
-				}else{
-					if(data->get_phenotype(i) == 1){
-						numMissingCntrl++;
-					}else if(data->get_phenotype(i) == 2){
-						numMissingCase++;
-					}
-					numMissingTotal++;
-				}
-			}
-		}else{
-			retVal = false;
-		}
+	if(lastBuild == snp){
+		return false;
 	}
-	return retVal;
+
+	#if DEBUG_POPSTATS_PULL
+	cout << "Rebuilding with SNP " << snp << endl;
+	#endif
+
+	lastBuild = snp;
+	reinit();
+	if(summary == NULL || summary->get_snp() != snp){
+		own.build(data, snp);
+		summary = &own;
+	}
+	const SnpSummary &s = *summary;
+
+	numMissingCntrl = s.missing(SnpSummary::CONTROL);
+	numMissingCase = s.missing(SnpSummary::CASE);
+	numMissingTotal = s.missing();
+
+	ppCntrls = s.count(SnpSummary::CONTROL, 1);
+	pqCntrls = s.count(SnpSummary::CONTROL, 2) + s.count(SnpSummary::CONTROL, 3);
+	qqCntrls = s.count(SnpSummary::CONTROL, 4);
+	ppCases = s.count(SnpSummary::CASE, 1);
+	pqCases = s.count(SnpSummary::CASE, 2) + s.count(SnpSummary::CASE, 3);
+	qqCases = s.count(SnpSummary::CASE, 4);
+
+	return true;
 }
 
 /**
  * Calculate the minor allele frequency for a given SNP.
  */
 bool PopStats::minorAlleleFreq(int snp){
-	double ma1 = 0.0, ma2 = 0.0;
-	double sum1 = 0.0, sum2 = 0.0;
-
-	/* Compile data. */
 	pullData(snp);
-	for(unsigned int i = 0;i<snp_data.size();++i){
-		if(snp_data.at(i) > 0){
 
-			if( phen_data.at(i) == 1 ){
-				sum1+=2;
-				switch(snp_data.at(i)){
-					case 1:
-						ppCntrls++;
-					break;
-					case 2:
-						pqCntrls++;
-						ma1++;
-					break;
-					case 3:
-						pqCntrls++;
-						ma1++;
-					break;
-					case 4:
-						qqCntrls++;
-						ma1+=2;
-					break;
-					default:
-					//empty
-					break;
-				}
-			}else if(phen_data.at(i) == 2){
-				sum2+=2;
-				switch(snp_data.at(i)){
-					case 1:
-						ppCases++;
-					break;
-					case 2:
-						pqCases++;
-						ma2++;
-					break;
-					case 3:
-						pqCases++;
-						ma2++;
-					break;
-					case 4:
-						qqCases++;
-						ma2+=2;
-					break;
-					default:
-					//empty
-					break;
-				}
-			}
-		}
-	}
+	double ma1 = pqCntrls + 2.0 * qqCntrls, sum1 = 2.0 * (ppCntrls + pqCntrls + qqCntrls);
+	double ma2 = pqCases + 2.0 * qqCases, sum2 = 2.0 * (ppCases + pqCases + qqCases);
 	
 	minorAlleleFreqCases = ma2/sum2;
 	minorAlleleFreqCntrls = ma1/sum1;
@@ -189,16 +148,6 @@ bool PopStats::minorAlleleFreq(int snp){
 bool PopStats::numCategories(int snp){
 
 	pullData(snp);
-	numTotalCases = numTotalCntrls = 0;  //Do these need to be set to zero again?
-	/*for(unsigned int i=0;i<snp_data.size();++i){
-		if(snp_data.at(i) != 0){
-			if(phen_data.at(i) == 1){
-				numTotalCntrls++;
-			}else if(phen_data.at(i) == 2){
-				numTotalCases++;
-			}
-		}
-	}*/
 	
 	casesNonMissing = qqCases+pqCases+ppCases;
 	cntrlsNonMissing = qqCntrls+pqCntrls+ppCntrls;
@@ -46,6 +46,8 @@ class PopStats {
 	
 		/* Main handle that will print everything to a print object */
 		bool prepPopStatsForOutput(int snp, PopStatsResults &results);
+		/* Same, using a summary already built for the SNP. */
+		bool prepPopStatsForOutput(const SnpSummary &s, PopStatsResults &results);
 	
 		/* Calculate MAF for a given SNP */
 		bool minorAlleleFreq(int snp);
@@ -64,8 +66,8 @@ class PopStats {
 	
 		/* OPTIMIZING STEP */
 		int lastBuild;
-		vector<short> snp_data;
-		vector<double> phen_data;
+		const SnpSummary *summary; // Counts for lastBuild.
+		SnpSummary own; // Used when no summary was handed in.
 		bool pullData(int build); // builds data.
 		
 		
@@ -24,6 +24,7 @@ Snpgwa::Snpgwa(){
 	this->data = new DataAccess;
 	this->data->init(NULL);
 	this->snp_param = new EngineParamReader;
+	streaming = false;
 }
 
 Snpgwa::~Snpgwa(){
@@ -78,7 +79,23 @@ void Snpgwa::init(){
 		cout << "Starting process" <<endl;
 	#endif
 
-	reader->process(data->getDataObject(), param_reader);
+	SnpDataCache cache(param_reader);
+	if(cache.load(data->getDataObject(), numInitSNPs, numInitPhen)){
+		delete reader;
+		numFinalPhen = data->pheno_size();
+		return;
+	}
+
+	streaming = false;
+	if(snp_param->get_snp_block() > 0){
+		streaming = reader->open_stream(data->getDataObject(), param_reader);
+		if(!streaming){
+			cerr << "--block is only supported for binary input.  Reading all genotypes." << endl;
+		}
+	}
+	if(!streaming){
+		reader->process(data->getDataObject(), param_reader);
+	}
 	// Read the number of individuals and genotypes.
 	numInitSNPs = data->geno_size();
 	numInitPhen = data->pheno_size();
@@ -107,10 +124,13 @@ void Snpgwa::init(){
 		cerr << "Unknown exception making categorical." << endl;
 		exit(0);
 	}
-	delete reader; // No longer needed.
+	if(!streaming){
+		delete reader; // No longer needed.
+	}
 
 	// Read the number of phenotypes remaining and get the num of cases.
 	numFinalPhen = data->pheno_size();
+	cache.save(data->getDataObject(), numInitSNPs, numInitPhen);
 	#if DB_V_SNPGWA
 		cout << "Finished init." <<endl;
 	#endif
@@ -133,6 +153,9 @@ void Snpgwa::preProcess(){
 
 	cout << ss.str();
 
+	// Every SNP's logistic models start from this one.
+	GenoStats::fitNullModel(data, snp_param, nullModel);
+
 	if(!out.init(param_reader, snp_param, data->max_map_size(), data->geno_size(), ss.str())){
 		cerr << "Error opening output files.  Aborting." <<
 		endl << "If you did not expect this error, and you are on a Linux/Unix machine, please verify that you have permission to open the file requested." << endl;
@@ -151,103 +174,184 @@ void Snpgwa::preProcess(){
  */
 void Snpgwa::process(){
 
-	#if RUN_IN_PARALLEL
-	#pragma omp parallel
-	{
-	#endif
 	int sz = data->geno_size();
-	#if RUN_IN_PARALLEL
-	#pragma omp for schedule(static, 10)
-	#endif
-	for(int i=0;i < sz;i++){
+	int block = streaming ? snp_param->get_snp_block() : sz;
 
-		SnpInfo s;
-		s.index = i+param_reader->get_begin();
+	for(int start=0; start < sz; start += block){
+		int stop = min(start + block, sz);
 
-		if(param_reader->get_linkage_map_file().compare("none") != 0){
-			data->get_map_info(i, s.chr, s.name, s.position);
+		if(streaming){
+			// Haplotype tests look up to two SNPs ahead.
+			reader->read_block(data->getDataObject(), start, min(stop + 2, sz) - start);
+			if(stop < sz){
+				reader->prefetch_block(stop, min(stop + block + 2, sz) - stop);
+			}
+		}
 
-			// calc diff.
-			if(i < sz-1){
+		processRange(start, stop);
+	}
 
-				string t, c;
-				int p = 0;
-	
-				data->get_map_info(i+1, c, t, p);
-				if(c.compare(s.chr) == 0){
-					s.diff = p-s.position;
-				}else{
-					s.diff = -999;
-				}
+	if(streaming){
+		delete reader;
+	}
+	out.close();
 
-			}else{
-				s.diff = -999;
-			}
-		}
+}
 
-		char ma, mi, mr;
-		data->get_allele_codes(i,ma,mi, mr);
-		s.majAllele = ma;
-		s.minAllele = mi;
-		s.refAllele = mr;
-		if(s.majAllele == ' '){
-			s.majAllele = '.';
+/**
+ * Process SNPs [start, stop), which must be resident.  The cost of a SNP
+ * varies a great deal (an unusable SNP is skipped, the haplotype tests may
+ * run EM several times), so rather than a static schedule the SNPs go
+ * through a work-stealing SnpScheduler one window at a time.
+ *
+ * @param start First SNP.
+ * @param stop One past the last SNP.
+ */
+void Snpgwa::processRange(int start, int stop){
+
+	#if RUN_IN_PARALLEL_SNPGWA
+	int threads = SnpScheduler::max_threads();
+	#else
+	int threads = 1;
+	#endif
+
+	if(threads == 1){
+		LogisticRegression lr(snp_param->getRegressionConditionNumberThreshold());
+		for(int i=start;i < stop;i++){
+			processSnp(i, lr);
 		}
-		if(s.minAllele == ' '){
-			s.minAllele = '.';
+		return;
+	}
+
+	SnpScheduler sched(threads);
+	int window = threads * SNPGWA_WINDOW_PER_THREAD;
+	vector<int> cost;
+
+	for(int w=start; w < stop; w += window){
+		int end = min(w + window, stop);
+
+		cost.resize(end - w);
+		for(int i=w; i < end; i++){
+			cost[i - w] = snpCost(i);
 		}
-		if(s.refAllele == ' '){
-			s.refAllele = '.';
+		sched.fill(w, end, cost);
+
+		#pragma omp parallel num_threads(threads)
+		{
+			LogisticRegression lr(snp_param->getRegressionConditionNumberThreshold());
+			int i;
+			while(sched.next(SnpScheduler::thread_id(), i)){
+				processSnp(i, lr);
+			}
 		}
+	}
+}
 
-		GenoStatsResults ge;
-		PopStatsResults p;
-		HaploStatsResults hr;
-
-		if(data->getDataObject()->isUsable(i)){
-
-			PopStats pop_calc(data);
-			GenoStats g(data, snp_param);
-			LinkageDisequilibrium ld(data);
-			ld.enslave(snp_param);
-			LinkageMeasures lr;
-			g.prepGenoStatsForOutput(i,ge);
-			
-			pop_calc.prepPopStatsForOutput(i,p);
-
-			if(snp_param->get_snpgwa_dohap()){
-				HaploStats h(data, snp_param);
-				if(snp_param->get_haplo_thresh() >= 0)
-					h.setHaploThresh(snp_param->get_haplo_thresh());
-				h.prepHaploStatsForOutput(i, hr);
-				if(i + 1 < data->geno_size()){
-	
-					ld.dprimeOnPair(i, i+1, lr);
-					hr.rsquare = lr.rsquare;
-					hr.dprime = lr.dPrime;
-				}else{
-					hr.rsquare = hr.dprime = -1.0;
-				}
-			}
+/**
+ * Rough relative cost of processSnp(i), used to size the chunks dealt to
+ * each thread.
+ *
+ * @param i SNP index
+ */
+int Snpgwa::snpCost(int i){
+	if(!data->getDataObject()->isUsable(i)){
+		return 1;
+	}
+	return snp_param->get_snpgwa_dohap() ? 32 : 8;
+}
+
+/**
+ * Compute and write all statistics for a single SNP.  SNPs i through i+2
+ * must be resident.
+ *
+ * @param i SNP index
+ * @param lr Logistic regression for the SNP's fits, one per thread
+ */
+void Snpgwa::processSnp(int i, LogisticRegression &lr){
+
+	int sz = data->geno_size();
+
+	SnpInfo s;
+	s.index = i+param_reader->get_begin();
+
+	if(param_reader->get_linkage_map_file().compare("none") != 0){
+		data->get_map_info(i, s.chr, s.name, s.position);
+
+		// calc diff.
+		if(i < sz-1){
+
+			string t, c;
+			int p = 0;
 
-			else{
-				initHaploStats(hr);
-				std::cout << hr.twoMarkerCaseFreq[0] << std::endl;
+			data->get_map_info(i+1, c, t, p);
+			if(c.compare(s.chr) == 0){
+				s.diff = p-s.position;
+			}else{
+				s.diff = -999;
 			}
 
 		}else{
-			// Not usable SNP.  Throw blanks.
-			initToZero(p,hr,ge);
+			s.diff = -999;
 		}
+	}
 
-		out.writeLine(i,s,p,hr, ge);
-
+	char ma, mi, mr;
+	data->get_allele_codes(i,ma,mi, mr);
+	s.majAllele = ma;
+	s.minAllele = mi;
+	s.refAllele = mr;
+	if(s.majAllele == ' '){
+		s.majAllele = '.';
+	}
+	if(s.minAllele == ' '){
+		s.minAllele = '.';
+	}
+	if(s.refAllele == ' '){
+		s.refAllele = '.';
 	}
 
-	#if RUN_IN_PARALLEL
+	GenoStatsResults ge;
+	PopStatsResults p;
+	HaploStatsResults hr;
+
+	if(data->getDataObject()->isUsable(i)){
+
+		SnpSummary summary(data, i); // One pass over the individuals for every test.
+		PopStats pop_calc(data);
+		GenoStats g(data, snp_param, &nullModel, &lr);
+		LinkageDisequilibrium ld(data);
+		ld.enslave(snp_param);
+		LinkageMeasures lm;
+		g.prepGenoStatsForOutput(summary,ge);
+		
+		pop_calc.prepPopStatsForOutput(summary,p);
+
+		if(snp_param->get_snpgwa_dohap()){
+			HaploStats h(data, snp_param, &lr);
+			if(snp_param->get_haplo_thresh() >= 0)
+				h.setHaploThresh(snp_param->get_haplo_thresh());
+			h.prepHaploStatsForOutput(summary, hr);
+			if(i + 1 < data->geno_size()){
+
+				ld.dprimeOnPair(summary, i+1, lm);
+				hr.rsquare = lm.rsquare;
+				hr.dprime = lm.dPrime;
+			}else{
+				hr.rsquare = hr.dprime = -1.0;
+			}
+		}
+
+		else{
+			initHaploStats(hr);
+			std::cout << hr.twoMarkerCaseFreq[0] << std::endl;
+		}
+
+	}else{
+		// Not usable SNP.  Throw blanks.
+		initToZero(p,hr,ge);
 	}
-	#endif
-	out.close();
+
+	out.writeLine(i,s,p,hr, ge);
 
 }
 
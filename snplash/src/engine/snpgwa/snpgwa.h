@@ -44,8 +44,16 @@
 
 #include "../../logger/log.hh"
 #include "../ld/ld.h"
+#include "../snp_scheduler.hh"
 
 #define DB_V_SNPGWA 0 // CHANGE TO 1 TO GET A PLAY BY PLAY
+#define RUN_IN_PARALLEL_SNPGWA 1
+
+/*
+ * SNPs handed to the threads at a time, per thread.  Output is reordered
+ * within a window, so this bounds the lines held in memory.
+ */
+#define SNPGWA_WINDOW_PER_THREAD 256
 
 
 using namespace std;
@@ -73,8 +81,14 @@ class Snpgwa : private Engine{
 		
 		void initToZero(PopStatsResults &p, HaploStatsResults &r, GenoStatsResults &ge);
 		void initHaploStats(HaploStatsResults &r);
+		/* lr: the thread's LogisticRegression, reused for every fit. */
+		void processSnp(int i, LogisticRegression &lr);
+		int snpCost(int i);
+		void processRange(int start, int stop);
 
 		SnpgwaOutput out;
+		LogisticNullModel nullModel; // Covariates-only logistic model.
+		bool streaming; // true if the reader is handing us blocks of SNPs.
 		
 		int numInitSNPs;
 		int numInitPhen;
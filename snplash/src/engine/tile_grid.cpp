@@ -0,0 +1,122 @@
+/*
+ *      tile_grid.cpp
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#include "tile_grid.hh"
+#include <algorithm>
+
+TileGrid::TileGrid(int snps, int tile){
+	build(snps, tile, tile);
+}
+
+TileGrid::TileGrid(int snps, int rows, int cols){
+	build(snps, rows, cols);
+}
+
+void TileGrid::build(int snps, int rows, int cols){
+	if(snps < 0) snps = 0;
+	if(rows < 1) rows = 1;
+	if(cols < 1) cols = 1;
+	this->snps = snps;
+	this->rows = rows;
+	this->cols = cols;
+	cursor = 0;
+
+	// Row block r starts at the column block of its first pair, (i0, i0 + 1).
+	int rowBlocks = (snps + rows - 1) / rows;
+	int colBlocks = (snps + cols - 1) / cols;
+	for(int r=0; r < rowBlocks && r * rows + 1 < snps; r++){
+		for(int c=(r * rows + 1) / cols; c < colBlocks; c++){
+			rowBlock.push_back(r);
+			colBlock.push_back(c);
+		}
+	}
+}
+
+void TileGrid::bounds(int t, int &i0, int &i1, int &j0, int &j1) const{
+	i0 = rowBlock.at(t) * rows;
+	i1 = min(i0 + rows, snps);
+	j0 = colBlock.at(t) * cols;
+	j1 = min(j0 + cols, snps);
+}
+
+long TileGrid::num_pairs(int t) const{
+	int i0, i1, j0, j1;
+	bounds(t, i0, i1, j0, j1);
+	long pairs = 0;
+	for(int i=i0; i < i1; i++){
+		pairs += max(0, j1 - max(j0, i+1));
+	}
+	return pairs;
+}
+
+long TileGrid::plan(long done){
+	firstPair.resize(num_tiles());
+	cursor = num_tiles();
+
+	long pairs = 0;
+	for(int t=0; t < num_tiles(); t++){
+		firstPair[t] = pairs;
+		pairs += num_pairs(t);
+		if(cursor == num_tiles() && pairs > done) cursor = t;
+	}
+	return pairs;
+}
+
+bool TileGrid::next(int &t, long &first){
+	bool found = false;
+	#pragma omp critical(tile_grid_next)
+	{
+		if(cursor < num_tiles()){
+			t = cursor;
+			first = firstPair[cursor];
+			cursor++;
+			found = true;
+		}
+	}
+	return found;
+}
+
+bool TileGrid::next_band(int &first, int &last, long &order){
+	bool found = false;
+	#pragma omp critical(tile_grid_next)
+	{
+		if(cursor < num_tiles()){
+			// plan() may have started partway through a row block.
+			int r = rowBlock[cursor];
+			first = cursor;
+			while(first > 0 && rowBlock[first-1] == r) first--;
+			last = cursor;
+			while(last < num_tiles() && rowBlock[last] == r) last++;
+			order = firstPair[first];
+			cursor = last;
+			found = true;
+		}
+	}
+	return found;
+}
+
+long TileGrid::band_pair(int i, int j) const{
+	// Rows i0 .. i-1 of the block each pair with every SNP after them.
+	long i0 = (i / rows) * rows;
+	long k = i - i0;
+	return k * (snps - 1 - i0) - k * (k - 1) / 2 + (j - i - 1);
+}
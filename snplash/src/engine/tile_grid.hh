@@ -0,0 +1,104 @@
+/*
+ *      tile_grid.hh
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef TILE_GRID_H
+#define TILE_GRID_H
+
+/**
+ * Cuts the upper triangle of an all-pairs SNP x SNP computation into
+ * tiles and hands them to the threads of one parallel region.
+ *
+ * Tile (r, c) holds the pairs i < j with i in row block r and j in column
+ * block c.  Row blocks are rows SNPs high and column blocks cols SNPs wide.
+ * A thread decodes the two blocks once and then runs every pair of the tile
+ * out of that buffer, so each SNP is decoded about snps / rows times as a
+ * row and snps / cols times as a column, instead of once per pair.
+ *
+ * Tiles are numbered row block by row block and handed out in that order,
+ * one at a time to whichever thread asks.  Their pairs are numbered the same
+ * way, row by row within a tile, which gives every pair a place in the
+ * output.  Since a thread finishes its tile before it asks for the next,
+ * the thread holding the lowest unwritten pair is never waiting on a later
+ * one, which is what the ResultQueue needs.  With tiles one SNP high, or a
+ * single tile (snps <= rows and cols), the numbering is the usual file
+ * order: i by i, then j by j.  Taller tiles decode less but number the
+ * pairs tile by tile.
+ *
+ * next_band hands out a whole row block instead.  A row block holds the same
+ * pairs under either numbering, so its first pair is the same, and
+ * band_pair numbers the pairs inside it i by i, then j by j.  A thread that
+ * keeps a band's results until the band is done can then write them in file
+ * order while still running them tile by tile.
+ *
+ * To resume a run that wrote its first done pairs, plan(done) leaves out
+ * the tiles that lie wholly before pair done.  Numbers do not change, so
+ * the caller skips the pairs before done in the first tile it is handed.
+ *
+ * Usage:
+ * 	grid.plan(done);
+ * 	#pragma omp parallel
+ * 	{
+ * 		int t; long order;
+ * 		while(grid.next(t, order)) ...
+ * 	}
+ */
+
+#include <vector>
+
+using namespace std;
+
+class TileGrid {
+
+	public:
+		/* Square tiles, tile SNPs on a side. */
+		TileGrid(int snps, int tile);
+		/* Tiles rows SNPs high and cols SNPs wide. */
+		TileGrid(int snps, int rows, int cols);
+
+		int num_tiles() const {return static_cast<int>(rowBlock.size());}
+
+		/* The SNPs of tile t: i in [i0, i1), j in [j0, j1) and i < j. */
+		void bounds(int t, int &i0, int &i1, int &j0, int &j1) const;
+		long num_pairs(int t) const;
+
+		/* Number the pairs and start at the tile holding pair done.  Returns the number of pairs. */
+		long plan(long done = 0);
+
+		/* Claim the next tile and the number of its first pair.  False when none are left. */
+		bool next(int &t, long &first);
+
+		/* Claim the next row block whole: its tiles [first, last) and the number of its first pair. */
+		bool next_band(int &first, int &last, long &order);
+		/* Number of pair (i, j), i < j, from the first pair of its row block, i by i then j by j. */
+		long band_pair(int i, int j) const;
+
+	protected:
+		int snps;
+		int rows, cols;             // Tile height and width.
+		vector<int> rowBlock, colBlock; // Block coordinates of each tile.
+		vector<long> firstPair;     // Number of the first pair of each tile.
+		int cursor;                 // Next tile to hand out.
+
+		void build(int snps, int rows, int cols);
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ *      top_pairs.hh
+ *
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef TOP_PAIRS_H
+#define TOP_PAIRS_H
+
+/**
+ * Keeps the pairs worth reporting from an all-pairs engine, so that only
+ * those reach the output.
+ *
+ * Each thread offers its pairs to its own slot; nothing is shared until
+ * merge(), which runs after the parallel loops.  With a limit of k, each
+ * slot is a heap of the k best pairs it has seen, worst on top, so a pair
+ * costs one comparison unless it makes the cut.  With no limit every
+ * offered pair is kept.
+ *
+ * Better is a strict ordering, "a should be reported before b".  T needs
+ * index1 and index2 for ByPair.
+ */
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/* The usual file order: by first SNP, then second. */
+template<class T>
+struct ByPair {
+	bool operator()(const T &a, const T &b) const {
+		return a.index1 < b.index1 || (a.index1 == b.index1 && a.index2 < b.index2);
+	}
+};
+
+template<class T, class Better>
+class TopPairs {
+
+	public:
+
+		/* Keep the best k pairs, or all of them if k is 0. */
+		TopPairs(int threads, unsigned int k) : kept(threads), limit(k) {}
+
+		/* Called by thread t only. */
+		void offer(int t, const T &pair){
+			vector<T> &heap = kept[t];
+			if(limit == 0){
+				heap.push_back(pair);
+			}else if(heap.size() < limit){
+				heap.push_back(pair);
+				push_heap(heap.begin(), heap.end(), better);
+			}else if(better(pair, heap.front())){
+				pop_heap(heap.begin(), heap.end(), better);
+				heap.back() = pair;
+				push_heap(heap.begin(), heap.end(), better);
+			}
+		}
+
+		/*
+		 * All the threads' pairs, best first, cut to k.  Call once the
+		 * threads are done; the slots are emptied.
+		 */
+		void merge(vector<T> &out){
+			out.clear();
+			for(unsigned int t=0;t < kept.size();t++){
+				out.insert(out.end(), kept[t].begin(), kept[t].end());
+				vector<T>().swap(kept[t]);
+			}
+			sort(out.begin(), out.end(), better);
+			if(limit > 0 && out.size() > limit) out.resize(limit);
+		}
+
+	protected:
+		vector<vector<T> > kept;
+		unsigned int limit;
+		Better better;
+};
+
+#endif
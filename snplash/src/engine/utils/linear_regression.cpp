@@ -149,6 +149,60 @@ vector<double> LinearRegression::residuals(const vector<vector<double> > &data,
 	return resid;
 }
 
+/**
+ * Least squares for a column coded by class, e.g. a SNP's additive or
+ * dominant coding, without expanding it.  With N, Sx, Sxx, Sr and Sxr the
+ * sums over individuals of 1, x, x^2, r and x r,
+ * 
+ * 		beta = (N Sxr - Sx Sr) / (N Sxx - Sx^2),  a = (Sr - beta Sx) / N,
+ * 
+ * and every individual in class k has the fitted value f_k = a + beta code[k].
+ * The error sum of squares is taken as the within class sum of squares plus
+ * the between class part, sum_k n_k (mean_k - f_k)^2.
+ * 
+ * @param sums Response counts, sums and sums of squares by class.
+ * @param code Value of the column in each class.
+ * @param mean The mean of the response variable.
+ * @return sse, ssr As for sumSquaredStats.
+ * @return sxx Sum of squares of the column about its mean, divided by N.
+ * @return beta The slope.
+ */
+double LinearRegression::classLeastSquares(const ClassSums &sums, const double code[3], double mean,
+				double &sse, double &ssr, double &sxx)
+{
+	
+	double n = 0, sx = 0, sxsq = 0, sr = 0, sxr = 0;
+	for(int k=0; k < 3; k++){
+		n += sums.n[k];
+		sx += sums.n[k] * code[k];
+		sxsq += sums.n[k] * code[k] * code[k];
+		sr += sums.sum[k];
+		sxr += code[k] * sums.sum[k];
+	}
+	
+	// Counts and codes are integers, so this is exact: zero when the column is constant.
+	double det = n * sxsq - sx * sx;
+	if(!(det > 0)){
+		throw LinearRegressionException();
+	}
+	
+	double beta = (n * sxr - sx * sr) / det;
+	double intercept = (sr - beta * sx) / n;
+	
+	sse = 0;
+	ssr = 0;
+	for(int k=0; k < 3; k++){
+		if(sums.n[k] == 0) continue;
+		double fitted = intercept + beta * code[k];
+		double classMean = sums.sum[k] / sums.n[k];
+		sse += (sums.sumSq[k] - sums.sum[k] * classMean) + sums.n[k] * pow(classMean - fitted, 2);
+		ssr += sums.n[k] * pow(mean - fitted, 2);
+	}
+	
+	sxx = (sxsq - pow(sx, 2) / n) / n;
+	return beta;
+}
+
 /**
  * Anova of the response variable.  In practice, this is called from
  * the genostats::compLinRegStats method using the calculated genotype
@@ -43,6 +43,16 @@ struct LinRegStats{
 	int n2;
 };
 
+/*
+ * Count, sum and sum of squares of the response in each of three classes,
+ * e.g. the genotypes AA, Aa and aa.
+ */
+struct ClassSums{
+	double n[3];
+	double sum[3];
+	double sumSq[3];
+};
+
 class LinearRegression{
 
 		public:
@@ -61,6 +71,16 @@ class LinearRegression{
 			vector<double> residuals(const vector<vector<double> > &data, const vector<double> &betas, 
 							const vector<double> &response);
 			
+			/*
+			 * Least squares on an intercept and a column that is code[k] for
+			 * every individual in class k, in closed form from the class sums.
+			 * Returns the slope; sse and ssr are those of sumSquaredStats and
+			 * sxx is the column's sum of squares about its mean over n.
+			 * Throws LinearRegressionException if the column is constant.
+			 */
+			double classLeastSquares(const ClassSums &sums, const double code[3], double mean,
+						double &sse, double &ssr, double &sxx);
+			
 			/*
 			 * Perform an anova on response variable.
 			 */
@@ -0,0 +1,400 @@
+/*
+ *      logistic_batch.cpp
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#include "logistic_batch.hh"
+#include "vecops.hh"
+#include "../linalg/linalg.h" // used for condition number.
+
+#include <math.h>
+
+namespace {
+
+	// As in LogisticRegression::newtonRaphson.
+	const double stop_var = 1e-10;
+}
+
+LogisticBatch::LogisticBatch(double conditionNumber){
+	condition_number_limit = 1 / conditionNumber;
+	people = 0;
+	cols = 0;
+}
+
+/*
+ * Store the covariates row by row with the intercept last, so the pass
+ * over individuals in accumulate() reads each row once.
+ */
+void LogisticBatch::set_base(const vector<vector<double> > &cov, const vector<double> &response, const vector<double> &start){
+	people = response.size();
+	cols = cov.size() + 1;
+	y = response;
+	this->start = start;
+	if(static_cast<int>(this->start.size()) != cols) this->start.assign(cols, 0.0);
+
+	base.resize(static_cast<size_t>(people) * cols);
+	for(int i=0; i < people; i++){
+		double *row = &base[static_cast<size_t>(i) * cols];
+		for(int c=0; c < cols-1; c++){
+			row[c] = cov[c][i];
+		}
+		row[cols-1] = 1.0;
+	}
+	snp.clear();
+	models.clear();
+}
+
+int LogisticBatch::add_model(const vector<double> &s){
+	snp.insert(snp.end(), s.begin(), s.end());
+	return add_model(1);
+}
+
+int LogisticBatch::add_model(const vector<double> &snp1, const vector<double> &snp2){
+	snp.insert(snp.end(), snp1.begin(), snp1.end());
+	snp.insert(snp.end(), snp2.begin(), snp2.end());
+	return add_model(2);
+}
+
+int LogisticBatch::add_model(int k){
+	Model m;
+	m.k = k;
+	m.first = snp.size() - static_cast<size_t>(k) * people;
+	m.state = RUNNING;
+	m.change = 0;
+	models.push_back(m);
+	return models.size() - 1;
+}
+
+vector<double> LogisticBatch::betas(int m) const{
+	return models[m].beta;
+}
+
+/*
+ * Newton-Raphson for every model, all iterating together.  Stops as
+ * LogisticRegression::newtonRaphson does: when the fitted values move by
+ * less than stop_var per individual.  Models still moving after
+ * LOGISTIC_BATCH_MAX_ITER iterations are flagged.
+ */
+void LogisticBatch::fit(){
+
+	for(unsigned int i=0; i < models.size(); i++){
+		Model &m = models[i];
+		int n = cols + m.k;
+		m.beta = start;
+		m.beta.resize(n, 0.0);
+		m.a.assign(cols * cols, 0.0);
+		m.b.assign(cols * m.k, 0.0);
+		m.d.assign(m.k * m.k, 0.0);
+		m.score.assign(n, 0.0);
+		m.oldP.assign(people, -1.0);
+		m.state = people > 0 ? RUNNING : FAILED;
+	}
+
+	int running = models.size();
+	for(int iter=0; running > 0 && iter < LOGISTIC_BATCH_MAX_ITER; iter++){
+		accumulate();
+		for(unsigned int i=0; i < models.size(); i++){
+			Model &m = models[i];
+			if(m.state != RUNNING) continue;
+			if(!step(m)){
+				m.state = FAILED;
+				running--;
+			}else if(m.change < people * stop_var){
+				m.state = well_conditioned(m) ? DONE : FAILED;
+				running--;
+			}
+		}
+	}
+
+	for(unsigned int i=0; i < models.size(); i++){
+		if(models[i].state == RUNNING) models[i].state = FAILED;
+	}
+}
+
+/*
+ * One pass over the individuals: fitted values, the blocks of the
+ * information matrix (upper triangle of A) and the score, for every model
+ * still running.
+ */
+void LogisticBatch::accumulate(){
+
+	for(unsigned int i=0; i < models.size(); i++){
+		Model &m = models[i];
+		if(m.state != RUNNING) continue;
+		m.a.assign(m.a.size(), 0.0);
+		m.b.assign(m.b.size(), 0.0);
+		m.d.assign(m.d.size(), 0.0);
+		m.score.assign(m.score.size(), 0.0);
+		m.change = 0;
+	}
+
+	for(int i=0; i < people; i++){
+		const double *x = &base[static_cast<size_t>(i) * cols];
+
+		for(unsigned int mi=0; mi < models.size(); mi++){
+			Model &m = models[mi];
+			if(m.state != RUNNING) continue;
+
+			const double *beta = &m.beta[0];
+			double g[2];
+			double eta = 0;
+			for(int c=0; c < cols; c++) eta += x[c] * beta[c];
+			for(int c=0; c < m.k; c++){
+				g[c] = snp[m.first + static_cast<size_t>(c) * people + i];
+				eta += g[c] * beta[cols + c];
+			}
+
+			double p = 1 / (1 + exp(-eta));
+			double w = p * (1 - p);
+			double r = y[i] - p;
+			m.change += fabs(p - m.oldP[i]);
+			m.oldP[i] = p;
+
+			double *a = &m.a[0];
+			for(int r1=0; r1 < cols; r1++){
+				double wx = w * x[r1];
+				double *arow = a + r1 * cols;
+				for(int c=r1; c < cols; c++) arow[c] += wx * x[c];
+				for(int c=0; c < m.k; c++) m.b[r1 * m.k + c] += wx * g[c];
+				m.score[r1] += r * x[r1];
+			}
+			for(int r1=0; r1 < m.k; r1++){
+				for(int c=0; c < m.k; c++) m.d[r1 * m.k + c] += w * g[r1] * g[c];
+				m.score[cols + r1] += r * g[r1];
+			}
+		}
+	}
+}
+
+/*
+ * Newton step by blocks.  With u = inv(A) score_base and V = inv(A) B,
+ *     S = D - B' V,  delta_snp = inv(S) (score_snp - B' u),
+ *     delta_base = u - V delta_snp.
+ * Keeps inv(S) as the SNP block of the inverse information.
+ */
+bool LogisticBatch::step(Model &m){
+
+	int k = m.k;
+	vector<double> l(m.a);
+	for(int r=0; r < cols; r++){
+		for(int c=0; c < r; c++) l[r * cols + c] = l[c * cols + r];
+	}
+	if(!vecops::cholesky(&l[0], cols)) return false;
+
+	vector<double> u(m.score.begin(), m.score.begin() + cols);
+	vecops::choleskySolve(&l[0], cols, &u[0]);
+
+	vector<double> v(cols * k);
+	vector<double> col(cols);
+	for(int c=0; c < k; c++){
+		for(int r=0; r < cols; r++) col[r] = m.b[r * k + c];
+		vecops::choleskySolve(&l[0], cols, &col[0]);
+		for(int r=0; r < cols; r++) v[r * k + c] = col[r];
+	}
+
+	double s[4], t[2], inv[4];
+	for(int r=0; r < k; r++){
+		t[r] = m.score[cols + r];
+		for(int j=0; j < cols; j++) t[r] -= m.b[j * k + r] * u[j];
+		for(int c=0; c < k; c++){
+			s[r * k + c] = m.d[r * k + c];
+			for(int j=0; j < cols; j++) s[r * k + c] -= m.b[j * k + r] * v[j * k + c];
+		}
+	}
+	if(k == 1){
+		if(!(s[0] > 0)) return false;
+		inv[0] = 1 / s[0];
+	}else if(k == 2){
+		double det = s[0] * s[3] - s[1] * s[2];
+		if(!(det > 0)) return false;
+		inv[0] = s[3] / det;
+		inv[1] = -s[1] / det;
+		inv[2] = -s[2] / det;
+		inv[3] = s[0] / det;
+	}
+
+	double delta[2];
+	for(int r=0; r < k; r++){
+		delta[r] = 0;
+		for(int c=0; c < k; c++) delta[r] += inv[r * k + c] * t[c];
+	}
+	for(int j=0; j < cols; j++){
+		double dj = u[j];
+		for(int c=0; c < k; c++) dj -= v[j * k + c] * delta[c];
+		m.beta[j] += dj;
+		if(m.beta[j] != m.beta[j]) return false;
+	}
+
+	m.snpBetas.resize(k);
+	m.snpInvInf.assign(k, vector<double>(k));
+	for(int r=0; r < k; r++){
+		m.beta[cols + r] += delta[r];
+		if(m.beta[cols + r] != m.beta[cols + r]) return false;
+		m.snpBetas[r] = m.beta[cols + r];
+		for(int c=0; c < k; c++) m.snpInvInf[r][c] = inv[r * k + c];
+	}
+	return true;
+}
+
+/*
+ * Same test as LogisticRegression: the reciprocal condition number (1-norm)
+ * of the whole information matrix, from the last pass.
+ */
+bool LogisticBatch::well_conditioned(const Model &m) const{
+	int n = cols + m.k;
+	alglib::real_2d_array h;
+	h.setlength(n, n);
+	for(int r=0; r < cols; r++){
+		for(int c=r; c < cols; c++){
+			h(r, c) = h(c, r) = m.a[r * cols + c];
+		}
+		for(int c=0; c < m.k; c++){
+			h(r, cols + c) = h(cols + c, r) = m.b[r * m.k + c];
+		}
+	}
+	for(int r=0; r < m.k; r++){
+		for(int c=0; c < m.k; c++){
+			h(cols + r, cols + c) = m.d[r * m.k + c];
+		}
+	}
+	return alglib::rmatrixrcond1(h, n) >= condition_number_limit;
+}
+
+/*
+ * The fit is a batch of one model with no SNP columns.  The information
+ * matrix is then rebuilt at the final betas and inverted for score().
+ */
+bool LogisticNullModel::fit(const vector<vector<double> > &cov, const vector<double> &response, double conditionNumber){
+
+	fitted = false;
+	LogisticBatch batch(conditionNumber);
+	batch.set_base(cov, response, vector<double>());
+	int m = batch.add_model(0);
+	batch.fit();
+	if(!batch.converged(m)){
+		betas.clear();
+		return false;
+	}
+	betas = batch.betas(m);
+
+	people = batch.people;
+	cols = batch.cols;
+	x.swap(batch.base);
+	resid.resize(people);
+	weight.resize(people);
+	vector<double> a(cols * cols, 0.0);
+	for(int i=0; i < people; i++){
+		const double *row = &x[static_cast<size_t>(i) * cols];
+		double eta = 0;
+		for(int c=0; c < cols; c++) eta += row[c] * betas[c];
+		double p = 1 / (1 + exp(-eta));
+		weight[i] = p * (1 - p);
+		resid[i] = response[i] - p;
+		for(int r=0; r < cols; r++){
+			for(int c=0; c < cols; c++) a[r * cols + c] += weight[i] * row[r] * row[c];
+		}
+	}
+	if(!vecops::cholesky(&a[0], cols)) return false;
+	invInf.assign(cols * cols, 0.0);
+	vector<double> e(cols);
+	for(int c=0; c < cols; c++){
+		e.assign(cols, 0.0);
+		e[c] = 1;
+		vecops::choleskySolve(&a[0], cols, &e[0]);
+		for(int r=0; r < cols; r++) invInf[r * cols + c] = e[r];
+	}
+	fitted = true;
+	return true;
+}
+
+/*
+ * Individuals missing at the SNP leave the sums.  The null model was fit on
+ * everyone, so over the rest X' (y - p) is no longer zero and X' W X is not
+ * the matrix it was inverted from; both are then summed over rows and the
+ * covariates projected out of the score with them:
+ *
+ *     U = G' r - B' inv(A) X' r,    V = G' W G - B' inv(A) B,
+ *
+ * with r = y - p, A = X' W X and B = X' W G over rows.
+ */
+bool LogisticNullModel::score(const vector<unsigned int> &rows, const vector<double> *const *snp, int k, double *u, double *v) const{
+
+	bool subset = rows.size() < static_cast<size_t>(people);
+	vector<double> b(cols * k, 0.0); // X' W G
+	vector<double> a, xr;            // X' W X and X' r over rows, for a subset.
+	if(subset){
+		a.assign(cols * cols, 0.0);
+		xr.assign(cols, 0.0);
+	}
+	for(int c=0; c < k; c++) u[c] = 0;
+	for(int c=0; c < k * k; c++) v[c] = 0;
+
+	for(unsigned int j=0; j < rows.size(); j++){
+		unsigned int i = rows[j];
+		const double *row = &x[static_cast<size_t>(i) * cols];
+		double w = weight[i];
+		if(subset){
+			for(int r=0; r < cols; r++){
+				xr[r] += row[r] * resid[i];
+				double wr = w * row[r];
+				for(int c=r; c < cols; c++) a[r * cols + c] += wr * row[c];
+			}
+		}
+		for(int c=0; c < k; c++){
+			double g = (*snp[c])[j];
+			if(g == 0) continue;
+			u[c] += g * resid[i];
+			for(int c2=0; c2 < k; c2++) v[c * k + c2] += w * g * (*snp[c2])[j];
+			double wg = w * g;
+			for(int t=0; t < cols; t++) b[t * k + c] += wg * row[t];
+		}
+	}
+
+	if(!subset){
+		for(int c=0; c < k; c++){
+			for(int c2=0; c2 < k; c2++){
+				double q = 0;
+				for(int r=0; r < cols; r++){
+					double ab = 0;
+					for(int t=0; t < cols; t++) ab += invInf[r * cols + t] * b[t * k + c2];
+					q += b[r * k + c] * ab;
+				}
+				v[c * k + c2] -= q;
+			}
+		}
+		return true;
+	}
+
+	for(int r=1; r < cols; r++){
+		for(int c=0; c < r; c++) a[r * cols + c] = a[c * cols + r];
+	}
+	if(!vecops::cholesky(&a[0], cols)) return false;
+	vector<double> z(cols); // inv(A) times one column of B.
+	for(int c2=0; c2 < k; c2++){
+		for(int t=0; t < cols; t++) z[t] = b[t * k + c2];
+		vecops::choleskySolve(&a[0], cols, &z[0]);
+		for(int c=0; c < k; c++){
+			double q = 0;
+			for(int r=0; r < cols; r++) q += b[r * k + c] * z[r];
+			v[c * k + c2] -= q;
+		}
+		for(int r=0; r < cols; r++) u[c2] -= z[r] * xr[r];
+	}
+	return true;
+}
@@ -0,0 +1,174 @@
+/*
+ *      logistic_batch.hh
+ *
+ *      Copyright 2012 Wake Forest University Health Sciences
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef LOGISTIC_BATCH_H
+#define LOGISTIC_BATCH_H
+
+/**
+ * Several logistic models on one set of individuals, fit together.
+ *
+ * Every SNPGWA model is the covariates and an intercept (the base columns)
+ * plus one or two columns coded from the SNP.  The base columns are stored
+ * once, row by row, and each Newton-Raphson iteration makes a single pass
+ * over the individuals that updates every model still running.
+ *
+ * The fits start from the covariates-only (null) model with the SNP terms
+ * at zero, which is fit once per run; most SNPs are then done in three or
+ * four iterations rather than the six or so a start from zero takes.
+ *
+ * The information matrix of a model is solved by blocks,
+ *
+ *     [ A  B ]    A = base' W base,  B = base' W snp,  D = snp' W snp,
+ *     [ B' D ]
+ *
+ * with A factored (Cholesky) and the SNP terms taken from the Schur
+ * complement S = D - B' inv(A) B, which is 1x1 or 2x2.  The SNP block of the
+ * inverse information, which is all the Wald tests need, is inv(S).
+ *
+ * A model that does not converge, or whose information matrix is singular
+ * or worse conditioned than the limit, is flagged rather than thrown; the
+ * caller runs it through LogisticRegression instead, which reports why.
+ * A fit still moving after LOGISTIC_BATCH_MAX_ITER iterations is almost
+ * always separated (the betas run off to infinity) and is flagged too.
+ *
+ * Usage:
+ * 	batch.set_base(cov, response, nullBetas);
+ * 	int add = batch.add_model(addColumn);
+ * 	int tdf = batch.add_model(col1, col2);
+ * 	batch.fit();
+ * 	if(batch.converged(add)) ... batch.snp_betas(add), batch.snp_inv_inf(add)
+ */
+
+#include <vector>
+
+using namespace std;
+
+// Iterations before a fit is handed back as unlikely to converge.
+#define LOGISTIC_BATCH_MAX_ITER 12
+
+class LogisticBatch {
+
+	public:
+		/* conditionNumber as for LogisticRegression. */
+		LogisticBatch(double conditionNumber = 1e12);
+
+		/*
+		 * Covariates (one vector per covariate) and response for the
+		 * individuals.  start holds the null-model betas, covariates then
+		 * intercept; if it is empty the fits start from zero.  Drops the
+		 * models.
+		 */
+		void set_base(const vector<vector<double> > &cov, const vector<double> &response, const vector<double> &start);
+
+		/* Add a model with one or two SNP columns.  Returns its index. */
+		int add_model(const vector<double> &snp);
+		int add_model(const vector<double> &snp1, const vector<double> &snp2);
+
+		/* Fit every model. */
+		void fit();
+
+		bool converged(int m) const {return models[m].state == DONE;}
+		/* Betas of the SNP columns of model m, in the order given. */
+		const vector<double> &snp_betas(int m) const {return models[m].snpBetas;}
+		/* The matching block of the inverse information matrix. */
+		const vector<vector<double> > &snp_inv_inf(int m) const {return models[m].snpInvInf;}
+		/* All betas: covariates, intercept, SNP columns. */
+		vector<double> betas(int m) const;
+
+	protected:
+		enum State { RUNNING, DONE, FAILED };
+
+		struct Model {
+			int k;                   // SNP columns, 0 (the null model) to 2.
+			int first;               // Offset of its columns in snp.
+			State state;
+			vector<double> beta;     // Base then SNP.
+			vector<double> a, b, d;  // Blocks of the information matrix.
+			vector<double> score;    // base' (y - p), then snp' (y - p).
+			vector<double> oldP;     // Fitted values of the last iteration.
+			double change;           // Sum of |p - oldP| this iteration.
+			vector<double> snpBetas;
+			vector<vector<double> > snpInvInf;
+		};
+
+		int people;
+		int cols;                    // Base columns, intercept last.
+		vector<double> base;         // people x cols, row-major.
+		vector<double> y;
+		vector<double> start;
+		vector<double> snp;          // SNP columns, one after another.
+		vector<Model> models;
+		double condition_number_limit; // Stored as inverse!
+
+		friend class LogisticNullModel;
+
+		int add_model(int k);
+		void accumulate();
+		bool step(Model &m);
+		bool well_conditioned(const Model &m) const;
+};
+
+/**
+ * The covariates-only model of a run, fit once on every individual, and
+ * score tests of SNP columns against it.
+ *
+ * With p the fitted values, W = diag(p (1 - p)) and X the covariates and
+ * intercept, the score of SNP columns G is U = G' (y - p), with variance
+ *
+ *     V = G' W G - (X' W G)' inv(X' W X) (X' W G).
+ *
+ * The residuals, weights and inv(X' W X) are kept from the fit, so a SNP
+ * costs one pass over its individuals.  A SNP with missing genotypes also
+ * sums X' W X and X' (y - p) over the individuals it has and adjusts U and
+ * V with those (see score()).
+ */
+class LogisticNullModel {
+
+	public:
+		LogisticNullModel() : fitted(false), people(0), cols(0) {}
+
+		/* Fit on every individual, in order.  False if the fit fails. */
+		bool fit(const vector<vector<double> > &cov, const vector<double> &response, double conditionNumber = 1e12);
+
+		bool is_fitted() const {return fitted;}
+		/* Covariates then intercept; empty if not fitted. */
+		const vector<double> &get_betas() const {return betas;}
+
+		/*
+		 * Score u (k values) and its variance v (k x k, row-major) for the
+		 * k SNP columns snp[0 .. k-1], which hold one value for each of the
+		 * listed individuals.  False if the covariates are singular over
+		 * those individuals.
+		 */
+		bool score(const vector<unsigned int> &rows, const vector<double> *const *snp, int k, double *u, double *v) const;
+
+	protected:
+		bool fitted;
+		int people;
+		int cols;
+		vector<double> betas;
+		vector<double> x;            // people x cols, row-major.
+		vector<double> resid;        // y - p
+		vector<double> weight;       // p (1 - p)
+		vector<double> invInf;       // inv(X' W X), cols x cols.
+};
+
+#endif
@@ -27,9 +27,11 @@
 
 LogisticRegression::LogisticRegression(){
      condition_number_limit = 1e-12;
+     firth_likelihood = 0;
 }
 LogisticRegression::LogisticRegression(double conditionNumber){
     condition_number_limit = 1 / conditionNumber;
+    firth_likelihood = 0;
 }
 /**
  * Check whether any column in the data completely separates the response variable. 
@@ -296,45 +298,222 @@ vector<double> LogisticRegression::expectedScores(const vector<double> &betas, c
  */
 bool LogisticRegression::invFisherInformation(const vector<vector<double> > &data, const vector<double> &betas, vector<vector<double> > &returnMatrix){
     
-    vector<double> expVals = expectedScores(betas, data);
+    loadData(data);
+    int sz = work.cols;
+    for(int i=0;i < sz; i++){
+        work.betas[i] = betas.at(i);
+    }
     
-    int sz = betas.size()-1;
+    accumulate(NULL);
+    try{
+        invertInformation();
+    }catch(const SingularMatrixEx &){
+        return false;
+    }
     
-    alglib::real_2d_array vInvInf;
-    vInvInf.setlength(sz+1,sz+1);
+    returnMatrix.assign(sz, vector<double>(sz, 0));
+    for(int i=0;i < sz; i++){
+        for(int j=0; j < sz; j++){
+            returnMatrix[i][j] = work.inv[i*sz + j];
+        }
+    }
+    
+    return true;
+}
+
+/*
+ * Size the workspace for data (one vector per variable) and copy data into
+ * it row by row.  Vectors keep their capacity, so this only allocates when
+ * the data are larger than any seen before.
+ */
+void LogisticRegression::loadData(const vector<vector<double> > &data){
+    
+    int numVars = data.size();
+    int numSamples = data.at(0).size();
+    
+    work.rows = numSamples;
+    work.cols = numVars;
+    work.x.resize(numSamples * numVars);
+    work.betas.resize(numVars);
+    work.p.resize(numSamples);
+    work.oldP.resize(numSamples);
+    work.hessian.resize(numVars * numVars);
+    work.xwz.resize(numVars);
+    work.wx.resize(numVars);
+    work.group.resize(numVars);
+    work.chol.resize(numVars * numVars);
+    work.inv.resize(numVars * numVars);
+    work.col.resize(numVars);
+    work.step.resize(numVars);
+    work.last.resize(numVars);
+    
+    double *x = &work.x[0];
+    for(int j=0; j < numVars; j++){
+        const vector<double> &column = data[j];
+        if(static_cast<int>(column.size()) != numSamples){
+            throw NewtonRaphsonFailureEx();
+        }
+        for(int i=0; i < numSamples; i++){
+            x[i*numVars + j] = column[i];
+        }
+    }
+}
+
+/*
+ * One pass over the individuals at work.betas.  Fills work.p with the fitted
+ * values and work.hessian with X' W X, W = p (1 - p).  Given the response,
+ * also fills work.xwz with X' W z for the working response
+ * z = X b + (y - p) / W of the IRLS update.
+ * 
+ * The sums are formed in the order the alglib version used (w x_j x_i per
+ * element, dot products in groups of four), so a fit takes the same
+ * iterates it always did.  Separated fits stop on rounding noise, and a
+ * different order changes where they stop.
+ */
+void LogisticRegression::accumulate(const vector<double> *response){
+    
+    int numSamples = work.rows;
+    int numVars = work.cols;
+    const double *x = &work.x[0];
+    const double *betas = &work.betas[0];
+    double *p = &work.p[0];
+    double *hessian = &work.hessian[0];
+    double *xwz = &work.xwz[0];
+    double *wx = &work.wx[0];
+    double *group = &work.group[0];
+    int grouped = numSamples - numSamples % 4;
+    
+    for(int i=0; i < numVars*numVars; i++) hessian[i] = 0.0;
+    for(int i=0; i < numVars; i++) xwz[i] = 0.0;
+    
+    for(int indiv=0; indiv < numSamples; indiv++){
+        const double *row = x + indiv*numVars;
+        
+        double eta = alglib::vdotproduct(row, betas, numVars);
+        double expY = 1 / (1 + exp(-eta));
+        double w = expY * (1 - expY);
+        p[indiv] = expY;
+        
+        for(int j=0; j < numVars; j++){
+            wx[j] = w * row[j];
+        }
+        
+        // The inner loop runs over contiguous memory.
+        for(int i=0; i < numVars; i++){
+            double xi = row[i];
+            double *h = hessian + i*numVars;
+            for(int j=0; j < numVars; j++){
+                h[j] += wx[j] * xi;
+            }
+        }
+        
+        if(response != NULL){
+            double adjy = eta + ((*response)[indiv] - expY) / w;
+            if(indiv >= grouped){
+                for(int i=0; i < numVars; i++) xwz[i] += wx[i] * adjy;
+            }else if(indiv % 4 == 0){
+                for(int i=0; i < numVars; i++) group[i] = wx[i] * adjy;
+            }else if(indiv % 4 != 3){
+                for(int i=0; i < numVars; i++) group[i] += wx[i] * adjy;
+            }else{
+                for(int i=0; i < numVars; i++) xwz[i] += group[i] + wx[i] * adjy;
+            }
+        }
+    }
+}
+
+/*
+ * Invert work.hessian into work.inv.
+ * 
+ * Small matrices are factored by Cholesky and the condition number taken
+ * from the 1-norms of the matrix and its inverse.  Large matrices, those that
+ * are not positive definite in floating point and those that fail the
+ * condition number limit go through rmatrixinverse, so a singular matrix
+ * still throws SingularMatrixEx and the reported condition number is the
+ * one it always was.
+ * 
+ * Throws SingularMatrixEx or ConditionNumberEx.
+ */
+void LogisticRegression::invertInformation(){
+    
+    int n = work.cols;
+    const double *hessian = &work.hessian[0];
+    double *inv = &work.inv[0];
     
-    for(unsigned int indiv = 0; indiv < data.at(0).size(); indiv++){
-        for(int i=0;i <= sz; i++){
-            for(int j=0; j <= sz; j++){
-                vInvInf(i,j) += expVals.at(indiv)*(1.0 - expVals.at(indiv))*data.at(i).at(indiv)*data.at(j).at(indiv);
+    if(n <= LR_CHOLESKY_MAX){
+        double *l = &work.chol[0];
+        for(int i=0; i < n*n; i++) l[i] = hessian[i];
+        
+        if(vecops::cholesky(l, n)){
+            double *e = &work.col[0];
+            for(int j=0; j < n; j++){
+                for(int i=0; i < n; i++) e[i] = 0.0;
+                e[j] = 1.0;
+                vecops::choleskySolve(l, n, e);
+                for(int i=0; i < n; i++) inv[i*n + j] = e[i];
+            }
+            
+            // Both are symmetric, so row sums serve for the 1-norm.
+            double normH = 0, normInv = 0;
+            for(int i=0; i < n; i++){
+                double sH = 0, sInv = 0;
+                for(int j=0; j < n; j++){
+                    sH += fabs(hessian[i*n + j]);
+                    sInv += fabs(inv[i*n + j]);
+                }
+                if(sH > normH) normH = sH;
+                if(sInv > normInv) normInv = sInv;
+            }
+            // A matrix that fails the limit, or is numerically singular but
+            // still factored, goes to the LU inverse below so that it is
+            // reported exactly as it always was.
+            double rcond = 1.0 / (normH * normInv);
+            if (rcond >= condition_number_limit){
+                return;
             }
         }
     }
     
+    invertInformationLU();
+}
+
+/*
+ * Invert work.hessian into work.inv with rmatrixinverse, as the alglib
+ * version of newtonRaphson did.  newtonRaphson uses this for every
+ * iteration: the Cholesky inverse differs in the last bits, which is enough
+ * to move where a separated fit stops.
+ * 
+ * Throws SingularMatrixEx or ConditionNumberEx.
+ */
+void LogisticRegression::invertInformationLU(){
+    
+    int n = work.cols;
+    const double *hessian = &work.hessian[0];
+    double *inv = &work.inv[0];
+    
+    alglib::real_2d_array a;
+    a.setlength(n, n);
+    for(int i=0; i < n; i++){
+        for(int j=0; j < n; j++){
+            a(i,j) = hessian[i*n + j];
+        }
+    }
+    
     alglib::matinvreport report;
     alglib::ae_int_t reportInfo;
-    rmatrixinverse(vInvInf, reportInfo, report);
-    if(reportInfo != 1) return false;
+    rmatrixinverse(a, reportInfo, report);
+    if(reportInfo != 1){
+        throw SingularMatrixEx();
+    }
     // Check condition number.
     if (report.r1 < condition_number_limit){
         throw ConditionNumberEx(1.0/report.r1);
     }
-    returnMatrix.clear();
-    vector<double> temp;
-    for(int i=0;i <= sz; i++){
-        temp.push_back(0);
-    }
-    for(int i=0;i <= sz; i++){
-        returnMatrix.push_back(temp);
-    }
-    
-    for(int i=0;i <= sz; i++){
-        for(int j=0; j <= sz; j++){
-            returnMatrix.at(i).at(j) = vInvInf(i,j);
+    for(int i=0; i < n; i++){
+        for(int j=0; j < n; j++){
+            inv[i*n + j] = a(i,j);
         }
     }
-    
-    return true;
 }
 
 /*
@@ -524,23 +703,12 @@ vector<double> LogisticRegression::newtonRaphsonFast(const vector<vector<double>
     return betas;
 }
 // Perform exact (and slower) NR test using the exact fisher information matrix.
+//
+// Each iteration is the IRLS update b <- inv(X' W X) X' W z, computed in one
+// pass over the rows of the design matrix held in the workspace.
 vector<double> LogisticRegression::newtonRaphson(const vector<vector<double> > &data, const vector<double> &response, vector<vector<double> > &invInfMatrix, double startVal)
 {
 
-    vector<double> betas;
-    
-    // Variables used in the computation:
-    alglib::real_1d_array tempBetas;
-    alglib::real_2d_array tempData;
-    alglib::real_2d_array tempDataTrans;
-    alglib::real_1d_array oldExpY;
-    alglib::real_2d_array hessian; // holds data' * w * data.  Returned in last input param.
-    alglib::real_1d_array expY;
-    alglib::real_1d_array W; // holds diagonal of the w matrix above.
-    alglib::real_1d_array adjy;
-    
-    alglib::real_1d_array work;
-    
     double stop_var = 1e-10;
 
     int iter = 0;
@@ -552,116 +720,51 @@ vector<double> LogisticRegression::newtonRaphson(const vector<vector<double> > &
     }
     
     int numSamples = data.at(0).size();
-    if(numSamples < 1){
+    if(numSamples < 1 || static_cast<int>(response.size()) < numSamples){
         throw NewtonRaphsonFailureEx();
     }
     
-    tempBetas.setlength(numVars);
-    tempData.setlength(numSamples,numVars);
-    tempDataTrans.setlength(numVars, numSamples);
-    oldExpY.setlength(numSamples);
-    expY.setlength(numSamples);
-    hessian.setlength(numVars, numVars);
-    adjy.setlength(numSamples);
-    W.setlength(numSamples);
-    
-    work.setlength(numVars);
+    loadData(data);
     
     for(int i=0;i < numVars; i++){
-        for(int j=0;j < numSamples; j++){
-            tempData(j,i) = data.at(i).at(j);
-        }
-        tempBetas(i) = startVal;
+        work.betas[i] = startVal;
     }
     for(int i=0;i < numSamples;i++){
-        oldExpY(i) = -1;
-        adjy(i) = 0; // makes valgrind happier.
+        work.oldP[i] = -1;
     }
 
     // End initial setup.
     // In each iteration, create a hessian and a first derivative.
     while(iter < maxIter){
         
-        //adjy <- data * tempBetas (get new y guess)
-        matrixvectormultiply(tempData, 0, numSamples-1,0,numVars-1,false, 
-                            tempBetas, 0, numVars-1, 1.0, 
-                            adjy, 0, numSamples-1, 0.0);
-        
-        // adjy = 1 / (1 + exp(-adjy))  
-        for(int i=0;i < numSamples; i++){
-            expY(i) = 1 / (1 + exp(-adjy(i)));
-        }
-        
-        // build deriv.
-        for(int i=0;i < numSamples; i++){
-            W(i) = expY(i) * (1 - expY(i));
-        }
+        accumulate(&response);
+        invertInformationLU();
         
-        // adjy = adjy + (y-expy) ./ deriv
-        for(int i=0;i<numSamples;i++){
-            adjy(i) = adjy(i) + (response.at(i) - expY(i)) / W(i);
-        }
-        
-        // build data' * w * data
-        // set to hessian.  
-        // Also doing secondary computation (see inside)
+        // betas <- invHessian * X'W * adjy
+        const double *inv = &work.inv[0];
+        const double *xwz = &work.xwz[0];
         for(int i=0; i < numVars; i++){
-            for(int j=0; j < numVars; j++)
-                hessian(i,j) = 0.0;
+            work.betas[i] = alglib::vdotproduct(inv + i*numVars, xwz, numVars);
         }
         
-        for(int indiv=0; indiv < numSamples; ++indiv){
-            for(int i = 0; i < numVars; i++){
-                for(int j = 0; j < numVars; j++){
-                    hessian(i,j) += W(indiv) * tempData(indiv, j) * tempData(indiv, i);
-                }
-                
-                // NOTE: as a speedup, I'm also computing X' * W
-                tempDataTrans(i, indiv) = W(indiv) * tempData(indiv, i);
-                
-            }
-        }
-        
-        alglib::matinvreport report;
-        alglib::ae_int_t reportInfo;
-        rmatrixinverse(hessian, reportInfo, report);
-        if(reportInfo != 1 ){
-            throw SingularMatrixEx();
-        }
-        
-        // Check condition number.
-        if (report.r1 < condition_number_limit){
-            throw ConditionNumberEx(1.0/report.r1);
-        }
-        
-        // work <- X'W * adjy
-        matrixvectormultiply(tempDataTrans,0,numVars-1,0,numSamples-1,false,
-                            adjy,0,numSamples-1,1,
-                            work,0,numVars-1,0.0);
-        // tempBetas <= invHessian * work
-        matrixvectormultiply(hessian,0,numVars-1,0,numVars-1,false,
-                            work,0,numVars-1,1.0,
-                            tempBetas,0,numVars-1,0.0);
-        
-        
         #if DEBUG_NR
             cout << "Betas ";
-            for(int i=0;i < numVars;i++) cout << tempBetas(i) << "  " ;
+            for(int i=0;i < numVars;i++) cout << work.betas[i] << "  " ;
             cout << endl;
         #endif
         
         double stop = 0.0;
-        // Could be computed as a 1-norm.
-        // This should be done as a sum of abs diff.
+        const double *expY = &work.p[0];
+        const double *oldExpY = &work.oldP[0];
         for(int i=0;i < numSamples;i++){
-            stop += abs(expY(i) - oldExpY(i));
+            stop += abs(expY[i] - oldExpY[i]);
         }
 
         if (stop < numSamples*stop_var){
             break;
         }
         
-        oldExpY = expY;
+        work.p.swap(work.oldP);
         
         iter++;
     }
@@ -671,21 +774,194 @@ vector<double> LogisticRegression::newtonRaphson(const vector<vector<double> > &
         throw NewtonRaphsonIterationEx();
     }
     
-    betas.clear();
+    vector<double> betas(work.betas.begin(), work.betas.end());
+
     for(int i=0;i<numVars;i++){
-        betas.push_back(tempBetas(i));
+        for(int j=0;j<numVars;j++){
+            invInfMatrix.at(i).at(j) = work.inv[i*numVars + j];
+        }
     }
+    
+    return betas;
+    
+}
 
+/*
+ * Firth's penalized likelihood (Firth, 1993; Heinze and Schemper, 2002).
+ * 
+ * Maximizes l(b) + 1/2 log |X' W X|.  Each iteration takes the Newton step
+ * inv(X' W X) U* on the modified score
+ * 
+ *     U*_j = sum_i x_ij (y_i - p_i + h_i (1/2 - p_i)),
+ * 
+ * with h_i the diagonal of the hat matrix W^1/2 X inv(X' W X) X' W^1/2.  Steps
+ * are capped at FIRTH_MAX_STEP in any beta and halved while they lower the
+ * penalized likelihood, which makes the fit converge from zero even when
+ * the data are separated.
+ * 
+ * @input data, response As for newtonRaphson.
+ * @input invInfMatrix Returns inv(X' W X) at the estimate.  Expects correct size.
+ * @return betas
+ */
+vector<double> LogisticRegression::firth(const vector<vector<double> > &data, const vector<double> &response, vector<vector<double> > &invInfMatrix)
+{
+    
+    double tolerance = 1e-6; // Largest step in a beta at convergence.
+    
+    int numVars = data.size();
+    if(numVars < 1){
+        throw NewtonRaphsonFailureEx();
+    }
+    
+    int numSamples = data.at(0).size();
+    if(numSamples < 1 || static_cast<int>(response.size()) < numSamples){
+        throw NewtonRaphsonFailureEx();
+    }
+    
+    loadData(data);
+    for(int i=0;i < numVars; i++){
+        work.betas[i] = 0.0;
+    }
+    
+    double *betas = &work.betas[0];
+    double *step = &work.step[0];
+    double *last = &work.last[0];
+    
+    double penalized = penalizedLikelihood(response);
+    if(penalized != penalized || penalized == -HUGE_VAL){
+        throw SingularMatrixEx();
+    }
+    
+    int iter = 0;
+    while(iter < FIRTH_MAX_ITER){
+        
+        invertInformation();
+        firthScore(response);
+        
+        const double *inv = &work.inv[0];
+        const double *score = &work.xwz[0];
+        double largest = 0.0;
+        for(int i=0; i < numVars; i++){
+            double d = 0.0;
+            for(int j=0; j < numVars; j++){
+                d += inv[i*numVars + j] * score[j];
+            }
+            step[i] = d;
+            if(fabs(d) > largest) largest = fabs(d);
+        }
+        
+        if(largest < tolerance){
+            break;
+        }
+        
+        if(largest > FIRTH_MAX_STEP){
+            for(int i=0; i < numVars; i++) step[i] *= FIRTH_MAX_STEP / largest;
+        }
+        
+        for(int i=0; i < numVars; i++) last[i] = betas[i];
+        double next = -HUGE_VAL;
+        for(int halving=0; halving <= FIRTH_MAX_HALVING; halving++){
+            for(int i=0; i < numVars; i++) betas[i] = last[i] + step[i];
+            next = penalizedLikelihood(response);
+            if(next >= penalized) break;
+            for(int i=0; i < numVars; i++) step[i] *= 0.5;
+        }
+        if(!(next >= penalized)){
+            // No step uphill: the last betas are the maximum to machine precision.
+            for(int i=0; i < numVars; i++) betas[i] = last[i];
+            penalizedLikelihood(response);
+            invertInformation();
+            break;
+        }
+        penalized = next;
+        
+        iter++;
+    }
+    
+    if(iter == FIRTH_MAX_ITER){
+        throw NewtonRaphsonIterationEx();
+    }
+    
+    firth_likelihood = penalized;
+    
+    vector<double> ret(work.betas.begin(), work.betas.end());
     for(int i=0;i<numVars;i++){
         for(int j=0;j<numVars;j++){
-            invInfMatrix.at(i).at(j) = hessian(i,j);
+            invInfMatrix.at(i).at(j) = work.inv[i*numVars + j];
         }
     }
     
-    //dumpMatrix(invInfMatrix);
+    return ret;
+}
+
+/*
+ * Penalized log likelihood l(b) + 1/2 log |X' W X| at work.betas.  Leaves
+ * the fitted values and X' W X at work.betas in the workspace.  -HUGE_VAL if
+ * X' W X is not positive definite.
+ */
+double LogisticRegression::penalizedLikelihood(const vector<double> &response){
     
-    return betas;
+    accumulate(NULL);
+    
+    int n = work.cols;
+    double *l = &work.chol[0];
+    for(int i=0; i < n*n; i++) l[i] = work.hessian[i];
+    if(!vecops::cholesky(l, n)){
+        return -HUGE_VAL;
+    }
+    
+    double logDet = 0.0;
+    for(int i=0; i < n; i++){
+        logDet += 2 * log(l[i*n + i]);
+    }
+    
+    double logLike = 0.0;
+    const double *p = &work.p[0];
+    for(int i=0; i < work.rows; i++){
+        if(equal(response[i], 0)){
+            logLike += log(1 - p[i]);
+        }else{
+            logLike += log(p[i]);
+        }
+    }
+    
+    return logLike + 0.5 * logDet;
+}
+
+/*
+ * Firth's modified score at work.betas into work.xwz, from the fitted values
+ * and inverse information already in the workspace.
+ */
+void LogisticRegression::firthScore(const vector<double> &response){
+    
+    int numVars = work.cols;
+    const double *x = &work.x[0];
+    const double *p = &work.p[0];
+    const double *inv = &work.inv[0];
+    double *score = &work.xwz[0];
     
+    for(int i=0; i < numVars; i++) score[i] = 0.0;
+    
+    for(int indiv=0; indiv < work.rows; indiv++){
+        const double *row = x + indiv*numVars;
+        
+        // h = w x' inv(X' W X) x
+        double q = 0.0;
+        for(int i=0; i < numVars; i++){
+            const double *inv_i = inv + i*numVars;
+            double t = 0.0;
+            for(int j=0; j < numVars; j++){
+                t += inv_i[j] * row[j];
+            }
+            q += row[i] * t;
+        }
+        double h = p[indiv] * (1 - p[indiv]) * q;
+        double r = response[indiv] - p[indiv] + h * (0.5 - p[indiv]);
+        
+        for(int i=0; i < numVars; i++){
+            score[i] += row[i] * r;
+        }
+    }
 }
 
 void LogisticRegression::dumpMatrix(const vector<vector<double> > &data){
@@ -39,6 +39,15 @@
 #define DEBUG_NR 0
 #define DEBUG_STATS 0
 
+// Information matrices up to this size are inverted by Cholesky, larger ones by LU.
+// newtonRaphson always uses LU.
+#define LR_CHOLESKY_MAX 32
+
+// Firth fits: iterations, step halvings, and the largest change in a beta per step.
+#define FIRTH_MAX_ITER 100
+#define FIRTH_MAX_HALVING 10
+#define FIRTH_MAX_STEP 5.0
+
 #ifndef LOGISTICREG_H
 #define LOGISTICREG_H
 
@@ -86,10 +95,23 @@ class LogisticRegression {
 	
 		/* Calculate the Newton-Raphson algorithm for matrix of explanatory variables
 		 * and vector of reponse variables.  The last matrix is the infomation matrix inverse
-		 * used to compute stats on the model. */
+		 * used to compute stats on the model.
+		 * 
+		 * newtonRaphson keeps its working arrays in the object between calls, so
+		 * keep one LogisticRegression per thread for repeated fits. */
 		vector<double> newtonRaphsonFast(const vector<vector<double> > &data, const vector<double> &response, vector<vector<double> > &invInfMatrix, double startVal = 0.0);
 		vector<double> newtonRaphson(const vector<vector<double> > &data, const vector<double> &response, vector<vector<double> > &invInfMatrix, double startVal = 0.0);
 		
+		/* Firth-penalized logistic regression: maximize the log likelihood plus
+		 * half the log determinant of the information matrix.  The estimates are
+		 * finite under separation and for rare variants, where newtonRaphson
+		 * throws ConditionNumberEx or runs out of iterations.  Arguments and
+		 * exceptions as for newtonRaphson; use Wald tests on the result, or
+		 * likelihood ratios of getFirthLikelihood() between nested fits. */
+		vector<double> firth(const vector<vector<double> > &data, const vector<double> &response, vector<vector<double> > &invInfMatrix);
+		/* Penalized log likelihood of the last firth() fit. */
+		inline double getFirthLikelihood(){return firth_likelihood;}
+		
 		bool invFisherInformation(const vector<vector<double> > &data, const vector<double> &betas, vector<vector<double> > &returnMatrix);
 		
 		int dataIsSeparable(const vector<vector<double> > &data, const vector<double> &response);
@@ -104,7 +126,39 @@ class LogisticRegression {
 		void dumpMatrix(const vector<vector<double> > &data);
 		double variance(const vector<double> &data);
 		
+		/*
+		 * Working arrays for newtonRaphson and invFisherInformation.  They are
+		 * sized at the start of a fit and keep their capacity, so iterations
+		 * allocate nothing and further fits of the same size allocate nothing.
+		 */
+		struct Workspace {
+			int rows;
+			int cols;
+			vector<double> x;        // rows x cols, row-major.
+			vector<double> betas;
+			vector<double> p;        // Fitted values.
+			vector<double> oldP;     // Fitted values of the last iteration.
+			vector<double> hessian;  // X' W X, cols x cols.
+			vector<double> xwz;      // X' W z for the working response z.
+			vector<double> wx;       // w times the current row.
+			vector<double> group;    // Partial sum of X' W z over a group of four rows.
+			vector<double> chol;     // Cholesky factor of hessian.
+			vector<double> inv;      // Inverse of hessian.
+			vector<double> col;      // One column of the inverse.
+			vector<double> step;     // Firth: this step, and the betas it starts from.
+			vector<double> last;
+		};
+		Workspace work;
+		
+		void loadData(const vector<vector<double> > &data);
+		void accumulate(const vector<double> *response);
+		void invertInformation();
+		void invertInformationLU();
+		double penalizedLikelihood(const vector<double> &response);
+		void firthScore(const vector<double> &response);
+		
 		double condition_number_limit; // Stored as inverse!
+		double firth_likelihood;
 		static const double SEPARABLE_THRESHOLD = 0.98;
 	
 };
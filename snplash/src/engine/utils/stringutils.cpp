@@ -1,5 +1,55 @@
 #include "stringutils.h"
 
+#include <stdio.h>
+
+/*
+ * Powers of ten for the range checks, computed with pow() exactly as the
+ * checks always have been so that the comparisons do not change.
+ */
+#define STRNUTILS_POWERS 32
+
+namespace {
+
+struct Powers {
+	double ten[STRNUTILS_POWERS];
+	double tenth[STRNUTILS_POWERS];
+	Powers(){
+		for(int i=0;i<STRNUTILS_POWERS;i++){
+			ten[i] = pow(10, i);
+			tenth[i] = pow(.1, i);
+		}
+	}
+};
+const Powers powers;
+
+inline double ten_to(int n){
+	return (n >= 0 && n < STRNUTILS_POWERS) ? powers.ten[n] : pow(10, n);
+}
+
+inline double tenth_to(int n){
+	return (n >= 0 && n < STRNUTILS_POWERS) ? powers.tenth[n] : pow(.1, n);
+}
+
+inline void pad(std::string &out, int n, char c = ' '){
+	if(n > 0) out.append(n, c);
+}
+
+/* printf conversion of a double.  A negative precision means the default, as in iostreams. */
+void append_double(std::string &out, double number, int precision, bool scientific){
+	char buf[128];
+	if(precision < 0) precision = 6;
+	int n = snprintf(buf, sizeof(buf), scientific ? "%.*e" : "%.*f", precision, number);
+	if(n < static_cast<int>(sizeof(buf))){
+		out.append(buf, n);
+	}else{
+		std::string big(n + 1, ' ');
+		snprintf(&big[0], n + 1, scientific ? "%.*e" : "%.*f", precision, number);
+		out.append(big, 0, n);
+	}
+}
+
+}
+
 /**
  * Correctly format left justified string with lead and trailing spaces.
  * The output will be at least the size of string s plus buffer. This method currently
@@ -10,19 +60,15 @@
  * @param buffer    Amount to buffer the string on the left. 
  */
 std::string strnutils::spaced_string(std::string s, int numspaces, int buffer){
-	#if DB_V_STRNUTILS
-	std::cout << "s " << s << std::endl;
-	#endif
-	std::stringstream ss;
-	for(int i=0;i<buffer;i++) ss << " ";
+	std::string out;
+	append_spaced_string(out, s, numspaces, buffer);
+	return out;
+}
 
-	int left = numspaces-s.length();
-	ss << s;
-	for(int i=0;i<left;i++) ss << " " ;
-	#if DB_V_STRNUTILS
-	std::cout << "done" << std::endl;
-	#endif
-	return ss.str();
+void strnutils::append_spaced_string(std::string &out, const std::string &s, int numspaces, int buffer){
+	pad(out, buffer);
+	out += s;
+	pad(out, numspaces - static_cast<int>(s.length()));
 }
 
 /**
@@ -30,29 +76,37 @@ std::string strnutils::spaced_string(std::string s, int numspaces, int buffer){
  * 
  */
 std::string strnutils::spaced_number(int number, int numspaces, int buffer){
-	#if DB_V_STRNUTILS
-	std::cout << "n1 " << number << std::endl;
-	#endif
-	std::stringstream ss;
+	std::string out;
+	append_spaced_number(out, number, numspaces, buffer);
+	return out;
+}
+
+void strnutils::append_spaced_number(std::string &out, int number, int numspaces, int buffer){
 	if(number < 0) buffer--;
-	for(int i=0;i<buffer;i++) ss << " ";
+	pad(out, buffer);
 	
-	
-	if(number > pow(10, numspaces)){
+	if(number > ten_to(numspaces)){
 		// make if an inf.
-		for(int i=0;i < numspaces; i++) ss << "9";
-		return ss.str();
+		pad(out, numspaces, '9');
+		return;
 	}
 	
 	int sz = int_log(number)+1;
-	for(int i=sz;i<numspaces;i++)
-		ss << " ";
-	ss << number;
-	#if DB_V_STRNUTILS
-	std::cout << "done" << std::endl;
-	#endif
-	return ss.str();
-	
+	pad(out, numspaces - sz);
+	append_number(out, number);
+}
+
+void strnutils::append_number(std::string &out, int number){
+	char buf[16];
+	int i = sizeof(buf);
+	// Work with the negative so INT_MIN needs no special case.
+	int n = number < 0 ? number : -number;
+	do{
+		buf[--i] = static_cast<char>('0' - n % 10);
+		n /= 10;
+	}while(n != 0);
+	if(number < 0) buf[--i] = '-';
+	out.append(buf + i, sizeof(buf) - i);
 }
 
 /**
@@ -71,11 +125,16 @@ std::string strnutils::spaced_number(int number, int numspaces, int buffer){
  * 	@bug Sometimes prints with too many spaces if a large exponent is involved.
  */
 std::string strnutils::spaced_number(double number, int numspaces, int precision, int buffer){
+	std::string out;
+	append_spaced_number(out, number, numspaces, precision, buffer);
+	return out;
+}
+
+void strnutils::append_spaced_number(std::string &out, double number, int numspaces, int precision, int buffer){
 	
-	std::stringstream ss;
-	for(int i=0;i<buffer;i++) ss << " ";
+	pad(out, buffer);
 	
-	double lim = pow(.1,precision);
+	double lim = tenth_to(precision);
 	
 	#if DB_V_STRNUTILS
 	std::cout << "n2 " << number << " spaces " << numspaces << " prec " << precision << " lim " << lim <<  std::endl;
@@ -86,48 +145,41 @@ std::string strnutils::spaced_number(double number, int numspaces, int precision
 		exp += 2; // for 'e-'
 		
 		int leading = numspaces - exp - 1;
-		if(number < 0) leading -= 1;
+		int digits;
 		
 		if(numspaces - exp - 2 > 0){
 			if(numspaces - exp - 2 > precision){
-				ss.precision(precision);
+				digits = precision;
 				leading -= precision;
 			}else{
 				leading = 0;
-				ss.precision(numspaces-exp-2);
+				digits = numspaces-exp-2;
 			}
 		}else{
 			// ran out of room.
-			ss.precision(0);
+			digits = 0;
 		}
 		
-		
-		for(int i=0;i<leading;i++) ss << " ";
-		ss << std::scientific << number;
-	}else if(number > pow(10, numspaces)){
+		pad(out, leading);
+		append_double(out, number, digits, true);
+	}else if(number > ten_to(numspaces)){
 		// make it an inf.
-		for(int i=0;i < numspaces; i++) ss << "9";
+		pad(out, numspaces, '9');
 		
-	}else if(-1*number > pow(10, numspaces)){
+	}else if(-1*number > ten_to(numspaces)){
 		// make it an inf.
-		ss << "-";
-		for(int i=0;i < numspaces-1; i++) ss << "9";
+		out += '-';
+		pad(out, numspaces-1, '9');
 		
 	}else{
-		ss << std::fixed;
 		int leading = numspaces - precision - 1;
 		leading -= (int_log(number) + 1);
 		if(number < 0) leading -= 1;
-		for(int i=0;i<leading;i++) ss << " ";
+		pad(out, leading);
 		if(leading < 0) precision += leading;
-		ss.precision(precision);
-		ss << number;
+		append_double(out, number, precision, false);
 		
 	}
-	#if DB_V_STRNUTILS
-	std::cout << "done" << std::endl;
-	#endif
-	return ss.str();
 }
 
 /* Return number of digits in exponent. */
@@ -45,6 +45,18 @@ namespace strnutils{
 std::string spaced_string(std::string s, int numspaces, int buffer=0);
 std::string spaced_number(int number, int numspaces, int buffer=0);
 std::string spaced_number(double number, int numspaces, int precision, int buffer=0);
+
+/*
+ * The same fields appended to out.  Nothing is allocated once out has the
+ * capacity, so writers that reuse one string per line allocate nothing per
+ * field.
+ */
+void append_spaced_string(std::string &out, const std::string &s, int numspaces, int buffer=0);
+void append_spaced_number(std::string &out, int number, int numspaces, int buffer=0);
+void append_spaced_number(std::string &out, double number, int numspaces, int precision, int buffer=0);
+/* number as operator<< would print it. */
+void append_number(std::string &out, int number);
+
 int small_log(double i);
 
 // Return the integer logarithm of the absolute value, so the log rounded down.
@@ -1,5 +1,7 @@
 #include "vecops.hh"
 
+#include <math.h>
+
 
 /**
  * getVec.  Get a double vector of the specified size.
@@ -15,3 +17,36 @@ std::vector<std::vector<double> > vecops::getDblVec(int size1, int size2){
 	return ret;
 	
 }
+
+bool vecops::cholesky(double *a, int n){
+	
+	for(int j=0; j < n; j++){
+		double s = a[j*n + j];
+		for(int k=0; k < j; k++) s -= a[j*n + k] * a[j*n + k];
+		if(!(s > 0)) return false;
+		s = sqrt(s);
+		a[j*n + j] = s;
+		for(int i=j+1; i < n; i++){
+			double t = a[i*n + j];
+			for(int k=0; k < j; k++) t -= a[i*n + k] * a[j*n + k];
+			a[i*n + j] = t / s;
+		}
+	}
+	return true;
+	
+}
+
+void vecops::choleskySolve(const double *l, int n, double *x){
+	
+	for(int i=0; i < n; i++){
+		double t = x[i];
+		for(int k=0; k < i; k++) t -= l[i*n + k] * x[k];
+		x[i] = t / l[i*n + i];
+	}
+	for(int i=n-1; i >= 0; i--){
+		double t = x[i];
+		for(int k=i+1; k < n; k++) t -= l[k*n + i] * x[k];
+		x[i] = t / l[i*n + i];
+	}
+	
+}
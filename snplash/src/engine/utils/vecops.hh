@@ -88,6 +88,20 @@ namespace vecops{
 	// This one is still defined in .cpp
 	std::vector<std::vector<double> > getDblVec(int size1, int size2);	
 	
+	/**
+	 * Cholesky factor of the symmetric n x n matrix a (row-major), in place:
+	 * the lower triangle becomes L with a = L L'.  The upper triangle is
+	 * not read.
+	 * 
+	 * @return False if a is not positive definite.
+	 */
+	bool cholesky(double *a, int n);
+	
+	/**
+	 * Solve L L' z = x in place, for the factor from cholesky().
+	 */
+	void choleskySolve(const double *l, int n, double *x);
+	
 }
 
 #endif
@@ -23,8 +23,9 @@
 #include "../linalg/alglibinternal.h"
 #include "../linalg/blas.h"
 
-Zaykin::Zaykin(EngineParamReader *p){
+Zaykin::Zaykin(EngineParamReader *p, LogisticRegression *lr) : ownLr(p->getRegressionConditionNumberThreshold()){
 	params = p;
+	this->lr = (lr != NULL) ? lr : &ownLr;
 	keepThresh = 20;
 	data = 0;
 }
@@ -164,7 +165,6 @@ ZaykinGlobalStatsResults Zaykin::runGlobal(){
 	#if DEBUG_ZAY_PROGRESS
 		cout << "Zaykin start LR portion" << endl;
 	#endif
-	LogisticRegression with(params->getRegressionConditionNumberThreshold()), without(params->getRegressionConditionNumberThreshold());
 	/*
 	 * Run without the haplotypes:
 	 */
@@ -175,14 +175,24 @@ ZaykinGlobalStatsResults Zaykin::runGlobal(){
 	inWithout = cov;
 	inWithout.push_back(ones);
 
+	vector<vector<double> > inWith;
+	inWith = inWithout;
+	for (unsigned int i=0; i < haps.size()-1; i++){ // NOTE: Don't push the very last haplotype.
+		inWith.push_back(haps.at(i));
+	}
+
 	inv_infmatrixWithOut = vecops::getDblVec(inWithout.size() , inWithout.size());
 
 	int retry = 0;
 	double startVal = 0;  // value to start betas with.
 
 	while(retry < 3){
+		// The penalized fits converge where other starting values would not.
+		if(retry == 1 && params->get_firth() && firthGlobal(inWithout, inWith, stats)){
+			return stats;
+		}
 		try{
-			betasWithOut = without.newtonRaphson(inWithout, phenotype, inv_infmatrixWithOut, startVal);
+			betasWithOut = lr->newtonRaphson(inWithout, phenotype, inv_infmatrixWithOut, startVal);
 			break;
 		}catch(NewtonRaphsonFailureEx){
 			handleException(stats, startVal, retry, "Unable to compute reduced model: Newton-Raphson setup failure.");
@@ -192,8 +202,7 @@ ZaykinGlobalStatsResults Zaykin::runGlobal(){
 			handleException(stats, startVal, retry, "Unable to compute reduced model: information matrix was singular.");
 		}catch(ConditionNumberEx err){
 			
-			LogisticRegression lr;
-			int separableVariable = lr.dataIsSeparable(inWithout, phenotype);
+			int separableVariable = lr->dataIsSeparable(inWithout, phenotype);
 			
 			string message;
 			if (separableVariable < 0){
@@ -226,22 +235,20 @@ ZaykinGlobalStatsResults Zaykin::runGlobal(){
 	/*
 	 * Run with the haplotypes:
 	 */
-	vector<vector<double> > inv_infmatrixWith, inWith;
+	vector<vector<double> > inv_infmatrixWith;
 	vector<double> betasWith;
 
-	inWith = inWithout;
-	for (unsigned int i=0; i < haps.size()-1; i++){ // NOTE: Don't push the very last haplotype.
-		inWith.push_back(haps.at(i));
-	}
-
 	inv_infmatrixWith = vecops::getDblVec(inWith.size() , inWith.size());
 
 	retry = 0;
 	startVal = 0;  // value to start betas with.
 
 	while(retry < 3){
+		if(retry == 1 && params->get_firth() && firthGlobal(inWithout, inWith, stats)){
+			return stats;
+		}
 		try{
-			betasWith = with.newtonRaphson(inWith, phenotype, inv_infmatrixWith, startVal);
+			betasWith = lr->newtonRaphson(inWith, phenotype, inv_infmatrixWith, startVal);
 			break;
 		}catch(NewtonRaphsonFailureEx){
 			handleException(stats, startVal, retry, "Unable to compute full model: Newton-Raphson setup failure.");
@@ -251,8 +258,7 @@ ZaykinGlobalStatsResults Zaykin::runGlobal(){
 			handleException(stats, startVal, retry, "Unable to compute full model: information matrix was singular.");
 		}catch(ConditionNumberEx err){
 			
-			LogisticRegression lr;
-			int separableVariable = lr.dataIsSeparable(inWith, phenotype);
+			int separableVariable = lr->dataIsSeparable(inWith, phenotype);
 			
 			stringstream ss;
 			if (separableVariable < 0){
@@ -278,7 +284,7 @@ ZaykinGlobalStatsResults Zaykin::runGlobal(){
 		}
 	}
 
-	double likeRatio =  with.likelihoodRatio(betasWithOut, inWithout, betasWith, inWith, phenotype);
+	double likeRatio =  lr->likelihoodRatio(betasWithOut, inWithout, betasWith, inWith, phenotype);
 	try{
 		stats.pvalue = Statistics::chi2prob(likeRatio, betasWith.size() - betasWithOut.size());
 		stats.testStat = likeRatio;
@@ -340,10 +346,10 @@ ZaykinStatsInfo Zaykin::runLikelihoodRatio(const vector<double> &haps, const vec
 
 	ZaykinStatsInfo stats;
 	vector<vector<double> > testVecWithout = cov;
-	vector<vector<double> > testVecWith; // wait to fill this one.
 	testVecWithout.push_back(ones);
+	vector<vector<double> > testVecWith = testVecWithout;
+	testVecWith.push_back(haps);
 
-	LogisticRegression lrWith, lrWithout;
 	vector<vector<double> > inv_infmatrixWithOut, inv_infmatrixWith;
 	vector<double> betasWith, betasWithOut;
 
@@ -353,8 +359,12 @@ ZaykinStatsInfo Zaykin::runLikelihoodRatio(const vector<double> &haps, const vec
 	double startVal = 0;  // value to start betas with.
 
 	while(retry < 3){
+		// The penalized fits converge where other starting values would not.
+		if(retry == 1 && params->get_firth() && firthLikelihoodRatio(testVecWithout, testVecWith, stats)){
+			return stats;
+		}
 		try{
-			betasWithOut = lrWithout.newtonRaphson(testVecWithout, phenotype, inv_infmatrixWithOut, startVal);
+			betasWithOut = lr->newtonRaphson(testVecWithout, phenotype, inv_infmatrixWithOut, startVal);
 			break;
 		}catch(NewtonRaphsonFailureEx){
 			handleException(stats, startVal, retry, "Unable to compute reduced model in single haplotype test: Newton-Raphson setup failure.");
@@ -364,8 +374,7 @@ ZaykinStatsInfo Zaykin::runLikelihoodRatio(const vector<double> &haps, const vec
 			handleException(stats, startVal, retry, "Unable to compute reduced model in single haplotype test: information matrix was singular.");
 		}catch(ConditionNumberEx){
 			
-			LogisticRegression lr;
-			int separableVariable = lr.dataIsSeparable(testVecWithout, phenotype);
+			int separableVariable = lr->dataIsSeparable(testVecWithout, phenotype);
 			
 			string message;
 			if (separableVariable < 0){
@@ -387,14 +396,14 @@ ZaykinStatsInfo Zaykin::runLikelihoodRatio(const vector<double> &haps, const vec
 	retry = 0;
 	startVal = 0;  // value to start betas with.
 
-	testVecWith = testVecWithout;
-	testVecWith.push_back(haps);
-
 	inv_infmatrixWith = vecops::getDblVec(testVecWith.size() , testVecWith.size());
 
 	while(retry < 3){
+		if(retry == 1 && params->get_firth() && firthLikelihoodRatio(testVecWithout, testVecWith, stats)){
+			return stats;
+		}
 		try{
-			betasWith = lrWith.newtonRaphson(testVecWith, phenotype, inv_infmatrixWith, startVal);
+			betasWith = lr->newtonRaphson(testVecWith, phenotype, inv_infmatrixWith, startVal);
 			break;
 		}catch(NewtonRaphsonFailureEx){
 			handleException(stats, startVal, retry, "Unable to compute full model in single haplotype test: Newton-Raphson setup failure.");
@@ -404,8 +413,7 @@ ZaykinStatsInfo Zaykin::runLikelihoodRatio(const vector<double> &haps, const vec
 			handleException(stats, startVal, retry, "Unable to compute full model in single haplotype test: information matrix was singular.");
 		}catch(ConditionNumberEx){
 			
-			LogisticRegression lr;
-			int separableVariable = lr.dataIsSeparable(testVecWith, phenotype);
+			int separableVariable = lr->dataIsSeparable(testVecWith, phenotype);
 			
 			string message;
 			if (separableVariable < 0){
@@ -424,7 +432,7 @@ ZaykinStatsInfo Zaykin::runLikelihoodRatio(const vector<double> &haps, const vec
 		}
 	}
 
-	stats.chiSqStat = lrWith.likelihoodRatio(betasWithOut, testVecWithout, betasWith, testVecWith, phenotype);
+	stats.chiSqStat = lr->likelihoodRatio(betasWithOut, testVecWithout, betasWith, testVecWith, phenotype);
 	stats.degFree = betasWith.size() - betasWithOut.size();
 	double beta = betasWith.at(betasWith.size() - 1);
 	double stderr = sqrt(inv_infmatrixWith.at(inv_infmatrixWith.size() - 1).at(inv_infmatrixWith.size() - 1));
@@ -522,20 +530,103 @@ void Zaykin::handleException(StatsFillable &stats, double &startVal, int &retry,
 		else if(retry == 2){ startVal = -0.5;}
 		else{
 
-			stringstream ss;
-			string tempS;
-			int tempP;
-			string name1;
-			if (data != 0){
-				(*data).get_map_info(snp, tempS, name1, tempP);
-				ss << "Zaykin for SNP " << name1 << ": " << message << endl;
-			}else{
-				ss << "Zaykin: " << message << endl;
-			}
-
-			Logger::Instance()->writeLine(ss.str());
-	
+			logMessage(message);
 			stats.fillDefault();
 		}
 	}
 }
+
+/**
+ * Write a message about the current SNP to the log.
+ */
+void Zaykin::logMessage(const string &message){
+
+	stringstream ss;
+	string tempS;
+	int tempP;
+	string name1;
+	if (data != 0){
+		(*data).get_map_info(snp, tempS, name1, tempP);
+		ss << "Zaykin for SNP " << name1 << ": " << message << endl;
+	}else{
+		ss << "Zaykin: " << message << endl;
+	}
+
+	Logger::Instance()->writeLine(ss.str());
+}
+
+/**
+ * Fit the reduced and full models with the Firth penalty (--firth), after a
+ * plain fit failed, and compare their penalized likelihoods.
+ *
+ * @param chiSq Returns the penalized likelihood ratio statistic.
+ * @param betasWith, invInfWith Return the fit of the full model.
+ * @return true if both fits worked.
+ */
+bool Zaykin::firthFit(const vector<vector<double> > &without, const vector<vector<double> > &with, double &chiSq,
+	vector<double> &betasWith, vector<vector<double> > &invInfWith){
+
+	vector<vector<double> > invInfWithout = vecops::getDblVec(without.size(), without.size());
+	invInfWith = vecops::getDblVec(with.size(), with.size());
+	double likelihoodWithout;
+	try{
+		lr->firth(without, phenotype, invInfWithout);
+		likelihoodWithout = lr->getFirthLikelihood();
+		betasWith = lr->firth(with, phenotype, invInfWith);
+	}catch(...){
+		return false;
+	}
+
+	chiSq = 2 * (lr->getFirthLikelihood() - likelihoodWithout);
+	if(chiSq < 0) chiSq = 0;
+	return true;
+}
+
+/**
+ * Global test from Firth-penalized fits.
+ *
+ * @return true if it worked; stats then holds the test.
+ */
+bool Zaykin::firthGlobal(const vector<vector<double> > &without, const vector<vector<double> > &with, ZaykinGlobalStatsResults &stats){
+
+	double chiSq;
+	vector<double> betas;
+	vector<vector<double> > invInf;
+	if(!firthFit(without, with, chiSq, betas, invInf)) return false;
+
+	int degFreedom = with.size() - without.size();
+	try{
+		stats.pvalue = Statistics::chi2prob(chiSq, degFreedom);
+	}catch(...){
+		return false;
+	}
+	stats.testStat = chiSq;
+	stats.degFreedom = degFreedom;
+
+	logMessage("Global test: reported the Firth-penalized fit.");
+	return true;
+}
+
+/**
+ * Single haplotype test from Firth-penalized fits.
+ *
+ * @return true if it worked; stats then holds the test.
+ */
+bool Zaykin::firthLikelihoodRatio(const vector<vector<double> > &without, const vector<vector<double> > &with, ZaykinStatsInfo &stats){
+
+	double chiSq;
+	vector<double> betas;
+	vector<vector<double> > invInf;
+	if(!firthFit(without, with, chiSq, betas, invInf)) return false;
+
+	stats.chiSqStat = chiSq;
+	stats.degFree = with.size() - without.size();
+	double beta = betas.at(betas.size() - 1);
+	double stderr = sqrt(invInf.at(invInf.size() - 1).at(invInf.size() - 1));
+	stats.OR = exp(beta);
+	stats.LCI = exp(beta - 1.96*stderr);
+	stats.UCI = exp(beta + 1.96*stderr);
+
+	logMessage("Single haplotype test: reported the Firth-penalized fit.");
+	return true;
+}
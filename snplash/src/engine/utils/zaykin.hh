@@ -94,7 +94,8 @@ class Zaykin {
 	
 	public : 
 	
-		Zaykin(EngineParamReader *p);
+		/* Fits go through lr if given, which must outlive this object; one per thread. */
+		Zaykin(EngineParamReader *p, LogisticRegression *lr = NULL);
 		~Zaykin();
 		
 		void setup(const vector<EMPersonalProbsResults>  &, int numHaps, bool reweight);
@@ -118,6 +119,8 @@ class Zaykin {
 	protected : 
 	
 		const EngineParamReader *params;
+		LogisticRegression ownLr;
+		LogisticRegression *lr; // Shared or ownLr.
 	
 		vector<double> phenotype;
 		vector<vector<double> > cov;	
@@ -133,6 +136,12 @@ class Zaykin {
 		void prepHaplotypes(vector<double> &ones, vector<vector<double> > &haps);
 		ZaykinStatsInfo runLikelihoodRatio(const vector<double> &haps, const vector<double> &ones);
 
+		/* --firth: penalized fits of the reduced and full models after a plain fit failed. */
+		bool firthFit(const vector<vector<double> > &without, const vector<vector<double> > &with, double &chiSq,
+			vector<double> &betasWith, vector<vector<double> > &invInfWith);
+		bool firthGlobal(const vector<vector<double> > &without, const vector<vector<double> > &with, ZaykinGlobalStatsResults &stats);
+		bool firthLikelihoodRatio(const vector<vector<double> > &without, const vector<vector<double> > &with, ZaykinStatsInfo &stats);
+
 		int keepThresh;
 
 		// Error data:
@@ -140,6 +149,7 @@ class Zaykin {
 		int numCovariates;
 		DataAccess *data;
 		void handleException(StatsFillable &stats, double &startVal, int &retry, const string &message);
+		void logMessage(const string &message);
 };
 
 #endif
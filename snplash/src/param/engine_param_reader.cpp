@@ -37,17 +37,25 @@ EngineParamReader::EngineParamReader(){
 	dprime_smartpairs = false;
 	dprime_fmt = 3;
 	dprime_window = -1;
+	report_p = -1;
+	report_r2 = -1;
+	report_top = 0;
+	checkpoint_minutes = 10;
+	resume = false;
 	
 	snpgwa_dohaptest = true;
 	
 	output_haplo = output_geno = output_hwe = false;
 	output_val = false;
+	snp_block = 0;
+	score_p = -1;
 	
 	dandelion_pprob = false;
 	haplo_thresh = -1;
 	dandelion_window = -1;
 	
 	regression_condition_threshold = 1e12;
+	firth = false;
 }
 
 void EngineParamReader::read_parameters(vector<string> *params){
@@ -159,6 +167,8 @@ void EngineParamReader::read_parameters(vector<string> *params){
 				int j = atoi(token.c_str());
 				regression_condition_threshold = j;
 			}
+		}else if(token.compare("--firth") == 0){
+			firth = true;
 		}else if(token.compare("--dprime_window") == 0){
 			i++;
 			if(i >= params->size()){
@@ -179,6 +189,56 @@ void EngineParamReader::read_parameters(vector<string> *params){
 				int j = atoi(token.c_str());
 				dprime_fmt = j;
 			}
+		}else if(token.compare("--report_p") == 0){
+			i++;
+			if(i >= params->size()){
+				cerr << "Expected --report_p <number>" << endl;
+				bad_start = true;
+			}else{
+				token = params->at(i);
+				report_p = atof(token.c_str());
+			}
+		}else if(token.compare("--report_r2") == 0){
+			i++;
+			if(i >= params->size()){
+				cerr << "Expected --report_r2 <number>" << endl;
+				bad_start = true;
+			}else{
+				token = params->at(i);
+				report_r2 = atof(token.c_str());
+			}
+		}else if(token.compare("--top") == 0){
+			i++;
+			if(i >= params->size()){
+				cerr << "Expected --top <int>" << endl;
+				bad_start = true;
+			}else{	// Get an integer
+				token = params->at(i);
+				int j = atoi(token.c_str());
+				if(j <= 0){
+					bad_start = true;
+					cerr << "--top must be positive.  Received " << token << endl;
+				}else{
+					report_top = j;
+				}
+			}
+		}else if(token.compare("--checkpoint") == 0){
+			i++;
+			if(i >= params->size()){
+				cerr << "Expected --checkpoint <minutes>" << endl;
+				bad_start = true;
+			}else{	// Get an integer
+				token = params->at(i);
+				int j = atoi(token.c_str());
+				if(j < 0){
+					bad_start = true;
+					cerr << "--checkpoint must not be negative.  Received " << token << endl;
+				}else{
+					checkpoint_minutes = j;
+				}
+			}
+		}else if(token.compare("--resume") == 0){
+			resume = true;
 		}else if(token.compare("--dandelion_window") == 0){
 			i++;
 			if(i >= params->size()){
@@ -199,6 +259,30 @@ void EngineParamReader::read_parameters(vector<string> *params){
 				int j = atoi(token.c_str());
 				haplo_thresh = j;
 			}
+		}else if(token.compare("--block") == 0){
+			i++;
+			if(i >= params->size()){
+				cerr << "Expected --block <int>" << endl;
+				bad_start = true;
+			}else{	// Get an integer
+				token = params->at(i);
+				int j = atoi(token.c_str());
+				if(j <= 0){
+					bad_start = true;
+					cerr << "Block size must be positive.  Received " << token << endl;
+				}else{
+					snp_block = j;
+				}
+			}
+		}else if(token.compare("--score_p") == 0){
+			i++;
+			if(i >= params->size()){
+				cerr << "Expected --score_p <number>" << endl;
+				bad_start = true;
+			}else{
+				token = params->at(i);
+				score_p = atof(token.c_str());
+			}
 		}else if(token.compare("--dandelion_pprob") == 0){
 			dandelion_pprob = true;
 		}else if(token.compare("--threshold") == 0){
@@ -53,6 +53,15 @@ class EngineParamReader {
 		bool get_dprime_smartpairs() const {return dprime_smartpairs;}
 		int get_dprime_fmt() const {return dprime_fmt;}
 		int get_dprime_window() const {return dprime_window;}
+
+		double get_report_p() const {return report_p;}
+		double get_report_r2() const {return report_r2;}
+		int get_report_top() const {return report_top;}
+		/* True if only selected pairs are written rather than all of them. */
+		bool get_report_pairs() const {return report_p >= 0 || report_r2 >= 0 || report_top > 0;}
+
+		int get_checkpoint_minutes() const {return checkpoint_minutes;}
+		bool get_resume() const {return resume;}
 		
 		bool get_snpgwa_dohap() const {return snpgwa_dohaptest;}
 		bool get_output_val() const {return output_val;}
@@ -61,11 +70,16 @@ class EngineParamReader {
 		bool get_output_hwe() const {return output_hwe;}
 		
 		int get_haplo_thresh() const {return haplo_thresh;}
+		int get_snp_block() const {return snp_block;}
+		/* SNPGWA: fit the logistic models only where a score test p-value is below this.  Negative for always. */
+		double get_score_p() const {return score_p;}
 		
 		bool get_dandelion_pprob() const {return dandelion_pprob;}
 		int get_dandelion_window() const {return dandelion_window;}
 		
 		double getRegressionConditionNumberThreshold() const {return regression_condition_threshold;}
+		/* Refit logistic models that fail with the Firth penalty rather than retrying them. */
+		bool get_firth() const {return firth;}
 		
 	protected :
 
@@ -87,6 +101,15 @@ class EngineParamReader {
 		bool dprime_smartpairs;
 		int dprime_fmt;
 		int dprime_window;
+
+		// intertwolog and dprime pair reporting.  Negative or 0 is off.
+		double report_p;
+		double report_r2;
+		int report_top;
+
+		// intertwolog and dprime checkpoints.
+		int checkpoint_minutes; // 0 for none.
+		bool resume;
 		
 		//snpgwa and qsnpgwa
 		bool snpgwa_dohaptest;
@@ -94,6 +117,8 @@ class EngineParamReader {
 		bool output_val; // if true, make output file with test stat values.
 
 		bool output_geno, output_haplo, output_hwe;
+		int snp_block; // SNPs read at a time.  0 reads them all up front.
+		double score_p; // Score test screen for the logistic models; negative for none.
 
 		// Dandelion
 		bool dandelion_pprob;
@@ -104,6 +129,7 @@ class EngineParamReader {
 		/// Stats engines
 		// This is a 1-norm threshold.
 		double regression_condition_threshold;
+		bool firth;
 
 		// Methods
 		bool check_necessary();
@@ -54,6 +54,10 @@ ParamReader::ParamReader(){
 	file_type = ARFF;
 	
 	missing_ignore = false;
+	memory_map = false;
+	compress_output = false;
+	column_output = false;
+	cache_file = "none";
 	
 }
 
@@ -110,6 +114,14 @@ bool ParamReader::process_parameters(int argc, char * argv[]){
 			bad_start = bad_start || resolve_single_int(argc, i, this->verbosity, token, argv);
 		}else if(token.compare("-ign") == 0){
 			missing_ignore = true;
+		}else if(token.compare("-mmap") == 0){
+			memory_map = true;
+		}else if(token.compare("-gz") == 0){
+			compress_output = true;
+		}else if(token.compare("-col") == 0){
+			column_output = true;
+		}else if(token.compare("-cache") == 0){
+			bad_start = bad_start || resolve_single_string(argc, i, this->cache_file, token, argv);
 		}else if(token.compare("-engine") == 0){
 			i++;
 			if(i >= argc){
@@ -307,11 +319,14 @@ void ParamReader::print_usage(){
 	ss << endl;
 	ss << "For binary input documents:" << endl;
 	ss << "    -bed <geno file>      Input file for genetic data in Plink format v0.991 or later." << endl;
+	ss << "    -mmap                 Map the .bed file into memory instead of reading it.  Genotypes are used in place." << endl;
 	ss << "    -phen <phenotype file> The phenotype input file." << endl;
 	ss << "    -map <map file>        Contains information about the SNPs." << endl;
 	ss << endl;
 	ss << endl;
 	ss << "    -out <output file>     The primary output file.  Some engines may create several files by appending extra information." << endl;
+	ss << "    -gz                    Compress the result files with gzip.  Each file name gets .gz added." << endl;
+	ss << "    -col                   Write the main SNPGWA or INTERTWOLOG results to <output file>.col, a binary column file, instead of the text table." << endl;
 	ss << endl;
 	ss << "    -trait <string>    An element of the header in the phenotype file.  Optional, with the default being the second column in the phenotype file." << endl;
 	ss << "    -cov <string,string,...,string>    An arbitrary number of covariates from the phenotype file.  Note that they should be comma separated."  << endl;
@@ -323,6 +338,8 @@ void ParamReader::print_usage(){
 	ss << endl;
 	ss << "    -v <1,2, or 3>    The amount of printing to perform.  Not supported by all engines.  Primarily intended for use with machine learning engines." << endl;
 	ss << "    -ign              If passed, any individuals with missing data in any SNP are excluded from the data set." << endl;
+	ss << "    -cache <file>     Keep the cleaned data set in <file>.  Later runs of the same engine on the same input load it" << endl;
+	ss << "                      instead of reading and cleaning the input again.  It is rebuilt when the input or options change." << endl;
 	
 	ss << endl << endl << "    -engine <adtree | bagging | snpgwa | qsnpgwa | dprime | dandelion > " << endl;
 	
@@ -332,6 +349,8 @@ void ParamReader::print_usage(){
 	ss << endl;
 	ss << "     --condition_number <number>    Maximum allowable condition number in logistic and linear regression." << endl;
 	ss << "                               Condition number is measured in the 1-norm. Default is 1e12" << endl;
+	ss << "     --firth          SNPGWA, INTERTWOLOG and the haplotype tests: when a logistic model is separated or" << endl;
+	ss << "                      does not converge, report the Firth-penalized fit instead of retrying and giving up." << endl;
 	ss << endl;
 	ss << "ADTree" << endl;
 	ss << "     --nodes <int>     The number of nodes to include in the tree" << endl;
@@ -347,6 +366,11 @@ void ParamReader::print_usage(){
 	ss << "     --snpgwa_nohap  If present, haplotype tests are not computed.  This saves run time." << endl;
 	ss << "     --haplo_thresh <int> If present, sets the threshold number of chromosomes on which a haplotype" << endl;
 	ss << "                          must exist to be used for global haplotype association testing." << endl;
+	ss << "     --block <int>   SNPGWA and QSNPGWA: with -bed input, read the genotypes <int> SNPs at a time" << endl;
+	ss << "                     rather than all at once.  Memory use is bounded by the block size." << endl;
+	ss << "     --score_p <number> SNPGWA: score test every SNP against the covariates-only model and fit the" << endl;
+	ss << "                     logistic models only for SNPs with a score p-value below <number>.  The other" << endl;
+	ss << "                     SNPs report the score tests, with odds ratios from one Newton step." << endl;
 	ss << endl;
 	ss << "DANDELION " << endl;
 	ss << "     --dandelion_pprob  If present, create a file <outfile>.pprob and list each individual's personal probability of having each possible haplotype.  " << endl;
@@ -356,6 +380,16 @@ void ParamReader::print_usage(){
 	ss << "     --dprime_window <int> Specify the window around each SNPs on which we should compute LD on SNP pairs  " << endl;
 	ss << "     --dprime_fmt <int> Output format. These mimic the old dprime." << endl;
 	ss << "     --dprime_smartpairs <int> Only compute dprime on SNP pairs from the same chromosome. " << endl;
+	ss << "     --report_r2 <number> Only write pairs with r^2 above <number>." << endl;
+	ss << "     --top <int>      Only write the <int> pairs with the largest r^2 (after --report_r2), largest first." << endl;
+	ss << "     --checkpoint <int> Record progress in <outfile>.ckpt every <int> minutes (default 10, 0 for never)." << endl;
+	ss << "     --resume         Continue a run that was stopped, from its checkpoint.  Use the same options." << endl;
+	ss << endl;
+	ss << "INTERTWOLOG " << endl;
+	ss << "     --report_p <number> Only write pairs with an interaction p-value below <number>." << endl;
+	ss << "     --top <int>      Only write the <int> pairs with the smallest p-values (after --report_p), smallest first." << endl;
+	ss << "     --checkpoint <int> Record progress in <outfile>.ckpt every <int> minutes (default 10, 0 for never)." << endl;
+	ss << "     --resume         Continue a run that was stopped, from its checkpoint.  Use the same options." << endl;
 	ss << "Send bug reports, including your computer's operating system, the full command line, and any additional information to dmcwilli@wfubmc.edu" << endl;
 	cout << ss.str();
 }
@@ -449,7 +483,9 @@ bool ParamReader::resolve_engine_params(int argc, int &i, string token, char *ar
 		token.compare("--bagthresh") == 0 || token.compare("--method") == 0 || token.compare("--partition") == 0 ||
 		token.compare("--dprime_fmt") == 0 || token.compare("--dprime_window") == 0 || 
 		token.compare("--haplo_thresh") == 0 || token.compare("--dandelion_window") == 0
-		|| token.compare("--condition_number") == 0){
+		|| token.compare("--condition_number") == 0 || token.compare("--block") == 0
+		|| token.compare("--report_p") == 0 || token.compare("--report_r2") == 0 || token.compare("--top") == 0
+		|| token.compare("--checkpoint") == 0 || token.compare("--score_p") == 0){
 		engine_specific_params.push_back(token);
 		i++;
 		if(i >= argc){
@@ -459,7 +495,7 @@ bool ParamReader::resolve_engine_params(int argc, int &i, string token, char *ar
 			engine_specific_params.push_back(argv[i]);
 		}
 	}else if(token.compare("--dprime_smartpairs") == 0 || token.compare("--snpgwa_nohap") == 0
-				|| token.compare("--val") == 0
+				|| token.compare("--val") == 0 || token.compare("--resume") == 0 || token.compare("--firth") == 0
 				|| token.compare("--dandelion_pprob") == 0 || token.compare("--geno_file") == 0
 				|| token.compare("--haplo_file") == 0 || token.compare("--hwe_file") == 0){
 		engine_specific_params.push_back(argv[i]);
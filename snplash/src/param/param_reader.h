@@ -96,8 +96,13 @@ class ParamReader {
 		
 		
 		bool get_ign(){return missing_ignore;}
+		bool get_mmap(){return memory_map;}
+		bool get_compress_output(){return compress_output;}
+		bool get_column_output(){return column_output;}
+		string get_cache_file(){return cache_file;}
 
 		vector<string> get_covariates(){return covariates;}
+		const vector<int> &get_skip_cols() const {return skip_cols;}
 
 		int get_begin() {return begin;}
 		
@@ -157,6 +162,10 @@ class ParamReader {
 		
 		/// Data information
 		bool missing_ignore;
+		bool memory_map; // Map binary input rather than read it.
+		bool compress_output; // gzip the result files.
+		bool column_output; // main results as a column file.
+		string cache_file; // Snapshot of the cleaned data.  init to "none"
 
 		/// Data localization parameters
 		int begin, end;  // Start and end of the data we want to use.  (1 based)
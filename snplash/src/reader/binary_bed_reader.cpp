@@ -1,14 +1,24 @@
 #include "binary_bed_reader.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define DBG_PROGRESS 0
 
 BinaryBedReader::BinaryBedReader(){
-	
+	stream_in = NULL;
+	stream_first_row = 0;
+	stream_people = 0;
 }
 
-BinaryBedReader::~BinaryBedReader(){}
+BinaryBedReader::~BinaryBedReader(){
+	if(stream_in != NULL){
+		fclose(stream_in);
+	}
+}
 
 /** process()
  *
@@ -21,18 +31,116 @@ void BinaryBedReader::process(SnpData *data, ParamReader *params){
 		
 	this->getPhenotype(data, params);
 	
-	// Create a vector per person.
-	long l = data->numIndividuals();
-	for(long i=0;i<l;i++){
-		vector<short> vec;
-		data->snp_data.push_back(vec);
-	}
-	
 #if DBG_PROGRESS
-	cout << "Binary reader has " << l << " individuals." << endl;
+	cout << "Binary reader has " << data->numIndividuals() << " individuals." << endl;
 #endif
 	
-	this->getBedFile(data, params);
+	if(params->get_mmap()){
+		this->getMappedBedFile(data, params);
+	}else{
+		this->getBedFile(data, params);
+	}
+	finishRead(data, params);
+}
+
+/** open_stream()
+ *
+ * Read phenotypes and map but leave the genotypes in the file.  The
+ * genotype matrix gets its full shape with no rows; read_block() brings
+ * the rows in a block of SNPs at a time.  The file stays open until the
+ * reader is deleted.
+ *
+ * @return true.  Binary input can always be streamed.
+ */
+bool BinaryBedReader::open_stream(SnpData *data, ParamReader *params){
+
+	this->getPhenotype(data, params);
+
+	stream_in = openBedFile(params);
+	stream_people = data->numIndividuals();
+
+	fseek(stream_in, 0, SEEK_END);
+	long numRows = bedRows(ftell(stream_in), stream_people);
+
+	long numKept;
+	bedWindow(numRows, params, stream_first_row, numKept);
+	data->genotypes.stream(numKept, stream_people);
+
+	finishRead(data, params);
+	return true;
+}
+
+/** read_block()
+ *
+ * Make SNPs first..first+count-1 resident.  The rows are contiguous in the
+ * file, so the block is read with a single call.  Individuals removed since
+ * open_stream() are dropped as the rows are copied in.  SNPs in the block
+ * that are missing on everyone are flagged as the block is read.
+ *
+ * @param data Data set opened with open_stream()
+ * @param first First SNP in the block
+ * @param count Number of SNPs in the block
+ */
+void BinaryBedReader::read_block(SnpData *data, unsigned long first, unsigned long count){
+
+	long stride = (stream_people + 3) / 4;
+	long rowBytes = data->genotypes.stride();
+	const vector<unsigned int> &source = data->genotypes.source_columns();
+	unsigned char *rows = data->genotypes.load_block(first, count);
+	if(count == 0 || stride == 0){
+		return;
+	}
+
+	// With everyone kept, read straight into the matrix.
+	bool direct = static_cast<long>(source.size()) == stream_people;
+	unsigned char *in = rows;
+	if(!direct){
+		stream_buffer.resize(count * stride);
+		in = &stream_buffer[0];
+	}
+
+	fseek(stream_in, 3 + (stream_first_row - 1 + first) * stride, SEEK_SET);
+	if(fread(in, sizeof(unsigned char), count * stride, stream_in) != count * stride){
+		cerr << "Error in row " << stream_first_row + first << ": file ended early." << endl << "Aborting." << endl;
+		exit(0);
+	}
+
+	for(unsigned long i=0; i < count; i++){
+		const unsigned char *src = in + i * stride;
+		if(!goodPadding(src, stream_people)){
+			cerr << "Error in row " << stream_first_row + first + i << " end of row expected but not found." << endl << "Aborting." << endl;
+			exit(0);
+		}
+		if(direct){
+			continue;
+		}
+		unsigned char *dst = rows + i * rowBytes;
+		for(unsigned int q=0; q < source.size(); q++){
+			unsigned int p = source[q];
+			dst[q >> 2] |= ((src[p >> 2] >> ((p & 3) << 1)) & 3) << ((q & 3) << 1);
+		}
+	}
+
+	data->check_missing_geno(first, count);
+}
+
+/** prefetch_block()
+ *
+ * Ask the kernel to start reading a block that will be wanted next.  The
+ * read happens in the background while the current block is processed.
+ */
+void BinaryBedReader::prefetch_block(unsigned long first, unsigned long count){
+	if(stream_in == NULL){
+		return;
+	}
+	long stride = (stream_people + 3) / 4;
+	posix_fadvise(fileno(stream_in), 3 + (stream_first_row - 1 + first) * stride, count * stride, POSIX_FADV_WILLNEED);
+}
+
+/**
+ * Everything but the genotypes and phenotypes: map file and final checks.
+ */
+void BinaryBedReader::finishRead(SnpData *data, ParamReader *params){
 	// don't need to verify this forever but for now, yes.
 	// Take out if we implement map based readin.
 	data->verify_data_size_match();
@@ -43,7 +151,7 @@ void BinaryBedReader::process(SnpData *data, ParamReader *params){
 		this->getMapFile(data, params);
 	}else{
 		// Build a dummy map file.
-		for(unsigned long i=0; i < data->snp_data.at(0).size(); i++){
+		for(long i=0; i < data->numSnps(); i++){
 			stringstream ss;
 			ss << i+params->get_begin();
 			data->push_map("0",ss.str(),0);
@@ -59,16 +167,99 @@ void BinaryBedReader::process(SnpData *data, ParamReader *params){
  */
 void BinaryBedReader::getBedFile(SnpData *data, ParamReader *params){
 
+	FILE *in = openBedFile(params);
+
+#if DBG_PROGRESS
+	cout << "Binary reader ready to start." << endl;
+#endif
+
+	// Rows in the .bed file use the same packing as the genotype matrix,
+	// so each SNP row in the window is copied in directly.
+	long numPeople = data->numIndividuals();
+	long stride = (numPeople + 3) / 4;
+
+	fseek(in, 0, SEEK_END);
+	long numRows = bedRows(ftell(in), numPeople);
+	fseek(in, 3, SEEK_SET);
+
+	long firstRow, numKept;
+	bedWindow(numRows, params, firstRow, numKept);
+
+	data->genotypes.resize(numKept, numPeople);
+	if(numKept == 0){
+		fclose(in);
+		return;
+	}
+
+	// Rows are independent once the stride is known, so blocks of rows are
+	// read and checked in parallel with positioned reads.
+	unsigned char *rows = data->genotypes.mutable_row(0);
+	int fd = fileno(in);
+	long numChunks = (numKept + BED_CHUNK_ROWS - 1) / BED_CHUNK_ROWS;
+	long shortRow = numKept;	// First row that could not be read.
+	long badRow = numKept;		// First row with bad padding.
+
+	#if RUN_IN_PARALLEL_BED
+	#pragma omp parallel for schedule(dynamic)
+	#endif
+	for(long chunk = 0; chunk < numChunks; chunk++){
+		long start = chunk * BED_CHUNK_ROWS;
+		long count = min(static_cast<long>(BED_CHUNK_ROWS), numKept - start);
+		unsigned char *dst = rows + start * stride;
+		size_t want = count * stride;
+		off_t offset = 3 + (firstRow - 1 + start) * stride;
+
+		size_t got = 0;
+		while(got < want){
+			ssize_t n = pread(fd, dst + got, want - got, offset + got);
+			if(n <= 0) break;
+			got += n;
+		}
+
+		long localShort = numKept, localBad = numKept;
+		if(got < want){
+			localShort = start + got / stride;
+			count = got / stride;
+		}
+		for(long r = 0; r < count; r++){
+			if(!goodPadding(dst + r * stride, numPeople)){
+				localBad = start + r;
+				break;
+			}
+		}
+
+		#if RUN_IN_PARALLEL_BED
+		#pragma omp critical
+		#endif
+		{
+			shortRow = min(shortRow, localShort);
+			badRow = min(badRow, localBad);
+		}
+	}
+
+	fclose(in);
+
+	if(badRow < numKept && badRow < shortRow){
+		cerr << "Error in row " << badRow + firstRow << " end of row expected but not found." << endl << "Aborting." << endl;
+		exit(0);
+	}
+	if(shortRow < numKept){
+		cerr << "Error in row " << shortRow + firstRow << ": file ended early." << endl << "Aborting." << endl;
+		exit(0);
+	}
+}
+
+/**
+ * Open a .bed file and check its 3-byte header.  Aborts on error.
+ *
+ * @return The file, positioned after the header.
+ */
+FILE *BinaryBedReader::openBedFile(ParamReader *params){
+
 	char file_buffer[4];
 
-	FILE *in;
-	
-	//long minSnp = params->get_begin();
-	//long maxSnp = params->get_end();
-	
-	
 	// Open file (rb for read binary)
-	in = fopen(params->get_binary_geno_file().c_str(), "rb");
+	FILE *in = fopen(params->get_binary_geno_file().c_str(), "rb");
 	if(in == NULL){
 		cerr << "Error opening file " << params->get_linkage_geno_file() << endl;
 		exit(0);
@@ -88,75 +279,146 @@ void BinaryBedReader::getBedFile(SnpData *data, ParamReader *params){
 		cerr << "File is not SNP-major format" << params->get_linkage_geno_file() << endl;
 		exit(0);
 	}
+	return in;
+}
 
-#if DBG_PROGRESS
-	cout << "Binary reader ready to start." << endl;
-#endif
+/**
+ * Apply the -beg/-end window to a file with numRows SNPs.
+ *
+ * @param numRows Number of SNP rows in the file
+ * @param params Parameters
+ * @param firstRow Set to the first row wanted (from 1)
+ * @param numKept Set to the number of rows wanted
+ */
+void BinaryBedReader::bedWindow(long numRows, ParamReader *params, long &firstRow, long &numKept){
+	firstRow = params->get_begin();
+	long lastRow = numRows;
+	if(params->get_end() < lastRow) lastRow = params->get_end();
+	numKept = lastRow - firstRow + 1;
+	if(numKept < 0) numKept = 0;
+}
 
-	// Read SNP 1 for all people, SNP2 for all people, etc (SNP-major mode)
-	int personCntr = 0;
-	short t; // hold the new bits.
-	char c;
-	long rowCntr=1;
-	while (fread(file_buffer, sizeof(char), 1, in) > 0){
-	
-		c = file_buffer[0];
-		t = c & 0x3;
-		if (params->in_window(rowCntr))
-			data->get_column(personCntr++)->push_back(binToCode(t));
-		// These lines ensure that the rest of the byte is discarded if the
-		// byte includes a row end. Check for all zeros for sanity.
-		if (personCntr == data->numIndividuals()){
-			
-			if ((c & 0xFC) != 0){
-				cerr << "Error in row " << rowCntr << " col 1 end of row expected but not found." << endl << "Aborting." << endl;
-				exit(0);
-			}
-			personCntr = 0;
-			rowCntr++;
-			continue;
-		}
-		
-		t = (c & 0xc) >> 2;
-		if (params->in_window(rowCntr))
-			data->get_column(personCntr++)->push_back(binToCode(t));
-		if (personCntr == data->numIndividuals()){
-			
-			if ((c & 0xf0) != 0){
-				cerr << "Error in row " << rowCntr << " col 2 end of row expected but not found." << endl << "Aborting." << endl;
-				exit(0);
-			}
-			personCntr = 0;
-			rowCntr++;
-			continue;
-		}
-		
-		
-		t = (c & 0x30) >> 4;
-		if (params->in_window(rowCntr))
-			data->get_column(personCntr++)->push_back(binToCode(t));
-		if (personCntr == data->numIndividuals()){
-			if ((c & 0xCF) != 0){
-				cerr << "Error in row " << rowCntr << " col 3 end of row expected but not found." << endl << "Aborting." << endl;
-				exit(0);
+/**
+ * Number of SNP rows in a .bed file.  Aborts if the bytes after the header
+ * are not a whole number of rows for numPeople individuals.
+ *
+ * @param length Size of the file, header included
+ * @param numPeople Individuals in the file
+ * @return The number of rows
+ */
+long BinaryBedReader::bedRows(long long length, long numPeople){
+	long stride = (numPeople + 3) / 4;
+	if(stride == 0){
+		return 0;
+	}
+	long numRows = (length - 3) / stride;
+	if((length - 3) % stride != 0){
+		cerr << "Error in row " << numRows + 1 << ": file ended early." << endl << "Aborting." << endl;
+		exit(0);
+	}
+	return numRows;
+}
+
+/**
+ * Padding bits in the last byte of each row must be zero.
+ *
+ * @param row Packed row from the file
+ * @param numPeople Individuals in the file
+ * @return false if the padding is not zero.
+ */
+bool BinaryBedReader::goodPadding(const unsigned char *row, long numPeople){
+	if(numPeople % 4 == 0){
+		return true;
+	}
+	unsigned char pad_mask = static_cast<unsigned char>(0xFF << ((numPeople % 4) * 2));
+	return (row[(numPeople + 3) / 4 - 1] & pad_mask) == 0;
+}
+
+/** getMappedBedFile()
+ *
+ * Map the .bed file rather than reading it.  The genotype matrix uses the
+ * .bed row layout, so the mapped rows are handed to it directly: there is no
+ * copy and no decoding.  The -beg/-end window is an offset into the mapping.
+ *
+ * The rows stay in the page cache and are shared with any other process
+ * reading the same file.  They are copied only if the data is later changed
+ * (for example by removing individuals with missing phenotype).
+ */
+void BinaryBedReader::getMappedBedFile(SnpData *data, ParamReader *params){
+
+	int fd = open(params->get_binary_geno_file().c_str(), O_RDONLY);
+	if(fd < 0){
+		cerr << "Error opening file " << params->get_binary_geno_file() << endl;
+		exit(0);
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < 3){
+		cerr << "Error reading file" << params->get_binary_geno_file() << ": please check path and file size." << endl;
+		exit(0);
+	}
+	size_t length = static_cast<size_t>(st.st_size);
+
+	void *mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // The mapping keeps its own reference to the file.
+	if(mapping == MAP_FAILED){
+		cerr << "Unable to map file " << params->get_binary_geno_file() << " into memory." << endl;
+		exit(0);
+	}
+
+	// Check the 3-byte header.
+	const unsigned char *bytes = static_cast<const unsigned char *>(mapping);
+	if (bytes[0] != 108 || bytes[1] != 27){
+		cerr << "File is not binary .bed format" << params->get_binary_geno_file() << endl;
+		exit(0);
+	}
+	if(bytes[2] != 1){
+		cerr << "File is not SNP-major format" << params->get_binary_geno_file() << endl;
+		exit(0);
+	}
+
+	long numPeople = data->numIndividuals();
+	long stride = (numPeople + 3) / 4;
+	long numRows = bedRows(length, numPeople);
+
+	long firstRow, numKept;
+	bedWindow(numRows, params, firstRow, numKept);
+	const unsigned char *rows = bytes + 3 + (firstRow - 1) * stride;
+
+	// The same check as a read: a .bed that does not match the .fam shows
+	// up as padding that is not zero.  Only the last byte of each row is
+	// touched.
+	long numChunks = (numKept + BED_CHUNK_ROWS - 1) / BED_CHUNK_ROWS;
+	long badRow = numKept;		// First row with bad padding.
+
+	#if RUN_IN_PARALLEL_BED
+	#pragma omp parallel for schedule(dynamic)
+	#endif
+	for(long chunk = 0; chunk < numChunks; chunk++){
+		long start = chunk * BED_CHUNK_ROWS;
+		long count = min(static_cast<long>(BED_CHUNK_ROWS), numKept - start);
+		long localBad = numKept;
+		for(long r = start; r < start + count; r++){
+			if(!goodPadding(rows + r * stride, numPeople)){
+				localBad = r;
+				break;
 			}
-			rowCntr++;
-			personCntr = 0;
-			continue;
 		}
-		
-		
-		t = (c & 0xc0) >> 6;
-		if (params->in_window(rowCntr))
-			data->get_column(personCntr++)->push_back(binToCode(t));
-		if (personCntr == data->numIndividuals()){
-			personCntr = 0;
-			rowCntr++;
-			continue;
 
+		#if RUN_IN_PARALLEL_BED
+		#pragma omp critical
+		#endif
+		{
+			badRow = min(badRow, localBad);
 		}
 	}
 
+	if(badRow < numKept){
+		cerr << "Error in row " << badRow + firstRow << " end of row expected but not found." << endl << "Aborting." << endl;
+		exit(0);
+	}
+
+	data->genotypes.attach(mapping, length, rows, numKept, numPeople);
 }
 
 /** getPhenotype()
@@ -182,7 +444,7 @@ void BinaryBedReader::getPhenotype(SnpData *data, ParamReader *params){
 	vector<int> cov_pos;
 	vector<int>::iterator it;
 
-	vector<double> *cov_vec = new vector<double>;
+	vector<double> cov_rows; // Covariates, one individual after another.
 
 	infile.open(params->get_linkage_pheno_file().c_str(), ifstream::in);
 	if(! infile.is_open()){
@@ -243,15 +505,14 @@ void BinaryBedReader::getPhenotype(SnpData *data, ParamReader *params){
 			t = numeric_limits<double>::max();
 		}
 		data->phenotypes.push_back(t);
-		// Add covariace
-		data->covariance.push_back(*(cov_vec));
+		// Add covariates
 		for(it = cov_pos.begin(); it != cov_pos.end(); it++){
 			t = atof(line.at(*(it)).c_str());
 			s = line.at(*(it));
 			if( s.compare(".") == 0 ){
 				t = numeric_limits<double>::max();
 			}
-			data->covariance.at(data->covariance.size() - 1).push_back(t);
+			cov_rows.push_back(t);
 		}
 
 		if(order_in_file.count(line.at(1)) > 0){
@@ -263,7 +524,7 @@ void BinaryBedReader::getPhenotype(SnpData *data, ParamReader *params){
 		order_in_file[line.at(0)] = line_no++;
 	}
 	infile.close();
-	delete cov_vec;
+	data->covariates.assign_rows(cov_rows, data->phenotypes.size(), cov_pos.size());
 
 }
 
@@ -6,8 +6,13 @@
  *  Expects there to be a linkage formatted parameter file.
  */
 
+#define RUN_IN_PARALLEL_BED 1
+// Rows read by one thread at a time.
+#define BED_CHUNK_ROWS 4096
+
 #include "reader.h"
 #include <map>		// Used to order individuals.
+#include <stdio.h>
 
 using namespace std;
 
@@ -18,39 +23,32 @@ public:
 	~BinaryBedReader();
 	virtual void process(SnpData *, ParamReader *);
 
+	virtual bool open_stream(SnpData *, ParamReader *);
+	virtual void read_block(SnpData *, unsigned long, unsigned long);
+	virtual void prefetch_block(unsigned long, unsigned long);
+
 private:
 
 	map<string, int> order_in_file;
+
+	// Open .bed file while streaming.
+	FILE *stream_in;
+	long stream_first_row;  // File row of SNP 0.
+	long stream_people;     // Individuals in the file.
+	vector<unsigned char> stream_buffer;
+
+	FILE *openBedFile(ParamReader *);
+	long bedRows(long long, long);
+	void bedWindow(long, ParamReader *, long &, long &);
+	void finishRead(SnpData *, ParamReader *);
+	bool goodPadding(const unsigned char *, long);
 	void getBedFile(SnpData *, ParamReader *);
+	void getMappedBedFile(SnpData *, ParamReader *);
 	void getPhenotype(SnpData *, ParamReader *);
 	void getMapFile(SnpData *, ParamReader *);
 	
 	void verify_phen_header(int, vector<int> *, vector<string> *, ParamReader *);
 
-	// Translate the Plink encoding to our encoding.
-	inline 
-	int binToCode(int t){
-		// Note: I am doing an implicit bit reversal.
-		// See http://pngu.mgh.harvard.edu/~purcell/plink/binary.shtml for encoding.
-		if (t == 0){
-			// homozygous major/major
-			return 1;
-		}else if (t == 2){
-			// hetero
-			return 2;
-		}else if (t == 1){
-			// missing
-			return 0;
-		}else if (t == 3){
-			// homo minor/minor
-			return 4;
-		}else{
-			// PROBLEM
-			cerr << "Corrupt bed file. Can not read. Aborting." << endl;
-			exit(0);
-		}
-	}
-
 };
 
 #endif
@@ -1,4 +1,9 @@
 #include "linkage_reader.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 LinkageReader::LinkageReader(){
 
@@ -28,7 +33,7 @@ void LinkageReader::process(SnpData *data, ParamReader *params){
 		cout << "Entering verify_snp_lengths" << endl;
 	#endif
 
-	data->verify_snp_lengths();
+	data->verify_snp_lengths(individual_loaded);
 
 	#if DBG_PROGRESS
 		cout << "Leaving verify_snp_lengths" << endl;
@@ -48,7 +53,7 @@ void LinkageReader::process(SnpData *data, ParamReader *params){
 		this->getMapFile(data, params);
 	}else{
 		// Build a dummy map file.
-		for(unsigned long i=0; i < data->snp_data.at(0).size(); i++){
+		for(long i=0; i < data->numSnps(); i++){
 			stringstream ss;
 			ss << i+params->get_begin();
 			data->push_map("0",ss.str(),0);
@@ -72,170 +77,354 @@ void LinkageReader::process(SnpData *data, ParamReader *params){
  * We have to store two symbols per locus so we know how to assign initial
  * case/con.  Choose arbitrary order.
  *
- * Future coders: don't be afraid to bust this 100 line method up if so inclined.
+ * The file is mapped and read in two parallel passes.  First the lines are
+ * split (see splitLine()), keeping one character per allele for the SNPs
+ * in the window.  Then each SNP is coded down its column (see codeSnp()).
+ * Lines are checked in file order between the two, so errors are reported
+ * for the first bad line as before.
  *
  */
 void LinkageReader::getGenotype(SnpData *data, ParamReader *params){
 
-	bool warned = false; // If there are any warnings, we want to print only the first one we see.
 	bool highVerbosity = params->get_verbosity(); // This will let us quickly know if we should include extra checks.
 
-	ifstream infile;
-	char s1, s2;
-	vector<string> line;
-	string id; // Will hold first element of the line.
-
-	int line_count = 1;
-
 	fillDataMatrix(data);
 
-	infile.open(params->get_linkage_geno_file().c_str(), ifstream::in);
-	if(!infile.is_open()){
+	int fd = open(params->get_linkage_geno_file().c_str(), O_RDONLY);
+	if(fd < 0){
+		cerr << "Unable to open file " << params->get_linkage_geno_file() << endl;
+		exit(0);
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0){
 		cerr << "Unable to open file " << params->get_linkage_geno_file() << endl;
 		exit(0);
 	}
+	size_t length = static_cast<size_t>(st.st_size);
+	void *mapping = NULL;
+	if(length > 0){
+		mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapping == MAP_FAILED){
+			cerr << "Unable to map file " << params->get_linkage_geno_file() << " into memory." << endl;
+			exit(0);
+		}
+	}
+	close(fd);
+	const char *text = static_cast<const char *>(mapping);
+
+	// Find the lines.  A trailing newline does not start another line.
+	vector<size_t> line_begin, line_end;
+	size_t pos = 0;
+	while(pos < length){
+		const char *nl = static_cast<const char *>(memchr(text + pos, '\n', length - pos));
+		size_t stop = (nl == NULL) ? length : static_cast<size_t>(nl - text);
+		line_begin.push_back(pos);
+		line_end.push_back(stop);
+		pos = stop + 1;
+	}
+	long numLines = line_begin.size();
+
+	// Skipped columns, by column number from 1.
+	vector<bool> skip;
+	const vector<int> &skip_cols = params->get_skip_cols();
+	for(unsigned int i=0; i < skip_cols.size(); i++){
+		if(skip_cols.at(i) < 0) continue;
+		if(static_cast<unsigned int>(skip_cols.at(i)) >= skip.size()){
+			skip.resize(skip_cols.at(i) + 1, false);
+		}
+		skip.at(skip_cols.at(i)) = true;
+	}
+
+	// The first line sets the number of SNPs and so the window.
+	long first = params->get_begin(), last = -1;
+	unsigned long first_line_size = 0;
+	if(numLines > 0){
+		string id;
+		first_line_size = splitLine(text + line_begin[0], text + line_end[0], skip, id, NULL, 1, 0);
+		if(first_line_size % 2 != 1){
+			cerr << "Uneven number of columns, line " << 1 << endl << "Aborting." << endl;
+			exit(0);
+		}
+		last = (first_line_size - 1) / 2;
+		if(params->get_end() < last) last = params->get_end();
+	}
+	if(first < 1) first = 1;
+	long number_in_window = (last >= first) ? last - first + 1 : 0;
+	unsigned long width = 2 * number_in_window;
+
+	// First pass: split every line.
+	vector<char> alleles(numLines * width);
+	vector<string> ids(numLines);
+	vector<unsigned long> columns(numLines);
+	vector<long> person(numLines, -1);
+
+	#if RUN_IN_PARALLEL_LINKAGE
+	#pragma omp parallel for schedule(dynamic, 16)
+	#endif
+	for(long l=0; l < numLines; l++){
+		columns[l] = splitLine(text + line_begin[l], text + line_end[l], skip, ids[l], width > 0 ? &alleles[l * width] : NULL, first, last);
+		map<string, int>::const_iterator it = order_in_file.find(ids[l]);
+		if(it != order_in_file.end()){
+			person[l] = it->second;
+		}
+	}
+
+	if(mapping != NULL){
+		munmap(mapping, length);
+	}
 
-	unsigned long start_spot = 1;  // Change one for skip.
-	while( ! this->getLine(&infile, &line, params, true)){
+	#if DBG_PROGRESS
+		cout << "First readthrough done. " << endl;
+	#endif
 
-		// Data verification:
-		if((line.size()) % 2 != 1){
+	// Check the lines in order.
+	for(long l=0; l < numLines; l++){
+		int line_count = l + 1;
+		if(columns[l] % 2 != 1){
 			cerr << "Uneven number of columns, line " << line_count << endl << "Aborting." << endl;
 			exit(0);
 		}
-
-		id = line.at(0);
-
-		// On first line, code the char sets.
-		if(line_count == 1){
-			codeCharacterSets(data, line, start_spot);
-		}else if (line_count == 2){
-			// Now, go through and reserve space for each vector.
-			size_t number_of_snps = data->character_list.size() / 2;
-			
-			for(size_t ii=0;ii<data->snp_data.size();ii++){
-				data->snp_data.at(ii).reserve(number_of_snps);
-			}
+		if(columns[l] != first_line_size){
+			cerr << "Line " << line_count << " did not have same number of snps as line 1.  " << endl;
+			cerr << "Size was: " << (columns[l] - 1) / 2 << endl;
+			cerr << "Aborting" << endl;
+			exit(0);
 		}
 
 		// If individual is used in the phenotype, then store their ordering.
-		if(order_in_file.count(id) == 0){
+		if(person[l] < 0){
 			if(params->get_verbosity() > 1){
-				 cout << "Individual " << id << " line " << line_count << " unused." << endl;
+				 cout << "Individual " << ids[l] << " line " << line_count << " unused." << endl;
 			}
-			line_count++;
 			continue;
-		}else{
-			data->setIndividualName(static_cast<unsigned int>(order_in_file[id]), id);
 		}
+		data->setIndividualName(static_cast<unsigned int>(person[l]), ids[l]);
 
-		// Pull line apart and put it in data.
-		for(unsigned long i=start_spot;i < data->character_list.size(); i+=2){
+		if(individual_loaded.at(person[l])){
+			cerr << "Individual " << ids[l] << " is repeated on line " << line_count << " of the genotype file.  Aborting." << endl;
+			exit(0);
+		}
+		individual_loaded.at(person[l]) = true;
+	}
 
-			// Verify element is in the window
-			if(!params->in_window( (i-start_spot)/2+1 )){
-				continue;
-			}
+	if(numLines != static_cast<long>(order_in_file.size())){
+		cout << "Warning: Uneven number of individuals in phen and gen.  If this message was unexpected, please verify data integrity." << endl;
+	}
 
-			// Get elements
-			s1 = *(line.at(i).c_str());
-			s2 = *(line.at(i+1).c_str());
+	// Second pass: code each SNP.
+	data->genotypes.resize(number_in_window, individual_loaded.size());
+	data->character_list.assign(width, ' ');
+	vector<AlleleWarning> warnings(number_in_window);
 
-			// Check for a specified set of characters. Warn on others.
-			if(highVerbosity && !warned){
-				warned = warned || performCharacterCheck(s1, s2, line_count, i, start_spot);
-			}
+	#if RUN_IN_PARALLEL_LINKAGE
+	#pragma omp parallel for schedule(dynamic, 64)
+	#endif
+	for(long snp=0; snp < number_in_window; snp++){
+		codeSnp(data, snp, alleles, width, person, highVerbosity, warnings[snp]);
+	}
+
+	// Only the first warning in the file is printed.
+	long warn_snp = -1;
+	for(long snp=0; snp < number_in_window; snp++){
+		if(warnings[snp].line < 0) continue;
+		if(warn_snp < 0 || warnings[snp].line < warnings[warn_snp].line){
+			warn_snp = snp;
+		}
+	}
+	if(warn_snp >= 0){
+		printWarning(warnings[warn_snp], warn_snp + first);
+	}
+}
+
+/**
+ * Split one line of the genotype file on white space, as Reader::getLine()
+ * does, but without building a string per column.  The first column kept
+ * is the individual's ID.  For the others only the first character is
+ * kept, and only for SNPs in the window.
+ *
+ * @param p Start of the line
+ * @param end End of the line
+ * @param skip Skipped columns, by column number from 1.
+ * @param id Receives the ID.
+ * @param alleles Receives two characters per SNP in the window.
+ * @param first First SNP in the window (from 1)
+ * @param last Last SNP in the window
+ * @return The number of columns kept.
+ */
+unsigned long LinkageReader::splitLine(const char *p, const char *end, const vector<bool> &skip, string &id, char *alleles, long first, long last){
+
+	unsigned long kept = 0;
+	unsigned long element = 0;
+	while(p < end){
+		while(p < end && isspace(static_cast<unsigned char>(*p))) p++;
+		if(p == end) break;
 
-			if(s1 == '0' || s2 == '0' || s1 == '.' || s2 == '.'){
-				// A missing in either means push missing onto stack.
-				data->snp_data.at(order_in_file[id]).push_back(0);
-				continue;
+		const char *start = p;
+		while(p < end && !isspace(static_cast<unsigned char>(*p))) p++;
+
+		element++;
+		if(element < skip.size() && skip[element]){
+			continue;
+		}
+		if(kept == 0){
+			id.assign(start, p);
+		}else{
+			long snp = (kept - 1) / 2 + 1;
+			if(snp >= first && snp <= last){
+				alleles[2 * (snp - first) + (kept - 1) % 2] = *start;
 			}
-			
-			// If both spots are blank, then attempt to store both s1 and s2.
-			if(' ' == data->character_list.at(i-start_spot) && ' ' == data->character_list.at((i-start_spot)+1)){
-				if(s1 == s2){
-					data->character_list.at(i-start_spot) = s1;
-				}else{
-					data->character_list.at(i-start_spot) = s1;
-					data->character_list.at(i-start_spot+1) = s2;
-				}
-			} else {
-				// Have we seen these elements before?
-				// Check against both spots.  If not match first, check second is available
-				// or matching.  Note that zeros (missing) are skipped.
-				if(s1 != data->character_list.at((i-start_spot)) && s1 != data->character_list.at((i-start_spot)+1)){
-					if(data->character_list.at((i-start_spot)+1) != ' '){
-						if(!warned){
-							cerr << "Message: " << data->character_list.at((i-start_spot)+1)  << " " << data->character_list.at((i-start_spot)) << endl;
-							cerr << "Have: " << s1 << " " << s2 << endl;
-							cerr << "Non-biallelic SNP: " << (i-start_spot)/2 + 1 << "  Locus 1" << endl << "Line " << line_count << endl;
-							cerr << "Individuals that do not have characters " << data->character_list.at((i-start_spot)+1)  << " or " << data->character_list.at((i-start_spot)) << " will be treated as missing." << endl;
-						}
-						warned = true;
-					}else{
-						data->character_list.at((i - start_spot) + 1) = s1;
+		}
+		kept++;
+	}
+	return kept;
+}
+
+/**
+ * Code one SNP for every individual in a single pass down the column.
+ *
+ * The alleles for the SNP (its two entries in character_list) are taken
+ * from the first line of the file and then filled in, in the order they
+ * are first seen.  A third allele is treated as missing.  Genotypes use
+ * the coding described in snp_data.hh.
+ *
+ * Each SNP is a separate row of the genotype matrix, so SNPs can be coded
+ * in parallel.
+ *
+ * @param data Data object, sized for the window.
+ * @param snp SNP within the window
+ * @param alleles Characters from splitLine(), one line after another.
+ * @param width Characters per line
+ * @param person Individual on each line, or -1 if unused.
+ * @param check If true, note unexpected characters.
+ * @param warning Receives the first suspect genotype, if any.
+ */
+void LinkageReader::codeSnp(SnpData *data, long snp, const vector<char> &alleles, unsigned long width, const vector<long> &person, bool check, AlleleWarning &warning){
+
+	char &d1 = data->character_list.at(2 * snp);
+	char &d2 = data->character_list.at(2 * snp + 1);
+	unsigned char *row = data->genotypes.mutable_row(snp);
+	vector<unsigned char> phase;
+
+	warning.line = -1;
+
+	// Line 1 is used to code the alleles whether or not it is used.
+	char s1 = alleles[2 * snp];
+	char s2 = alleles[2 * snp + 1];
+	if(s1 == '0' || s2 == '0'){
+		// Nothing known yet.
+	}else if(s1 == s2){
+		d1 = s1;
+	}else{
+		d1 = s1;
+		d2 = s2;
+	}
+
+	for(unsigned long l=0; l < person.size(); l++){
+		if(person[l] < 0){
+			continue;
+		}
+		unsigned int p = static_cast<unsigned int>(person[l]);
+		s1 = alleles[l * width + 2 * snp];
+		s2 = alleles[l * width + 2 * snp + 1];
+
+		// Check for a specified set of characters. Warn on others.
+		if(check && warning.line < 0 && (!expectedAllele(s1) || !expectedAllele(s2))){
+			warning.line = l;
+			warning.nonBiallelic = false;
+			warning.locus = expectedAllele(s1) ? 2 : 1;
+			warning.s1 = s1;
+			warning.s2 = s2;
+		}
+
+		if(s1 == '0' || s2 == '0' || s1 == '.' || s2 == '.'){
+			// A missing in either means missing.  The matrix starts as missing.
+			continue;
+		}
+
+		if(d1 == ' ' && d2 == ' '){
+			d1 = s1;
+			if(s1 != s2) d2 = s2;
+		}else{
+			// Have we seen these elements before?  If not, the second spot
+			// must still be available.
+			if(s1 != d1 && s1 != d2){
+				if(d2 != ' '){
+					if(warning.line < 0){
+						warning.line = l;
+						warning.nonBiallelic = true;
+						warning.s1 = s1;
+						warning.s2 = s2;
+						warning.d1 = d1;
+						warning.d2 = d2;
 					}
+				}else{
+					d2 = s1;
 				}
-				if(s2 != data->character_list.at((i-start_spot)) && s2 != data->character_list.at((i-start_spot)+1)){
-					if(data->character_list.at((i - start_spot) + 1) != ' '){
-						if(!warned){
-							cerr << "Message: " << data->character_list.at((i-start_spot)+1)  << " " << data->character_list.at((i-start_spot)) << endl;
-							cerr << "Have: " << s1 << " " << s2 << endl;
-							cerr << "Non-biallelic SNP: " << (i-start_spot)/2 + 1 << "  Locus 1" << endl << "Line " << line_count << endl;
-							cerr << "Individuals that do not have characters " << data->character_list.at((i-start_spot)+1)  << " or " << data->character_list.at((i-start_spot)) << " will be treated as missing." << endl;
-						}
-						warned = true;
-					}else{
-						data->character_list.at((i - start_spot) + 1) = s2;
+			}
+			if(s2 != d1 && s2 != d2){
+				if(d2 != ' '){
+					if(warning.line < 0){
+						warning.line = l;
+						warning.nonBiallelic = true;
+						warning.s1 = s1;
+						warning.s2 = s2;
+						warning.d1 = d1;
+						warning.d2 = d2;
 					}
+				}else{
+					d2 = s2;
 				}
 			}
+		}
 
-			// Push this element onto the end of the last genotype.
-			// Use coding described in snp_data.h.
-			short push_val = 1;
-			char d1 = data->character_list.at(i-start_spot);
-			char d2 = data->character_list.at(i-start_spot+1);
-
-			if(s1 == d1 && s2 == d1){
-				push_val = 1;
-			}else if(s1 == d1 && s2 == d2){
-				push_val = 2;
-			}else if(s1 == d2 && s2 == d1){
-				push_val = 3;
-			}else if(s1 == d2 && s2 == d2){
-				push_val = 4;
-			}else{
-				push_val = 0;
-			}
-
-			data->snp_data.at(order_in_file[id]).push_back( push_val );
-
+		short code;
+		if(s1 == d1 && s2 == d1){
+			code = 1;
+		}else if(s1 == d1 && s2 == d2){
+			code = 2;
+		}else if(s1 == d2 && s2 == d1){
+			code = 3;
+		}else if(s1 == d2 && s2 == d2){
+			code = 4;
+		}else{
+			continue; // Missing.
 		}
 
-		line_count++;
+		int shift = (p & 3) << 1;
+		row[p >> 2] = (row[p >> 2] & ~(3 << shift)) | (GenotypeMatrix::encode[code] << shift);
+		if(code == 3){
+			if(phase.empty()){
+				phase.assign((data->genotypes.num_people() + 7) / 8, 0);
+			}
+			phase[p >> 3] |= (1 << (p & 7));
+		}
 	}
 
-	#if DBG_PROGRESS
-		cout << "First readthrough done. " << endl;
-	#endif
-
-	if(line_count != static_cast<int>(order_in_file.size())+1){ // note: line_count starts at 1 for the user.
-		cout << "Warning: Uneven number of individuals in phen and gen.  If this message was unexpected, please verify data integrity." << endl;
+	if(!phase.empty()){
+		#if RUN_IN_PARALLEL_LINKAGE
+		#pragma omp critical
+		#endif
+		data->genotypes.set_phase_row(snp, &phase[0]);
 	}
+}
 
-	infile.close();
-
-	// Fix char_list to window size.
-	vector<char> t;
-	for(unsigned int i=0; i < data->character_list.size(); i+=2){
-		if(params->in_window(i/2+1)){
-			t.push_back(data->character_list.at(i));
-			t.push_back(data->character_list.at(i+1));
-		}
+/**
+ * Print a warning from codeSnp().
+ *
+ * @param warning The warning
+ * @param snp SNP number in the file (from 1)
+ */
+void LinkageReader::printWarning(const AlleleWarning &warning, long snp){
+	long line_count = warning.line + 1;
+	if(warning.nonBiallelic){
+		cerr << "Message: " << warning.d2 << " " << warning.d1 << endl;
+		cerr << "Have: " << warning.s1 << " " << warning.s2 << endl;
+		cerr << "Non-biallelic SNP: " << snp << "  Locus 1" << endl << "Line " << line_count << endl;
+		cerr << "Individuals that do not have characters " << warning.d2 << " or " << warning.d1 << " will be treated as missing." << endl;
+	}else{
+		cerr << "SNP: " << snp << "  Locus " << warning.locus << endl << "Line " << line_count << " had coding '" << warning.s1 << ", " << warning.s2 <<"'.  If unexpected, please check data." << endl;
+		cerr << "Further warnings suppressed." << endl;
 	}
-	data->character_list = t;
 }
 
 /** getPhenotype()
@@ -261,7 +450,7 @@ void LinkageReader::getPhenotype(SnpData *data, ParamReader *params){
 		vector<int> cov_pos;
 		vector<int>::iterator it;
 
-		vector<double> *cov_vec = new vector<double>;
+		vector<double> cov_rows; // Covariates, one individual after another.
 
 		infile.open(params->get_linkage_pheno_file().c_str(), ifstream::in);
 		if(! infile.is_open()){
@@ -322,15 +511,14 @@ void LinkageReader::getPhenotype(SnpData *data, ParamReader *params){
 				t = numeric_limits<double>::max();
 			}
 			data->phenotypes.push_back(t);
-			// Add covariace
-			data->covariance.push_back(*(cov_vec));
+			// Add covariates
 			for(it = cov_pos.begin(); it != cov_pos.end(); it++){
 				t = atof(line.at(*(it)).c_str());
 				s = line.at(*(it));
 				if( s.compare(".") == 0 ){
 					t = numeric_limits<double>::max();
 				}
-				data->covariance.at(data->covariance.size() - 1).push_back(t);
+				cov_rows.push_back(t);
 			}
 
 			if(order_in_file.count(line.at(0)) > 0){
@@ -342,7 +530,7 @@ void LinkageReader::getPhenotype(SnpData *data, ParamReader *params){
 			order_in_file[line.at(0)] = line_no++;
 		}
 		infile.close();
-		delete cov_vec;
+		data->covariates.assign_rows(cov_rows, data->phenotypes.size(), cov_pos.size());
 
 }
 
@@ -416,71 +604,24 @@ void LinkageReader::verify_phen_header(int trait_pos, vector<int> *cov_pos, vect
 
 
 /**
- * Initialize data matrix to the correct size.
+ * Count the individuals in the phenotype file.  The genotype matrix is sized
+ * once the number of SNPs is known from the first line.
  */
 void LinkageReader::fillDataMatrix(SnpData *data) {
-	long numSNPS = 0;
+	long numIndiv = 0;
 	map<string, int>::iterator it;
 	for(it = order_in_file.begin(); it != order_in_file.end(); it++){
-		if(numSNPS < (*it).second){
-			numSNPS = (*it).second;
-		}
-	}
-	data->snp_data.reserve(numSNPS);
-	for(long i = 0; i <= numSNPS; i++){
-		vector<short> vec;
-		data->snp_data.push_back(vec);
-	}
-}
-
-/**
- * Attempt to code character sets. This performs two functions:
- * 
- * 1) Most importantly, reserve space in the character_list array.
- * 2) If possible, note the characters that are used for each SNP.
- * 
- * @param data Pointer to data object
- * @param line Vector of string tokens in the line.
- * @param start_spot Location in line of first SNP.
- */
-void LinkageReader::codeCharacterSets(SnpData *data, const vector<string> &line, unsigned long start_spot) {
-	char s1, s2;
-	data->character_list.reserve((line.size() - start_spot) / 2);
-	for(unsigned long i=start_spot;i < line.size(); i+=2){
-
-		s1 = *(line.at(i).c_str());
-		s2 = *(line.at(i+1).c_str());
-
-		if(s1 == '0' || s2 == '0'){
-			data->character_list.push_back(' ');
-			data->character_list.push_back(' ');
-		}else if(s1 == s2){
-			data->character_list.push_back(line.at(i).at(0));
-			data->character_list.push_back(' ');
-		}else{
-			data->character_list.push_back(line.at(i).at(0));
-			data->character_list.push_back(line.at(i+1).at(0));
+		if(numIndiv < (*it).second){
+			numIndiv = (*it).second;
 		}
 	}
+	individual_loaded.assign(numIndiv + 1, false);
 }
 
 /**
- * Check that characters are in the allowed character set.
- * 
- * @param s1 Locus 1 character
- * @param s2 Locus 2 character
- * @return boolean true iff warning was made.
+ * Allele characters that do not draw a warning: digits, nucleotides, B and
+ * the missing marker.
  */
-bool LinkageReader::performCharacterCheck(const char s1, const char s2, unsigned long line_count, unsigned int i, unsigned int start_spot) {
-	if(!(s1 >= '0' && s1 <= '9' ) || s1 == 'A'|| s1 == 'C'|| s1 == 'T'|| s1 == 'G'|| s1 == 'a'|| s1 == 'c'|| s1 == 'g'|| s1 == 't'|| s1 == 'B'|| s1 == 'b'|| s1 == '.'){
-		cerr << "SNP: " << (i-start_spot)/2 + 1 << "  Locus 1" << endl << "Line " << line_count << " had coding '" << s1 << ", " << s2 <<"'.  If unexpected, please check data." << endl;
-		cerr << "Further warnings suppressed." << endl;
-		return true;
-	}
-	if(!(s2 >= '0' && s2 <= '9') || s2 == 'A'|| s2 == 'C'|| s2 == 'T'|| s2 == 'G'|| s2 == 'a'|| s2 == 'c'|| s2 == 'g'|| s2 == 't'|| s2 == 'B'|| s2 == 'b'|| s2 == '.'){
-		cerr << "SNP: " << (i-start_spot)/2 + 1 << "  Locus 2" << endl << "Line " << line_count << " had coding '" << s1 << ", " << s2 <<"'.  If unexpected, please check data." << endl;
-		cerr << "Further warnings suppressed." << endl;
-		return true;
-	}
-	return false;
+bool LinkageReader::expectedAllele(char c){
+	return (c >= '0' && c <= '9') || c == 'A'|| c == 'C'|| c == 'T'|| c == 'G'|| c == 'a'|| c == 'c'|| c == 'g'|| c == 't'|| c == 'B'|| c == 'b'|| c == '.';
 }
@@ -12,6 +12,7 @@
 #include <map>		// Used to order individuals.
 
 #define DBG_PROGRESS 0
+#define RUN_IN_PARALLEL_LINKAGE 1
 
 class LinkageReader : public Reader {
 
@@ -22,7 +23,18 @@ public:
 
 private:
 
+	// The first suspect genotype seen for a SNP.  Only the first one in the
+	// file is reported.
+	struct AlleleWarning {
+		long line;		// Line in the genotype file (from 0), or -1 if none.
+		bool nonBiallelic;	// Otherwise an unexpected character.
+		int locus;
+		char s1, s2;		// Genotype as read.
+		char d1, d2;		// Alleles known for the SNP at that point.
+	};
+
 	map<string, int> order_in_file;
+	vector<bool> individual_loaded; // true once a genotype line was read for the individual.
 	void getGenotype(SnpData *, ParamReader *);
 	void getPhenotype(SnpData *, ParamReader *);
 	void getMapFile(SnpData *, ParamReader *);
@@ -31,8 +43,10 @@ private:
 	
 	// helpers
 	void fillDataMatrix(SnpData *);
-	void codeCharacterSets(SnpData *, const vector<string> &line, unsigned long start_spot);
-	bool performCharacterCheck(const char s1, const char s2, unsigned long line_count, unsigned int i, unsigned int start_spot);
+	unsigned long splitLine(const char *, const char *, const vector<bool> &skip, string &id, char *alleles, long first, long last);
+	void codeSnp(SnpData *, long snp, const vector<char> &alleles, unsigned long width, const vector<long> &person, bool check, AlleleWarning &warning);
+	void printWarning(const AlleleWarning &, long snp);
+	static bool expectedAllele(char c);
 
 };
 
@@ -24,6 +24,13 @@ class Reader {
 public:
 	virtual ~Reader();
 	virtual void process(SnpData *, ParamReader *) = 0;
+
+	// Streaming: read everything but the genotypes, then read the genotypes
+	// in blocks of SNPs.  Readers that can not stream return false.
+	virtual bool open_stream(SnpData *, ParamReader *){return false;}
+	virtual void read_block(SnpData *, unsigned long, unsigned long){}
+	virtual void prefetch_block(unsigned long, unsigned long){}
+
 	bool getLine(ifstream *, vector<string> *, ParamReader *, bool check);
 };
 
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# bench_snpgwa_threads.sh
+#
+# Time SNPGWA on the Sim2000 data with 1, 2, 4, ... threads up to the
+# number of cores (or the list given) and report the speedup over one
+# thread.  Each run's output is checked against the one-thread output.
+# The speedup column only means something on a multi-core host; with
+# more threads than cores the script is just an output check.
+#
+# usage: bench_snpgwa_threads.sh [snplash binary] [thread counts...]
+
+SNPLASH=${1:-../snplash}
+[ $# -gt 0 ] && shift
+THREADS="$*"
+if [ -z "$THREADS" ]; then
+	n=1; max=`nproc`
+	while [ $n -lt $max ]; do THREADS="$THREADS $n"; n=`expr $n \* 2`; done
+	THREADS="$THREADS $max"
+fi
+
+OUT=`mktemp -d`
+trap 'rm -rf $OUT' 0
+
+base=""
+for t in $THREADS; do
+	start=`date +%s%N`
+	OMP_NUM_THREADS=$t $SNPLASH -bed Sim2000/sim2000.bed -phen Sim2000/sim2000.covphen \
+		-map Sim2000/sim2000.bim -engine snpgwa -out $OUT/run$t > /dev/null 2>&1 || exit 1
+	ms=`expr \( \`date +%s%N\` - $start \) / 1000000`
+	[ -z "$base" ] && base=$ms && first=$t
+	# The header names the output file; take that out before comparing.
+	sed "s#$OUT/run$t##g" $OUT/run$t > $OUT/clean$t
+	same=same
+	cmp -s $OUT/clean$t $OUT/clean$first || same=DIFFERENT
+	echo "threads $t: ${ms} ms  speedup `expr 100 \* $base / $ms`%  output $same"
+done